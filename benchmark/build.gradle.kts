@@ -0,0 +1,113 @@
+import groovy.json.JsonSlurper
+
+plugins {
+    alias(libs.plugins.kotlinMultiplatform)
+    alias(libs.plugins.kotlinAllopen)
+    alias(libs.plugins.kotlinxBenchmark)
+}
+
+kotlin {
+    jvm()
+
+    val hostOs = System.getProperty("os.name")
+    val isArm64 = System.getProperty("os.arch") == "aarch64"
+    val isMingwX64 = hostOs.startsWith("Windows")
+    val nativeTarget = when {
+        hostOs == "Mac OS X" && isArm64 -> macosArm64()
+        hostOs == "Mac OS X" && !isArm64 -> macosX64()
+        hostOs == "Linux" && isArm64 -> linuxArm64()
+        hostOs == "Linux" && !isArm64 -> linuxX64()
+        isMingwX64 -> mingwX64()
+        else -> throw GradleException("Host OS is not supported in Kotlin/Native.")
+    }
+
+    // the same scenarios run on the JNI backend (jvm) and on the Kotlin/Native backend
+    benchmark {
+        targets {
+            register("jvm")
+            register(nativeTarget.name)
+        }
+    }
+
+    sourceSets {
+        commonMain.dependencies {
+            implementation(project(":FirebirdClient-ext"))
+            implementation(libs.kotlinx.benchmark.runtime)
+        }
+    }
+}
+
+// JMH generates subclasses of the benchmark states
+allOpen {
+    annotation("org.openjdk.jmh.annotations.State")
+}
+
+benchmark {
+    configurations {
+        named("main") {
+            warmups = 3
+            iterations = 5
+            iterationTime = 1
+            iterationTimeUnit = "s"
+            reportFormat = "json"
+        }
+
+        // a quick pass over the smallest parameters, to check that every benchmark runs
+        register("smoke") {
+            warmups = 1
+            iterations = 1
+            iterationTime = 200
+            iterationTimeUnit = "ms"
+            param("columns", "4")
+            param("rows", "100")
+            param("blobSize", "1024")
+            reportFormat = "json"
+        }
+    }
+}
+
+/**
+ * Puts the last results of each target side by side, with the ratio of the native score to the jvm score.
+ *
+ * Run after `benchmark` (or `smokeBenchmark` with -Pconfiguration=smoke); the table is printed and written next to
+ * the reports as comparison.md.
+ */
+tasks.register("benchmarkReport") {
+    group = "benchmark"
+    description = "Compares the last jvm and native benchmark results."
+    doLast {
+        val configuration = findProperty("configuration")?.toString() ?: "main"
+        val root = layout.buildDirectory.dir("reports/benchmarks/$configuration").get().asFile
+        val run = root.listFiles()?.filter { it.isDirectory }?.maxByOrNull { it.name }
+            ?: throw GradleException("No results in $root, run the benchmarks first")
+
+        // benchmark and parameters -> score and unit, for each report of the run
+        val targets = run.listFiles { file -> file.extension == "json" }!!.sortedBy { it.name }.associate { file ->
+            @Suppress("UNCHECKED_CAST")
+            val results = JsonSlurper().parse(file) as List<Map<String, Any?>>
+            file.nameWithoutExtension to results.associate { result ->
+                val params = (result["params"] as Map<*, *>?)?.entries?.sortedBy { it.key.toString() }
+                    ?.joinToString(",") { "${it.key}=${it.value}" }
+                val name = result["benchmark"].toString().substringAfterLast(".benchmark.")
+                val metric = result["primaryMetric"] as Map<*, *>
+                (if (params.isNullOrEmpty()) name else "$name($params)") to
+                    Pair((metric["score"] as Number).toDouble(), metric["scoreUnit"].toString())
+            }
+        }
+        val jvm = targets["jvm"] ?: throw GradleException("No jvm results in $run")
+        val native = targets.filterKeys { it != "jvm" }.values.firstOrNull()
+            ?: throw GradleException("No native results in $run")
+
+        val table = StringBuilder()
+        table.append("| Benchmark | jvm | native | native / jvm |\n|---|---:|---:|---:|\n")
+        for (name in (jvm.keys + native.keys).sorted()) {
+            val a = jvm[name]
+            val b = native[name]
+            val ratio = if (a != null && b != null && a.first != 0.0) "%.2f".format(b.first / a.first) else ""
+            table.append("| $name | ${a?.let { "%.3f %s".format(it.first, it.second) } ?: ""} | " +
+                "${b?.let { "%.3f %s".format(it.first, it.second) } ?: ""} | $ratio |\n")
+        }
+        run.resolve("comparison.md").writeText(table.toString())
+        println(table)
+    }
+}
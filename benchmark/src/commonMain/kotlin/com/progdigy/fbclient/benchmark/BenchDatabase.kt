@@ -0,0 +1,103 @@
+package com.progdigy.fbclient.benchmark
+
+import com.progdigy.fbclient.API
+import com.progdigy.fbclient.Attachment
+import com.progdigy.fbclient.Attachment.Transaction
+import com.progdigy.fbclient.checkStatus
+import com.progdigy.fbclient.makeDPB
+
+/**
+ * Returns the path of a new temporary database.
+ */
+expect fun benchDatabasePath(): String
+
+/**
+ * Deletes a temporary database.
+ */
+expect fun deleteBenchDatabase(path: String)
+
+/**
+ * A temporary embedded database, created like the test databases and deleted when closed.
+ *
+ * A transaction stays open for the whole benchmark, so the measured operations do not include the cost of starting
+ * and committing transactions.
+ *
+ * @param schema Creates and populates the tables, in its own committed transaction.
+ */
+class BenchDatabase(schema: Transaction.() -> Unit) : AutoCloseable {
+    private val path = benchDatabasePath()
+
+    val attachment: Attachment = Attachment.createDatabase(path, makeDPB {
+        userName("SYSDBA")
+        password("masterkey")
+        setDBCharset("UTF8")
+        sqlDialect(3)
+    })
+
+    val transaction: Transaction
+
+    init {
+        attachment.transaction(block = schema)
+        val trHandle = API.allocHandle()
+        checkStatus(attachment.status, API.startTransaction(attachment.status, trHandle, attachment.dbHandle, null))
+        transaction = attachment.getTransaction(trHandle)
+    }
+
+    override fun close() {
+        try {
+            transaction.commit()
+            attachment.close()
+        } finally {
+            deleteBenchDatabase(path)
+        }
+    }
+}
+
+/**
+ * The column types of a benchmark table, cycled to reach the requested column count.
+ *
+ * @property types The SQL types of the columns.
+ * @property values The PSQL expressions computing the value of each type from the row number `I`.
+ */
+enum class TypeMix(val types: List<String>, val values: List<String>) {
+    NUMERIC(
+        listOf("INTEGER", "BIGINT", "DOUBLE PRECISION", "NUMERIC(18,2)"),
+        listOf(":I", ":I * 1000", ":I / 3.0e0", ":I / 7.0")
+    ),
+    MIXED(
+        listOf("INTEGER", "VARCHAR(32)", "BIGINT", "DOUBLE PRECISION", "TIMESTAMP", "BOOLEAN", "VARCHAR(100)", "DATE"),
+        listOf(
+            ":I", "'value ' || :I", ":I * 1000", ":I / 3.0e0",
+            "DATEADD(:I SECOND TO TIMESTAMP '2020-01-01 00:00:00')", "MOD(:I, 2) = 0",
+            "RPAD('text ' || :I, 60, 'x')", "DATEADD(:I DAY TO DATE '2020-01-01')"
+        )
+    ),
+    TEXT(
+        listOf("VARCHAR(64)", "CHAR(16)", "VARCHAR(255)"),
+        listOf("'value ' || :I", "'c' || :I", "RPAD('text ' || :I, 200, 'x')")
+    );
+
+    /**
+     * Creates the table `BENCH` with [columns] columns named `C0`, `C1`... and fills it with [rows] rows.
+     */
+    fun create(transaction: Transaction, columns: Int, rows: Int) {
+        val indices = 0 until columns
+        transaction.execute(
+            "CREATE TABLE BENCH (${indices.joinToString { "C$it ${types[it % types.size]}" }})"
+        )
+        transaction.commitRetaining()
+        transaction.execute(
+            """
+            EXECUTE BLOCK AS
+            DECLARE I INTEGER = 0;
+            BEGIN
+                WHILE (I < $rows) DO
+                BEGIN
+                    INSERT INTO BENCH VALUES (${indices.joinToString { values[it % values.size] }});
+                    I = I + 1;
+                END
+            END
+            """.trimIndent()
+        )
+    }
+}
@@ -0,0 +1,75 @@
+package com.progdigy.fbclient.benchmark
+
+import kotlinx.benchmark.*
+
+/**
+ * Reads and writes binary blobs through the blob scopes of a transaction.
+ *
+ * Reads use a 32 KB buffer, the largest segment the client library transfers at once; writes send the whole blob in
+ * one call, split into segments by the native layer. Every 256 writes, a commit retaining releases the written blobs.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(BenchmarkTimeUnit.SECONDS)
+class BlobBenchmark {
+    @Param("1024", "65536", "1048576")
+    var blobSize = 0
+
+    private lateinit var database: BenchDatabase
+    private lateinit var data: ByteArray
+    private val buffer = ByteArray(32767)
+    private var blobId = 0L
+    private var written = 0
+
+    @Setup
+    fun setup() {
+        database = BenchDatabase {
+            execute("CREATE TABLE BLOBS (ID INTEGER, DATA BLOB SUB_TYPE BINARY)")
+        }
+        data = ByteArray(blobSize) { it.toByte() }
+        database.transaction.apply {
+            val created = blobCreate { write(data) }
+            statement("INSERT INTO BLOBS VALUES (1, ?)") {
+                params.setBlobId(0, created)
+                execute()
+            }
+            commitRetaining()
+            // the stored blob gets a permanent id
+            statement("SELECT DATA FROM BLOBS") {
+                open { blobId = getBlobId(0) }
+            }
+        }
+    }
+
+    @TearDown
+    fun tearDown() {
+        database.close()
+    }
+
+    @Benchmark
+    fun read(blackhole: Blackhole) {
+        var total = 0
+        database.transaction.blobOpen(blobId) {
+            while (true) {
+                val size = read(buffer)
+                if (size <= 0)
+                    break
+                total += size
+            }
+        }
+        blackhole.consume(total)
+    }
+
+    @Benchmark
+    fun write(blackhole: Blackhole) {
+        val transaction = database.transaction
+        blackhole.consume(transaction.blobCreate { write(data) })
+        // the written blobs are never stored, they are released with the transaction
+        if (++written % RELEASE_INTERVAL == 0)
+            transaction.commitRetaining()
+    }
+
+    private companion object {
+        const val RELEASE_INTERVAL = 256
+    }
+}
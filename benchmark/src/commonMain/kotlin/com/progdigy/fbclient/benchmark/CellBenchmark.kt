@@ -0,0 +1,88 @@
+package com.progdigy.fbclient.benchmark
+
+import com.progdigy.fbclient.API
+import com.progdigy.fbclient.Attachment.Transaction.SQLDA
+import com.progdigy.fbclient.Attachment.Transaction.Statement
+import com.progdigy.fbclient.checkStatus
+import kotlinx.benchmark.*
+
+/**
+ * Reads single cells of a fetched row, isolating the cost of a getter call from the fetch.
+ *
+ * On the JVM a getter crosses JNI, on Kotlin/Native it reads the XSQLDA directly; string getters also measure the
+ * decoding of UTF-8 text, ASCII or with two-byte characters.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(BenchmarkTimeUnit.NANOSECONDS)
+class CellBenchmark {
+    private lateinit var database: BenchDatabase
+    private lateinit var statement: Statement
+    private lateinit var row: SQLDA
+
+    @Setup
+    fun setup() {
+        database = BenchDatabase {}
+        val transaction = database.transaction
+        val attachment = database.attachment
+        val stHandle = API.allocHandle()
+        val output = API.allocHandle()
+        val sql = """
+            SELECT
+                CAST(123456789 AS INTEGER),
+                CAST(1234567890123 AS BIGINT),
+                CAST(1.25 AS DOUBLE PRECISION),
+                CAST(RPAD('value', 32, 'x') AS VARCHAR(32)),
+                CAST(RPAD('text', 255, 'x') AS VARCHAR(255)),
+                CAST(RPAD('café', 255, 'é') AS VARCHAR(255)),
+                CAST('char' AS CHAR(32)),
+                CAST('2020-01-01 12:00:00' AS TIMESTAMP)
+            FROM RDB${'$'}DATABASE
+        """.trimIndent()
+        checkStatus(attachment.status, API.prepareStatement(attachment.status, attachment.dbHandle,
+            transaction.trHandle, stHandle, sql, null, attachment.dialect, output))
+        statement = transaction.getStatement(stHandle, output)
+        statement.execute()
+        row = statement.result
+    }
+
+    @TearDown
+    fun tearDown() {
+        val stHandle = statement.stHandle
+        val output = statement.output
+        statement.close()
+        API.freeHandle(stHandle)
+        API.freeHandle(output)
+        database.close()
+    }
+
+    @Benchmark
+    fun getInt(): Int = row.getInt(0)
+
+    @Benchmark
+    fun getLong(): Long = row.getLong(1)
+
+    @Benchmark
+    fun getDouble(): Double = row.getDouble(2)
+
+    @Benchmark
+    fun getIsNull(): Boolean = row.getIsNull(0)
+
+    @Benchmark
+    fun getStringShort(): String = row.getString(3)
+
+    @Benchmark
+    fun getStringLong(): String = row.getString(4)
+
+    @Benchmark
+    fun getStringMultibyte(): String = row.getString(5)
+
+    @Benchmark
+    fun getStringChar(): String = row.getString(6)
+
+    @Benchmark
+    fun getDateTime(blackhole: Blackhole) {
+        blackhole.consume(row.getEpochDays(7))
+        blackhole.consume(row.getMillisecondOfDay(7))
+    }
+}
@@ -0,0 +1,126 @@
+package com.progdigy.fbclient.benchmark
+
+import com.progdigy.fbclient.API
+import com.progdigy.fbclient.Attachment.Transaction.SQLDA
+import com.progdigy.fbclient.Attachment.Transaction.Statement
+import com.progdigy.fbclient.DataType
+import com.progdigy.fbclient.checkStatus
+import com.progdigy.fbclient.ext.getAnyOrNull
+import kotlinx.benchmark.*
+
+/**
+ * Fetches and decodes a whole table through a prepared statement.
+ *
+ * [fetchTyped] reads every cell with the getter matching its type, as hand-written code does, [fetchAny] reads them
+ * with `getAny` from the extension library, and [fetchOnly] fetches without reading anything, which is the floor of
+ * the two others.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(BenchmarkTimeUnit.MICROSECONDS)
+class FetchBenchmark {
+    @Param("4", "16", "64")
+    var columns = 0
+
+    @Param("NUMERIC", "MIXED", "TEXT")
+    var mix = ""
+
+    @Param("100", "10000")
+    var rows = 0
+
+    private lateinit var database: BenchDatabase
+    private lateinit var statement: Statement
+    private lateinit var types: Array<DataType>
+
+    @Setup
+    fun setup() {
+        database = BenchDatabase { TypeMix.valueOf(mix).create(this, columns, rows) }
+        val transaction = database.transaction
+        val attachment = database.attachment
+        val stHandle = API.allocHandle()
+        val output = API.allocHandle()
+        checkStatus(attachment.status, API.prepareStatement(attachment.status, attachment.dbHandle,
+            transaction.trHandle, stHandle, "SELECT * FROM BENCH", null, attachment.dialect, output))
+        statement = transaction.getStatement(stHandle, output)
+        types = Array(columns) { statement.result.getType(it) }
+    }
+
+    @TearDown
+    fun tearDown() {
+        val stHandle = statement.stHandle
+        val output = statement.output
+        statement.close()
+        API.freeHandle(stHandle)
+        API.freeHandle(output)
+        database.close()
+    }
+
+    @Benchmark
+    fun fetchTyped(blackhole: Blackhole) {
+        statement.open {
+            while (!eof) {
+                for (index in types.indices)
+                    decode(index, types[index], blackhole)
+                fetch()
+            }
+        }
+    }
+
+    @Benchmark
+    fun fetchAny(blackhole: Blackhole) {
+        statement.open {
+            while (!eof) {
+                for (index in types.indices)
+                    blackhole.consume(getAnyOrNull(index))
+                fetch()
+            }
+        }
+    }
+
+    @Benchmark
+    fun fetchOnly(blackhole: Blackhole) {
+        var count = 0
+        statement.open {
+            while (!eof) {
+                count++
+                fetch()
+            }
+        }
+        blackhole.consume(count)
+    }
+}
+
+/**
+ * Reads a cell with the getter matching its type, without conversion to a higher level type.
+ */
+internal fun SQLDA.decode(index: Int, type: DataType, blackhole: Blackhole) {
+    if (getIsNull(index))
+        return
+    when (type) {
+        DataType.SHORT -> blackhole.consume(getShort(index))
+        DataType.INT -> blackhole.consume(getInt(index))
+        DataType.LONG -> blackhole.consume(getLong(index))
+        DataType.FLOAT -> blackhole.consume(getFloat(index))
+        DataType.DOUBLE -> blackhole.consume(getDouble(index))
+        DataType.STRING, DataType.BLOB_TEXT -> blackhole.consume(getString(index))
+        DataType.BYTEARRAY -> blackhole.consume(getByteArray(index))
+        DataType.INT128 -> blackhole.consume(getInt128(index))
+        DataType.BOOLEAN -> blackhole.consume(getBoolean(index))
+        DataType.DATE -> blackhole.consume(getEpochDays(index))
+        DataType.TIME -> blackhole.consume(getMillisecondOfDay(index))
+        DataType.DATETIME -> {
+            blackhole.consume(getEpochDays(index))
+            blackhole.consume(getMillisecondOfDay(index))
+        }
+        DataType.TIME_TZ -> {
+            blackhole.consume(getMillisecondOfDay(index))
+            blackhole.consume(getTimeZoneId(index).id)
+        }
+        DataType.DATETIME_TZ -> {
+            blackhole.consume(getEpochDays(index))
+            blackhole.consume(getMillisecondOfDay(index))
+            blackhole.consume(getTimeZoneId(index).id)
+        }
+        DataType.BLOB_BINARY -> blackhole.consume(getBlobId(index))
+    }
+}
@@ -0,0 +1,123 @@
+package com.progdigy.fbclient.benchmark
+
+import com.ionspin.kotlin.bignum.decimal.BigDecimal
+import com.progdigy.fbclient.API
+import com.progdigy.fbclient.Attachment.Transaction.SQLDA
+import com.progdigy.fbclient.Attachment.Transaction.Statement
+import com.progdigy.fbclient.checkStatus
+import com.progdigy.fbclient.ext.setParams
+import kotlinx.benchmark.*
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.LocalDateTime
+
+/**
+ * Prepares and executes statements with parameters of the given type mix.
+ *
+ * The executed statement is a singleton `SELECT CAST(? AS ...) FROM RDB$DATABASE`, so each execution sets every
+ * parameter, runs a round trip through the engine and receives one row, without growing a table.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(BenchmarkTimeUnit.MICROSECONDS)
+class StatementBenchmark {
+    @Param("4", "16", "64")
+    var columns = 0
+
+    @Param("NUMERIC", "MIXED", "TEXT")
+    var mix = ""
+
+    private lateinit var database: BenchDatabase
+    private lateinit var statement: Statement
+    private lateinit var selectSql: String
+    private lateinit var values: Array<Any?>
+    private lateinit var setters: Array<SQLDA.(Int) -> Unit>
+
+    @Setup
+    fun setup() {
+        val typeMix = TypeMix.valueOf(mix)
+        val types = List(columns) { typeMix.types[it % typeMix.types.size] }
+        database = BenchDatabase { typeMix.create(this, columns, 1) }
+        selectSql = "SELECT * FROM BENCH WHERE ${(0 until columns).joinToString(" AND ") { "C$it = ?" }}"
+        values = Array(columns) { sampleValue(types[it]) }
+        setters = Array(columns) { typedSetter(types[it]) }
+
+        val transaction = database.transaction
+        val attachment = database.attachment
+        val stHandle = API.allocHandle()
+        val output = API.allocHandle()
+        val sql = "SELECT ${types.joinToString { "CAST(? AS $it)" }} FROM RDB\$DATABASE"
+        checkStatus(attachment.status, API.prepareStatement(attachment.status, attachment.dbHandle,
+            transaction.trHandle, stHandle, sql, null, attachment.dialect, output))
+        statement = transaction.getStatement(stHandle, output)
+    }
+
+    @TearDown
+    fun tearDown() {
+        val stHandle = statement.stHandle
+        val output = statement.output
+        statement.close()
+        API.freeHandle(stHandle)
+        API.freeHandle(output)
+        database.close()
+    }
+
+    /**
+     * Prepares a statement with one parameter per column, describes it, then frees it.
+     */
+    @Benchmark
+    fun prepare(blackhole: Blackhole) {
+        database.transaction.statement(selectSql) {
+            blackhole.consume(params.getCount())
+        }
+    }
+
+    /**
+     * Executes the prepared singleton with the typed setters.
+     */
+    @Benchmark
+    fun executeTyped(blackhole: Blackhole) {
+        val params = statement.params
+        for (index in setters.indices)
+            setters[index](params, index)
+        statement.execute()
+        blackhole.consume(statement.result.getIsNull(0))
+    }
+
+    /**
+     * Executes the prepared singleton with `setParams` from the extension library.
+     */
+    @Benchmark
+    fun executeParams(blackhole: Blackhole) {
+        statement.setParams(*values)
+        statement.execute()
+        blackhole.consume(statement.result.getIsNull(0))
+    }
+}
+
+private fun sampleValue(type: String): Any = when {
+    type == "INTEGER" -> 42
+    type == "BIGINT" -> 42000L
+    type == "DOUBLE PRECISION" -> 1.25
+    type.startsWith("NUMERIC") -> BigDecimal.parseString("123.45")
+    type.startsWith("VARCHAR") || type.startsWith("CHAR") -> "value"
+    type == "TIMESTAMP" -> LocalDateTime(2020, 1, 1, 12, 0)
+    type == "BOOLEAN" -> true
+    type == "DATE" -> LocalDate(2020, 1, 1)
+    else -> throw IllegalArgumentException(type)
+}
+
+// 18262 is 2020-01-01 in epoch days
+private fun typedSetter(type: String): SQLDA.(Int) -> Unit = when {
+    type == "INTEGER" -> { index -> setInt(index, 42) }
+    type == "BIGINT" -> { index -> setLong(index, 42000L) }
+    type == "DOUBLE PRECISION" -> { index -> setDouble(index, 1.25) }
+    type.startsWith("NUMERIC") -> { index -> setLong(index, 12345L) }
+    type.startsWith("VARCHAR") || type.startsWith("CHAR") -> { index -> setString(index, "value") }
+    type == "TIMESTAMP" -> { index ->
+        setEpochDays(index, 18262)
+        setMillisecondOfDay(index, 43200000)
+    }
+    type == "BOOLEAN" -> { index -> setBoolean(index, true) }
+    type == "DATE" -> { index -> setEpochDays(index, 18262) }
+    else -> throw IllegalArgumentException(type)
+}
@@ -0,0 +1,13 @@
+package com.progdigy.fbclient.benchmark
+
+import java.io.File
+
+actual fun benchDatabasePath(): String {
+    val tmp = System.getProperty("java.io.tmpdir")
+    val time = System.nanoTime()
+    return "$tmp/fbbench$time.fdb"
+}
+
+actual fun deleteBenchDatabase(path: String) {
+    File(path).delete()
+}
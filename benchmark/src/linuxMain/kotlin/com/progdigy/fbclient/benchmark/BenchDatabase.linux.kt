@@ -0,0 +1,12 @@
+package com.progdigy.fbclient.benchmark
+
+import platform.posix.unlink
+import kotlin.random.Random
+
+actual fun benchDatabasePath(): String {
+    return "/tmp/fbbench${Random.nextLong()}.fdb"
+}
+
+actual fun deleteBenchDatabase(path: String) {
+    unlink(path)
+}
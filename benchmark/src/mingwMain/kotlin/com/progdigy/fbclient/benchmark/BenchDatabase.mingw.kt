@@ -0,0 +1,18 @@
+package com.progdigy.fbclient.benchmark
+
+import kotlinx.cinterop.ExperimentalForeignApi
+import kotlinx.cinterop.toKString
+import platform.posix.getenv
+import platform.posix.unlink
+import kotlin.random.Random
+
+@OptIn(ExperimentalForeignApi::class)
+actual fun benchDatabasePath(): String {
+    val random = Random.nextLong()
+    val temp = getenv("TEMP")!!.toKString()
+    return "$temp/fbbench$random.fdb"
+}
+
+actual fun deleteBenchDatabase(path: String) {
+    unlink(path)
+}
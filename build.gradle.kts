@@ -2,4 +2,6 @@ plugins {
     //trick: for the same plugin versions in all sub-modules
     alias(libs.plugins.androidLibrary).apply(false)
     alias(libs.plugins.kotlinMultiplatform).apply(false)
+    alias(libs.plugins.kotlinAllopen).apply(false)
+    alias(libs.plugins.kotlinxBenchmark).apply(false)
 }
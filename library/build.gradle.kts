@@ -74,6 +74,11 @@ kotlin {
                 cinterops {
                     create("fbclient") {
                         header(file("../native/include/ibase.h"))
+                        header(file("../native/fbcore.h"))
+                        // the conversion core is compiled into the klib, the JNI shim links the same source via CMake
+                        extraOpts("-Xcompile-source", file("../native/fbcore.c").path)
+                        extraOpts("-Xsource-compiler-option", "-I${file("../native/include").path}")
+                        extraOpts("-Xsource-compiler-option", "-O3")
                     }
                 }
             }
@@ -89,6 +94,14 @@ kotlin {
             implementation(libs.kotlin.test)
             implementation(libs.kotlinx.coroutines)
         }
+
+        // the sources written against the JNI layer, shared by the JVM and Android targets
+        jvmMain {
+            kotlin.srcDir("src/jniMain/kotlin")
+        }
+        androidMain {
+            kotlin.srcDir("src/jniMain/kotlin")
+        }
     }
 }
 
@@ -25,6 +25,8 @@ actual object API {
     @JvmStatic
     actual external fun detachDatabase(status: HANDLE, dbHandle: HANDLE): STATUS
     @JvmStatic
+    actual external fun databaseInfo(status: HANDLE, dbHandle: HANDLE, items: ByteArray, length: Int): ByteArray
+    @JvmStatic
     actual external fun executeImmediate(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sql: String, dialect: Short): STATUS
     @JvmStatic
     actual external fun startTransaction(status: HANDLE, trHandle: HANDLE, dbHandle: HANDLE, options: ByteArray?): STATUS
@@ -42,6 +44,10 @@ actual object API {
     @JvmStatic
     actual external fun prepareParams(status: HANDLE, stHandle: HANDLE, dialect: Short, sqlda: HANDLE): STATUS
     @JvmStatic
+    actual external fun setTypes(sqlda: HANDLE, types: IntArray)
+    @JvmStatic
+    actual external fun setOutputProfile(sqlda: HANDLE, profile: Int)
+    @JvmStatic
     actual external fun setIsNull(sqlda: HANDLE, index: Int)
     @JvmStatic
     actual external fun setValueBoolean(sqlda: HANDLE, index: Int, value: Boolean)
@@ -129,6 +135,585 @@ actual object API {
     actual external fun blobWrite(status: HANDLE, blobHandle: HANDLE, buffer: ByteArray, offset: Int, length: Int): Int
     @JvmStatic
     actual external fun blobCreate(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, blobHandle: HANDLE): Long
-}
+    @JvmStatic
+    actual external fun queEvents(status: HANDLE, dbHandle: HANDLE, names: Array<String>, listener: EventListener): HANDLE
+    @JvmStatic
+    actual external fun cancelEvents(status: HANDLE, events: HANDLE): STATUS
+
+    /**
+     * Enables or disables the latency histograms of the native entry points.
+     *
+     * While disabled, calls go straight to the client library and each JNI function only checks a flag.
+     */
+    @JvmStatic
+    external fun setLatencyTracking(enabled: Boolean)
+
+    /**
+     * Clears the latency histograms.
+     */
+    @JvmStatic
+    external fun resetLatency()
+
+    @JvmStatic
+    private external fun latencyNames(): Array<String>
+    @JvmStatic
+    private external fun latencyValues(): LongArray
+
+    /**
+     * Takes a snapshot of the latency histograms, see [setLatencyTracking].
+     *
+     * @return The statistics of every entry point called since tracking was enabled or last reset.
+     */
+    fun latencySnapshot(): List<LatencyStats> = LatencyStats.decode(latencyNames(), latencyValues())
+
+    /**
+     * Configures the slow query log.
+     *
+     * Statements prepared while the log is enabled are followed, those whose execution exceeds the threshold are
+     * captured with their plan and record counts into a ring of the given capacity, the oldest captures are dropped
+     * when the ring is full.
+     *
+     * @param thresholdNanos The latency threshold in nanoseconds, 0 disables the log.
+     * @param capacity The maximum number of captures kept until drained.
+     */
+    @JvmStatic
+    external fun setSlowQueryLog(thresholdNanos: Long, capacity: Int)
+
+    /**
+     * Removes and returns the captures of the slow query log, see [setSlowQueryLog].
+     *
+     * @return The captured statements, oldest first.
+     */
+    @JvmStatic
+    external fun drainSlowQueries(): Array<SlowQuery>
+
+    /**
+     * Enables or disables the counting of the calls made to the client library.
+     *
+     * While disabled, calls go straight to the client library.
+     */
+    @JvmStatic
+    external fun setCallCounting(enabled: Boolean)
+
+    /**
+     * Clears the call counters.
+     */
+    @JvmStatic
+    external fun resetCallCounts()
+
+    @JvmStatic
+    private external fun callCountNames(): Array<String>
+    @JvmStatic
+    private external fun callCountValues(): LongArray
+
+    /**
+     * Takes a snapshot of the call counters, see [setCallCounting].
+     *
+     * @return The totals of every function of the client library called since counting was enabled or last reset.
+     */
+    fun callCounts(): List<CallStats> = CallStats.decode(callCountNames(), callCountValues())
+
+    /**
+     * Starts recording every call made to the client library, with its inputs and results, into a binary log.
+     *
+     * Calls made concurrently by several threads are interleaved in the log, record a single session to replay it.
+     *
+     * @param path The path of the log file, overwritten if it exists.
+     * @throws FirebirdException if the file cannot be created.
+     */
+    @JvmStatic
+    external fun startRecording(path: String)
+
+    /**
+     * Stops recording and closes the log file.
+     */
+    @JvmStatic
+    external fun stopRecording()
+
+    /**
+     * Serves the calls to the client library from a recorded log instead of the database.
+     *
+     * The recorded results are returned in sequence without network or server work, so the session must issue the
+     * same calls in the same order; a call out of sequence fails with a Firebird error.
+     *
+     * @param path The path of a log written by [startRecording].
+     * @throws FirebirdException if the file cannot be read or is not a recorded log.
+     */
+    @JvmStatic
+    external fun startReplay(path: String)
+
+    /**
+     * Stops replaying, calls go to the client library again.
+     */
+    @JvmStatic
+    external fun stopReplay()
+
+    @JvmStatic
+    private external fun createRowMapper(type: Class<*>, columns: IntArray, names: Array<String>,
+                                         signatures: Array<String>): HANDLE
+
+    /**
+     * Creates a mapper filling instances of a class from rows, without a getter call per column.
+     *
+     * Each bound field receives the value of its column through the getter matching the field type: Boolean,
+     * Short, Int, Long, Float, Double, their nullable boxes, String or ByteArray. Instances are built with the no-arg
+     * constructor when the class has one, otherwise allocated without running a constructor, so every property of a
+     * data class without defaults must be bound. Field ids are resolved once, here.
+     *
+     * @param type The class of the instances.
+     * @param bindings The name of the field receiving each column, by column index.
+     * @return The mapper handle, released with [freeRowMapper].
+     * @throws NoSuchFieldException if a bound field does not exist.
+     * @throws FirebirdException if a field type is not supported.
+     */
+    fun createRowMapper(type: Class<*>, bindings: Map<Int, String>): HANDLE {
+        val columns = bindings.keys.toIntArray()
+        val names = bindings.values.toTypedArray()
+        val signatures = Array(names.size) { i ->
+            val field = generateSequence<Class<*>>(type) { it.superclass }
+                .mapNotNull { c -> c.declaredFields.firstOrNull { it.name == names[i] } }
+                .firstOrNull() ?: throw NoSuchFieldException(names[i])
+            signature(field.type)
+        }
+        return createRowMapper(type, columns, names, signatures)
+    }
+
+    private fun signature(type: Class<*>): String = when {
+        type == java.lang.Boolean.TYPE -> "Z"
+        type == java.lang.Short.TYPE -> "S"
+        type == Integer.TYPE -> "I"
+        type == java.lang.Long.TYPE -> "J"
+        type == java.lang.Float.TYPE -> "F"
+        type == java.lang.Double.TYPE -> "D"
+        type.isArray -> type.name.replace('.', '/')
+        else -> "L${type.name.replace('.', '/')};"
+    }
+
+    /**
+     * Releases a mapper created by [createRowMapper].
+     */
+    @JvmStatic
+    external fun freeRowMapper(mapper: HANDLE)
+
+    /**
+     * Maps the current row of an XSQLDA, see [createRowMapper].
+     *
+     * @return A new instance of the mapper class.
+     */
+    @JvmStatic
+    external fun mapRow(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, mapper: HANDLE): Any
+
+    /**
+     * Fetches and maps up to count rows of a cursor in one call, see [createRowMapper].
+     *
+     * @return The mapped rows, fewer than count when the cursor is exhausted.
+     */
+    @JvmStatic
+    external fun mapRows(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, stHandle: HANDLE, sqlda: HANDLE,
+                         mapper: HANDLE, count: Int): Array<Any>
+
+    /** [writeJson] option: text blobs are read and inlined as strings, other blobs are written as their id. */
+    const val JSON_BLOB_TEXT = 1
+    /** [writeJson] option: each row is followed by a new line instead of rows being separated by commas. */
+    const val JSON_LINES = 2
+    /** [writeJson] option: the first row is preceded by a comma, continuing an array written by a previous call. */
+    const val JSON_CONTINUE = 4
+
+    /**
+     * Writes the current row of an XSQLDA as a UTF-8 JSON object keyed by column alias into a direct buffer.
+     *
+     * Numerics keep their scale, dates and times are ISO 8601 strings (in UTC with a Z suffix for values with a
+     * time zone, with their offset for the extended ones), binary text is base64 and NaN or infinities are null.
+     *
+     * @param buffer A direct buffer; its position and limit are ignored, see position.
+     * @param position The offset where the row is written.
+     * @param options A combination of the JSON_ options.
+     * @return The offset after the row, or -1 when the row does not fit; nothing is written then.
+     */
+    @JvmStatic
+    external fun writeJson(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, buffer: java.nio.ByteBuffer,
+                           position: Int, options: Int): Int
 
+    /**
+     * Writes the current row as [writeJson] does, then fetches and writes the following ones until count rows are
+     * written, the buffer is full or the cursor is exhausted.
+     *
+     * When the buffer fills, the row that did not fit stays current and is the first one written by the next call.
+     *
+     * @param state The offset where writing starts, updated, followed by the number of rows written, also updated when
+     * an exception is thrown, to cover the rows written before it.
+     * @return False when the cursor is exhausted.
+     */
+    @JvmStatic
+    external fun writeJsonRows(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, stHandle: HANDLE, sqlda: HANDLE,
+                               buffer: java.nio.ByteBuffer, state: IntArray, count: Int, options: Int): Boolean
 
+    /** [exportRows] option: tab separated values, tabs, new lines and backslashes are escaped and nulls are \N. */
+    const val CSV_TAB = 1
+    /** [exportRows] option: a line of column aliases is written first. */
+    const val CSV_HEADER = 2
+    /** [exportRows] option: text blobs are read and written as text, other blobs are written as their id. */
+    const val CSV_BLOB_TEXT = 4
+    /** [exportRows] option: full buffers are written by a separate thread while the next ones are formatted. */
+    const val CSV_WRITER_THREAD = 8
+    /** [exportRows] option: a file opened by path is appended to instead of truncated. */
+    const val CSV_APPEND = 16
+
+    /**
+     * Exports the current row and the following ones as CSV (RFC 4180) or TSV lines to a file, formatting the values
+     * natively into large buffers.
+     *
+     * Text is quoted in CSV so that an empty field is a null, binary text is base64 and numerics keep their scale;
+     * dates and times are ISO 8601, values with a time zone in UTC with a Z suffix, with their offset for the
+     * extended ones.
+     *
+     * Rows reach the file whole: when a row fails to export, the rows before it are written and the failing one is
+     * neither written nor counted.
+     *
+     * @param path The file to write, created when missing; when null, the rows are written to fd, which is left open.
+     * @param count The maximum number of rows to export, all the remaining rows when 0 or less.
+     * @param options A combination of the CSV_ options.
+     * @param progress The number of rows exported followed by the number of bytes written, both incremented.
+     * @return False when the cursor is exhausted.
+     */
+    @JvmStatic
+    external fun exportRows(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, stHandle: HANDLE, sqlda: HANDLE,
+                            path: String?, fd: Int, count: Int, options: Int, progress: LongArray): Boolean
+
+    /** [importRows] option: tab separated values, with the escapes and the \N nulls written by [exportRows]. */
+    const val IMPORT_TAB = 1
+    /** [importRows] option: the first record holds the column names and is skipped. */
+    const val IMPORT_HEADER = 2
+    /** [importRows] option: records failing to parse or to insert are counted and skipped instead of ending the import. */
+    const val IMPORT_CONTINUE = 4
+
+    /**
+     * Imports a CSV (RFC 4180) or TSV file into a prepared INSERT, UPDATE OR INSERT or MERGE statement, one record per
+     * execution, parsing the file natively in parallel.
+     *
+     * Fields follow the formats written by [exportRows]: an unquoted empty CSV field or an empty field of a non text
+     * column is a null, binary text is base64 and values with a time zone take a Z suffix or an offset. With a
+     * Firebird 4 client, records are sent in batches of batchSize messages through the batch interface; they may be
+     * inserted out of file order.
+     *
+     * @param sqlda The input XSQLDA of the statement, described.
+     * @param threads The number of parsing threads, the number of processors when 0 or less.
+     * @param options A combination of the IMPORT_ options.
+     * @param progress Receives the number of records inserted followed by the number of records rejected.
+     * @param rejected Receives the file offsets of the first rejected records, when not null.
+     */
+    @JvmStatic
+    external fun importRows(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, stHandle: HANDLE, sqlda: HANDLE,
+                            path: String, dialect: Int, batchSize: Int, threads: Int, options: Int, progress: LongArray,
+                            rejected: LongArray?)
+
+    /**
+     * Creates a spool, an off-heap store of rows in memory mapped temporary files deleted when the spool is freed or
+     * the process ends.
+     *
+     * @param directory The directory of the files, TMPDIR or the system temporary directory when null; on Android,
+     * pass the cache directory of the application.
+     * @return The spool handle, released with [freeSpool].
+     */
+    @JvmStatic
+    actual external fun createSpool(directory: String?): HANDLE
+
+    /**
+     * Releases a spool created by [createSpool] and deletes its files.
+     */
+    @JvmStatic
+    actual external fun freeSpool(spool: HANDLE)
+
+    /**
+     * Returns the number of rows stored in a spool, 0 once its files failed to grow.
+     */
+    @JvmStatic
+    actual external fun getSpoolCount(spool: HANDLE): Long
+
+    /**
+     * Appends the current row of an XSQLDA to a spool, then fetches and appends the following ones until count rows
+     * are stored or the cursor is exhausted.
+     *
+     * Rows keep their blob ids, which can only be opened while the transaction is active.
+     *
+     * @param count The maximum number of rows to store, all the remaining rows when 0 or less.
+     * @return False when the cursor is exhausted.
+     */
+    @JvmStatic
+    actual external fun spoolRows(status: HANDLE, stHandle: HANDLE, sqlda: HANDLE, spool: HANDLE, count: Int): Boolean
+
+    /**
+     * Restores a row of a spool into the XSQLDA it was fetched into, where the getters read it as a fetched row.
+     *
+     * @param row The number of the row, from 0.
+     * @return False when the spool has no such row; the XSQLDA is left unchanged then.
+     * @throws FirebirdException if the files of the spool failed to grow, its rows are lost then.
+     */
+    @JvmStatic
+    actual external fun spoolSeek(sqlda: HANDLE, spool: HANDLE, row: Long): Boolean
+
+    /**
+     * Creates a result cache, holding result sets in native memory up to maxBytes, least recently used first evicted.
+     *
+     * Entries tagged with event names are dropped when one of these events is posted, the cache listens to them on
+     * the attachment of dbHandle; free the cache before detaching it.
+     *
+     * @return The cache handle, released with [freeResultCache].
+     */
+    @JvmStatic
+    actual external fun createResultCache(dbHandle: HANDLE, maxBytes: Long): HANDLE
+
+    /**
+     * Releases a cache created by [createResultCache]; the rows returned by [cacheLookup] or [cacheRows] stay valid
+     * until they are released.
+     */
+    @JvmStatic
+    actual external fun freeResultCache(cache: HANDLE)
+
+    /**
+     * Looks up the rows of a query, counted as a hit or a miss.
+     *
+     * @param sql The SQL text of the query.
+     * @param input The input XSQLDA of the query with its parameters set, or 0 without parameters.
+     * @return The cached rows, released with [releaseCachedRows], or 0 on a miss.
+     */
+    @JvmStatic
+    actual external fun cacheLookup(cache: HANDLE, sql: String, input: HANDLE): HANDLE
+
+    /**
+     * Fetches every row of an executed cursor, from the first one, and stores them in a cache.
+     *
+     * The rows are not stored when one of the tags is posted while they are read, or when they exceed the memory
+     * limit of the cache; they are returned all the same.
+     *
+     * @param sql The SQL text of the query, see [cacheLookup].
+     * @param input The input XSQLDA the cursor was executed with, or 0.
+     * @param tags The events that invalidate the rows, at most 255 bytes each, or null.
+     * @return The rows, released with [releaseCachedRows].
+     */
+    @JvmStatic
+    actual external fun cacheRows(status: HANDLE, stHandle: HANDLE, sqlda: HANDLE, cache: HANDLE, sql: String,
+                                  input: HANDLE, tags: Array<String>?): HANDLE
+
+    /**
+     * Returns the number of rows returned by [cacheLookup] or [cacheRows].
+     */
+    @JvmStatic
+    actual external fun getCachedCount(rows: HANDLE): Long
+
+    /**
+     * Restores a row of cached rows into the XSQLDA of the query, where the getters read it as a fetched row.
+     *
+     * @param row The number of the row, from 0.
+     * @return False when there is no such row; the XSQLDA is left unchanged then.
+     */
+    @JvmStatic
+    actual external fun cacheSeek(sqlda: HANDLE, rows: HANDLE, row: Long): Boolean
+
+    /**
+     * Releases rows returned by [cacheLookup] or [cacheRows].
+     */
+    @JvmStatic
+    actual external fun releaseCachedRows(rows: HANDLE)
+
+    /**
+     * Drops the entries of a cache tagged with an event, or every entry when tag is null.
+     */
+    @JvmStatic
+    actual external fun cacheInvalidate(cache: HANDLE, tag: String?)
+
+    /**
+     * Returns the counters of a cache: hits, misses, entries, bytes, evictions and invalidations.
+     */
+    @JvmStatic
+    actual external fun getCacheStats(cache: HANDLE): LongArray
+
+    /**
+     * Returns the lower and upper bound of each dimension of an array column, as declared.
+     *
+     * The descriptor of the column is looked up on first use and cached until the attachment is detached.
+     */
+    @JvmStatic
+    external fun getArrayBounds(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int): IntArray
+
+    /**
+     * Reads a slice of an array of SMALLINT or INTEGER in one round trip, elements in row-major order.
+     *
+     * @param bounds The lower and upper bound of each dimension, within the declared ones, or null for the whole
+     * array.
+     */
+    @JvmStatic
+    external fun getArrayInt(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                             bounds: IntArray?): IntArray
+
+    /**
+     * Reads a slice of an array of FLOAT or DOUBLE PRECISION in one round trip, see [getArrayInt].
+     */
+    @JvmStatic
+    external fun getArrayDouble(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                                bounds: IntArray?): DoubleArray
+
+    /**
+     * Reads a slice of an array of any type straight into a direct buffer, elements in the native byte order and
+     * VARCHAR elements prefixed with their 2-byte length.
+     *
+     * @param buffer A direct buffer; its position and limit are ignored, see position.
+     * @param position The offset where the slice is written.
+     * @return The offset after the slice, or -1 when it does not fit; nothing is read then.
+     */
+    @JvmStatic
+    external fun getArrayBuffer(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                                bounds: IntArray?, buffer: java.nio.ByteBuffer, position: Int): Int
+
+    /**
+     * Names the column of an array parameter, for the parameters the server does not describe with their relation
+     * and field.
+     */
+    @JvmStatic
+    external fun setArrayColumn(sqlda: HANDLE, index: Int, relation: String, field: String)
+
+    /**
+     * Writes a slice of an array of INTEGER, BIGINT or DOUBLE PRECISION into a new array and sets its id into the
+     * parameter.
+     *
+     * Elements outside the slice keep the values of the array the parameter held, when it was not null.
+     *
+     * @param bounds The slice, see [getArrayInt].
+     * @param values The elements of the slice, in row-major order.
+     */
+    @JvmStatic
+    external fun setArrayInt(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                             bounds: IntArray?, values: IntArray)
+
+    /**
+     * Writes a slice of an array of DOUBLE PRECISION, see [setArrayInt].
+     */
+    @JvmStatic
+    external fun setArrayDouble(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                                bounds: IntArray?, values: DoubleArray)
+
+    /**
+     * Writes a slice of an array of any type straight from a direct buffer, in the layout of [getArrayBuffer], see
+     * [setArrayInt].
+     *
+     * @param length The length of the slice in bytes.
+     */
+    @JvmStatic
+    external fun setArrayBuffer(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                                bounds: IntArray?, buffer: java.nio.ByteBuffer, position: Int, length: Int)
+
+    /** [bindPacked] tag: null, without value. */
+    const val PACKED_NULL = 0
+    /** [bindPacked] tag: a boolean byte. */
+    const val PACKED_BOOLEAN = 1
+    /** [bindPacked] tag: a 16-bit integer. */
+    const val PACKED_SHORT = 2
+    /** [bindPacked] tag: a 32-bit integer. */
+    const val PACKED_INT = 3
+    /** [bindPacked] tag: a 64-bit integer. */
+    const val PACKED_LONG = 4
+    /** [bindPacked] tag: a 32-bit float. */
+    const val PACKED_FLOAT = 5
+    /** [bindPacked] tag: a 64-bit float. */
+    const val PACKED_DOUBLE = 6
+    /** [bindPacked] tag: UTF-8 text, a 32-bit length then the bytes. */
+    const val PACKED_STRING = 7
+    /** [bindPacked] tag: bytes, a 32-bit length then the bytes. */
+    const val PACKED_BYTES = 8
+    /** [bindPacked] tag: a 128-bit integer, its low then its high 64 bits. */
+    const val PACKED_INT128 = 9
+    /** [bindPacked] tag: a date, 32-bit days since 1970-01-01. */
+    const val PACKED_DATE = 10
+    /** [bindPacked] tag: a time, 32-bit milliseconds of the day. */
+    const val PACKED_TIME = 11
+    /** [bindPacked] tag: a timestamp, days then milliseconds. */
+    const val PACKED_TIMESTAMP = 12
+    /** [bindPacked] tag: a timestamp with time zone, days, milliseconds then the 32-bit time zone id. */
+    const val PACKED_TIMESTAMP_TZ = 13
+    /** [bindPacked] tag: a 64-bit blob id. */
+    const val PACKED_BLOB_ID = 14
+    /** [bindPacked] tag: leaves the parameter unchanged, without value. */
+    const val PACKED_SKIP = 15
+
+    /**
+     * Sets the parameters of an input XSQLDA from packed entries in one call, see [PackedParams].
+     *
+     * Each entry is a PACKED_ tag byte followed by the value in the native byte order; entries are bound in the order
+     * of the parameters until every parameter is bound or the entries end. Values are converted as the setValue*
+     * functions do, strings and byte arrays set into blob parameters create the blobs.
+     *
+     * @param buffer A direct buffer; its position and limit are ignored, see position.
+     * @param position The offset of the first entry.
+     * @param length The length of the entries.
+     * @return The offset after the last entry bound.
+     * @throws FirebirdException if an entry is malformed or a value does not convert.
+     */
+    @JvmStatic
+    external fun bindPacked(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, buffer: java.nio.ByteBuffer,
+                            position: Int, length: Int): Int
+
+    /** [executeMany] option: rows failing to execute are reported and skipped instead of ending the loop. */
+    const val EXECUTE_CONTINUE = 1
+
+    /**
+     * Executes a prepared statement once per row of packed entries in one call, for servers without the batch
+     * interface of Firebird 4.
+     *
+     * Each row is bound as [bindPacked] does and holds an entry per parameter, [PACKED_SKIP] keeping the value of the
+     * previous row. The status vector is cleared first and keeps the error of the last row that failed; without
+     * [EXECUTE_CONTINUE] the loop ends on the first failure.
+     *
+     * @param buffer A direct buffer; its position and limit are ignored, see position.
+     * @param position The offset of the first row.
+     * @param length The length of the rows.
+     * @param count The number of rows.
+     * @param options A combination of the EXECUTE_ options.
+     * @param codes Receives the status of each row executed, 0 or an error code, when not null.
+     * @param affected Receives the number of records inserted, updated or deleted by each row executed, -1 when
+     * unknown, when not null; the counts are requested from the server after each execution.
+     * @return The number of rows executed, including the rows that failed.
+     * @throws FirebirdException if an entry is malformed, a row ends before its last parameter or a value does not
+     * convert, the rows before it are executed.
+     */
+    @JvmStatic
+    external fun executeMany(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, stHandle: HANDLE, dialect: Short,
+                             sqlda: HANDLE, buffer: java.nio.ByteBuffer, position: Int, length: Int, count: Int,
+                             options: Int, codes: LongArray?, affected: LongArray?): Int
+
+    /**
+     * Creates a blob from a file and sets its id into a BLOB parameter, reading and writing the file natively in
+     * chunks of 64 KB so that its content is never held whole in memory.
+     *
+     * @param path The file to read; when null, the blob is read from fd up to its end, fd is left open.
+     * @return The number of bytes written.
+     * @throws FirebirdException if the parameter is not a blob, the file cannot be read or the blob written.
+     */
+    @JvmStatic
+    external fun setValueBlobFile(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                                  path: String?, fd: Int): Long
+
+    /**
+     * Creates a blob from a stream and sets its id into a BLOB parameter, reading the stream up to its end in chunks
+     * of 64 KB, each one written before the next is read. The stream is not closed.
+     *
+     * @return The number of bytes written.
+     * @throws FirebirdException if the parameter is not a blob or the blob cannot be written.
+     * @throws java.io.IOException if the stream cannot be read.
+     */
+    @JvmStatic
+    external fun setValueBlobStream(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int,
+                                    stream: java.io.InputStream): Long
+
+    /**
+     * Loads the Firebird client library from the given path, replacing the library loaded at startup.
+     *
+     * By default the library is taken from the `fbclient.library` system property, then from the `FBCLIENT_LIBRARY`
+     * environment variable, then from the system library path. Connections opened with the previous library must
+     * be closed first.
+     *
+     * @param path The path of the client library.
+     * @throws FirebirdException if the library cannot be loaded or misses an entry point.
+     */
+    @JvmStatic
+    external fun init(path: String)
+}
@@ -15,6 +15,10 @@ const val CLASS_INFO    = 2 // Code represents an information msg
 const val DSQL_close : Short = 1
 const val DSQL_drop	 : Short = 2
 
+const val OUTPUT_TIMESTAMP = 1 // times and timestamps with a time zone read without it, in the session time zone
+const val OUTPUT_BIGINT    = 2 // INT128 read as BIGINT with the same scale
+const val OUTPUT_VARCHAR   = 4 // CHAR read as VARCHAR, with the length of the value
+
 /**
  * Represents the data types for SQLDA fields.
  */
@@ -34,7 +38,8 @@ enum class DataType {
     TIME_TZ,
     DATETIME_TZ,
     BLOB_BINARY,
-    BLOB_TEXT
+    BLOB_TEXT,
+    ARRAY
 }
 
 enum class StatementType {
@@ -146,6 +151,7 @@ expect object API {
     fun attachDatabase(status: HANDLE, path: String, dbHandle: HANDLE, options: ByteArray?): STATUS
     fun createDatabase(status: HANDLE, path: String, dbHandle: HANDLE, options: ByteArray?): STATUS
     fun detachDatabase(status: HANDLE, dbHandle: HANDLE): STATUS
+    fun databaseInfo(status: HANDLE, dbHandle: HANDLE, items: ByteArray, length: Int): ByteArray
     fun executeImmediate(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sql: String, dialect: Short): STATUS
     fun startTransaction(status: HANDLE, trHandle: HANDLE, dbHandle: HANDLE, options: ByteArray?): STATUS
     fun commitTransaction(status: HANDLE, trHandle: HANDLE, retain: Boolean): STATUS
@@ -155,6 +161,8 @@ expect object API {
     fun getStatementType(status: HANDLE, stHandle: HANDLE): Int
     fun freeStatement(status: HANDLE, stHandle: HANDLE, action: Short): STATUS
     fun prepareParams(status: HANDLE, stHandle: HANDLE, dialect: Short, sqlda: HANDLE): STATUS
+    fun setTypes(sqlda: HANDLE, types: IntArray)
+    fun setOutputProfile(sqlda: HANDLE, profile: Int)
     fun execute(status: HANDLE, trHandle: HANDLE, stHandle: HANDLE, dialect: Short, sqlda: HANDLE): STATUS
     fun execute2(status: HANDLE, trHandle: HANDLE, stHandle: HANDLE, dialect: Short, input: HANDLE, output: HANDLE): STATUS
     fun fetch(status: HANDLE, stHandle: HANDLE, sqlda: HANDLE): STATUS
@@ -203,4 +211,24 @@ expect object API {
     fun blobLength(status: HANDLE, blobHandle: HANDLE): Long
     fun blobWrite(status: HANDLE, blobHandle: HANDLE, buffer: ByteArray, offset: Int, length: Int): Int
     fun blobCreate(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, blobHandle: HANDLE): Long
+
+    fun queEvents(status: HANDLE, dbHandle: HANDLE, names: Array<String>, listener: EventListener): HANDLE
+    fun cancelEvents(status: HANDLE, events: HANDLE): STATUS
+
+    fun createSpool(directory: String?): HANDLE
+    fun freeSpool(spool: HANDLE)
+    fun getSpoolCount(spool: HANDLE): Long
+    fun spoolRows(status: HANDLE, stHandle: HANDLE, sqlda: HANDLE, spool: HANDLE, count: Int): Boolean
+    fun spoolSeek(sqlda: HANDLE, spool: HANDLE, row: Long): Boolean
+
+    fun createResultCache(dbHandle: HANDLE, maxBytes: Long): HANDLE
+    fun freeResultCache(cache: HANDLE)
+    fun cacheLookup(cache: HANDLE, sql: String, input: HANDLE): HANDLE
+    fun cacheRows(status: HANDLE, stHandle: HANDLE, sqlda: HANDLE, cache: HANDLE, sql: String, input: HANDLE,
+                  tags: Array<String>?): HANDLE
+    fun getCachedCount(rows: HANDLE): Long
+    fun cacheSeek(sqlda: HANDLE, rows: HANDLE, row: Long): Boolean
+    fun releaseCachedRows(rows: HANDLE)
+    fun cacheInvalidate(cache: HANDLE, tag: String?)
+    fun getCacheStats(cache: HANDLE): LongArray
 }
\ No newline at end of file
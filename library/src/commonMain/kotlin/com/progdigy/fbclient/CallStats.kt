@@ -0,0 +1,33 @@
+package com.progdigy.fbclient
+
+/**
+ * The totals of the calls made to a function of the Firebird client library.
+ *
+ * @property name The name of the function, `dsql_fetch` for `isc_dsql_fetch`.
+ * @property calls The number of calls, each one is usually a round trip to the server.
+ * @property bytes The number of bytes moved: SQL text, parameter blocks, messages, blob segments and info buffers.
+ * @property errors The number of calls that returned an error status.
+ */
+data class CallStats(
+    val name: String,
+    val calls: Long,
+    val bytes: Long,
+    val errors: Long
+) {
+    companion object {
+        private const val FIELDS = 3
+
+        /**
+         * Decodes the raw values of the native counters, keeping the functions that were called.
+         *
+         * @param names The names of all the functions.
+         * @param values The calls, bytes and errors of each function, in the order of [names].
+         * @return The totals of the functions called at least once.
+         */
+        internal fun decode(names: Array<String>, values: LongArray): List<CallStats> =
+            names.indices.filter { values[it * FIELDS] > 0 }.map {
+                val offset = it * FIELDS
+                CallStats(names[it], values[offset], values[offset + 1], values[offset + 2])
+            }
+    }
+}
@@ -0,0 +1,16 @@
+package com.progdigy.fbclient
+
+/**
+ * Receives the events posted with POST_EVENT by committed transactions, see [Attachment.listen].
+ *
+ * The listener is called on a thread dedicated to it, never concurrently with itself.
+ */
+fun interface EventListener {
+    /**
+     * Called for each event posted since the previous call.
+     *
+     * @param name The name of the event.
+     * @param count The number of times the event was posted; events posted close together are reported at once.
+     */
+    fun onEvent(name: String, count: Int)
+}
@@ -0,0 +1,111 @@
+package com.progdigy.fbclient
+
+internal const val isc_info_end: Byte = 1
+internal const val isc_info_truncated: Byte = 2
+
+internal const val isc_info_reads: Byte = 5
+internal const val isc_info_writes: Byte = 6
+internal const val isc_info_fetches: Byte = 7
+internal const val isc_info_marks: Byte = 8
+internal const val isc_info_current_memory: Byte = 17
+internal const val isc_info_max_memory: Byte = 18
+
+/**
+ * A snapshot of the database I/O counters (see `perf.h`), obtained from a single `isc_database_info` call.
+ *
+ * @property fetches The number of page fetches from the page cache.
+ * @property reads The number of page reads from disk.
+ * @property writes The number of page writes to disk.
+ * @property marks The number of pages marked as modified in the page cache.
+ * @property currentMemory The amount of server memory currently in use, in bytes.
+ * @property maxMemory The peak amount of server memory used, in bytes.
+ */
+data class IoStats(
+    val fetches: Long,
+    val reads: Long,
+    val writes: Long,
+    val marks: Long,
+    val currentMemory: Long,
+    val maxMemory: Long
+) {
+    /**
+     * Computes the difference between two snapshots.
+     *
+     * Counters are subtracted, the memory peak is a high-water mark and keeps the value of this snapshot.
+     *
+     * @param other The earlier snapshot.
+     * @return The activity that took place between both snapshots.
+     */
+    operator fun minus(other: IoStats): IoStats = IoStats(
+        fetches = fetches - other.fetches,
+        reads = reads - other.reads,
+        writes = writes - other.writes,
+        marks = marks - other.marks,
+        currentMemory = currentMemory - other.currentMemory,
+        maxMemory = maxMemory
+    )
+
+    companion object {
+        internal val items = byteArrayOf(
+            isc_info_fetches,
+            isc_info_reads,
+            isc_info_writes,
+            isc_info_marks,
+            isc_info_current_memory,
+            isc_info_max_memory,
+            isc_info_end
+        )
+
+        // item + length + value (up to 64 bits) for each item, and the end marker
+        internal const val BUFFER_LENGTH = 128
+
+        /**
+         * Decodes the result buffer of an `isc_database_info` call.
+         *
+         * @param buffer The raw result buffer.
+         * @return The decoded snapshot, items missing from the buffer are set to zero.
+         * @throws FirebirdException if the result buffer is truncated.
+         */
+        internal fun parse(buffer: ByteArray): IoStats {
+            var fetches = 0L
+            var reads = 0L
+            var writes = 0L
+            var marks = 0L
+            var currentMemory = 0L
+            var maxMemory = 0L
+            var i = 0
+            while (i < buffer.size) {
+                val item = buffer[i++]
+                if (item == isc_info_end)
+                    break
+                if (item == isc_info_truncated || i + 2 > buffer.size)
+                    throw FirebirdException("Database information truncated")
+                val length = (buffer[i].toInt() and 0xFF) or ((buffer[i + 1].toInt() and 0xFF) shl 8)
+                i += 2
+                if (i + length > buffer.size)
+                    throw FirebirdException("Database information truncated")
+                val value = vaxInteger(buffer, i, length)
+                i += length
+                when (item) {
+                    isc_info_fetches -> fetches = value
+                    isc_info_reads -> reads = value
+                    isc_info_writes -> writes = value
+                    isc_info_marks -> marks = value
+                    isc_info_current_memory -> currentMemory = value
+                    isc_info_max_memory -> maxMemory = value
+                }
+            }
+            return IoStats(fetches, reads, writes, marks, currentMemory, maxMemory)
+        }
+
+        /**
+         * Reads a little-endian integer of variable length, as `isc_vax_integer` does.
+         */
+        private fun vaxInteger(buffer: ByteArray, offset: Int, length: Int): Long {
+            var value = 0L
+            for (n in 0 until minOf(length, 8))
+                value = value or ((buffer[offset + n].toLong() and 0xFF) shl (n * 8))
+            return value
+        }
+    }
+}
@@ -0,0 +1,61 @@
+package com.progdigy.fbclient
+
+/**
+ * The latency distribution of a native entry point, in nanoseconds.
+ *
+ * Names starting with `client.` measure calls into the Firebird client library (`client.dsql_fetch` times
+ * `isc_dsql_fetch`), names starting with `jni.` measure the time spent in a JNI function converting values,
+ * excluding the time spent in the client library.
+ *
+ * Percentiles come from log-linear buckets and are accurate to about 3%.
+ *
+ * @property name The name of the entry point.
+ * @property count The number of recorded calls.
+ * @property totalNanos The cumulated duration of the calls.
+ * @property maxNanos The longest call.
+ * @property p50 The median duration.
+ * @property p90 The 90th percentile.
+ * @property p99 The 99th percentile.
+ * @property p999 The 99.9th percentile.
+ */
+data class LatencyStats(
+    val name: String,
+    val count: Long,
+    val totalNanos: Long,
+    val maxNanos: Long,
+    val p50: Long,
+    val p90: Long,
+    val p99: Long,
+    val p999: Long
+) {
+    /**
+     * The mean duration of a call.
+     */
+    val meanNanos: Long get() = if (count > 0) totalNanos / count else 0
+
+    companion object {
+        private const val FIELDS = 7
+
+        /**
+         * Decodes the raw values of a native snapshot, keeping the entry points that were called.
+         *
+         * @param names The names of all the histograms.
+         * @param values The count, total, max, p50, p90, p99 and p999 of each histogram, in the order of [names].
+         * @return The statistics of the histograms with at least one recorded call.
+         */
+        internal fun decode(names: Array<String>, values: LongArray): List<LatencyStats> =
+            names.indices.filter { values[it * FIELDS] > 0 }.map {
+                val offset = it * FIELDS
+                LatencyStats(
+                    name = names[it],
+                    count = values[offset],
+                    totalNanos = values[offset + 1],
+                    maxNanos = values[offset + 2],
+                    p50 = values[offset + 3],
+                    p90 = values[offset + 4],
+                    p99 = values[offset + 5],
+                    p999 = values[offset + 6]
+                )
+            }
+    }
+}
@@ -9,16 +9,35 @@ import com.progdigy.fbclient.Attachment.Transaction.Statement
 class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE): AutoCloseable {
     var dialect: Short = 3
 
+    /**
+     * When set, every [transaction] block takes an [IoStats] snapshot before it starts and after it is committed, and
+     * reports the difference to this listener.
+     */
+    var onTransactionIoStats: ((IoStats) -> Unit)? = null
+
     private var cacheBlobs: Blob? = null
     private var cacheTransactions: Attachment.Transaction? = null
     private var cacheStatements: Attachment.Transaction.Statement? = null
     private var cacheRecord: Attachment.Transaction.Record? = null
     private var cacheRecordSet: Attachment.Transaction.Statement.RecordSet? = null
+    private val listeners = mutableListOf<Events>()
+    private val resultCaches = mutableListOf<ResultCache>()
 
     /**
-     * Closes the attachment by detaching the database.
+     * Closes the attachment by detaching the database, after cancelling the events still listened to and freeing the
+     * result caches.
      */
     override fun close() {
+        for (events in listeners) {
+            API.cancelEvents(status, events.handle)
+            events.handle = 0L
+        }
+        listeners.clear()
+        for (cache in resultCaches) {
+            API.freeResultCache(cache.handle)
+            cache.handle = 0L
+        }
+        resultCaches.clear()
         API.detachDatabase(status, dbHandle)
         API.freeHandle(dbHandle)
         API.freeStatusArray(status)
@@ -208,6 +227,21 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
              */
             fun getCount(): Int = API.getCount(sqlda)
 
+            /**
+             * Changes the types of the fields to the ones written or read by the client, the server converting the
+             * values once instead of the setters and getters; for instance a SMALLINT parameter set as LONG.
+             *
+             * The buffer is laid out again: the values and null indicators already set are reset, so the types are
+             * changed before binding any value.
+             *
+             * @param types The type of each field from the first one, null to keep the described type; the fields
+             * after the last type keep theirs.
+             * @throws FirebirdException if there are more types than fields or a field cannot take its type, a blob
+             * or an array; no field is changed then.
+             */
+            fun setTypes(vararg types: DataType?) =
+                API.setTypes(sqlda, IntArray(types.size) { types[it]?.ordinal ?: -1 })
+
             /**
              * Retrieves the SQL name for a given index.
              *
@@ -496,15 +530,30 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
              */
             inner class RecordSet(sqlda: HANDLE): SQLDA(sqlda) {
                 internal var next: RecordSet? = null
-                private var isEof = false
+                internal var isEof = false
                 val eof: Boolean
                     get() = isEof
 
+                /**
+                 * The rows of a result cache the records are read from instead of the cursor, see [open].
+                 */
+                var cachedRows: HANDLE = 0L
+                    set(value) {
+                        field = value
+                        cachedRow = 0L
+                    }
+                private var cachedRow = 0L
+
                 /**
                  * Fetches the next record from the record set.
                  */
                 fun fetch() {
-                    if (!isEof) {
+                    if (!isEof && cachedRows != 0L) {
+                        if (API.cacheSeek(sqlda, cachedRows, cachedRow))
+                            cachedRow++
+                        else
+                            isEof = true
+                    } else if (!isEof) {
                         when (val ret = API.fetch(status, stHandle, sqlda)) {
                             0L -> {
                                 // success
@@ -514,6 +563,57 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
                         }
                     }
                 }
+
+                /**
+                 * Stores the current record and the remaining ones in a spool, from which they are read again in
+                 * any order, and leaves the record set at its end.
+                 *
+                 * The spool is read through the record set, within the [open] block.
+                 *
+                 * @param directory The directory of the spool files on JVM and Android, see [API.createSpool]; the
+                 * native targets keep the records in memory.
+                 * @return The spool, closed to release it.
+                 * @throws FirebirdException if a fetch fails.
+                 */
+                fun spool(directory: String? = null): Spool {
+                    val spool = Spool(API.createSpool(directory))
+                    try {
+                        if (!isEof)
+                            API.spoolRows(status, stHandle, sqlda, spool.handle, 0)
+                    } catch (e: Throwable) {
+                        spool.close()
+                        throw e
+                    }
+                    isEof = true
+                    return spool
+                }
+
+                /**
+                 * Records stored by [spool].
+                 */
+                inner class Spool internal constructor(internal var handle: HANDLE): AutoCloseable {
+                    /**
+                     * The number of records stored.
+                     */
+                    val count: Long
+                        get() = API.getSpoolCount(handle)
+
+                    /**
+                     * Restores a record into the record set, where the getters read it.
+                     *
+                     * @param row The number of the record, from 0.
+                     * @return False when there is no such record; the record set is left unchanged then.
+                     */
+                    fun seek(row: Long): Boolean = API.spoolSeek(sqlda, handle, row)
+
+                    override fun close() {
+                        val spool = handle
+                        if (spool != 0L) {
+                            handle = 0L
+                            API.freeSpool(spool)
+                        }
+                    }
+                }
             }
 
             private fun getRecord(sqlda: HANDLE): Record {
@@ -563,6 +663,16 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
                     return _result!!
                 }
 
+            /**
+             * Has the server convert the output columns to the types the getters read best, before the statement
+             * is executed: time zone timestamps to timestamps in the session time zone (UTC for a session opened in
+             * UTC), INT128 to BIGINT, failing the fetch of a value beyond its range, and CHAR to VARCHAR.
+             *
+             * @param profile A combination of the OUTPUT_ flags.
+             */
+            fun setOutputProfile(profile: Int = OUTPUT_TIMESTAMP or OUTPUT_BIGINT or OUTPUT_VARCHAR) =
+                API.setOutputProfile(output, profile)
+
             /**
              * Executes the SQL statement.
              */
@@ -576,6 +686,8 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
                     cacheRecordSet = cache.next
                     cache.next = null
                     cache.sqlda = sqlda
+                    cache.isEof = false
+                    cache.cachedRows = 0L
                     cache
                 } else
                     RecordSet(sqlda)
@@ -604,6 +716,37 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
                 releaseRecordSet(scope)
             }
 
+            /**
+             * Opens the statement as [open], with the records served from a result cache when the query and its
+             * parameters are cached; otherwise every record is fetched and stored in the cache first.
+             *
+             * @param cache The cache of the records.
+             * @param sql The SQL text of the statement, the key of the records with the parameters.
+             * @param tags The events that drop the records from the cache when they are posted, or null.
+             * @param block The code block to execute within the record set's scope.
+             */
+            inline fun open(cache: ResultCache, sql: String, tags: Array<String>? = null, block: RecordSet.() -> Unit) {
+                var rows = API.cacheLookup(cache.handle, sql, input)
+                if (rows == 0L) {
+                    checkStatus(status, API.execute(status, trHandle, stHandle, dialect, input))
+                    try {
+                        rows = API.cacheRows(status, stHandle, output, cache.handle, sql, input, tags)
+                    } finally {
+                        checkStatus(status, API.freeStatement(status, stHandle, DSQL_close))
+                    }
+                }
+                val scope = getRecordSet(output)
+                try {
+                    scope.cachedRows = rows
+                    scope.fetch()
+                    scope.block()
+                } finally {
+                    scope.cachedRows = 0L
+                    API.releaseCachedRows(rows)
+                }
+                releaseRecordSet(scope)
+            }
+
             /**
              * Closes the statement and frees any associated resources.
              *
@@ -803,6 +946,88 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
         cacheTransactions = transaction
     }
 
+    /**
+     * Retrieves the database I/O counters.
+     *
+     * @return A snapshot of the counters, taken with a single database information request.
+     * @throws FirebirdException if the request fails.
+     */
+    fun ioStats(): IoStats = IoStats.parse(API.databaseInfo(status, dbHandle, IoStats.items, IoStats.BUFFER_LENGTH))
+
+    /**
+     * Events listened to by [listen], until closed.
+     */
+    inner class Events internal constructor(internal var handle: HANDLE): AutoCloseable {
+        /**
+         * Stops listening; the listener is not called anymore once this returns, unless it is the caller.
+         */
+        override fun close() {
+            val events = handle
+            if (events != 0L) {
+                handle = 0L
+                listeners.remove(this)
+                checkStatus(status, API.cancelEvents(status, events))
+            }
+        }
+    }
+
+    /**
+     * Listens to events posted with POST_EVENT by committed transactions, instead of polling for changes.
+     *
+     * The listener is called on a thread dedicated to these events, once for each event posted since the previous
+     * call with the number of times it was posted. Events are listened to until the returned [Events] or the
+     * attachment is closed.
+     *
+     * @param names The names of the events.
+     * @param listener Receives the name and the count of each event posted.
+     * @return The events listened to, closed to stop listening.
+     * @throws FirebirdException if the events cannot be queued.
+     */
+    fun listen(names: Iterable<String>, listener: EventListener): Events {
+        val events = Events(API.queEvents(status, dbHandle, names.toList().toTypedArray(), listener))
+        listeners.add(events)
+        return events
+    }
+
+    /**
+     * Result sets cached in memory by [Transaction.Statement.open], until closed.
+     */
+    inner class ResultCache internal constructor(var handle: HANDLE): AutoCloseable {
+        /**
+         * Drops the records tagged with an event, or every record when tag is null.
+         */
+        fun invalidate(tag: String? = null) = API.cacheInvalidate(handle, tag)
+
+        /**
+         * Returns the counters of the cache: hits, misses, entries, bytes, evictions and invalidations.
+         */
+        fun stats(): LongArray = API.getCacheStats(handle)
+
+        override fun close() {
+            val cache = handle
+            if (cache != 0L) {
+                handle = 0L
+                resultCaches.remove(this)
+                API.freeResultCache(cache)
+            }
+        }
+    }
+
+    /**
+     * Creates a cache of result sets read over and over, keyed by the SQL text and the parameters of the query.
+     *
+     * Records tagged with event names are dropped as soon as one of these events is posted, and the least recently
+     * used ones are evicted beyond the memory limit. The cache is freed when it or the attachment is closed.
+     *
+     * @param maxBytes The memory limit of the cache.
+     * @return The cache, closed to free it.
+     */
+    fun resultCache(maxBytes: Long): ResultCache {
+        val cache = ResultCache(API.createResultCache(dbHandle, maxBytes))
+        resultCaches.add(cache)
+        return cache
+    }
+
     /**
      * Executes the given transaction block within a transaction.
      *
@@ -815,8 +1040,11 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
      * @param block The block of code to execute within the transaction.
      *
      * @see Transaction
+     * @see onTransactionIoStats
      */
     inline fun transaction(tpb: ByteArray? = null, block: Transaction.() -> Unit) {
+        val listener = onTransactionIoStats
+        val before = if (listener != null) ioStats() else null
         val trHandle = API.allocHandle()
         checkStatus(status, API.startTransaction(status, trHandle, dbHandle, tpb))
         val scope = getTransaction(trHandle)
@@ -831,6 +1059,8 @@ class Attachment private constructor(val status: HANDLE, val dbHandle: HANDLE):
             scope.commit()
         }
         releaseTransaction(scope)
+        if (listener != null && before != null)
+            listener(ioStats() - before)
     }
 
     /**
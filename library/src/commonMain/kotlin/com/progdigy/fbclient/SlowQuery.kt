@@ -0,0 +1,27 @@
+package com.progdigy.fbclient
+
+/**
+ * A statement that exceeded the threshold of the slow query log.
+ *
+ * The elapsed time is the time spent in the client library executing the statement and, for a cursor, fetching
+ * its records until the end was reached or the cursor was closed.
+ *
+ * @property sql The SQL text of the statement.
+ * @property parameters The types of the input parameters, separated by commas.
+ * @property elapsedNanos The elapsed time in nanoseconds.
+ * @property selected The number of records selected.
+ * @property inserted The number of records inserted.
+ * @property updated The number of records updated.
+ * @property deleted The number of records deleted.
+ * @property plan The explained plan on Firebird 3 and later, the legacy plan otherwise, null when not available.
+ */
+data class SlowQuery(
+    val sql: String,
+    val parameters: String,
+    val elapsedNanos: Long,
+    val selected: Long,
+    val inserted: Long,
+    val updated: Long,
+    val deleted: Long,
+    val plan: String?
+)
@@ -1,10 +1,17 @@
 import com.progdigy.fbclient.*
 import com.progdigy.fbclient.Attachment.Transaction
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
 import kotlin.test.Test
 import kotlin.test.assertContentEquals
 import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNotNull
+import kotlin.test.assertTrue
 
 expect fun Testing.getTestDBPath(): String
 expect fun Testing.deleteTestDB(path: String)
@@ -191,6 +198,209 @@ class Testing {
         }
     }
 
+    @Test
+    fun ioStats() {
+        attachment {
+            var delta: IoStats? = null
+            onTransactionIoStats = { delta = it }
+            transaction {
+                createTable()
+                commitRetaining()
+                createData(10)
+            }
+            onTransactionIoStats = null
+
+            assertTrue(ioStats().fetches > 0)
+            assertNotNull(delta)
+            assertTrue(delta!!.fetches > 0)
+        }
+    }
+
+    @Test
+    fun parameterTypes() {
+        attachment {
+            transaction {
+                statement("select cast(? as smallint) from RDB\$DATABASE") {
+                    params.setTypes(DataType.LONG)
+                    assertEquals(DataType.LONG, params.getType(0))
+                    params.setLong(0, 1234L)
+                    open {
+                        assertEquals(DataType.SHORT, getType(0))
+                        assertEquals(1234.toShort(), getShort(0))
+                    }
+                }
+
+                statement("select cast(? as blob sub_type text) from RDB\$DATABASE") {
+                    assertFailsWith<FirebirdException> { params.setTypes(DataType.LONG) }
+                    assertFailsWith<FirebirdException> { params.setTypes(null, DataType.LONG) }
+                    assertEquals(DataType.BLOB_TEXT, params.getType(0))
+                }
+            }
+        }
+    }
+
+    @Test
+    fun outputProfile() {
+        attachment {
+            transaction {
+                // the timestamp is converted to and from the session time zone, whichever it is
+                statement("""
+                    select
+                        cast(? as int128),
+                        cast(? as char(8)),
+                        cast(cast(? as timestamp) as timestamp with time zone)
+                    from RDB\$DATABASE
+                """.trimIndent()) {
+                    assertEquals(DataType.INT128, result.getType(0))
+                    assertEquals(DataType.DATETIME_TZ, result.getType(2))
+                    setOutputProfile()
+                    assertEquals(DataType.LONG, result.getType(0))
+                    assertEquals(DataType.STRING, result.getType(1))
+                    assertEquals(DataType.DATETIME, result.getType(2))
+
+                    params.apply {
+                        setLong(0, Long.MAX_VALUE)
+                        setString(1, "firebird")
+                        setEpochDays(2, 19737) // 2024-01-15
+                        setMillisecondOfDay(2, 12 * 3600 * 1000)
+                    }
+                    open {
+                        assertEquals(Long.MAX_VALUE, getLong(0))
+                        assertEquals("firebird", getString(1))
+                        assertEquals(19737, getEpochDays(2))
+                        assertEquals(12 * 3600 * 1000, getMillisecondOfDay(2))
+                    }
+                }
+            }
+        }
+    }
+
+    private fun Attachment.postEvent() {
+        execute("""
+                    EXECUTE BLOCK AS
+                    BEGIN
+                        POST_EVENT 'TEST_EVENT';
+                    END
+                    """.trimIndent()
+        )
+    }
+
+    @Test
+    fun events() {
+        attachment {
+            val received = Channel<Pair<String, Int>>(Channel.UNLIMITED)
+            val events = listen(listOf("TEST_EVENT")) { name, count -> received.trySend(name to count) }
+            try {
+                // each commit posts the event once, commits close together may be reported at once
+                postEvent()
+                postEvent()
+                var total = 0
+                runBlocking {
+                    withTimeout(10_000) {
+                        while (total < 2) {
+                            val (name, count) = received.receive()
+                            assertEquals("TEST_EVENT", name)
+                            total += count
+                        }
+                    }
+                }
+                assertEquals(2, total)
+            } finally {
+                events.close()
+            }
+
+            postEvent()
+            runBlocking { delay(500) }
+            assertTrue(received.tryReceive().isFailure)
+        }
+    }
+
+    @Test
+    fun resultCache() {
+        attachment {
+            transaction {
+                createTable()
+                commitRetaining()
+                createData(10)
+            }
+            val cache = resultCache(1L shl 20)
+            val sql = "SELECT ID FROM TEST_TABLE WHERE ID > ? ORDER BY ID"
+            fun read(): Int {
+                var rows = 0
+                transaction {
+                    statement(sql) {
+                        params.setInt(0, 0)
+                        open(cache, sql, arrayOf("TEST_EVENT")) {
+                            while (!eof) {
+                                assertEquals(++rows, getInt(0))
+                                fetch()
+                            }
+                        }
+                    }
+                }
+                return rows
+            }
+            try {
+                assertEquals(10, read())
+                assertEquals(10, read())
+                // hits, misses, entries
+                assertContentEquals(longArrayOf(1, 1, 1), cache.stats().copyOf(3))
+
+                // served from the cache until the event is posted
+                transaction { createData(5) }
+                assertEquals(10, read())
+                postEvent()
+                runBlocking {
+                    withTimeout(10_000) {
+                        while (cache.stats()[5] == 0L)
+                            delay(50)
+                    }
+                }
+                assertEquals(0L, cache.stats()[2])
+                assertEquals(15, read())
+                assertContentEquals(longArrayOf(2, 2, 1), cache.stats().copyOf(3))
+            } finally {
+                cache.close()
+            }
+        }
+    }
+
+    @Test
+    fun spool() {
+        attachment {
+            transaction {
+                createTable()
+                commitRetaining()
+                createData(100)
+                commitRetaining()
+
+                statement("SELECT ID, DESCRIPTION FROM TEST_TABLE ORDER BY ID") {
+                    open {
+                        val spool = spool()
+                        try {
+                            assertTrue(eof)
+                            assertEquals(100L, spool.count)
+                            // twice, the second time backwards
+                            for (row in 0L until spool.count) {
+                                assertTrue(spool.seek(row))
+                                assertEquals(row.toInt() + 1, getInt(0))
+                                assertEquals("data", getString(1))
+                            }
+                            for (row in spool.count - 1 downTo 0L) {
+                                assertTrue(spool.seek(row))
+                                assertEquals(row.toInt() + 1, getInt(0))
+                            }
+                            assertFalse(spool.seek(spool.count))
+                            assertEquals(1, getInt(0))
+                        } finally {
+                            spool.close()
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     inner class DBPool(size: Int, private val db: String): Pool<Attachment>(size) {
         override fun newInstance(): Attachment {
             return Attachment.attachDatabase(db, dpb)
@@ -0,0 +1,132 @@
+package com.progdigy.fbclient
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Writes the parameters of a statement as packed entries, bound in one call by [API.bindPacked].
+ *
+ * Entries are appended in the order of the parameters, from the first one; a parameter without an entry is left
+ * unchanged. Values are converted as the setters of [Attachment.Transaction.SQLDA] do. Rows of entries, each with an
+ * entry per parameter, can follow each other to be executed by [executeMany].
+ *
+ * @param capacity The initial capacity of the buffer in bytes, it grows as needed.
+ */
+class PackedParams(capacity: Int = 1024) {
+    /**
+     * The direct buffer holding the entries, from 0 to [position]; replaced when it grows.
+     */
+    var buffer: ByteBuffer = ByteBuffer.allocateDirect(capacity).order(ByteOrder.nativeOrder())
+        private set
+
+    /**
+     * The length of the entries written.
+     */
+    val position: Int get() = buffer.position()
+
+    /**
+     * Removes every entry.
+     */
+    fun clear(): PackedParams {
+        buffer.clear()
+        return this
+    }
+
+    fun putNull() = tag(API.PACKED_NULL, 0)
+
+    /**
+     * Leaves the parameter unchanged.
+     */
+    fun skip() = tag(API.PACKED_SKIP, 0)
+
+    fun putBoolean(value: Boolean) = tag(API.PACKED_BOOLEAN, 1).also { buffer.put(if (value) 1 else 0) }
+
+    fun putShort(value: Short) = tag(API.PACKED_SHORT, 2).also { buffer.putShort(value) }
+
+    fun putInt(value: Int) = tag(API.PACKED_INT, 4).also { buffer.putInt(value) }
+
+    fun putLong(value: Long) = tag(API.PACKED_LONG, 8).also { buffer.putLong(value) }
+
+    fun putFloat(value: Float) = tag(API.PACKED_FLOAT, 4).also { buffer.putFloat(value) }
+
+    fun putDouble(value: Double) = tag(API.PACKED_DOUBLE, 8).also { buffer.putDouble(value) }
+
+    fun putString(value: String) = putBytes(API.PACKED_STRING, value.encodeToByteArray())
+
+    fun putByteArray(value: ByteArray) = putBytes(API.PACKED_BYTES, value)
+
+    /**
+     * @param low The low 64 bits, as returned by [API.getValueInt128].
+     * @param high The high 64 bits.
+     */
+    fun putInt128(low: Long, high: Long) = tag(API.PACKED_INT128, 16).also { buffer.putLong(low).putLong(high) }
+
+    /**
+     * @param days The days since 1970-01-01.
+     */
+    fun putEpochDays(days: Int) = tag(API.PACKED_DATE, 4).also { buffer.putInt(days) }
+
+    fun putMillisecondOfDay(millis: Int) = tag(API.PACKED_TIME, 4).also { buffer.putInt(millis) }
+
+    fun putDateTime(days: Int, millis: Int) = tag(API.PACKED_TIMESTAMP, 8).also { buffer.putInt(days).putInt(millis) }
+
+    fun putDateTime(days: Int, millis: Int, zone: TimeZoneId) =
+        tag(API.PACKED_TIMESTAMP_TZ, 12).also { buffer.putInt(days).putInt(millis).putInt(zone.id) }
+
+    fun putBlobId(value: Long) = tag(API.PACKED_BLOB_ID, 8).also { buffer.putLong(value) }
+
+    /**
+     * Appends a value of the primitive types, strings or byte arrays, null for a null parameter.
+     *
+     * @throws FirebirdException if the type is not supported
+     */
+    fun put(value: Any?) {
+        when (value) {
+            null -> putNull()
+            is Boolean -> putBoolean(value)
+            is Byte -> putShort(value.toShort())
+            is Short -> putShort(value)
+            is Int -> putInt(value)
+            is Long -> putLong(value)
+            is Float -> putFloat(value)
+            is Double -> putDouble(value)
+            is String -> putString(value)
+            is ByteArray -> putByteArray(value)
+            else -> throw FirebirdException("unhandled data type $value")
+        }
+    }
+
+    /**
+     * Binds the entries to the parameters of an input XSQLDA.
+     */
+    fun bind(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE) {
+        API.bindPacked(status, dbHandle, trHandle, sqlda, buffer, 0, position)
+    }
+
+    /**
+     * Executes a statement once per row of entries, see [API.executeMany].
+     *
+     * @param count The number of rows written.
+     * @return The number of rows executed.
+     */
+    fun executeMany(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, stHandle: HANDLE, dialect: Short, sqlda: HANDLE,
+                    count: Int, options: Int = 0, codes: LongArray? = null, affected: LongArray? = null): Int =
+        API.executeMany(status, dbHandle, trHandle, stHandle, dialect, sqlda, buffer, 0, position, count, options, codes,
+            affected)
+
+    private fun putBytes(tag: Int, value: ByteArray) {
+        tag(tag, 4 + value.size)
+        buffer.putInt(value.size).put(value)
+    }
+
+    private fun tag(tag: Int, size: Int) {
+        if (buffer.remaining() < 1 + size) {
+            val grown = ByteBuffer.allocateDirect(maxOf(buffer.capacity() * 2, buffer.position() + 1 + size))
+                .order(ByteOrder.nativeOrder())
+            buffer.flip()
+            grown.put(buffer)
+            buffer = grown
+        }
+        buffer.put(tag.toByte())
+    }
+}
@@ -0,0 +1,624 @@
+import com.progdigy.fbclient.*
+import com.progdigy.fbclient.Attachment.Transaction
+import java.io.ByteArrayInputStream
+import java.io.File
+import java.io.IOException
+import java.io.InputStream
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+private fun Transaction.createCustomers(count: Int) {
+    execute("""
+                    CREATE TABLE CUSTOMER (
+                        ID INT NOT NULL PRIMARY KEY,
+                        NAME VARCHAR(32),
+                        BALANCE DOUBLE PRECISION
+                    );
+                    """.trimIndent()
+    )
+    commitRetaining()
+    statement("INSERT INTO CUSTOMER (ID, NAME, BALANCE) VALUES (?, ?, ?)") {
+        for (id in 1..count) {
+            params.setInt(0, id)
+            params.setString(1, "name $id")
+            if (id % 2 == 0)
+                params.setDouble(2, id * 1.5)
+            else
+                params.setIsNull(2)
+            execute()
+        }
+    }
+    commitRetaining()
+}
+
+// the text written by the native code from the start of a direct buffer, whose position it leaves unchanged
+private fun ByteBuffer.text(length: Int): String {
+    val bytes = ByteArray(length)
+    duplicate().get(bytes)
+    return bytes.decodeToString()
+}
+
+private fun customer(id: Int) = JniTesting.Customer(id, "name $id", if (id % 2 == 0) id * 1.5 else null)
+
+/**
+ * Tests of the functions of the JNI layer that the native targets do not have, against the embedded database.
+ */
+class JniTesting {
+    private val testing = Testing()
+
+    data class Customer(val id: Int, val name: String?, val balance: Double?)
+
+    @Test
+    fun mapRows() {
+        testing.attachment {
+            transaction {
+                createCustomers(10)
+
+                statement("SELECT ID, NAME, BALANCE FROM CUSTOMER ORDER BY ID") {
+                    val bindings = mapOf(0 to "id", 1 to "name", 2 to "balance")
+                    val mapper = API.createRowMapper(Customer::class.java, bindings)
+                    try {
+                        open {
+                            assertEquals(customer(1), API.mapRow(status, dbHandle, trHandle, sqlda, mapper))
+                            // fetched from the row after the current one, the last batch is shorter
+                            val rows = API.mapRows(status, dbHandle, trHandle, stHandle, sqlda, mapper, 6)
+                            assertContentEquals((2..7).map { customer(it) }, rows.toList())
+                            val last = API.mapRows(status, dbHandle, trHandle, stHandle, sqlda, mapper, 6)
+                            assertContentEquals((8..10).map { customer(it) }, last.toList())
+                        }
+                    } finally {
+                        API.freeRowMapper(mapper)
+                    }
+                }
+            }
+        }
+    }
+
+    @Test
+    fun writeJson() {
+        testing.attachment {
+            transaction {
+                createCustomers(3)
+
+                statement("SELECT ID, NAME, BALANCE FROM CUSTOMER ORDER BY ID") {
+                    val buffer = ByteBuffer.allocateDirect(4096)
+                    open {
+                        // nothing is written when the row does not fit
+                        assertEquals(-1, API.writeJson(status, dbHandle, trHandle, sqlda, buffer, 4090, 0))
+                        val end = API.writeJson(status, dbHandle, trHandle, sqlda, buffer, 0, 0)
+                        assertEquals("""{"ID":1,"NAME":"name 1","BALANCE":null}""", buffer.text(end))
+
+                        val state = intArrayOf(0, 0)
+                        assertFalse(API.writeJsonRows(status, dbHandle, trHandle, stHandle, sqlda, buffer, state, 10,
+                            API.JSON_LINES))
+                        assertEquals(3, state[1])
+                        val lines = buffer.text(state[0]).lines()
+                        assertEquals(4, lines.size)
+                        assertEquals(lines[0], buffer.text(end))
+                        assertEquals("""{"ID":3,"NAME":"name 3","BALANCE":null}""", lines[2])
+                        assertEquals("", lines[3])
+                    }
+                }
+            }
+        }
+    }
+
+    @Test
+    fun exportRows() {
+        testing.attachment {
+            val file = File.createTempFile("fbtest", ".csv")
+            try {
+                transaction {
+                    createCustomers(3)
+
+                    statement("SELECT ID, NAME FROM CUSTOMER ORDER BY ID") {
+                        val progress = LongArray(2)
+                        open {
+                            // the rows exported by a call, continued by the next one
+                            assertTrue(API.exportRows(status, dbHandle, trHandle, stHandle, sqlda, file.path, -1, 2,
+                                API.CSV_HEADER, progress))
+                            assertEquals(2L, progress[0])
+                            assertFalse(API.exportRows(status, dbHandle, trHandle, stHandle, sqlda, file.path, -1, 0,
+                                API.CSV_APPEND, progress))
+                            assertEquals(3L, progress[0])
+                        }
+                        val expected = "\"ID\",\"NAME\"\n1,\"name 1\"\n2,\"name 2\"\n3,\"name 3\"\n"
+                        assertEquals(expected, file.readText())
+                        assertEquals(file.length(), progress[1])
+                    }
+
+                    statement("SELECT ID, NAME, BALANCE FROM CUSTOMER WHERE ID = 1") {
+                        val progress = LongArray(2)
+                        open {
+                            API.exportRows(status, dbHandle, trHandle, stHandle, sqlda, file.path, -1, 0, API.CSV_TAB,
+                                progress)
+                        }
+                        assertEquals("1\tname 1\t\\N\n", file.readText())
+                    }
+                }
+            } finally {
+                file.delete()
+            }
+        }
+    }
+
+    @Test
+    fun importRows() {
+        testing.attachment {
+            val file = File.createTempFile("fbtest", ".csv")
+            val content = "ID,NAME,BALANCE\n1,\"one\",1.5\n2,,\nx,\"bad\",\n3,\"three\",2\n"
+            file.writeText(content)
+            try {
+                transaction {
+                    createCustomers(0)
+
+                    statement("INSERT INTO CUSTOMER (ID, NAME, BALANCE) VALUES (?, ?, ?)") {
+                        val progress = LongArray(2)
+                        val rejected = LongArray(4)
+                        API.importRows(status, dbHandle, trHandle, stHandle, params.sqlda, file.path, dialect.toInt(),
+                            2, 1, API.IMPORT_HEADER or API.IMPORT_CONTINUE, progress, rejected)
+                        assertContentEquals(longArrayOf(3, 1), progress)
+                        assertEquals(content.indexOf("x,").toLong(), rejected[0])
+                    }
+
+                    statement("SELECT ID, NAME, BALANCE FROM CUSTOMER ORDER BY ID") {
+                        open {
+                            assertEquals(1, getInt(0))
+                            assertEquals("one", getString(1))
+                            assertEquals(1.5, getDouble(2))
+                            fetch()
+                            // an unquoted empty field is a null
+                            assertEquals(2, getInt(0))
+                            assertTrue(getIsNull(1))
+                            assertTrue(getIsNull(2))
+                            fetch()
+                            assertEquals(3, getInt(0))
+                            assertEquals("three", getString(1))
+                            assertEquals(2.0, getDouble(2))
+                            fetch()
+                            assertTrue(eof)
+                        }
+                    }
+                }
+            } finally {
+                file.delete()
+            }
+        }
+    }
+
+    @Test
+    fun arrays() {
+        testing.attachment {
+            transaction {
+                execute("""
+                    CREATE TABLE SERIES (
+                        ID INT NOT NULL PRIMARY KEY,
+                        SAMPLES INT[1:4],
+                        GRID DOUBLE PRECISION[0:1, 0:2]
+                    );
+                    """.trimIndent()
+                )
+                commitRetaining()
+                val grid = doubleArrayOf(0.5, 1.5, 2.5, 3.5, 4.5, 5.5)
+
+                statement("INSERT INTO SERIES (ID, SAMPLES, GRID) VALUES (1, ?, ?)") {
+                    API.setArrayColumn(params.sqlda, 0, "SERIES", "SAMPLES")
+                    API.setArrayColumn(params.sqlda, 1, "SERIES", "GRID")
+                    API.setArrayInt(status, dbHandle, trHandle, params.sqlda, 0, null, intArrayOf(1, 2, 3, 4))
+                    API.setArrayDouble(status, dbHandle, trHandle, params.sqlda, 1, null, grid)
+                    execute()
+                }
+
+                statement("SELECT SAMPLES, GRID FROM SERIES WHERE ID = 1") {
+                    open {
+                        assertContentEquals(intArrayOf(1, 4), API.getArrayBounds(status, dbHandle, trHandle, sqlda, 0))
+                        assertContentEquals(intArrayOf(0, 1, 0, 2),
+                            API.getArrayBounds(status, dbHandle, trHandle, sqlda, 1))
+                        assertContentEquals(intArrayOf(1, 2, 3, 4),
+                            API.getArrayInt(status, dbHandle, trHandle, sqlda, 0, null))
+                        assertContentEquals(intArrayOf(2, 3),
+                            API.getArrayInt(status, dbHandle, trHandle, sqlda, 0, intArrayOf(2, 3)))
+                        assertContentEquals(grid, API.getArrayDouble(status, dbHandle, trHandle, sqlda, 1, null))
+                        // the second row of the grid
+                        assertContentEquals(doubleArrayOf(3.5, 4.5, 5.5),
+                            API.getArrayDouble(status, dbHandle, trHandle, sqlda, 1, intArrayOf(1, 1, 0, 2)))
+
+                        val buffer = ByteBuffer.allocateDirect(64).order(ByteOrder.nativeOrder())
+                        assertEquals(-1, API.getArrayBuffer(status, dbHandle, trHandle, sqlda, 0, null, buffer, 56))
+                        assertEquals(16, API.getArrayBuffer(status, dbHandle, trHandle, sqlda, 0, null, buffer, 0))
+                        assertContentEquals(intArrayOf(1, 2, 3, 4), IntArray(4) { buffer.getInt(it * 4) })
+                    }
+                }
+            }
+        }
+    }
+
+    @Test
+    fun bindPacked() {
+        testing.attachment {
+            transaction {
+                val table = "RDB\$DATABASE"
+                statement("""
+                    select
+                        cast(? as int),
+                        cast(? as varchar(10)),
+                        cast(? as double precision),
+                        cast(? as bigint),
+                        cast(? as date),
+                        cast(? as blob sub_type text)
+                    from $table
+                """.trimIndent()) {
+                    val packed = PackedParams(16)
+                    packed.putInt(42)
+                    packed.putString("héllo")
+                    packed.putNull()
+                    packed.putLong(Long.MAX_VALUE)
+                    packed.putEpochDays(19737)
+                    packed.putString("lorem ipsum")
+                    // grown past its initial capacity
+                    assertEquals(packed.position, API.bindPacked(status, dbHandle, trHandle, params.sqlda,
+                        packed.buffer, 0, packed.position))
+                    open {
+                        assertEquals(42, getInt(0))
+                        assertEquals("héllo", getString(1))
+                        assertTrue(getIsNull(2))
+                        assertEquals(Long.MAX_VALUE, getLong(3))
+                        assertEquals(19737, getEpochDays(4))
+                        assertEquals("lorem ipsum", getString(5))
+                    }
+
+                    // a skipped parameter and the ones without an entry keep their values
+                    packed.clear().skip()
+                    packed.put("world")
+                    packed.bind(status, dbHandle, trHandle, params.sqlda)
+                    open {
+                        assertEquals(42, getInt(0))
+                        assertEquals("world", getString(1))
+                        assertEquals(Long.MAX_VALUE, getLong(3))
+                    }
+                }
+            }
+        }
+    }
+
+    @Test
+    fun executeMany() {
+        testing.attachment {
+            transaction {
+                createCustomers(0)
+
+                statement("INSERT INTO CUSTOMER (ID, NAME, BALANCE) VALUES (?, ?, ?)") {
+                    val packed = PackedParams()
+                    // the third row repeats the key of the first one
+                    for (id in listOf(1, 2, 1, 3)) {
+                        packed.putInt(id)
+                        packed.putString("name $id")
+                        packed.putNull()
+                    }
+                    val codes = LongArray(4)
+                    val affected = LongArray(4)
+                    assertEquals(4, packed.executeMany(status, dbHandle, trHandle, stHandle, dialect, params.sqlda, 4,
+                        API.EXECUTE_CONTINUE, codes, affected))
+                    assertEquals(0L, codes[0])
+                    assertTrue(codes[2] != 0L)
+                    assertEquals(0L, codes[3])
+                    assertContentEquals(longArrayOf(1, 1, -1, 1), affected)
+
+                    // a skipped parameter keeps the value of the previous row
+                    packed.clear()
+                    packed.putInt(4)
+                    packed.skip()
+                    packed.putDouble(6.0)
+                    // a row ending before its last parameter fails, the rows before it are executed
+                    packed.putInt(5)
+                    assertFailsWith<FirebirdException> {
+                        packed.executeMany(status, dbHandle, trHandle, stHandle, dialect, params.sqlda, 2)
+                    }
+                }
+
+                // every row slower than 1 ns is captured when it is executed
+                API.setSlowQueryLog(1, 8)
+                try {
+                    statement("INSERT INTO CUSTOMER (ID, NAME) VALUES (?, ?)") {
+                        val packed = PackedParams()
+                        for (id in 10..11) {
+                            packed.putInt(id)
+                            packed.putString("name $id")
+                        }
+                        assertEquals(2, packed.executeMany(status, dbHandle, trHandle, stHandle, dialect, params.sqlda,
+                            2))
+                        val queries = API.drainSlowQueries()
+                        assertEquals(2, queries.size)
+                        for (query in queries) {
+                            assertEquals("INSERT INTO CUSTOMER (ID, NAME) VALUES (?, ?)", query.sql)
+                            assertEquals(1L, query.inserted)
+                        }
+                    }
+                } finally {
+                    API.setSlowQueryLog(0, 0)
+                }
+
+                statement("SELECT ID, NAME, BALANCE FROM CUSTOMER WHERE ID > 2 AND ID < 10 ORDER BY ID") {
+                    open {
+                        assertEquals(3, getInt(0))
+                        fetch()
+                        assertEquals(4, getInt(0))
+                        assertEquals("name 3", getString(1))
+                        assertEquals(6.0, getDouble(2))
+                        fetch()
+                        assertTrue(eof)
+                    }
+                }
+            }
+        }
+    }
+
+    @Test
+    fun blobSources() {
+        testing.attachment {
+            // several chunks of 64 KB, the last one partial
+            val data = ByteArray(200_000) { (it % 251).toByte() }
+            val file = File.createTempFile("fbtest", ".bin")
+            file.writeBytes(data)
+            try {
+                transaction {
+                    statement("select cast(? as blob sub_type binary), cast(? as int) from RDB\$DATABASE") {
+                        params.setInt(1, 0)
+                        assertEquals(data.size.toLong(),
+                            API.setValueBlobFile(status, dbHandle, trHandle, params.sqlda, 0, file.path, -1))
+                        open {
+                            assertContentEquals(data, getByteArray(0))
+                        }
+
+                        assertEquals(data.size.toLong(), API.setValueBlobStream(status, dbHandle, trHandle,
+                            params.sqlda, 0, ByteArrayInputStream(data)))
+                        open {
+                            assertContentEquals(data, getByteArray(0))
+                        }
+
+                        // the error of the stream is thrown, the partial blob is cancelled
+                        val failing = object : InputStream() {
+                            var left = 100_000
+                            override fun read(): Int = throw IOException("disk")
+                            override fun read(b: ByteArray, off: Int, len: Int): Int {
+                                if (left <= 0)
+                                    throw IOException("disk")
+                                val count = minOf(len, left)
+                                left -= count
+                                return count
+                            }
+                        }
+                        assertFailsWith<IOException> {
+                            API.setValueBlobStream(status, dbHandle, trHandle, params.sqlda, 0, failing)
+                        }
+                        assertFailsWith<FirebirdException> {
+                            API.setValueBlobFile(status, dbHandle, trHandle, params.sqlda, 1, file.path, -1)
+                        }
+                    }
+                }
+            } finally {
+                file.delete()
+            }
+        }
+    }
+
+    @Test
+    fun slowQueries() {
+        testing.attachment {
+            transaction {
+                createCustomers(3)
+
+                // every statement prepared from now on is slower than 1 ns
+                API.setSlowQueryLog(1, 8)
+                try {
+                    statement("SELECT ID FROM CUSTOMER WHERE ID > ? ORDER BY ID") {
+                        params.setInt(0, 1)
+                        open {
+                            while (!eof)
+                                fetch()
+                        }
+                    }
+                    statement("UPDATE CUSTOMER SET BALANCE = 0 WHERE ID >= ?") {
+                        params.setInt(0, 2)
+                        // a DML statement is captured as soon as it is executed, it opens no cursor
+                        assertEquals(0L, API.execute(status, trHandle, stHandle, dialect, params.sqlda))
+                        val queries = API.drainSlowQueries()
+                        assertEquals(2, queries.size)
+
+                        val select = queries[0]
+                        assertEquals("SELECT ID FROM CUSTOMER WHERE ID > ? ORDER BY ID", select.sql)
+                        assertEquals("INTEGER", select.parameters)
+                        assertEquals(2L, select.selected)
+                        assertTrue(select.elapsedNanos > 0)
+                        assertFalse(select.plan.isNullOrEmpty())
+
+                        val update = queries[1]
+                        assertEquals("UPDATE CUSTOMER SET BALANCE = 0 WHERE ID >= ?", update.sql)
+                        assertEquals("INTEGER", update.parameters)
+                        assertEquals(2L, update.updated)
+                        assertEquals(0L, update.inserted)
+                        assertFalse(update.plan.isNullOrEmpty())
+                    }
+                    // nothing is left to capture when the statements are released
+                    assertEquals(0, API.drainSlowQueries().size)
+                } finally {
+                    API.setSlowQueryLog(0, 0)
+                }
+            }
+        }
+    }
+
+    @Test
+    fun recordReplay() {
+        testing.attachment {
+            transaction {
+                createCustomers(3)
+            }
+            fun session(): List<Customer> {
+                val rows = mutableListOf<Customer>()
+                transaction {
+                    statement("SELECT ID, NAME, BALANCE FROM CUSTOMER WHERE ID >= ? ORDER BY ID") {
+                        params.setInt(0, 2)
+                        open {
+                            while (!eof) {
+                                rows += Customer(getInt(0), getString(1), if (getIsNull(2)) null else getDouble(2))
+                                fetch()
+                            }
+                        }
+                    }
+                }
+                return rows
+            }
+
+            val log = File.createTempFile("fbtest", ".log")
+            val truncated = File.createTempFile("fbtest", ".log")
+            try {
+                API.startRecording(log.path)
+                val recorded = try {
+                    session()
+                } finally {
+                    API.stopRecording()
+                }
+                assertEquals(listOf(customer(2), customer(3)), recorded)
+
+                // the database no longer has the rows, the replayed session still reads them
+                transaction {
+                    execute("DELETE FROM CUSTOMER")
+                }
+                API.startReplay(log.path)
+                try {
+                    assertEquals(recorded, session())
+                    // the log is exhausted
+                    assertFailsWith<FirebirdException> { session() }
+                } finally {
+                    API.stopReplay()
+                }
+                assertEquals(emptyList<Customer>(), session())
+
+                transaction {
+                    API.startReplay(log.path)
+                    try {
+                        // the log starts with the start of a transaction
+                        assertFailsWith<FirebirdException> { commitRetaining() }
+                    } finally {
+                        API.stopReplay()
+                    }
+                }
+
+                // the last call reads past the end of its record
+                val bytes = log.readBytes()
+                truncated.writeBytes(bytes.copyOf(bytes.size - 1))
+                API.startReplay(truncated.path)
+                try {
+                    assertFailsWith<FirebirdException> { session() }
+                } finally {
+                    API.stopReplay()
+                }
+            } finally {
+                log.delete()
+                truncated.delete()
+            }
+        }
+    }
+
+    @Test
+    fun latency() {
+        testing.attachment {
+            transaction {
+                createCustomers(10)
+
+                API.setLatencyTracking(true)
+                try {
+                    API.resetLatency()
+                    statement("SELECT ID, NAME FROM CUSTOMER ORDER BY ID") {
+                        open {
+                            while (!eof)
+                                fetch()
+                        }
+                    }
+                    val stats = API.latencySnapshot().associateBy { it.name }
+                    for (name in listOf("client.dsql_fetch", "jni.fetch")) {
+                        val entry = stats.getValue(name)
+                        // the end of the cursor is one more fetch
+                        assertEquals(11L, entry.count, name)
+                        assertTrue(entry.totalNanos >= entry.maxNanos, name)
+                        assertTrue(entry.p50 <= entry.p99 && entry.p99 <= entry.maxNanos, name)
+                    }
+
+                    API.resetLatency()
+                    assertEquals(emptyList<LatencyStats>(), API.latencySnapshot())
+                } finally {
+                    API.setLatencyTracking(false)
+                }
+            }
+        }
+    }
+
+    @Test
+    fun callCounts() {
+        testing.attachment {
+            transaction {
+                createCustomers(10)
+                fun fetchAll() {
+                    statement("SELECT ID, NAME FROM CUSTOMER ORDER BY ID") {
+                        open {
+                            while (!eof)
+                                fetch()
+                        }
+                    }
+                }
+
+                API.setCallCounting(true)
+                try {
+                    API.resetCallCounts()
+                    fetchAll()
+                    assertFailsWith<FirebirdException> {
+                        statement("SELECT ID FROM NOWHERE") {}
+                    }
+                    val counts = API.callCounts().associateBy { it.name }
+                    val fetches = counts.getValue("dsql_fetch")
+                    // the end of the cursor is one more fetch
+                    assertEquals(11L, fetches.calls)
+                    assertTrue(fetches.bytes > 0)
+                    assertEquals(0L, fetches.errors)
+                    val prepares = counts.getValue("dsql_prepare")
+                    assertEquals(2L, prepares.calls)
+                    assertEquals(1L, prepares.errors)
+                } finally {
+                    API.setCallCounting(false)
+                }
+
+                // nothing is counted while disabled
+                val before = API.callCounts()
+                fetchAll()
+                assertEquals(before, API.callCounts())
+                API.resetCallCounts()
+            }
+        }
+    }
+
+    @Test
+    fun initFailure() {
+        testing.attachment {
+            transaction {
+                createCustomers(3)
+            }
+            assertFailsWith<FirebirdException> { API.init("/nonexistent") }
+
+            // the library loaded before still serves the open attachment
+            transaction {
+                statement("SELECT COUNT(*) FROM CUSTOMER") {
+                    open {
+                        assertEquals(3L, getLong(0))
+                    }
+                }
+            }
+        }
+    }
+}
@@ -5,8 +5,12 @@ package com.progdigy.fbclient
 import kotlinx.cinterop.*
 import org.firebirdsql.fbclient.*
 import platform.posix.memcpy
-import platform.posix.memset
+import platform.posix.size_t
+import kotlin.concurrent.AtomicInt
 import kotlin.math.min
+import kotlin.native.concurrent.ObsoleteWorkersApi
+import kotlin.native.concurrent.TransferMode
+import kotlin.native.concurrent.Worker
 
 @OptIn(ExperimentalForeignApi::class)
 actual object API {
@@ -16,86 +20,29 @@ actual object API {
     private const val ERR_FIELD_NULL = "Field is null"
     private const val ERR_STRING_TRUNCATION = "String truncation"
 
-    private const val ISC_SEGMENT = 335544366L
-
     private inline fun HANDLE.toXSQLDA() = toCPointer<CPointerVar<XSQLDA>>()?.pointed?.value?.pointed
 
     private inline fun xsqldaLength(n: ISC_SHORT): Long = sizeOf<XSQLDA>() + (n - 1) * sizeOf<XSQLVAR>()
 
     /**
-     * Calculates the size of a UTF-8 encoded string up to a certain maximum length.
+     * Throws the exception matching a conversion status of the fbcore kernels, if any.
      *
-     * @param string The null-terminated UTF-8 encoded string represented as a C pointer to an array of bytes.
-     * @param maxLength The maximum length of the string to consider when calculating the size.
-     * @param maxSize The maximum size of the string to consider when calculating the size.
-     * @return The size of the UTF-8 encoded string in bytes.
+     * @param index The index of the field, reported in the exception message.
+     * @param code The status returned by the kernel.
      */
-    private fun utf8Size(string: CPointer<ByteVarOf<Byte>>, maxLength: Int, maxSize: Int): Int {
-        var length = 0
-        var size = 0
-        var value = string[size].toInt()
-        while (value != 0) {
-            if((value and 0xC0) != 0x80) length++
-            if(length > maxLength || size++ == maxSize)
-                break
-            value = string[size].toInt()
+    private inline fun checkCore(index: Int, code: Int) {
+        when (code) {
+            FBCORE_OK -> return
+            FBCORE_TRUNCATION -> throw FirebirdException("$ERR_STRING_TRUNCATION: $index")
+            else -> throw FirebirdException("$ERR_CONVERSION ($index)")
         }
-        return size
     }
 
     /**
-     * @brief Allocates memory for the data buffer of an XSQLDA structure.
-     *
-     * This function allocates memory for a data buffer based on the information provided in the specified XSQLDA structure.
-     * The data buffer is used to store the actual data values for each field in the XSQLDA structure.
-     *
-     * @param sqlda The XSQLDA structure containing the field definitions.
-     *
-     * @note The XSQLDA structure should be pre-initialized with the correct values for version, sqldaid, sqldabc, sqln, and sqld.
-     *       The sqlvar array should contain the field definitions.
+     * Pins the array and passes the address of its first byte to block, or null when the array is empty.
      */
-    private fun allocateDataBuffer(sqlda: XSQLDA) {
-        var total = 0L
-        for (i in 0 until sqlda.sqld) {
-            val v = sqlda.sqlvar[i]
-            v.sqldata = total.toCPointer()
-            when (v.sqltype.toInt() and 1.inv()) {
-                SQL_TEXT -> {
-                    // + zero terminal
-                    total += v.sqllen
-                    total++
-                }
-                SQL_VARYING -> {
-                    // size of PARAMVARY + zero terminal
-                    total += sizeOf<ISC_USHORTVar>() + v.sqllen
-                    total++
-                }
-                SQL_FLOAT, SQL_D_FLOAT, SQL_DOUBLE -> {
-                    // scale is irrelevant and lead to duplicate code
-                    v.sqlscale = 0
-                    total += v.sqllen
-                }
-                else -> {
-                    total += v.sqllen
-                }
-            }
-            if ((v.sqltype.toInt() and 1) == 1) {
-                v.sqlind = total.toCPointer()
-                total += sizeOf<ShortVar>()
-            } else
-                v.sqlind = null
-        }
-        val buffer = nativeHeap.allocArray<ISC_SCHARVar>(total)
-        memset(buffer, 0, total.toULong())
-        for (i in 0 until sqlda.sqld) {
-            val v = sqlda.sqlvar[i]
-            v.sqldata = buffer.plus(v.sqldata.toLong())
-            if (v.sqlind != null) {
-                v.sqlind = buffer.plus(v.sqlind!!.toLong())!!.reinterpret()
-                v.sqlind!!.pointed.value = -1 // nullables are null
-            }
-        }
-    }
+    private inline fun <R> ByteArray.useAddress(offset: Int = 0, block: (CPointer<ByteVar>?) -> R): R =
+        if (offset >= size) block(null) else usePinned { block(it.addressOf(offset)) }
 
     /**
      * Frees the memory allocated for the SQLDA structure.
@@ -107,7 +54,7 @@ actual object API {
         if (ptr != null) {
             val sqlda = ptr.pointed.value
             if (sqlda != null) {
-                nativeHeap.free(sqlda)
+                fbcore_free_sqlda(sqlda.reinterpret())
                 ptr.pointed.value = null
             }
         }
@@ -287,22 +234,11 @@ actual object API {
      * @return A string representing the description of the status.
      */
     actual fun interpret(status: HANDLE): String {
-        val buffer = nativeHeap.allocArray<ISC_SCHARVar>(1024)
-        val statusArray = status.toCPointer<ISC_STATUSVar>()
-        val pStatusArray = nativeHeap.allocArray<CPointerVar<ISC_STATUSVar>>(1)
-        pStatusArray[0] = statusArray
-
-        var len = fb_interpret(buffer, 1024u, pStatusArray)
-        var total = len
-        while (len > 0 && total < 1024) {
-            buffer[total++] = '\n'.code.toByte()
-            len = fb_interpret(buffer + total, (1024 - total).toUInt(), pStatusArray)
-            total += len
+        val buffer = ByteArray(1024)
+        val length = buffer.usePinned {
+            fbclient_interpret(it.addressOf(0), buffer.size.toUInt(), status.toCPointer<ISC_STATUSVar>())
         }
-        val result = buffer.toKString()
-        nativeHeap.free(buffer)
-        nativeHeap.free(pStatusArray)
-        return result
+        return buffer.decodeToString(0, length.toInt())
     }
 
     /**
@@ -364,6 +300,30 @@ actual object API {
         return isc_detach_database(statusArray, dbHandlePtr)
     }
 
+    /**
+     * Requests information items about the attached database.
+     *
+     * @param status The handle containing the status of the operation.
+     * @param dbHandle The handle of the database.
+     * @param items The information items to request.
+     * @param length The size of the result buffer.
+     * @return The raw result buffer, a sequence of item, length and value clumplets.
+     * @throws FirebirdException if the request fails.
+     */
+    actual fun databaseInfo(status: HANDLE, dbHandle: HANDLE, items: ByteArray, length: Int): ByteArray {
+        val statusArray = status.toCPointer<ISC_STATUSVar>()
+        val dbHandlePtr = dbHandle.toCPointer<FB_API_HANDLEVar>()
+        val result = ByteArray(length)
+        val ret = items.usePinned { request ->
+            result.usePinned { buffer ->
+                isc_database_info(statusArray, dbHandlePtr, items.size.toShort(), request.addressOf(0),
+                    length.toShort(), buffer.addressOf(0))
+            }
+        }
+        checkStatus(status, ret)
+        return result
+    }
+
     /**
      * Executes an immediate SQL statement using the provided handles and SQL string.
      *
@@ -480,7 +440,7 @@ actual object API {
         var ret = isc_dsql_allocate_statement(statusArray, dbHandlePtr, stHandlePtr)
 
         if (ret == 0L) {
-            var len = xsqldaLength(1)
+            val len = xsqldaLength(1)
 
             val da = nativeHeap.allocArray<ByteVar>(len){ value = 0 }.reinterpret<XSQLDA>().pointed
             da.version = SQLDA_VERSION1.toShort()
@@ -493,18 +453,16 @@ actual object API {
                         ret = isc_dsql_set_cursor_name(statusArray, stHandlePtr, cursor, 0u)
 
                     if (ret == 0L && sqldaPtr != null && da.sqld > 0) {
-                        len = xsqldaLength(da.sqld)
-
-                        val pXSQLDA = nativeHeap.allocArray<ByteVar>(len){value = 0}.reinterpret<XSQLDA>().pointed
-
-                        pXSQLDA.version = SQLDA_VERSION1.toShort()
-                        pXSQLDA.sqln = da.sqld
-                        ret = isc_dsql_describe(statusArray, stHandlePtr, dialect.toUShort(), pXSQLDA.ptr)
+                        val pXSQLDA = fbcore_alloc_sqlda(da.sqld)
+                        ret = isc_dsql_describe(statusArray, stHandlePtr, dialect.toUShort(), pXSQLDA)
+                        if (ret == 0L && fbcore_allocate_data_buffer(pXSQLDA) != FBCORE_OK) {
+                            fbcore_free_sqlda(pXSQLDA)
+                            throw OutOfMemoryError()
+                        }
                         if (ret == 0L) {
-                            sqldaPtr.pointed.value = pXSQLDA.ptr
-                            allocateDataBuffer(pXSQLDA)
+                            sqldaPtr.pointed.value = pXSQLDA
                         } else {
-                            nativeHeap.free(pXSQLDA)
+                            fbcore_free_sqlda(pXSQLDA)
                         }
                     }
                 }
@@ -528,12 +486,7 @@ actual object API {
         val stHandlePtr = stHandle.toCPointer<FB_API_HANDLEVar>()
         if (stHandlePtr == null || stHandlePtr.pointed.value == 0u)
             throw FirebirdException(ERR_INVALID_HANDLE)
-        val data = nativeHeap.allocArray<ByteVar>(9)
-        data[0] = isc_info_sql_stmt_type.toByte()
-        isc_dsql_sql_info(statusArray, stHandlePtr, 1, data, 8, data.plus(1))
-        val ret = data[4] - 1
-        nativeHeap.free(data)
-        return ret
+        return fbclient_statement_type(statusArray, stHandlePtr)
     }
 
     /**
@@ -641,7 +594,7 @@ actual object API {
         val statusArray = status.toCPointer<ISC_STATUSVar>()
         val stHandlePtr = stHandle.toCPointer<FB_API_HANDLEVar>()
         val sqldaPtr = sqlda.toCPointer<CPointerVar<XSQLDA>>()
-        var len = xsqldaLength(1)
+        val len = xsqldaLength(1)
         val da = nativeHeap.allocArray<ByteVar>(len).reinterpret<XSQLDA>().pointed
         da.version = SQLDA_VERSION1.toShort()
         da.sqld = 0
@@ -649,17 +602,17 @@ actual object API {
 
         var ret = isc_dsql_describe_bind(statusArray, stHandlePtr, dialect.toUShort(), da.ptr)
         if (ret == 0L && da.sqld > 0) {
-            len = xsqldaLength(da.sqld)
-            val pXSQLDA = nativeHeap.allocArray<ByteVar>(len){ value = 0 }.reinterpret<XSQLDA>().pointed
-            memset(pXSQLDA.ptr, 0, len.toULong())
-            pXSQLDA.version = SQLDA_VERSION1.toShort()
-            pXSQLDA.sqln = da.sqld
-            ret = isc_dsql_describe_bind(statusArray, stHandlePtr, dialect.toUShort(), pXSQLDA.ptr)
+            val pXSQLDA = fbcore_alloc_sqlda(da.sqld)
+            ret = isc_dsql_describe_bind(statusArray, stHandlePtr, dialect.toUShort(), pXSQLDA)
             if (ret == 0L && sqldaPtr != null) {
-                sqldaPtr.pointed.value = pXSQLDA.ptr
-                allocateDataBuffer(pXSQLDA)
+                if (fbcore_allocate_data_buffer(pXSQLDA) != FBCORE_OK) {
+                    fbcore_free_sqlda(pXSQLDA)
+                    nativeHeap.free(da)
+                    throw OutOfMemoryError()
+                }
+                sqldaPtr.pointed.value = pXSQLDA
             } else {
-                nativeHeap.free(pXSQLDA)
+                fbcore_free_sqlda(pXSQLDA)
             }
         }
 
@@ -667,6 +620,73 @@ actual object API {
         return ret
     }
 
+    /**
+     * Changes the types of the columns of a described SQLDA to the ones the client reads or writes, the server
+     * converting the values, and lays out its buffer again; the values and null indicators already set are lost, it
+     * is called before binding.
+     *
+     * @param sqlda The SQLDA handle.
+     * @param types The [DataType] ordinal of each column, from the first one, -1 to keep the described type.
+     * @throws FirebirdException if there are more types than columns or a column cannot take its type, no column is
+     * changed then.
+     */
+    actual fun setTypes(sqlda: HANDLE, types: IntArray) {
+        val p = sqlda.toXSQLDA() ?: throw FirebirdException(ERR_INVALID_HANDLE)
+        if (types.size > p.sqld)
+            throw FirebirdException("$ERR_OUT_OF_BOUND: ${p.sqld}")
+        val count = types.size
+        if (count == 0)
+            return
+        memScoped {
+            // the columns are changed on a copy, left as they are when a type is refused or the buffer cannot be
+            // allocated
+            val vars = allocArray<XSQLVAR>(p.sqld.toInt())
+            memcpy(vars, p.sqlvar, (sizeOf<XSQLVAR>() * p.sqld).toULong())
+            for (i in 0 until count) {
+                if (types[i] < 0)
+                    continue
+                // text as UTF8, bytes as NONE, as getType reports them
+                val subtype = if (types[i] == 5) 4 else 0
+                val code = when (types[i]) {
+                    0 -> SQL_SHORT
+                    1 -> SQL_LONG
+                    2 -> SQL_INT64
+                    3 -> SQL_FLOAT
+                    4 -> SQL_DOUBLE
+                    5, 6 -> SQL_VARYING
+                    7 -> SQL_INT128
+                    8 -> SQL_BOOLEAN
+                    9 -> SQL_TYPE_DATE
+                    10 -> SQL_TYPE_TIME
+                    11 -> SQL_TIMESTAMP
+                    12 -> SQL_TIME_TZ
+                    13 -> SQL_TIMESTAMP_TZ
+                    else -> throw FirebirdException("$ERR_CONVERSION ($i)")
+                }
+                checkCore(i, fbcore_set_var_type(vars[i].ptr, code, subtype))
+            }
+            if (fbcore_relayout_data_buffer(p.ptr, vars) != FBCORE_OK)
+                throw OutOfMemoryError()
+        }
+    }
+
+    /**
+     * Changes the types of the output columns of a statement to the ones read without decoding and lays out its
+     * buffer again, before the statement is executed.
+     *
+     * @param sqlda The output SQLDA handle, its XSQLDA is null for a statement without columns.
+     * @param profile A combination of the OUTPUT_ flags.
+     * @throws FirebirdException if the SQLDA handle is invalid.
+     */
+    actual fun setOutputProfile(sqlda: HANDLE, profile: Int) {
+        if (sqlda == 0L)
+            throw FirebirdException(ERR_INVALID_HANDLE)
+        // a statement without columns has no XSQLDA
+        val p = sqlda.toXSQLDA() ?: return
+        if (fbcore_set_output_profile(p.ptr, profile) < 0)
+            throw OutOfMemoryError()
+    }
+
     /**
      * Sets the field value of the specified index in the given SQLDA to null.
      *
@@ -690,11 +710,7 @@ actual object API {
      */
     actual fun setValueBoolean(sqlda: HANDLE, index: Int, value: Boolean) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_BOOLEAN -> data.reinterpret<ByteVar>().value = value.toByte()
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_boolean(data.ptr, sqlCode, if (value) 1 else 0))
         }
 
     /**
@@ -707,23 +723,7 @@ actual object API {
      */
     actual fun setValueShort(sqlda: HANDLE, index: Int, value: Short) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_SHORT -> data.reinterpret<ShortVar>().value = value
-                SQL_LONG -> data.reinterpret<IntVar>().value = value.toInt()
-                SQL_QUAD, SQL_INT64 ->
-                    data.reinterpret<LongVar>().value = value.toLong()
-                SQL_FLOAT ->
-                    data.reinterpret<FloatVar>().value = value.toFloat()
-                SQL_DOUBLE, SQL_D_FLOAT ->
-                    data.reinterpret<DoubleVar>().value = value.toDouble()
-                SQL_INT128 ->
-                    data.reinterpret<FB_I128>().apply {
-                        fb_data[0] = value.toULong()
-                        fb_data[1] = if (value < 0) (-1).toULong() else 0u
-                    }
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_short(data.ptr, sqlCode, value))
         }
 
     /**
@@ -736,20 +736,7 @@ actual object API {
      */
     actual fun setValueInt(sqlda: HANDLE, index: Int, value: Int) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_LONG -> data.reinterpret<IntVar>().value = value
-                SQL_QUAD, SQL_INT64 ->
-                    data.reinterpret<LongVar>().value = value.toLong()
-                SQL_DOUBLE, SQL_D_FLOAT ->
-                    data.reinterpret<DoubleVar>().value = value.toDouble()
-                SQL_INT128 ->
-                    data.reinterpret<FB_I128>().apply {
-                        fb_data[0] = value.toULong()
-                        fb_data[1] = if (value < 0) (-1).toULong() else 0u
-                    }
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_int(data.ptr, sqlCode, value))
         }
 
     /**
@@ -762,17 +749,7 @@ actual object API {
      */
     actual fun setValueLong(sqlda: HANDLE, index: Int, value: Long) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_QUAD, SQL_INT64 ->
-                    data.reinterpret<LongVar>().value = value
-                SQL_INT128 ->
-                    data.reinterpret<FB_I128>().apply {
-                        fb_data[0] = value.toULong()
-                        fb_data[1] = if (value < 0) (-1).toULong() else 0u
-                    }
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_long(data.ptr, sqlCode, value))
         }
 
     /**
@@ -786,15 +763,7 @@ actual object API {
      */
     actual fun setValueInt128(sqlda: HANDLE, index: Int, a: Long, b: Long) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_INT128 ->
-                    data.reinterpret<FB_I128>().apply {
-                        fb_data[0] = a.toULong()
-                        fb_data[1] = b.toULong()
-                    }
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_int128(data.ptr, sqlCode, a, b))
         }
 
     /**
@@ -813,27 +782,13 @@ actual object API {
     actual fun setValueString(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int, value: String) =
         setFieldValue(sqlda, index) { data, sqlCode, sqlLen, sqlSubType ->
             when (sqlCode) {
-                SQL_VARYING ->
-                    if (sqlSubType == 4.toShort()) {
-                        val vary = data.reinterpret<PARAMVARY>()
-                        val len = sqlLen / 4
-                        if (value.length <= len) {
-                            val valueBytes = value.encodeToByteArray()
-                            val size = valueBytes.size
-                            memcpy(vary.vary_string, valueBytes.refTo(0), size.toULong())
-                            vary.vary_length = size.toUShort()
-                        } else
-                            throw FirebirdException("$ERR_STRING_TRUNCATION: $index")
-                    } else
-                        throw FirebirdException("$ERR_CONVERSION ($index)")
-                SQL_TEXT ->
+                SQL_VARYING, SQL_TEXT ->
                     if (sqlSubType == 4.toShort()) {
-                        val len = sqlLen / 4
-                        if (value.length <= len) {
+                        if (value.length <= sqlLen / 4) {
                             val valueBytes = value.encodeToByteArray()
-                            val size = valueBytes.size
-                            memset(data.ptr, 32, sqlLen.toULong())
-                            memcpy(data.ptr, valueBytes.refTo(0), size.toULong())
+                            valueBytes.useAddress {
+                                fbcore_set_bytes(data.ptr, sqlCode, sqlLen.toInt(), it, valueBytes.size, ' '.code.toByte())
+                            }
                         } else
                             throw FirebirdException("$ERR_STRING_TRUNCATION: $index")
                     } else
@@ -849,18 +804,8 @@ actual object API {
                             val blobId = data.reinterpret<GDS_QUAD>()
                             var ret = isc_create_blob(statusArray, dbHandlePtr, trHandlePtr, blob.ptr, blobId.ptr)
                             if (ret == 0L) {
-                                val bytes = value.cstr
-                                var length = bytes.size - 1 // remove zero terminal
-                                var toWrite = min(length, Short.MAX_VALUE.toInt())
-                                var p: CPointer<ByteVar>? = bytes.getPointer(this)
-                                while (length > 0 && isc_put_segment(statusArray, blob.ptr, toWrite.toUShort(), p) == 0L) {
-                                    length -= toWrite
-                                    if (length <= 0)
-                                        break
-                                    toWrite = min(length, Short.MAX_VALUE.toInt())
-                                    p = p + toWrite
-                                }
-
+                                val bytes = value.encodeToByteArray()
+                                bytes.useAddress { fbclient_blob_write(statusArray, blob.ptr, it, bytes.size) }
                                 ret = isc_close_blob(statusArray, blob.ptr)
                             }
                             if (ret != 0L)
@@ -885,22 +830,13 @@ actual object API {
      * @throws FirebirdException if there is an error setting the field value.
      */
     actual fun setValueByteArray(status: HANDLE, dbHandle: HANDLE, trHandle: HANDLE, sqlda: HANDLE, index: Int, value: ByteArray) =
-        setFieldValue(sqlda, index) { data, sqlCode, sqlLen, _ ->
+        setFieldValue(sqlda, index) { data, sqlCode, sqlLen, sqlSubType ->
             when (sqlCode) {
-                SQL_VARYING -> {
-                    val vary = data.reinterpret<PARAMVARY>()
-                    if (value.size <= sqlLen) {
-                        memcpy(vary.vary_string, value.refTo(0), value.size.toULong())
-                        vary.vary_length = value.size.toUShort()
-                    } else
-                        throw FirebirdException("$ERR_STRING_TRUNCATION: $index")
-                }
-                SQL_TEXT -> {
-                    if (value.size <= sqlLen) {
-                        memcpy(data.ptr, value.refTo(0), value.size.toULong())
-                    } else
-                        throw FirebirdException("$ERR_STRING_TRUNCATION: $index")
-                }
+                SQL_VARYING, SQL_TEXT ->
+                    checkCore(index, value.useAddress {
+                        fbcore_set_bytes(data.ptr, sqlCode, sqlLen.toInt(), it, value.size,
+                            if (sqlSubType > 0) ' '.code.toByte() else 0)
+                    })
                 SQL_BLOB -> {
                     val statusArray = status.toCPointer<ISC_STATUSVar>()
                     val dbHandlePtr = dbHandle.toCPointer<FB_API_HANDLEVar>()
@@ -911,19 +847,7 @@ actual object API {
                         val blobId = data.reinterpret<GDS_QUAD>()
                         var ret = isc_create_blob(statusArray, dbHandlePtr, trHandlePtr, blob.ptr, blobId.ptr)
                         if (ret == 0L) {
-                            value.usePinned {
-                                var p = 0
-                                var length = value.size
-                                var toWrite = min(length, Short.MAX_VALUE.toInt())
-                                while (length > 0 && isc_put_segment(statusArray, blob.ptr, toWrite.toUShort(), it.addressOf(p)) == 0L) {
-                                    length -= toWrite
-                                    if (length <= 0)
-                                        break
-                                    toWrite = min(length, Short.MAX_VALUE.toInt())
-                                    p += toWrite
-                                }
-                            }
-
+                            value.useAddress { fbclient_blob_write(statusArray, blob.ptr, it, value.size) }
                             ret = isc_close_blob(statusArray, blob.ptr)
                         }
                         if (ret != 0L)
@@ -945,14 +869,7 @@ actual object API {
      */
     actual fun setValueFloat(sqlda: HANDLE, index: Int, value: Float) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_FLOAT ->
-                    data.reinterpret<FloatVar>().value = value
-                SQL_DOUBLE, SQL_D_FLOAT ->
-                    data.reinterpret<DoubleVar>().value = value.toDouble()
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_float(data.ptr, sqlCode, value))
         }
 
     /**
@@ -966,12 +883,7 @@ actual object API {
      */
     actual fun setValueDouble(sqlda: HANDLE, index: Int, value: Double) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_DOUBLE, SQL_D_FLOAT ->
-                    data.reinterpret<DoubleVar>().value = value
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_double(data.ptr, sqlCode, value))
         }
 
     /**
@@ -984,15 +896,7 @@ actual object API {
      */
     actual fun setValueDate(sqlda: HANDLE, index: Int, value: Int) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_TYPE_DATE,
-                SQL_TIMESTAMP,
-                SQL_TIMESTAMP_TZ,
-                SQL_TIMESTAMP_TZ_EX ->
-                    data.reinterpret<ISC_DATEVar>().value = value + 40587
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_date(data.ptr, sqlCode, value))
         }
 
     /**
@@ -1005,18 +909,7 @@ actual object API {
      */
     actual fun setValueTime(sqlda: HANDLE, index: Int, value: Int) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_TYPE_TIME,
-                SQL_TIME_TZ,
-                SQL_TIME_TZ_EX ->
-                    data.reinterpret<ISC_TIMEVar>().value = value.toUInt() * 10u
-                SQL_TIMESTAMP,
-                SQL_TIMESTAMP_TZ,
-                SQL_TIMESTAMP_TZ_EX ->
-                    data.reinterpret<ISC_TIMESTAMP>().timestamp_time = value.toUInt() * 10u
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_time(data.ptr, sqlCode, value))
         }
 
     /**
@@ -1030,16 +923,7 @@ actual object API {
      */
     actual fun setValueTimeZone(sqlda: HANDLE, index: Int, value: Int) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_TIME_TZ,
-                SQL_TIME_TZ_EX ->
-                    data.reinterpret<ISC_TIME_TZ>().time_zone = value.toUShort()
-                SQL_TIMESTAMP_TZ,
-                SQL_TIMESTAMP_TZ_EX ->
-                    data.reinterpret<ISC_TIMESTAMP_TZ>().time_zone = value.toUShort()
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_time_zone(data.ptr, sqlCode, value))
         }
 
     /**
@@ -1051,12 +935,7 @@ actual object API {
      */
     actual fun setValueBlobId(sqlda: HANDLE, index: Int, value: Long) =
         setFieldValue(sqlda, index) { data, sqlCode ->
-            when(sqlCode) {
-                SQL_BLOB ->
-                    data.reinterpret<LongVar>().value = value
-                else ->
-                    throw FirebirdException("$ERR_CONVERSION ($index)")
-            }
+            checkCore(index, fbcore_set_blob_id(data.ptr, sqlCode, value))
         }
 
     /**
@@ -1084,6 +963,7 @@ actual object API {
                 SQL_TIME_TZ, SQL_TIME_TZ_EX -> 12
                 SQL_TIMESTAMP_TZ, SQL_TIMESTAMP_TZ_EX -> 13
                 SQL_BLOB -> if (v.sqlsubtype == 1.toShort()) 15 else 14
+                SQL_ARRAY -> 16
                 else -> -1  // if none of the cases match
             }
         }
@@ -1290,21 +1170,10 @@ actual object API {
         getFieldValue(sqlda, index) { data, sqlCode, sqlLen, sqlSubType ->
 
                 return@getFieldValue when (sqlCode) {
-                    SQL_VARYING ->
-                        if (sqlSubType > 0) {
-                            val vary = data.reinterpret<PARAMVARY>()
-                            val length = vary.vary_length
-                            vary.vary_string[length.toInt()] = 0u
-                            vary.vary_string.reinterpret<ByteVar>().toKString()
-                        } else
-                            throw FirebirdException("$ERR_CONVERSION ($index)")
-                    SQL_TEXT ->
-                        if (sqlSubType > 0) {
-                            val arr = data.ptr.reinterpret<ByteVar>()
-                            val size = utf8Size(arr, sqlLen / sqlSubType, sqlLen.toInt())
-                            arr[size] = 0
-                            arr.toKString()
-                        } else
+                    SQL_VARYING, SQL_TEXT ->
+                        if (sqlSubType > 0)
+                            fbcore_get_text(data.ptr, sqlCode, sqlLen.toInt(), sqlSubType.toInt())!!.toKString()
+                        else
                             throw FirebirdException("$ERR_CONVERSION ($index)")
                     SQL_BLOB -> {
                         if (sqlSubType == 1.toShort()) { // text
@@ -1385,33 +1254,15 @@ actual object API {
             val blob = alloc<FB_API_HANDLEVar>()
             blob.value = 0u
             val blobId = data.reinterpret<GDS_QUAD>()
-            //char* str = nullptr
             var ret = isc_open_blob(statusArray, dbHandlePtr, trHandlePtr, blob.ptr, blobId.ptr)
             if (ret == 0L) {
-                val buffer = allocArray<ByteVar>(9)
-                val info = allocArray<ByteVar>(1)
                 var arr: ByteArray? = null
-                info[0] = isc_info_blob_total_length.toByte()
-                ret = isc_blob_info(statusArray, blob.ptr, 1, info, 9, buffer)
+                val length = alloc<ISC_LONGVar>()
+                ret = fbclient_blob_length(statusArray, blob.ptr, length.ptr)
                 if (ret == 0L) {
-                    var length = (buffer + 3)!!.reinterpret<ISC_LONGVar>().pointed.value
-                    arr = ByteArray(length)
-                    if (length > 0) {
-                        var toRead = min(length, Short.MAX_VALUE.toInt())
-                        val size = alloc<ISC_USHORTVar>()
-                        arr.usePinned {
-                            var p = 0
-                            ret = isc_get_segment(statusArray, blob.ptr, size.ptr, toRead.toUShort(), it.addressOf(p))
-                            while (ret == 0L || statusArray!![1] == ISC_SEGMENT) {
-                                length -= size.value.toInt()
-                                if (length <= 0)
-                                    break
-                                toRead = min(length, Short.MAX_VALUE.toInt())
-                                p += size.value.toInt()
-                                ret = isc_get_segment(statusArray, blob.ptr, size.ptr, toRead.toUShort(), it.addressOf(p))
-                            }
-                        }
-                    }
+                    val bytes = ByteArray(length.value)
+                    bytes.useAddress { fbclient_blob_read(statusArray, blob.ptr, it, bytes.size) }
+                    arr = bytes
                 }
                 ret = isc_close_blob(statusArray, blob.ptr)
 
@@ -1636,29 +1487,7 @@ actual object API {
         var total = 0
         if (arrayLength > 0 && offset >= 0 && length > 0) {
             arrayLength = min(arrayLength - offset, length)
-            buffer.usePinned {
-                var p = offset
-                val size = nativeHeap.alloc<ISC_USHORTVar>()
-
-                while (arrayLength > 0) {
-                    val toRead = min(arrayLength, Short.MAX_VALUE.toInt())
-                    var ret = isc_get_segment(statusArray, blobHandlePtr, size.ptr, toRead.toUShort(), it.addressOf(p))
-                    var success = ret == 0L || statusArray!![1] == ISC_SEGMENT
-                    while (success && size.value == 0.toUShort()) {
-                        ret = isc_get_segment(statusArray, blobHandlePtr, size.ptr, toRead.toUShort(), it.addressOf(p))
-                        success = ret == 0L || statusArray!![1] == ISC_SEGMENT
-                    }
-                    val s = size.value.toInt()
-                    if (s > 0) {
-                        p += s
-                        arrayLength -= s
-                        total += s
-                        size.value = 0.toUShort()
-                    } else
-                        break
-                }
-                nativeHeap.free(size)
-            }
+            total = buffer.useAddress(offset) { fbclient_blob_read(statusArray, blobHandlePtr, it, arrayLength) }
 
         }
         return total
@@ -1675,12 +1504,9 @@ actual object API {
         val statusArray = status.toCPointer<ISC_STATUSVar>()
         val blobHandlePtr = blobHandle.toCPointer<FB_API_HANDLEVar>()
         memScoped {
-            val buffer = allocArray<ByteVar>(9)
-            val info = allocArray<ByteVar>(1)
-            info[0] = isc_info_blob_total_length.toByte()
-            val ret = isc_blob_info(statusArray, blobHandlePtr, 1, info, 9, buffer)
-            if (ret == 0L)
-                return (buffer + 3)!!.reinterpret<ISC_LONGVar>().pointed.value.toLong()
+            val length = alloc<ISC_LONGVar>()
+            if (fbclient_blob_length(statusArray, blobHandlePtr, length.ptr) == 0L)
+                return length.value.toLong()
         }
         throw FirebirdException(interpret(status))
     }
@@ -1702,18 +1528,7 @@ actual object API {
         var total = 0
         if (arrayLength > 0 && offset >= 0 && length > 0) {
             arrayLength = min(arrayLength - offset, length)
-            buffer.usePinned {
-                var p = offset
-                while (arrayLength > 0) {
-                    val toWrite = min(arrayLength, Short.MAX_VALUE.toInt())
-                    if (toWrite > 0 && isc_put_segment(statusArray, blobHandlePtr, toWrite.toUShort(), it.addressOf(p)) == 0L) {
-                        p += toWrite
-                        arrayLength -= toWrite
-                        total += toWrite
-                    } else
-                        break
-                }
-            }
+            total = buffer.useAddress(offset) { fbclient_blob_write(statusArray, blobHandlePtr, it, arrayLength) }
         }
         return total
     }
@@ -1742,4 +1557,459 @@ actual object API {
             throw FirebirdException(interpret(status))
         return id
     }
-}
\ No newline at end of file
+
+    /**
+     * Events queued by [queEvents]. The callback, run by a thread of the client library, hands the updated block to
+     * the worker of the queue, which queues the events again then calls the listener; every call to the client
+     * library is made on the worker, so a cancellation never races with a new queue.
+     */
+    @OptIn(ObsoleteWorkersApi::class)
+    private class EventQueue(dbHandle: FB_API_HANDLE, val names: Array<String>, val listener: EventListener,
+                             val length: Int) {
+        val worker = Worker.start(name = "Firebird events")
+        val db = nativeHeap.alloc<FB_API_HANDLEVar>().apply { value = dbHandle }
+        val id = nativeHeap.alloc<ISC_LONGVar>().apply { value = 0 }
+        val block = nativeHeap.allocArray<ISC_UCHARVar>(length)
+        val counts = nativeHeap.allocArray<ISC_ULONGVar>(names.size)
+        val status = nativeHeap.allocArray<ISC_STATUSVar>(ISC_STATUS_LENGTH)
+        val ref = StableRef.create(this)
+        var cancelled = false
+        var first = true
+
+        fun queue(statusArray: CPointer<ISC_STATUSVar>?): STATUS =
+            isc_que_events(statusArray, db.ptr, id.ptr, length.toUShort(), block, callback, ref.asCPointer())
+
+        fun dispatch(updated: ByteArray) {
+            if (cancelled || updated.size != length)
+                return
+            updated.usePinned {
+                fbcore_event_counts(counts, names.size, block, length.convert(), it.addressOf(0).reinterpret())
+            }
+            // stops when the attachment is lost
+            if (queue(status) != 0L)
+                return
+            // the first callback only brings the counts of the events when they were queued
+            if (first) {
+                first = false
+                return
+            }
+            // a listener cancelling its events frees the counts
+            for (i in names.indices) {
+                if (cancelled)
+                    break
+                val count = counts[i].toInt()
+                if (count != 0)
+                    listener.onEvent(names[i], count)
+            }
+        }
+
+        fun cancel(statusArray: CPointer<ISC_STATUSVar>?): STATUS {
+            cancelled = true
+            return isc_cancel_events(statusArray, db.ptr, id.ptr)
+        }
+
+        fun free() {
+            ref.dispose()
+            nativeHeap.free(db)
+            nativeHeap.free(id)
+            nativeHeap.free(block)
+            nativeHeap.free(counts)
+            nativeHeap.free(status)
+        }
+
+        companion object {
+            val callback = staticCFunction { argument: COpaquePointer?, length: ISC_USHORT, updated: CPointer<ISC_UCHARVar>? ->
+                // a zero length for cancelled events or a lost attachment
+                if (argument != null && updated != null && length.toInt() != 0) {
+                    val queue = argument.asStableRef<EventQueue>().get()
+                    val bytes = updated.readBytes(length.toInt())
+                    queue.worker.executeAfter(0L) { queue.dispatch(bytes) }
+                }
+            }
+        }
+    }
+
+    /**
+     * Listens to events posted with POST_EVENT, until [cancelEvents] is called.
+     *
+     * @param status The handle to the status array.
+     * @param dbHandle The handle to the database connection.
+     * @param names The names of the events, at most 255 bytes each.
+     * @param listener Called on a worker dedicated to the events.
+     * @return The handle of the queued events.
+     */
+    @OptIn(ObsoleteWorkersApi::class)
+    actual fun queEvents(status: HANDLE, dbHandle: HANDLE, names: Array<String>, listener: EventListener): HANDLE {
+        val encoded = names.map { it.encodeToByteArray() }
+        val invalid = encoded.indexOfFirst { it.isEmpty() || it.size > 255 }
+        if (encoded.isEmpty() || invalid >= 0)
+            throw FirebirdException("$ERR_OUT_OF_BOUND: ${maxOf(invalid, 0)}")
+        val length = 1 + encoded.sumOf { it.size + 5 }
+        val queue = EventQueue(dbHandle.toCPointer<FB_API_HANDLEVar>()!!.pointed.value, names, listener, length)
+        var position: size_t = 0u
+        for (name in encoded)
+            position = name.usePinned { fbcore_event_name(queue.block, position, it.addressOf(0), name.size.convert()) }
+        val statusArray = status.toCPointer<ISC_STATUSVar>()
+        val ret = queue.worker.execute(TransferMode.SAFE, { queue }) { it.queue(statusArray) }.result
+        if (ret != 0L) {
+            queue.worker.requestTermination().result
+            queue.free()
+            checkStatus(status, ret)
+        }
+        return queue.ref.asCPointer().toLong()
+    }
+
+    /**
+     * Stops listening to events queued by [queEvents] and releases them; the listener may cancel its own events.
+     *
+     * @param status The handle to the status array.
+     * @param events The handle of the queued events.
+     * @return The status of the cancellation.
+     */
+    @OptIn(ObsoleteWorkersApi::class)
+    actual fun cancelEvents(status: HANDLE, events: HANDLE): STATUS {
+        val queue = events.toCPointer<CPointed>()?.asStableRef<EventQueue>()?.get()
+            ?: throw FirebirdException(ERR_INVALID_HANDLE)
+        val statusArray = status.toCPointer<ISC_STATUSVar>()
+        val ret = if (Worker.current == queue.worker)
+            queue.cancel(statusArray)
+        else
+            queue.worker.execute(TransferMode.SAFE, { queue }) { it.cancel(statusArray) }.result
+        val terminated = queue.worker.requestTermination(processScheduledJobs = false)
+        if (Worker.current != queue.worker)
+            terminated.result
+        queue.free()
+        return ret
+    }
+
+    /**
+     * Rows packed by fbcore_pack_row one after the other in a heap array grown by doubling, with their offsets.
+     */
+    private class PackedRows {
+        var data = ByteArray(0)
+        var size = 0
+        val offsets = ArrayList<Int>()
+
+        fun append(sqlda: CPointer<XSQLDA>) {
+            val length = fbcore_packed_size(sqlda).toLong()
+            if (size + length >= Int.MAX_VALUE)
+                throw OutOfMemoryError()
+            // the array stays larger than its rows, so that the offset of a new row is always inside it
+            if (size + length >= data.size) {
+                val capacity = maxOf(size + length + 1, data.size * 2L, 4096L)
+                data = data.copyOf(capacity.coerceAtMost(Int.MAX_VALUE.toLong()).toInt())
+            }
+            data.usePinned { fbcore_pack_row(sqlda, it.addressOf(size)) }
+            offsets.add(size)
+            size += length.toInt()
+        }
+
+        fun unpack(sqlda: CPointer<XSQLDA>, row: Long): Boolean {
+            if (row < 0 || row >= offsets.size)
+                return false
+            data.usePinned { fbcore_unpack_row(sqlda, it.addressOf(offsets[row.toInt()])) }
+            return true
+        }
+    }
+
+    private inline fun HANDLE.toPackedRows() = toCPointer<CPointed>()?.asStableRef<PackedRows>()?.get()
+
+    /**
+     * Creates a spool, a store of rows kept in memory by the native targets.
+     *
+     * @param directory Not used, the rows are not written to files.
+     * @return The spool handle, released with [freeSpool].
+     */
+    actual fun createSpool(directory: String?): HANDLE = StableRef.create(PackedRows()).asCPointer().toLong()
+
+    /**
+     * Releases a spool created by [createSpool].
+     */
+    actual fun freeSpool(spool: HANDLE) {
+        spool.toCPointer<CPointed>()?.asStableRef<PackedRows>()?.dispose()
+    }
+
+    /**
+     * Returns the number of rows stored in a spool.
+     */
+    actual fun getSpoolCount(spool: HANDLE): Long = spool.toPackedRows()?.offsets?.size?.toLong() ?: 0L
+
+    /**
+     * Appends the current row of an XSQLDA to a spool, then fetches and appends the following ones until count rows
+     * are stored or the cursor is exhausted.
+     *
+     * @param count The maximum number of rows to store, all the remaining rows when 0 or less.
+     * @return False when the cursor is exhausted.
+     */
+    actual fun spoolRows(status: HANDLE, stHandle: HANDLE, sqlda: HANDLE, spool: HANDLE, count: Int): Boolean {
+        val p = sqlda.toXSQLDA()
+        val target = spool.toPackedRows()
+        if (p == null || target == null)
+            throw FirebirdException(ERR_INVALID_HANDLE)
+        var rows = 0
+        while (count <= 0 || rows < count) {
+            target.append(p.ptr)
+            val ret = fetch(status, stHandle, sqlda)
+            if (ret != 0L) {
+                if (ret != 100L)
+                    checkStatus(status, ret)
+                return false
+            }
+            rows++
+        }
+        return true
+    }
+
+    /**
+     * Restores a row of a spool into the XSQLDA it was fetched into, where the getters read it as a fetched row.
+     *
+     * @param row The number of the row, from 0.
+     * @return False when the spool has no such row; the XSQLDA is left unchanged then.
+     */
+    actual fun spoolSeek(sqlda: HANDLE, spool: HANDLE, row: Long): Boolean {
+        val p = sqlda.toXSQLDA()
+        val source = spool.toPackedRows()
+        if (p == null || source == null)
+            throw FirebirdException(ERR_INVALID_HANDLE)
+        return source.unpack(p.ptr, row)
+    }
+
+    /**
+     * The key of cached rows: the SQL text of the query and its parameters packed by fbcore_pack_row.
+     */
+    private class CacheKey(val sql: String, val params: ByteArray) {
+        override fun equals(other: Any?) = other is CacheKey && sql == other.sql && params.contentEquals(other.params)
+        override fun hashCode() = sql.hashCode() * 31 + params.contentHashCode()
+    }
+
+    private class CachedRows(val key: CacheKey, val tags: List<String>, val rows: PackedRows) {
+        val bytes = key.sql.length * 2L + key.params.size + rows.data.size + rows.offsets.size * 4L
+    }
+
+    /**
+     * Result sets cached in memory. The events are listened to by [queEvents], whose listener runs on a worker of its
+     * own, so the entries and the counters are guarded by a spin lock, only held for a few map operations; reader
+     * handles are stable references to the packed rows, which outlive an eviction until they are released.
+     */
+    private class ResultCache(dbHandle: FB_API_HANDLE, val limit: Long) {
+        val db = nativeHeap.alloc<FB_API_HANDLEVar>().apply { value = dbHandle }
+        val ref = StableRef.create(this)
+        private val lock = AtomicInt(0)
+        // most recently used last, the first one evicted
+        private val entries = LinkedHashMap<CacheKey, CachedRows>()
+        private var bytes = 0L
+        private var generation = 0L
+        private var hits = 0L
+        private var misses = 0L
+        private var evictions = 0L
+        private var invalidations = 0L
+        // guards the events and the names they listen to
+        private val listening = AtomicInt(0)
+        private var events = 0L
+        private var listened = emptyList<String>()
+
+        private inline fun <T> locked(lock: AtomicInt, block: () -> T): T {
+            while (!lock.compareAndSet(0, 1)) {
+                // the holder only runs a few map operations
+            }
+            try {
+                return block()
+            } finally {
+                lock.value = 0
+            }
+        }
+
+        fun lookup(key: CacheKey): PackedRows? = locked(lock) {
+            val found = entries.remove(key)
+            if (found == null) {
+                misses++
+            } else {
+                hits++
+                entries[key] = found
+            }
+            found?.rows
+        }
+
+        // stores an entry unless an event was posted since generation, when its rows were read
+        fun store(rows: CachedRows, since: Long) = locked(lock) {
+            if (since == generation && rows.bytes <= limit) {
+                entries.remove(rows.key)?.let { bytes -= it.bytes }
+                val iterator = entries.values.iterator()
+                while (iterator.hasNext() && bytes + rows.bytes > limit) {
+                    bytes -= iterator.next().bytes
+                    iterator.remove()
+                    evictions++
+                }
+                entries[rows.key] = rows
+                bytes += rows.bytes
+            }
+        }
+
+        // drops the entries tagged with an event, every entry when tag is null
+        fun invalidate(tag: String?) = locked(lock) {
+            generation++
+            val iterator = entries.values.iterator()
+            while (iterator.hasNext()) {
+                val entry = iterator.next()
+                if (tag == null || tag in entry.tags) {
+                    bytes -= entry.bytes
+                    iterator.remove()
+                    invalidations++
+                }
+            }
+        }
+
+        fun since(): Long = locked(lock) { generation }
+
+        fun stats(): LongArray = locked(lock) {
+            longArrayOf(hits, misses, entries.size.toLong(), bytes, evictions, invalidations)
+        }
+
+        /**
+         * Listens to the tags not listened to yet, with new events queued before the previous ones are cancelled so
+         * that no event is missed in between.
+         */
+        fun listen(status: HANDLE, tags: List<String>) = locked(listening) {
+            val names = (listened + tags).distinct()
+            if (names.size != listened.size) {
+                val next = API.queEvents(status, db.ptr.toLong(), names.toTypedArray()) { name, _ -> invalidate(name) }
+                val previous = events
+                events = next
+                listened = names
+                if (previous != 0L)
+                    cancel(previous)
+            }
+        }
+
+        fun free() {
+            locked(listening) {
+                if (events != 0L)
+                    cancel(events)
+                events = 0L
+            }
+            ref.dispose()
+            nativeHeap.free(db)
+        }
+
+        private fun cancel(events: HANDLE) = memScoped {
+            val ignored = allocArray<ISC_STATUSVar>(ISC_STATUS_LENGTH)
+            API.cancelEvents(ignored.toLong(), events)
+        }
+    }
+
+    private inline fun HANDLE.toResultCache() = toCPointer<CPointed>()?.asStableRef<ResultCache>()?.get()
+
+    private fun cacheKey(sql: String, input: HANDLE): CacheKey {
+        val p = input.toXSQLDA()
+        if (p == null || p.sqld.toInt() == 0)
+            return CacheKey(sql, ByteArray(0))
+        val params = ByteArray(fbcore_packed_size(p.ptr).toInt())
+        if (params.isNotEmpty())
+            params.usePinned { fbcore_pack_row(p.ptr, it.addressOf(0)) }
+        return CacheKey(sql, params)
+    }
+
+    /**
+     * Creates a result cache, holding result sets in memory up to maxBytes, least recently used first evicted.
+     *
+     * Entries tagged with event names are dropped when one of these events is posted, the cache listens to them on
+     * the attachment of dbHandle; free the cache before detaching it.
+     *
+     * @return The cache handle, released with [freeResultCache].
+     */
+    actual fun createResultCache(dbHandle: HANDLE, maxBytes: Long): HANDLE {
+        val db = dbHandle.toCPointer<FB_API_HANDLEVar>() ?: throw FirebirdException(ERR_INVALID_HANDLE)
+        return ResultCache(db.pointed.value, maxOf(maxBytes, 0L)).ref.asCPointer().toLong()
+    }
+
+    /**
+     * Releases a cache created by [createResultCache]; the rows returned by [cacheLookup] or [cacheRows] stay valid
+     * until they are released.
+     */
+    actual fun freeResultCache(cache: HANDLE) {
+        cache.toResultCache()?.free()
+    }
+
+    /**
+     * Looks up the rows of a query, counted as a hit or a miss.
+     *
+     * @param sql The SQL text of the query.
+     * @param input The input XSQLDA of the query with its parameters set, or 0 without parameters.
+     * @return The cached rows, released with [releaseCachedRows], or 0 on a miss.
+     */
+    actual fun cacheLookup(cache: HANDLE, sql: String, input: HANDLE): HANDLE {
+        val target = cache.toResultCache() ?: throw FirebirdException(ERR_INVALID_HANDLE)
+        val rows = target.lookup(cacheKey(sql, input)) ?: return 0L
+        return StableRef.create(rows).asCPointer().toLong()
+    }
+
+    /**
+     * Fetches every row of an executed cursor, from the first one, and stores them in a cache.
+     *
+     * The rows are not stored when one of the tags is posted while they are read, or when they exceed the memory
+     * limit of the cache; they are returned all the same.
+     *
+     * @param sql The SQL text of the query, see [cacheLookup].
+     * @param input The input XSQLDA the cursor was executed with, or 0.
+     * @param tags The events that invalidate the rows, at most 255 bytes each, or null.
+     * @return The rows, released with [releaseCachedRows].
+     */
+    actual fun cacheRows(status: HANDLE, stHandle: HANDLE, sqlda: HANDLE, cache: HANDLE, sql: String, input: HANDLE,
+                         tags: Array<String>?): HANDLE {
+        val p = sqlda.toXSQLDA()
+        val target = cache.toResultCache()
+        if (p == null || target == null)
+            throw FirebirdException(ERR_INVALID_HANDLE)
+        val key = cacheKey(sql, input)
+        val names = tags?.toList() ?: emptyList()
+        if (names.isNotEmpty())
+            target.listen(status, names)
+        // the events are listened to before the rows are read, an event posted while reading them discards the entry
+        val since = target.since()
+        val rows = PackedRows()
+        while (true) {
+            val ret = fetch(status, stHandle, sqlda)
+            if (ret != 0L) {
+                if (ret != 100L) {
+                    checkStatus(status, ret)
+                    return 0L
+                }
+                break
+            }
+            rows.append(p.ptr)
+        }
+        target.store(CachedRows(key, names, rows), since)
+        return StableRef.create(rows).asCPointer().toLong()
+    }
+
+    /**
+     * Returns the number of rows returned by [cacheLookup] or [cacheRows].
+     */
+    actual fun getCachedCount(rows: HANDLE): Long = getSpoolCount(rows)
+
+    /**
+     * Restores a row of cached rows into the XSQLDA of the query, where the getters read it as a fetched row.
+     *
+     * @param row The number of the row, from 0.
+     * @return False when there is no such row; the XSQLDA is left unchanged then.
+     */
+    actual fun cacheSeek(sqlda: HANDLE, rows: HANDLE, row: Long): Boolean = spoolSeek(sqlda, rows, row)
+
+    /**
+     * Releases rows returned by [cacheLookup] or [cacheRows].
+     */
+    actual fun releaseCachedRows(rows: HANDLE) = freeSpool(rows)
+
+    /**
+     * Drops the entries of a cache tagged with an event, or every entry when tag is null.
+     */
+    actual fun cacheInvalidate(cache: HANDLE, tag: String?) {
+        val target = cache.toResultCache() ?: throw FirebirdException(ERR_INVALID_HANDLE)
+        target.invalidate(tag)
+    }
+
+    /**
+     * Returns the counters of a cache: hits, misses, entries, bytes, evictions and invalidations.
+     */
+    actual fun getCacheStats(cache: HANDLE): LongArray = cache.toResultCache()?.stats() ?: LongArray(6)
+}
@@ -0,0 +1,1025 @@
+/*
+ * Micro-benchmarks of the native kernels of the JNI layer.
+ *
+ * The JNI translation unit is compiled into the benchmark so its internal functions can be called directly, the
+ * kernels of the conversion core (fbcore_allocate_data_buffer, fbcore_utf8_size) are linked from libfbcore, and
+ * calls to the client library go to fbclient_stub, so no server is involved.
+ *
+ * By default the JNI functions receive a minimal JNIEnv implemented here: strings and arrays are plain buffers, so
+ * the numbers measure the native side alone. When a JDK was found at configure time, --jvm starts a JVM through the
+ * Invocation API and uses its JNIEnv, adding the cost of the JVM string and array functions.
+ *
+ * usage: jnifbclient_bench [--filter=text] [--time=ms] [--blob-size=bytes] [--format=text|csv|json] [--jvm]
+ */
+
+#include "../firebird-lib-jni.cpp"
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// minimal JNIEnv: objects created while measuring are recycled from small pools, local references are never deleted
+
+struct FakeString {
+    std::string utf8;
+    jsize length;
+};
+
+struct FakeArray {
+    std::vector<char> data;
+    jsize length;
+};
+
+constexpr int FAKE_POOL = 64;
+
+FakeString fakeStrings[FAKE_POOL];
+FakeArray fakeArrays[FAKE_POOL];
+int nextFakeString = 0;
+int nextFakeArray = 0;
+
+// objects created while the benchmarks are set up live until the end
+bool fakeRecycle = false;
+std::deque<FakeString> fakePinnedStrings;
+std::deque<FakeArray> fakePinnedArrays;
+
+jsize utf16Length(const char* utf8, size_t size) {
+    jsize length = 0;
+    for (size_t i = 0; i < size; i++) {
+        auto c = (unsigned char)utf8[i];
+        if ((c & 0xC0) != 0x80)
+            length += c >= 0xF0 ? 2 : 1;
+    }
+    return length;
+}
+
+jstring JNICALL fakeNewStringUTF(JNIEnv*, const char* utf) {
+    auto string = fakeRecycle ? &fakeStrings[nextFakeString++ % FAKE_POOL]
+                              : (fakePinnedStrings.emplace_back(), &fakePinnedStrings.back());
+    string->utf8.assign(utf);
+    string->length = utf16Length(string->utf8.data(), string->utf8.size());
+    return reinterpret_cast<jstring>(string);
+}
+
+jsize JNICALL fakeGetStringLength(JNIEnv*, jstring str) {
+    return reinterpret_cast<FakeString*>(str)->length;
+}
+
+const char* JNICALL fakeGetStringUTFChars(JNIEnv*, jstring str, jboolean* isCopy) {
+    if (isCopy != nullptr)
+        *isCopy = JNI_FALSE;
+    return reinterpret_cast<FakeString*>(str)->utf8.c_str();
+}
+
+void JNICALL fakeReleaseStringUTFChars(JNIEnv*, jstring, const char*) {
+}
+
+jarray fakeNewArray(jsize length, size_t elementSize) {
+    auto array = fakeRecycle ? &fakeArrays[nextFakeArray++ % FAKE_POOL]
+                             : (fakePinnedArrays.emplace_back(), &fakePinnedArrays.back());
+    array->data.assign(length * elementSize, 0);
+    array->length = length;
+    return reinterpret_cast<jarray>(array);
+}
+
+jbyteArray JNICALL fakeNewByteArray(JNIEnv*, jsize length) {
+    return reinterpret_cast<jbyteArray>(fakeNewArray(length, sizeof(jbyte)));
+}
+
+jlongArray JNICALL fakeNewLongArray(JNIEnv*, jsize length) {
+    return reinterpret_cast<jlongArray>(fakeNewArray(length, sizeof(jlong)));
+}
+
+jsize JNICALL fakeGetArrayLength(JNIEnv*, jarray array) {
+    return reinterpret_cast<FakeArray*>(array)->length;
+}
+
+jbyte* JNICALL fakeGetByteArrayElements(JNIEnv*, jbyteArray array, jboolean* isCopy) {
+    if (isCopy != nullptr)
+        *isCopy = JNI_FALSE;
+    return reinterpret_cast<jbyte*>(reinterpret_cast<FakeArray*>(array)->data.data());
+}
+
+void JNICALL fakeReleaseByteArrayElements(JNIEnv*, jbyteArray, jbyte*, jint) {
+}
+
+void JNICALL fakeSetByteArrayRegion(JNIEnv*, jbyteArray array, jsize start, jsize len, const jbyte* buf) {
+    memcpy(reinterpret_cast<FakeArray*>(array)->data.data() + start, buf, len);
+}
+
+jlong* JNICALL fakeGetLongArrayElements(JNIEnv*, jlongArray array, jboolean* isCopy) {
+    if (isCopy != nullptr)
+        *isCopy = JNI_FALSE;
+    return reinterpret_cast<jlong*>(reinterpret_cast<FakeArray*>(array)->data.data());
+}
+
+void JNICALL fakeReleaseLongArrayElements(JNIEnv*, jlongArray, jlong*, jint) {
+}
+
+void JNICALL fakeSetLongArrayRegion(JNIEnv*, jlongArray array, jsize start, jsize len, const jlong* buf) {
+    memcpy(reinterpret_cast<FakeArray*>(array)->data.data() + start * sizeof(jlong), buf, len * sizeof(jlong));
+}
+
+jdoubleArray JNICALL fakeNewDoubleArray(JNIEnv*, jsize length) {
+    return reinterpret_cast<jdoubleArray>(fakeNewArray(length, sizeof(jdouble)));
+}
+
+void JNICALL fakeGetDoubleArrayRegion(JNIEnv*, jdoubleArray array, jsize start, jsize len, jdouble* buf) {
+    memcpy(buf, reinterpret_cast<FakeArray*>(array)->data.data() + start * sizeof(jdouble), len * sizeof(jdouble));
+}
+
+void JNICALL fakeSetDoubleArrayRegion(JNIEnv*, jdoubleArray array, jsize start, jsize len, const jdouble* buf) {
+    memcpy(reinterpret_cast<FakeArray*>(array)->data.data() + start * sizeof(jdouble), buf, len * sizeof(jdouble));
+}
+
+void JNICALL fakeDeleteLocalRef(JNIEnv*, jobject) {
+}
+
+// a direct ByteBuffer is its memory
+struct FakeDirectBuffer {
+    std::vector<char> data;
+};
+
+void* JNICALL fakeGetDirectBufferAddress(JNIEnv*, jobject buffer) {
+    return reinterpret_cast<FakeDirectBuffer*>(buffer)->data.data();
+}
+
+jlong JNICALL fakeGetDirectBufferCapacity(JNIEnv*, jobject buffer) {
+    return (jlong)reinterpret_cast<FakeDirectBuffer*>(buffer)->data.size();
+}
+
+jclass JNICALL fakeFindClass(JNIEnv*, const char*) {
+    static int dummy;
+    return reinterpret_cast<jclass>(&dummy);
+}
+
+// a benchmark must only exercise successful conversions
+jint JNICALL fakeThrowNew(JNIEnv*, jclass, const char* message) {
+    fprintf(stderr, "unexpected exception: %s\n", message);
+    exit(2);
+}
+
+JNIEnv* fakeEnv() {
+    static JNINativeInterface_ functions;
+    static JNIEnv env;
+    functions.NewStringUTF = fakeNewStringUTF;
+    functions.GetStringLength = fakeGetStringLength;
+    functions.GetStringUTFChars = fakeGetStringUTFChars;
+    functions.ReleaseStringUTFChars = fakeReleaseStringUTFChars;
+    functions.NewByteArray = fakeNewByteArray;
+    functions.NewLongArray = fakeNewLongArray;
+    functions.GetArrayLength = fakeGetArrayLength;
+    functions.GetByteArrayElements = fakeGetByteArrayElements;
+    functions.ReleaseByteArrayElements = fakeReleaseByteArrayElements;
+    functions.SetByteArrayRegion = fakeSetByteArrayRegion;
+    functions.GetLongArrayElements = fakeGetLongArrayElements;
+    functions.ReleaseLongArrayElements = fakeReleaseLongArrayElements;
+    functions.SetLongArrayRegion = fakeSetLongArrayRegion;
+    functions.NewDoubleArray = fakeNewDoubleArray;
+    functions.GetDoubleArrayRegion = fakeGetDoubleArrayRegion;
+    functions.SetDoubleArrayRegion = fakeSetDoubleArrayRegion;
+    functions.DeleteLocalRef = fakeDeleteLocalRef;
+    functions.GetDirectBufferAddress = fakeGetDirectBufferAddress;
+    functions.GetDirectBufferCapacity = fakeGetDirectBufferCapacity;
+    functions.FindClass = fakeFindClass;
+    functions.ThrowNew = fakeThrowNew;
+    env.functions = &functions;
+    return &env;
+}
+
+#ifdef BENCH_JVM
+JNIEnv* jvmEnv() {
+    JavaVM* vm = nullptr;
+    JNIEnv* env = nullptr;
+    JavaVMOption options[1];
+    options[0].optionString = (char*)"-Xrs";
+    JavaVMInitArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.nOptions = 1;
+    args.options = options;
+    args.ignoreUnrecognized = JNI_FALSE;
+    if (JNI_CreateJavaVM(&vm, (void**)&env, &args) != JNI_OK)
+        return nullptr;
+    return env;
+}
+#endif
+
+// column types, sqllen is in bytes
+
+struct ColumnType {
+    const char* name;
+    ISC_SHORT type;
+    ISC_SHORT length;
+    ISC_SHORT scale;
+    ISC_SHORT subtype;
+};
+
+const ColumnType BOOLEAN_TYPE = {"boolean", SQL_BOOLEAN, sizeof(FB_BOOLEAN), 0, 0};
+const ColumnType SMALLINT_TYPE = {"smallint", SQL_SHORT, sizeof(ISC_SHORT), 0, 0};
+const ColumnType INTEGER_TYPE = {"integer", SQL_LONG, sizeof(ISC_LONG), 0, 0};
+const ColumnType BIGINT_TYPE = {"bigint", SQL_INT64, sizeof(ISC_INT64), 0, 0};
+const ColumnType NUMERIC_TYPE = {"numeric(18,2)", SQL_INT64, sizeof(ISC_INT64), -2, 0};
+const ColumnType INT128_TYPE = {"int128", SQL_INT128, sizeof(FB_I128), 0, 0};
+const ColumnType FLOAT_TYPE = {"float", SQL_FLOAT, sizeof(float), 0, 0};
+const ColumnType DOUBLE_TYPE = {"double", SQL_DOUBLE, sizeof(double), 0, 0};
+const ColumnType DATE_TYPE = {"date", SQL_TYPE_DATE, sizeof(ISC_DATE), 0, 0};
+const ColumnType TIME_TYPE = {"time", SQL_TYPE_TIME, sizeof(ISC_TIME), 0, 0};
+const ColumnType TIMESTAMP_TYPE = {"timestamp", SQL_TIMESTAMP, sizeof(ISC_TIMESTAMP), 0, 0};
+const ColumnType TIME_TZ_TYPE = {"time_tz", SQL_TIME_TZ, sizeof(ISC_TIME_TZ), 0, 0};
+const ColumnType TIMESTAMP_TZ_TYPE = {"timestamp_tz", SQL_TIMESTAMP_TZ, sizeof(ISC_TIMESTAMP_TZ), 0, 0};
+const ColumnType CHAR_TYPE = {"char(32)", SQL_TEXT, 32 * 4, 0, 4};
+const ColumnType VARCHAR_TYPE = {"varchar(32)", SQL_VARYING, 32 * 4, 0, 4};
+const ColumnType LONG_VARCHAR_TYPE = {"varchar(255)", SQL_VARYING, 255 * 4, 0, 4};
+const ColumnType OCTETS_TYPE = {"varbinary(255)", SQL_VARYING, 255, 0, 1};
+const ColumnType BLOB_TYPE = {"blob", SQL_BLOB, sizeof(ISC_QUAD), 0, 0};
+const ColumnType TEXT_TYPE = {"text", SQL_BLOB, sizeof(ISC_QUAD), 0, 1};
+const ColumnType ARRAY_TYPE = {"array", SQL_ARRAY, sizeof(ISC_QUAD), 0, 0};
+
+struct Mix {
+    const char* name;
+    std::vector<ColumnType> columns;
+    std::vector<bool> nullable;
+};
+
+const Mix MIXES[] = {
+    {"narrow", {INTEGER_TYPE, BIGINT_TYPE, DOUBLE_TYPE, DATE_TYPE}, {false, false, false, false}},
+    {"mixed", {INTEGER_TYPE, VARCHAR_TYPE, BIGINT_TYPE, NUMERIC_TYPE, DOUBLE_TYPE, TIMESTAMP_TYPE, BOOLEAN_TYPE,
+               LONG_VARCHAR_TYPE}, {false, false, false, false, false, false, false, true}},
+    {"wide-text", {CHAR_TYPE, VARCHAR_TYPE, LONG_VARCHAR_TYPE, LONG_VARCHAR_TYPE, LONG_VARCHAR_TYPE, TEXT_TYPE},
+     {false, true, true, true, true, true}},
+};
+
+/**
+ * A described XSQLDA with its data buffer, freed as freeSQLDA does.
+ */
+class Sqlda {
+public:
+    explicit Sqlda(const std::vector<ColumnType>& columns, const std::vector<bool>& nullable = {}) {
+        auto count = (ISC_SHORT)columns.size();
+        sqlda = allocSQLDA(count);
+        describe(columns, nullable);
+        allocateDataBuffer(sqlda);
+    }
+
+    ~Sqlda() {
+        fbcore_free_sqlda(sqlda);
+    }
+
+    void describe(const std::vector<ColumnType>& columns, const std::vector<bool>& nullable) {
+        sqlda->sqld = (ISC_SHORT)columns.size();
+        for (size_t i = 0; i < columns.size(); i++) {
+            auto var = &sqlda->sqlvar[i];
+            var->sqltype = (ISC_SHORT)(columns[i].type | (i < nullable.size() && nullable[i] ? 1 : 0));
+            var->sqllen = columns[i].length;
+            var->sqlscale = columns[i].scale;
+            var->sqlsubtype = columns[i].subtype;
+        }
+    }
+
+    // the jlong handle expected by the JNI functions
+    jlong handle() {
+        return reinterpret_cast<jlong>(&sqlda);
+    }
+
+    XSQLDA* sqlda;
+};
+
+struct Result {
+    std::string name;
+    double nanos;
+    double best;
+    double bytes;
+};
+
+struct Benchmark {
+    std::string name;
+    // bytes processed by one operation, 0 when not meaningful
+    double bytes;
+    // runs the given number of operations
+    std::function<void(uint64_t)> run;
+};
+
+volatile uint64_t sink;
+
+Result measure(const Benchmark& benchmark, uint64_t targetNanos) {
+    // grows the batch until it runs long enough for the clock resolution
+    uint64_t iterations = 1;
+    uint64_t elapsed = 0;
+    while (true) {
+        auto start = nanoTime();
+        benchmark.run(iterations);
+        elapsed = nanoTime() - start;
+        if (elapsed >= 10000000 || iterations >= (1ULL << 40))
+            break;
+        iterations *= 2;
+    }
+    constexpr int ROUNDS = 5;
+    iterations = std::max<uint64_t>(1, (uint64_t)((double)iterations * targetNanos / ROUNDS / std::max<uint64_t>(elapsed, 1)));
+    std::vector<double> samples;
+    for (int i = 0; i < ROUNDS; i++) {
+        auto start = nanoTime();
+        benchmark.run(iterations);
+        samples.push_back((double)(nanoTime() - start) / (double)iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return Result{benchmark.name, samples[ROUNDS / 2], samples[0], benchmark.bytes};
+}
+
+std::string utf8Text(int chars, bool multibyte) {
+    std::string text;
+    for (int i = 0; i < chars; i++)
+        text += multibyte && i % 2 == 1 ? "\xC3\xA9" : std::string(1, (char)('a' + i % 26));
+    return text;
+}
+
+// writes a representative value in the first column, as a fetch would
+void fill(Sqlda& row, const std::string& text) {
+    auto var = &row.sqlda->sqlvar[0];
+    if (var->sqlind != nullptr)
+        *var->sqlind = 0;
+    auto data = var->sqldata;
+    switch (var->sqltype & ~1) {
+        case SQL_BOOLEAN: *(FB_BOOLEAN*)data = 1; break;
+        case SQL_SHORT: *(ISC_SHORT*)data = 12345; break;
+        case SQL_LONG: *(ISC_LONG*)data = 123456789; break;
+        case SQL_INT64: *(ISC_INT64*)data = 1234567890123LL; break;
+        case SQL_INT128: ((FB_I128*)data)->fb_data[0] = 1234567890123ULL; break;
+        case SQL_FLOAT: *(float*)data = 1.5f; break;
+        case SQL_DOUBLE: *(double*)data = 1.25; break;
+        case SQL_TYPE_DATE: *(ISC_DATE*)data = 58849; break;
+        case SQL_TYPE_TIME: *(ISC_TIME*)data = 3600 * ISC_TIME_SECONDS_PRECISION; break;
+        case SQL_TIMESTAMP:
+            ((ISC_TIMESTAMP*)data)->timestamp_date = 58849;
+            ((ISC_TIMESTAMP*)data)->timestamp_time = 3600 * ISC_TIME_SECONDS_PRECISION;
+            break;
+        case SQL_TIME_TZ: ((ISC_TIME_TZ*)data)->utc_time = 3600 * ISC_TIME_SECONDS_PRECISION; break;
+        case SQL_TIMESTAMP_TZ: ((ISC_TIMESTAMP_TZ*)data)->utc_timestamp.timestamp_date = 58849; break;
+        case SQL_TEXT:
+            memset(data, ' ', var->sqllen);
+            memcpy(data, text.data(), std::min(text.size(), (size_t)var->sqllen));
+            break;
+        case SQL_VARYING: {
+            auto vary = (PARAMVARY*)data;
+            vary->vary_length = (ISC_USHORT)std::min(text.size(), (size_t)var->sqllen);
+            memcpy(vary->vary_string, text.data(), vary->vary_length);
+            break;
+        }
+        case SQL_BLOB:
+            ((ISC_QUAD*)data)->gds_quad_low = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+class Suite {
+public:
+    Suite(JNIEnv* env, uint32_t blobSize) : env(env), blobSize(blobSize) {
+        status = Java_com_progdigy_fbclient_API_allocStatusArray(env, nullptr);
+        auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+        attach_database(statusArray, 0, "stub", &db, 0, nullptr);
+        start_transaction(statusArray, &tr, 1, &db, 0, nullptr);
+    }
+
+    ~Suite() {
+        Java_com_progdigy_fbclient_API_freeStatusArray(env, nullptr, status);
+        for (auto& file : files)
+            unlink(file.c_str());
+    }
+
+    void add(const std::string& name, double bytes, std::function<void(uint64_t)> run) {
+        benchmarks.push_back(Benchmark{name, bytes, std::move(run)});
+    }
+
+    void allocation() {
+        for (auto& mix : MIXES) {
+            auto row = std::make_shared<Sqlda>(mix.columns, mix.nullable);
+            add(std::string("allocateDataBuffer/") + mix.name, (double)messageSize(row->sqlda), [row](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++) {
+                    fbcore_free_data_buffer(row->sqlda);
+                    allocateDataBuffer(row->sqlda);
+                }
+            });
+        }
+    }
+
+    void utf8() {
+        const struct { const char* name; int chars; bool multibyte; } texts[] = {
+            {"ascii-32", 32, false}, {"ascii-255", 255, false}, {"utf8-255", 255, true}};
+        for (auto& text : texts) {
+            auto value = utf8Text(text.chars, text.multibyte);
+            auto len = (ISC_SHORT)(text.chars * 4);
+            auto buffer = std::make_shared<std::vector<char>>(len + 1, ' ');
+            memcpy(buffer->data(), value.data(), value.size());
+            (*buffer)[len] = 0;
+            add(std::string("utf8_size/") + text.name, (double)len, [buffer, len](uint64_t n) {
+                size_t total = 0;
+                for (uint64_t i = 0; i < n; i++)
+                    total += fbcore_utf8_size(buffer->data(), len / 4, len);
+                sink = total;
+            });
+        }
+    }
+
+    template<typename T>
+    void getter(const char* name, T (JNICALL *get)(JNIEnv*, jclass, jlong, jint), const ColumnType& type) {
+        auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{type});
+        fill(*row, "");
+        auto env = this->env;
+        add(std::string(name) + "/" + type.name, (double)type.length, [row, env, get](uint64_t n) {
+            auto handle = row->handle();
+            uint64_t total = 0;
+            for (uint64_t i = 0; i < n; i++)
+                total += (uint64_t)get(env, nullptr, handle, 0);
+            sink = total;
+        });
+    }
+
+    template<typename T>
+    void objectGetter(const char* name, T (JNICALL *get)(JNIEnv*, jclass, jlong, jlong, jlong, jlong, jint),
+                      const ColumnType& type, const std::string& text, double bytes) {
+        auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{type});
+        fill(*row, text);
+        auto env = this->env;
+        auto status = this->status;
+        auto db = reinterpret_cast<jlong>(&this->db);
+        auto tr = reinterpret_cast<jlong>(&this->tr);
+        add(std::string(name) + "/" + type.name, bytes, [=](uint64_t n) {
+            auto handle = row->handle();
+            for (uint64_t i = 0; i < n; i++)
+                env->DeleteLocalRef(get(env, nullptr, status, db, tr, handle, (jint)0));
+        });
+    }
+
+    void getters() {
+        getter("getValueBoolean", Java_com_progdigy_fbclient_API_getValueBoolean, BOOLEAN_TYPE);
+        getter("getValueShort", Java_com_progdigy_fbclient_API_getValueShort, SMALLINT_TYPE);
+        for (auto& type : {INTEGER_TYPE, SMALLINT_TYPE})
+            getter("getValueInt", Java_com_progdigy_fbclient_API_getValueInt, type);
+        for (auto& type : {BIGINT_TYPE, INTEGER_TYPE, SMALLINT_TYPE})
+            getter("getValueLong", Java_com_progdigy_fbclient_API_getValueLong, type);
+        getter("getValueFloat", Java_com_progdigy_fbclient_API_getValueFloat, FLOAT_TYPE);
+        for (auto& type : {DOUBLE_TYPE, FLOAT_TYPE})
+            getter("getValueDouble", Java_com_progdigy_fbclient_API_getValueDouble, type);
+        for (auto& type : {DATE_TYPE, TIMESTAMP_TYPE, TIMESTAMP_TZ_TYPE})
+            getter("getValueDate", Java_com_progdigy_fbclient_API_getValueDate, type);
+        for (auto& type : {TIME_TYPE, TIMESTAMP_TYPE, TIME_TZ_TYPE, TIMESTAMP_TZ_TYPE})
+            getter("getValueTime", Java_com_progdigy_fbclient_API_getValueTime, type);
+        for (auto& type : {TIME_TZ_TYPE, TIMESTAMP_TZ_TYPE})
+            getter("getValueTimeZone", Java_com_progdigy_fbclient_API_getValueTimeZone, type);
+        getter("getValueBlobId", Java_com_progdigy_fbclient_API_getValueBlobId, BLOB_TYPE);
+        getter("getIsNull", Java_com_progdigy_fbclient_API_getIsNull, INTEGER_TYPE);
+
+        auto env = this->env;
+        for (auto& type : {SMALLINT_TYPE, INTEGER_TYPE, BIGINT_TYPE, INT128_TYPE}) {
+            auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{type});
+            fill(*row, "");
+            add(std::string("getValueInt128/") + type.name, (double)type.length, [row, env](uint64_t n) {
+                auto handle = row->handle();
+                for (uint64_t i = 0; i < n; i++)
+                    env->DeleteLocalRef(Java_com_progdigy_fbclient_API_getValueInt128(env, nullptr, handle, 0));
+            });
+        }
+
+        auto shortText = utf8Text(32, false);
+        auto longText = utf8Text(255, true);
+        objectGetter("getValueString", Java_com_progdigy_fbclient_API_getValueString, VARCHAR_TYPE, shortText,
+                     (double)shortText.size());
+        objectGetter("getValueString", Java_com_progdigy_fbclient_API_getValueString, LONG_VARCHAR_TYPE, longText,
+                     (double)longText.size());
+        objectGetter("getValueString", Java_com_progdigy_fbclient_API_getValueString, CHAR_TYPE, shortText,
+                     (double)CHAR_TYPE.length);
+        objectGetter("getValueString", Java_com_progdigy_fbclient_API_getValueString, TEXT_TYPE, "", blobSize);
+        objectGetter("getValueByteArray", Java_com_progdigy_fbclient_API_getValueByteArray, OCTETS_TYPE, shortText,
+                     (double)shortText.size());
+        objectGetter("getValueByteArray", Java_com_progdigy_fbclient_API_getValueByteArray, CHAR_TYPE, shortText,
+                     (double)CHAR_TYPE.length);
+        objectGetter("getValueByteArray", Java_com_progdigy_fbclient_API_getValueByteArray, BLOB_TYPE, "", blobSize);
+    }
+
+    template<typename T>
+    void setter(const char* name, void (JNICALL *set)(JNIEnv*, jclass, jlong, jint, T), const ColumnType& type,
+                T value) {
+        auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{type});
+        auto env = this->env;
+        add(std::string(name) + "/" + type.name, (double)type.length, [row, env, set, value](uint64_t n) {
+            auto handle = row->handle();
+            for (uint64_t i = 0; i < n; i++)
+                set(env, nullptr, handle, 0, value);
+        });
+    }
+
+    template<typename T>
+    void objectSetter(const char* name, void (JNICALL *set)(JNIEnv*, jclass, jlong, jlong, jlong, jlong, jint, T),
+                      const ColumnType& type, T value, double bytes) {
+        auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{type});
+        auto env = this->env;
+        auto status = this->status;
+        auto db = reinterpret_cast<jlong>(&this->db);
+        auto tr = reinterpret_cast<jlong>(&this->tr);
+        add(std::string(name) + "/" + type.name, bytes, [=](uint64_t n) {
+            auto handle = row->handle();
+            for (uint64_t i = 0; i < n; i++)
+                set(env, nullptr, status, db, tr, handle, (jint)0, value);
+        });
+    }
+
+    jbyteArray byteArray(const std::string& bytes) {
+        auto array = env->NewByteArray((jsize)bytes.size());
+        env->SetByteArrayRegion(array, 0, (jsize)bytes.size(), (const jbyte*)bytes.data());
+        return array;
+    }
+
+    void setters() {
+        setter("setValueBoolean", Java_com_progdigy_fbclient_API_setValueBoolean, BOOLEAN_TYPE, (jboolean)JNI_TRUE);
+        for (auto& type : {SMALLINT_TYPE, INTEGER_TYPE, BIGINT_TYPE, FLOAT_TYPE, DOUBLE_TYPE, INT128_TYPE})
+            setter("setValueShort", Java_com_progdigy_fbclient_API_setValueShort, type, (jshort)12345);
+        for (auto& type : {INTEGER_TYPE, BIGINT_TYPE, DOUBLE_TYPE, INT128_TYPE})
+            setter("setValueInt", Java_com_progdigy_fbclient_API_setValueInt, type, (jint)123456789);
+        for (auto& type : {BIGINT_TYPE, NUMERIC_TYPE, INT128_TYPE})
+            setter("setValueLong", Java_com_progdigy_fbclient_API_setValueLong, type, (jlong)1234567890123LL);
+        for (auto& type : {FLOAT_TYPE, DOUBLE_TYPE})
+            setter("setValueFloat", Java_com_progdigy_fbclient_API_setValueFloat, type, (jfloat)1.5f);
+        setter("setValueDouble", Java_com_progdigy_fbclient_API_setValueDouble, DOUBLE_TYPE, (jdouble)1.25);
+        for (auto& type : {DATE_TYPE, TIMESTAMP_TYPE})
+            setter("setValueDate", Java_com_progdigy_fbclient_API_setValueDate, type, (jint)58849);
+        for (auto& type : {TIME_TYPE, TIMESTAMP_TYPE})
+            setter("setValueTime", Java_com_progdigy_fbclient_API_setValueTime, type, (jint)36000000);
+        for (auto& type : {TIME_TZ_TYPE, TIMESTAMP_TZ_TYPE})
+            setter("setValueTimeZone", Java_com_progdigy_fbclient_API_setValueTimeZone, type, (jint)65000);
+        setter("setValueBlobId", Java_com_progdigy_fbclient_API_setValueBlobId, BLOB_TYPE, (jlong)1);
+
+        auto env = this->env;
+        auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{INT128_TYPE});
+        add("setValueInt128/int128", (double)INT128_TYPE.length, [row, env](uint64_t n) {
+            auto handle = row->handle();
+            for (uint64_t i = 0; i < n; i++)
+                Java_com_progdigy_fbclient_API_setValueInt128(env, nullptr, handle, 0, 1234567890123LL, 0);
+        });
+
+        // PARAMVARY encoding and the segment loop of text blobs
+        auto shortText = utf8Text(32, false);
+        auto longText = utf8Text(255, true);
+        auto blobText = std::string(blobSize, 'x');
+        objectSetter("setValueString", Java_com_progdigy_fbclient_API_setValueString, VARCHAR_TYPE,
+                     env->NewStringUTF(shortText.c_str()), (double)shortText.size());
+        objectSetter("setValueString", Java_com_progdigy_fbclient_API_setValueString, LONG_VARCHAR_TYPE,
+                     env->NewStringUTF(longText.c_str()), (double)longText.size());
+        objectSetter("setValueString", Java_com_progdigy_fbclient_API_setValueString, CHAR_TYPE,
+                     env->NewStringUTF(shortText.c_str()), (double)shortText.size());
+        objectSetter("setValueString", Java_com_progdigy_fbclient_API_setValueString, TEXT_TYPE,
+                     env->NewStringUTF(blobText.c_str()), (double)blobText.size());
+        objectSetter("setValueByteArray", Java_com_progdigy_fbclient_API_setValueByteArray, OCTETS_TYPE,
+                     byteArray(shortText), (double)shortText.size());
+        objectSetter("setValueByteArray", Java_com_progdigy_fbclient_API_setValueByteArray, CHAR_TYPE,
+                     byteArray(shortText), (double)shortText.size());
+        objectSetter("setValueByteArray", Java_com_progdigy_fbclient_API_setValueByteArray, BLOB_TYPE,
+                     byteArray(blobText), (double)blobText.size());
+    }
+
+    // binds every parameter of a row in one call, from the entries PackedParams writes
+    void packed() {
+        auto env = this->env;
+        auto status = this->status;
+        auto db = reinterpret_cast<jlong>(&this->db);
+        auto tr = reinterpret_cast<jlong>(&this->tr);
+        for (auto& mix : MIXES) {
+            auto row = std::make_shared<Sqlda>(mix.columns, mix.nullable);
+            auto buffer = std::make_shared<FakeDirectBuffer>();
+            auto& out = buffer->data;
+            auto put = [&out](const void* value, size_t size) {
+                out.insert(out.end(), (const char*)value, (const char*)value + size);
+            };
+            for (auto& column : mix.columns) {
+                jint i = 42;
+                jlong l = 4200;
+                jdouble d = 0.25;
+                jint timestamp[2] = {18262, 43200000};
+                std::string text = "value 42";
+                char tag;
+                switch (column.type) {
+                    case SQL_LONG: tag = PACKED_INT; put(&tag, 1); put(&i, sizeof i); break;
+                    case SQL_INT64: tag = PACKED_LONG; put(&tag, 1); put(&l, sizeof l); break;
+                    case SQL_DOUBLE: tag = PACKED_DOUBLE; put(&tag, 1); put(&d, sizeof d); break;
+                    case SQL_TYPE_DATE: tag = PACKED_DATE; put(&tag, 1); put(timestamp, sizeof(jint)); break;
+                    case SQL_TIMESTAMP: tag = PACKED_TIMESTAMP; put(&tag, 1); put(timestamp, sizeof timestamp); break;
+                    case SQL_BOOLEAN: tag = PACKED_BOOLEAN; put(&tag, 1); out.push_back(1); break;
+                    default: {
+                        jint size = (jint)text.size();
+                        tag = PACKED_STRING;
+                        put(&tag, 1);
+                        put(&size, sizeof size);
+                        put(text.data(), text.size());
+                        break;
+                    }
+                }
+            }
+            auto length = (jint)out.size();
+            add(std::string("bindPacked/") + mix.name, length, [=](uint64_t n) {
+                auto handle = row->handle();
+                auto object = reinterpret_cast<jobject>(buffer.get());
+                for (uint64_t i = 0; i < n; i++)
+                    sink = Java_com_progdigy_fbclient_API_bindPacked(env, nullptr, status, db, tr, handle, object, 0,
+                                                                     length);
+            });
+
+            // an op is a hundred rows executed in one call, against an insert of the stub
+            auto rows = 100;
+            auto many = std::make_shared<FakeDirectBuffer>();
+            for (int r = 0; r < rows; r++)
+                many->data.insert(many->data.end(), out.begin(), out.end());
+            auto statement = std::make_shared<FB_API_HANDLE>(0);
+            auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+            dsql_allocate_statement(statusArray, &this->db, statement.get());
+            dsql_prepare(statusArray, &this->tr, statement.get(), 0, "insert into stub values (?)", SQL_DIALECT_CURRENT,
+                         nullptr);
+            auto codes = env->NewLongArray(rows);
+            add(std::string("executeMany/") + mix.name + "x100", (double)many->data.size(), [=](uint64_t n) {
+                auto handle = row->handle();
+                auto st = reinterpret_cast<jlong>(statement.get());
+                auto object = reinterpret_cast<jobject>(many.get());
+                for (uint64_t i = 0; i < n; i++)
+                    sink = Java_com_progdigy_fbclient_API_executeMany(env, nullptr, status, db, tr, st,
+                                                                      SQL_DIALECT_CURRENT, handle, object, 0,
+                                                                      (jint)many->data.size(), rows, 0, codes, nullptr);
+            });
+        }
+    }
+
+    void blobs() {
+        auto env = this->env;
+        auto status = this->status;
+        auto db = reinterpret_cast<jlong>(&this->db);
+        auto tr = reinterpret_cast<jlong>(&this->tr);
+        auto blob = std::make_shared<FB_API_HANDLE>(0);
+        auto buffer = byteArray(std::string(blobSize, 0));
+        auto size = (jint)blobSize;
+        add("blobRead/" + std::to_string(blobSize), blobSize, [=](uint64_t n) {
+            auto handle = reinterpret_cast<jlong>(blob.get());
+            for (uint64_t i = 0; i < n; i++) {
+                Java_com_progdigy_fbclient_API_blobOpen(env, nullptr, status, db, tr, handle, 1);
+                sink = Java_com_progdigy_fbclient_API_blobRead(env, nullptr, status, handle, buffer, 0, size);
+                Java_com_progdigy_fbclient_API_blobClose(env, nullptr, status, handle);
+            }
+        });
+        add("blobWrite/" + std::to_string(blobSize), blobSize, [=](uint64_t n) {
+            auto handle = reinterpret_cast<jlong>(blob.get());
+            for (uint64_t i = 0; i < n; i++) {
+                Java_com_progdigy_fbclient_API_blobCreate(env, nullptr, status, db, tr, handle);
+                sink = Java_com_progdigy_fbclient_API_blobWrite(env, nullptr, status, handle, buffer, 0, size);
+                Java_com_progdigy_fbclient_API_blobClose(env, nullptr, status, handle);
+            }
+        });
+
+        // a blob parameter written from a file descriptor, rewound for each op
+        auto file = std::string("/tmp/jnifbclient-bench-blob");
+        auto out = fopen(file.c_str(), "wb");
+        if (out != nullptr) {
+            fwrite(std::string(blobSize, 'x').data(), 1, blobSize, out);
+            fclose(out);
+        }
+        auto fd = std::make_shared<int>(open(file.c_str(), O_RDONLY));
+        auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{BLOB_TYPE});
+        add("setValueBlobFile/" + std::to_string(blobSize), blobSize, [=](uint64_t n) {
+            auto handle = row->handle();
+            for (uint64_t i = 0; i < n; i++) {
+                lseek(*fd, 0, SEEK_SET);
+                sink = Java_com_progdigy_fbclient_API_setValueBlobFile(env, nullptr, status, db, tr, handle, 0,
+                                                                       nullptr, *fd);
+            }
+        });
+    }
+
+    // slices of a stub array, double precision [1:FBCLIENT_STUB_ARRAY_SIZE]; the stub generates the elements read
+    void arrays() {
+        auto env = this->env;
+        auto status = this->status;
+        auto db = reinterpret_cast<jlong>(&this->db);
+        auto tr = reinterpret_cast<jlong>(&this->tr);
+        auto row = std::make_shared<Sqlda>(std::vector<ColumnType>{ARRAY_TYPE});
+        // the first call looks the descriptor up, the benchmarks run with it cached
+        auto values = Java_com_progdigy_fbclient_API_getArrayDouble(env, nullptr, status, db, tr, row->handle(), 0,
+                                                                    nullptr);
+        auto count = env->GetArrayLength(values);
+        auto bytes = (double)count * sizeof(double);
+        add("getArrayDouble/" + std::to_string(count), bytes, [=](uint64_t n) {
+            auto handle = row->handle();
+            for (uint64_t i = 0; i < n; i++) {
+                auto result = Java_com_progdigy_fbclient_API_getArrayDouble(env, nullptr, status, db, tr, handle, 0,
+                                                                            nullptr);
+                env->DeleteLocalRef(result);
+            }
+        });
+        auto buffer = std::make_shared<FakeDirectBuffer>();
+        buffer->data.resize((size_t)bytes);
+        add("getArrayBuffer/" + std::to_string(count), bytes, [=](uint64_t n) {
+            auto handle = row->handle();
+            auto object = reinterpret_cast<jobject>(buffer.get());
+            for (uint64_t i = 0; i < n; i++)
+                sink = Java_com_progdigy_fbclient_API_getArrayBuffer(env, nullptr, status, db, tr, handle, 0, nullptr,
+                                                                     object, 0);
+        });
+        add("setArrayDouble/" + std::to_string(count), bytes, [=](uint64_t n) {
+            auto handle = row->handle();
+            for (uint64_t i = 0; i < n; i++)
+                Java_com_progdigy_fbclient_API_setArrayDouble(env, nullptr, status, db, tr, handle, 0, nullptr, values);
+        });
+    }
+
+    // fetches a row of the stub cursor and reads every column, as RecordSet does
+    void rows() {
+        auto env = this->env;
+        auto status = this->status;
+        auto tr = reinterpret_cast<jlong>(&this->tr);
+        auto db = reinterpret_cast<jlong>(&this->db);
+        for (auto& mix : MIXES) {
+            auto row = std::make_shared<Sqlda>(mix.columns, mix.nullable);
+            auto statement = std::make_shared<FB_API_HANDLE>(0);
+            auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+            dsql_allocate_statement(statusArray, &this->db, statement.get());
+            dsql_prepare(statusArray, &this->tr, statement.get(), 0, "select * from stub", SQL_DIALECT_CURRENT,
+                         nullptr);
+            add(std::string("fetch/") + mix.name, (double)messageSize(row->sqlda), [=](uint64_t n) {
+                auto handle = row->handle();
+                auto st = reinterpret_cast<jlong>(statement.get());
+                auto sqlda = row->sqlda;
+                for (uint64_t i = 0; i < n; i++) {
+                    if (Java_com_progdigy_fbclient_API_fetch(env, nullptr, status, st, handle) != 0) {
+                        Java_com_progdigy_fbclient_API_freeStatement(env, nullptr, status, st, DSQL_close);
+                        Java_com_progdigy_fbclient_API_execute(env, nullptr, status, tr, st, SQL_DIALECT_CURRENT, 0);
+                        continue;
+                    }
+                    for (int c = 0; c < sqlda->sqld; c++) {
+                        auto var = &sqlda->sqlvar[c];
+                        if (var->sqlind != nullptr && *var->sqlind != 0)
+                            continue;
+                        switch (var->sqltype & ~1) {
+                            case SQL_LONG: sink = Java_com_progdigy_fbclient_API_getValueInt(env, nullptr, handle, c); break;
+                            case SQL_INT64: sink = Java_com_progdigy_fbclient_API_getValueLong(env, nullptr, handle, c); break;
+                            case SQL_DOUBLE: sink = (uint64_t)Java_com_progdigy_fbclient_API_getValueDouble(env, nullptr, handle, c); break;
+                            case SQL_BOOLEAN: sink = Java_com_progdigy_fbclient_API_getValueBoolean(env, nullptr, handle, c); break;
+                            case SQL_TYPE_DATE: sink = Java_com_progdigy_fbclient_API_getValueDate(env, nullptr, handle, c); break;
+                            case SQL_TIMESTAMP:
+                                sink = Java_com_progdigy_fbclient_API_getValueDate(env, nullptr, handle, c);
+                                sink = Java_com_progdigy_fbclient_API_getValueTime(env, nullptr, handle, c);
+                                break;
+                            case SQL_TEXT:
+                            case SQL_VARYING:
+                            case SQL_BLOB:
+                                env->DeleteLocalRef(Java_com_progdigy_fbclient_API_getValueString(env, nullptr, status, db, tr, handle, c));
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                }
+            });
+            // the fake env only: a JVM needs a real direct ByteBuffer
+            if (env->functions->GetDirectBufferAddress == fakeGetDirectBufferAddress) {
+                auto buffer = std::make_shared<FakeDirectBuffer>();
+                buffer->data.resize(1 << 20);
+                add(std::string("writeJson/") + mix.name, (double)messageSize(row->sqlda), [=](uint64_t n) {
+                    auto handle = row->handle();
+                    auto st = reinterpret_cast<jlong>(statement.get());
+                    auto target = reinterpret_cast<jobject>(buffer.get());
+                    jint position = 0;
+                    for (uint64_t i = 0; i < n; i++) {
+                        if (Java_com_progdigy_fbclient_API_fetch(env, nullptr, status, st, handle) != 0) {
+                            Java_com_progdigy_fbclient_API_freeStatement(env, nullptr, status, st, DSQL_close);
+                            Java_com_progdigy_fbclient_API_execute(env, nullptr, status, tr, st, SQL_DIALECT_CURRENT, 0);
+                            continue;
+                        }
+                        position = Java_com_progdigy_fbclient_API_writeJson(env, nullptr, status, db, tr, handle,
+                                                                            target, position, JSON_LINES);
+                        if (position < 0 || position > (jint)buffer->data.size() / 2)
+                            position = 0;
+                    }
+                    sink = (uint64_t)position;
+                });
+            }
+            // an op is a row, exported in as few calls as the cursor allows
+            for (auto threaded : {false, true}) {
+                auto progress = env->NewLongArray(2);
+                add(std::string("exportRows/") + mix.name + (threaded ? "/thread" : ""), (double)messageSize(row->sqlda),
+                    [=](uint64_t n) {
+                    auto handle = row->handle();
+                    auto st = reinterpret_cast<jlong>(statement.get());
+                    auto options = threaded ? CSV_WRITER_THREAD : 0;
+                    uint64_t done = 0;
+                    while (done < n) {
+                        if (Java_com_progdigy_fbclient_API_fetch(env, nullptr, status, st, handle) != 0) {
+                            Java_com_progdigy_fbclient_API_freeStatement(env, nullptr, status, st, DSQL_close);
+                            Java_com_progdigy_fbclient_API_execute(env, nullptr, status, tr, st, SQL_DIALECT_CURRENT, 0);
+                            continue;
+                        }
+                        auto counters = env->GetLongArrayElements(progress, nullptr);
+                        counters[0] = counters[1] = 0;
+                        env->ReleaseLongArrayElements(progress, counters, 0);
+                        Java_com_progdigy_fbclient_API_exportRows(env, nullptr, status, db, tr, st, handle, nullptr,
+                                                                  nullFile, (jint)(n - done), options, progress);
+                        counters = env->GetLongArrayElements(progress, nullptr);
+                        done += (uint64_t)counters[0];
+                        sink = (uint64_t)counters[1];
+                        env->ReleaseLongArrayElements(progress, counters, JNI_ABORT);
+                    }
+                });
+            }
+            // an op is the import of the stub cursor exported to a file; the stub has no IBatch, so the records are
+            // executed one by one
+            auto file = std::string("/tmp/jnifbclient-bench-") + mix.name + ".csv";
+            auto st = reinterpret_cast<jlong>(statement.get());
+            auto path = env->NewStringUTF(file.c_str());
+            auto progress = env->NewLongArray(2);
+            Java_com_progdigy_fbclient_API_execute(env, nullptr, status, tr, st, SQL_DIALECT_CURRENT, 0);
+            Java_com_progdigy_fbclient_API_fetch(env, nullptr, status, st, row->handle());
+            Java_com_progdigy_fbclient_API_exportRows(env, nullptr, status, db, tr, st, row->handle(), path, -1, 0,
+                                                      CSV_BLOB_TEXT, progress);
+            Java_com_progdigy_fbclient_API_freeStatement(env, nullptr, status, st, DSQL_close);
+            files.push_back(file);
+            auto counters = env->GetLongArrayElements(progress, nullptr);
+            auto bytes = (double)counters[1];
+            env->ReleaseLongArrayElements(progress, counters, JNI_ABORT);
+            add(std::string("importRows/") + mix.name, bytes, [=](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++) {
+                    Java_com_progdigy_fbclient_API_importRows(env, nullptr, status, db, tr, st, row->handle(), path,
+                                                              SQL_DIALECT_CURRENT, 1000, 0, 0, progress, nullptr);
+                    auto counters = env->GetLongArrayElements(progress, nullptr);
+                    sink = (uint64_t)counters[0];
+                    env->ReleaseLongArrayElements(progress, counters, JNI_ABORT);
+                }
+            });
+            // an op is a row packed into a spool, a new spool per million rows
+            auto spooled = std::shared_ptr<jlong>(new jlong(0), [=](jlong* spool) {
+                Java_com_progdigy_fbclient_API_freeSpool(env, nullptr, *spool);
+                delete spool;
+            });
+            add(std::string("spoolRows/") + mix.name, (double)messageSize(row->sqlda), [=](uint64_t n) {
+                auto handle = row->handle();
+                uint64_t done = 0;
+                while (done < n) {
+                    if (Java_com_progdigy_fbclient_API_fetch(env, nullptr, status, st, handle) != 0) {
+                        Java_com_progdigy_fbclient_API_freeStatement(env, nullptr, status, st, DSQL_close);
+                        Java_com_progdigy_fbclient_API_execute(env, nullptr, status, tr, st, SQL_DIALECT_CURRENT, 0);
+                        continue;
+                    }
+                    auto count = Java_com_progdigy_fbclient_API_getSpoolCount(env, nullptr, *spooled);
+                    if (*spooled == 0 || count >= 1 << 20) {
+                        Java_com_progdigy_fbclient_API_freeSpool(env, nullptr, *spooled);
+                        *spooled = Java_com_progdigy_fbclient_API_createSpool(env, nullptr, nullptr);
+                        count = 0;
+                    }
+                    Java_com_progdigy_fbclient_API_spoolRows(env, nullptr, status, st, handle, *spooled,
+                                                             (jint)(n - done));
+                    done += (uint64_t)(Java_com_progdigy_fbclient_API_getSpoolCount(env, nullptr, *spooled) - count);
+                }
+            });
+            // an op is a row of the whole cursor restored from a spool, in a scattered order
+            Java_com_progdigy_fbclient_API_execute(env, nullptr, status, tr, st, SQL_DIALECT_CURRENT, 0);
+            Java_com_progdigy_fbclient_API_fetch(env, nullptr, status, st, row->handle());
+            auto spool = std::shared_ptr<void>((void*)Java_com_progdigy_fbclient_API_createSpool(env, nullptr, nullptr),
+                                               [=](void* spool) {
+                Java_com_progdigy_fbclient_API_freeSpool(env, nullptr, (jlong)spool);
+            });
+            Java_com_progdigy_fbclient_API_spoolRows(env, nullptr, status, st, row->handle(), (jlong)spool.get(), 0);
+            Java_com_progdigy_fbclient_API_freeStatement(env, nullptr, status, st, DSQL_close);
+            add(std::string("spoolSeek/") + mix.name, (double)messageSize(row->sqlda), [=](uint64_t n) {
+                auto handle = row->handle();
+                auto count = (uint64_t)Java_com_progdigy_fbclient_API_getSpoolCount(env, nullptr, (jlong)spool.get());
+                uint64_t position = 0;
+                for (uint64_t i = 0; i < n; i++) {
+                    position = (position + 7919) % count;
+                    sink += Java_com_progdigy_fbclient_API_spoolSeek(env, nullptr, handle, (jlong)spool.get(),
+                                                                     (jlong)position);
+                }
+            });
+            // an op is a row of the cursor served by a cache hit, the lookup included
+            auto cache = std::shared_ptr<void>((void*)Java_com_progdigy_fbclient_API_createResultCache(env, nullptr, db,
+                                                                                                      1 << 30),
+                                               [=](void* cache) {
+                Java_com_progdigy_fbclient_API_freeResultCache(env, nullptr, (jlong)cache);
+            });
+            auto sql = env->NewStringUTF(mix.name);
+            Java_com_progdigy_fbclient_API_execute(env, nullptr, status, tr, st, SQL_DIALECT_CURRENT, 0);
+            Java_com_progdigy_fbclient_API_releaseCachedRows(env, nullptr, Java_com_progdigy_fbclient_API_cacheRows(
+                env, nullptr, status, st, row->handle(), (jlong)cache.get(), sql, 0, nullptr));
+            Java_com_progdigy_fbclient_API_freeStatement(env, nullptr, status, st, DSQL_close);
+            add(std::string("cacheLookup/") + mix.name, (double)messageSize(row->sqlda), [=](uint64_t n) {
+                auto handle = row->handle();
+                uint64_t done = 0;
+                while (done < n) {
+                    auto rows = Java_com_progdigy_fbclient_API_cacheLookup(env, nullptr, (jlong)cache.get(), sql, 0);
+                    auto count = Java_com_progdigy_fbclient_API_getCachedCount(env, nullptr, rows);
+                    for (jlong i = 0; i < count && done < n; i++, done++)
+                        sink += Java_com_progdigy_fbclient_API_cacheSeek(env, nullptr, handle, rows, i);
+                    Java_com_progdigy_fbclient_API_releaseCachedRows(env, nullptr, rows);
+                }
+            });
+        }
+    }
+
+    JNIEnv* env;
+    int nullFile = open("/dev/null", O_WRONLY);
+    std::vector<std::string> files;
+    uint32_t blobSize;
+    jlong status;
+    FB_API_HANDLE db = 0;
+    FB_API_HANDLE tr = 0;
+    std::vector<Benchmark> benchmarks;
+};
+
+void report(const std::vector<Result>& results, const std::string& format, const char* envName) {
+    if (format == "json") {
+        printf("{\"env\":\"%s\",\"benchmarks\":[", envName);
+        for (size_t i = 0; i < results.size(); i++) {
+            auto& r = results[i];
+            printf("%s\n{\"name\":\"%s\",\"ns_per_op\":%.3f,\"best_ns_per_op\":%.3f,\"ops_per_s\":%.0f,\"bytes_per_s\":%.0f}",
+                   i > 0 ? "," : "", r.name.c_str(), r.nanos, r.best, 1e9 / r.nanos, r.bytes * 1e9 / r.nanos);
+        }
+        printf("\n]}\n");
+    } else if (format == "csv") {
+        printf("name,ns_per_op,best_ns_per_op,ops_per_s,bytes_per_s\n");
+        for (auto& r : results)
+            printf("%s,%.3f,%.3f,%.0f,%.0f\n", r.name.c_str(), r.nanos, r.best, 1e9 / r.nanos, r.bytes * 1e9 / r.nanos);
+    } else {
+        printf("%-40s %12s %12s %12s\n", "benchmark", "ns/op", "best ns/op", "MB/s");
+        for (auto& r : results)
+            printf("%-40s %12.2f %12.2f %12.1f\n", r.name.c_str(), r.nanos, r.best, r.bytes * 1e3 / r.nanos);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string format = "text";
+    uint64_t targetMillis = 500;
+    uint32_t blobSize = 65536;
+    bool jvm = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0)
+            filter = arg.substr(9);
+        else if (arg.rfind("--time=", 0) == 0)
+            targetMillis = strtoull(arg.c_str() + 7, nullptr, 10);
+        else if (arg.rfind("--blob-size=", 0) == 0)
+            blobSize = (uint32_t)strtoul(arg.c_str() + 12, nullptr, 10);
+        else if (arg.rfind("--format=", 0) == 0)
+            format = arg.substr(9);
+        else if (arg == "--jvm")
+            jvm = true;
+        else {
+            fprintf(stderr, "usage: %s [--filter=text] [--time=ms] [--blob-size=bytes] [--format=text|csv|json] [--jvm]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    // the stub reads its configuration when loaded
+    auto size = std::to_string(blobSize);
+#ifdef _WIN32
+    _putenv_s("FBCLIENT_STUB_BLOB_SIZE", size.c_str());
+#else
+    setenv("FBCLIENT_STUB_BLOB_SIZE", size.c_str(), 1);
+#endif
+    auto stub = getenv("FBCLIENT_LIBRARY");
+    if (!loadClientLibrary(stub != nullptr ? stub : FBCLIENT_STUB_PATH)) {
+        fprintf(stderr, "cannot load %s\n", stub != nullptr ? stub : FBCLIENT_STUB_PATH);
+        return 1;
+    }
+
+    JNIEnv* env = nullptr;
+    const char* envName = "native";
+    if (jvm) {
+#ifdef BENCH_JVM
+        env = jvmEnv();
+        envName = "jvm";
+#endif
+        if (env == nullptr) {
+            fprintf(stderr, "no JVM available\n");
+            return 1;
+        }
+    } else
+        env = fakeEnv();
+
+    Suite suite(env, blobSize);
+    suite.allocation();
+    suite.utf8();
+    suite.getters();
+    suite.setters();
+    suite.packed();
+    suite.blobs();
+    suite.arrays();
+    suite.rows();
+
+    fakeRecycle = true;
+    std::vector<Result> results;
+    for (auto& benchmark : suite.benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+            continue;
+        results.push_back(measure(benchmark, targetMillis * 1000000));
+    }
+    report(results, format, envName);
+    return 0;
+}
@@ -0,0 +1,1096 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "fbcore.h"
+
+/* the largest segment isc_get_segment and isc_put_segment are asked for */
+#define FBCORE_SEGMENT_SIZE 32767
+
+/* isc_segment, iberror.h only declares the error codes for C++ */
+#define FBCORE_ISC_SEGMENT 335544366L
+
+/* the UTF8 character set, 4 bytes per character at most */
+#define FBCORE_CS_UTF8 4
+
+/* the length in characters of text standing for a column that was not text, enough for any number or date */
+#define FBCORE_TEXT_LENGTH 64
+
+/* the longest VARCHAR, in bytes */
+#define FBCORE_MAX_VARYING 32765
+
+XSQLDA* fbcore_alloc_sqlda(short count) {
+    size_t length = XSQLDA_LENGTH(count > 0 ? count : 1);
+    XSQLDA* sqlda = (XSQLDA*)calloc(1, length);
+    if (sqlda != NULL) {
+        sqlda->version = SQLDA_VERSION1;
+        sqlda->sqln = count;
+    }
+    return sqlda;
+}
+
+/* the alignment of a fixed width column, the largest power of two dividing its length, up to 8 */
+static size_t fbcore_alignment(const XSQLVAR* var) {
+    size_t length = (size_t)var->sqllen;
+    size_t align = 1;
+    while (align < 8 && length % (align * 2) == 0)
+        align *= 2;
+    return align;
+}
+
+static int fbcore_is_varlen(const XSQLVAR* var) {
+    int code = var->sqltype & ~1;
+    return code == SQL_TEXT || code == SQL_VARYING;
+}
+
+static size_t fbcore_align(size_t offset, size_t align) {
+    return (offset + align - 1) & ~(align - 1);
+}
+
+/*
+ * The buffer is planned in passes, without sorting:
+ * - the null indicators of the nullable columns, one contiguous block of shorts
+ * - the fixed width columns, by decreasing alignment so that none of them needs padding
+ * - the CHAR and VARCHAR columns, in column order, a VARCHAR aligned for its length prefix
+ * Offsets are stored in sqldata and sqlind, then rebased on the allocated buffer.
+ */
+int fbcore_allocate_data_buffer(XSQLDA* sqlda) {
+    size_t total = 0;
+    size_t align;
+    ISC_SCHAR* buffer;
+    int i;
+    if (sqlda->sqld <= 0)
+        return FBCORE_OK;
+    for (i = 0; i < sqlda->sqld; i++) {
+        XSQLVAR* var = &sqlda->sqlvar[i];
+        if ((var->sqltype & 1) == 1) {
+            var->sqlind = (ISC_SHORT*)total;
+            total += sizeof(ISC_SHORT);
+        } else
+            var->sqlind = NULL;
+    }
+    for (align = 8; align > 0; align /= 2) {
+        for (i = 0; i < sqlda->sqld; i++) {
+            XSQLVAR* var = &sqlda->sqlvar[i];
+            if (fbcore_is_varlen(var) || fbcore_alignment(var) != align)
+                continue;
+            switch (var->sqltype & ~1) {
+                case SQL_FLOAT:
+                case SQL_D_FLOAT:
+                case SQL_DOUBLE:
+                    /* scale is irrelevant and lead to duplicate code */
+                    var->sqlscale = 0;
+                    break;
+            }
+            total = fbcore_align(total, align);
+            var->sqldata = (ISC_SCHAR*)total;
+            total += var->sqllen;
+        }
+    }
+    for (i = 0; i < sqlda->sqld; i++) {
+        XSQLVAR* var = &sqlda->sqlvar[i];
+        if ((var->sqltype & ~1) == SQL_TEXT) {
+            var->sqldata = (ISC_SCHAR*)total;
+            /* + zero terminal */
+            total += var->sqllen + 1;
+        } else if ((var->sqltype & ~1) == SQL_VARYING) {
+            total = fbcore_align(total, sizeof(ISC_USHORT));
+            var->sqldata = (ISC_SCHAR*)total;
+            /* size of PARAMVARY + zero terminal */
+            total += sizeof(ISC_USHORT) + var->sqllen + 1;
+        }
+    }
+    /* calloc is aligned for any fixed width column */
+    buffer = (ISC_SCHAR*)calloc(1, total);
+    if (buffer == NULL) {
+        /* sqldata and sqlind hold offsets, nothing to free */
+        for (i = 0; i < sqlda->sqld; i++) {
+            sqlda->sqlvar[i].sqldata = NULL;
+            sqlda->sqlvar[i].sqlind = NULL;
+        }
+        return -1;
+    }
+    for (i = 0; i < sqlda->sqld; i++) {
+        XSQLVAR* var = &sqlda->sqlvar[i];
+        var->sqldata = buffer + (size_t)var->sqldata;
+        /* the first indicator is at offset 0, test the null flag */
+        if ((var->sqltype & 1) == 1) {
+            var->sqlind = (ISC_SHORT*)(buffer + (size_t)var->sqlind);
+            *var->sqlind = -1; /* nullables are null */
+        }
+    }
+    return FBCORE_OK;
+}
+
+void fbcore_free_data_buffer(XSQLDA* sqlda) {
+    /* the buffer starts at the lowest sqldata or sqlind, whichever the layout put first */
+    char* buffer = NULL;
+    int i;
+    for (i = 0; i < sqlda->sqld; i++) {
+        XSQLVAR* var = &sqlda->sqlvar[i];
+        if (buffer == NULL || (char*)var->sqldata < buffer)
+            buffer = (char*)var->sqldata;
+        if (var->sqlind != NULL && (char*)var->sqlind < buffer)
+            buffer = (char*)var->sqlind;
+    }
+    free(buffer);
+    for (i = 0; i < sqlda->sqld; i++) {
+        sqlda->sqlvar[i].sqldata = NULL;
+        sqlda->sqlvar[i].sqlind = NULL;
+    }
+}
+
+int fbcore_relayout_data_buffer(XSQLDA* sqlda, const XSQLVAR* vars) {
+    XSQLDA* copy;
+    if (sqlda->sqld <= 0)
+        return FBCORE_OK;
+    copy = (XSQLDA*)malloc(XSQLDA_LENGTH(sqlda->sqld));
+    if (copy == NULL)
+        return -1;
+    copy->version = SQLDA_VERSION1;
+    copy->sqln = copy->sqld = sqlda->sqld;
+    memcpy(copy->sqlvar, vars, sizeof(XSQLVAR) * (size_t)sqlda->sqld);
+    if (fbcore_allocate_data_buffer(copy) != FBCORE_OK) {
+        free(copy);
+        return -1;
+    }
+    fbcore_free_data_buffer(sqlda);
+    memcpy(sqlda->sqlvar, copy->sqlvar, sizeof(XSQLVAR) * (size_t)sqlda->sqld);
+    free(copy);
+    return FBCORE_OK;
+}
+
+static int fbcore_is_exact(int code) {
+    return code == SQL_SHORT || code == SQL_LONG || code == SQL_INT64 || code == SQL_INT128;
+}
+
+int fbcore_set_var_type(XSQLVAR* var, int code, int subtype) {
+    int from = var->sqltype & ~1;
+    int length;
+    if (from == SQL_BLOB || from == SQL_ARRAY || from == SQL_QUAD)
+        return FBCORE_CONVERSION;
+    switch (code) {
+        case SQL_SHORT: length = sizeof(ISC_SHORT); break;
+        case SQL_LONG: length = sizeof(ISC_LONG); break;
+        case SQL_INT64: length = sizeof(ISC_INT64); break;
+        case SQL_INT128: length = sizeof(FB_I128); break;
+        case SQL_FLOAT: length = sizeof(float); break;
+        case SQL_DOUBLE: length = sizeof(double); break;
+        case SQL_BOOLEAN: length = sizeof(FB_BOOLEAN); break;
+        case SQL_TYPE_DATE: length = sizeof(ISC_DATE); break;
+        case SQL_TYPE_TIME: length = sizeof(ISC_TIME); break;
+        case SQL_TIMESTAMP: length = sizeof(ISC_TIMESTAMP); break;
+        case SQL_TIME_TZ: length = sizeof(ISC_TIME_TZ); break;
+        case SQL_TIMESTAMP_TZ: length = sizeof(ISC_TIMESTAMP_TZ); break;
+        case SQL_TEXT:
+        case SQL_VARYING:
+            if (!fbcore_is_varlen(var))
+                length = subtype == FBCORE_CS_UTF8 ? FBCORE_TEXT_LENGTH * 4 : FBCORE_TEXT_LENGTH;
+            else if (subtype == FBCORE_CS_UTF8 && var->sqlsubtype != FBCORE_CS_UTF8)
+                /* a character of the described set takes up to 4 bytes in UTF-8 */
+                length = var->sqllen * 4;
+            else
+                length = var->sqllen;
+            if (length > FBCORE_MAX_VARYING)
+                length = FBCORE_MAX_VARYING;
+            break;
+        default:
+            return FBCORE_CONVERSION;
+    }
+    if (!fbcore_is_exact(code) || !fbcore_is_exact(from))
+        var->sqlscale = 0;
+    var->sqlsubtype = (code == SQL_TEXT || code == SQL_VARYING) ? (ISC_SHORT)subtype : 0;
+    var->sqltype = (ISC_SHORT)(code | (var->sqltype & 1));
+    var->sqllen = (ISC_SHORT)length;
+    return FBCORE_OK;
+}
+
+int fbcore_set_output_profile(XSQLDA* sqlda, int profile) {
+    int changed = 0;
+    int i;
+    XSQLVAR* vars;
+    if (sqlda->sqld <= 0)
+        return 0;
+    /* the columns are changed on a copy, the XSQLDA is left as it was when the buffer cannot be allocated */
+    vars = (XSQLVAR*)malloc(sizeof(XSQLVAR) * (size_t)sqlda->sqld);
+    if (vars == NULL)
+        return -1;
+    memcpy(vars, sqlda->sqlvar, sizeof(XSQLVAR) * (size_t)sqlda->sqld);
+    for (i = 0; i < sqlda->sqld; i++) {
+        XSQLVAR* var = &vars[i];
+        int code;
+        switch (var->sqltype & ~1) {
+            case SQL_TIMESTAMP_TZ:
+            case SQL_TIMESTAMP_TZ_EX:
+                code = (profile & FBCORE_OUTPUT_TIMESTAMP) != 0 ? SQL_TIMESTAMP : 0;
+                break;
+            case SQL_TIME_TZ:
+            case SQL_TIME_TZ_EX:
+                code = (profile & FBCORE_OUTPUT_TIMESTAMP) != 0 ? SQL_TYPE_TIME : 0;
+                break;
+            case SQL_INT128:
+                code = (profile & FBCORE_OUTPUT_BIGINT) != 0 ? SQL_INT64 : 0;
+                break;
+            case SQL_TEXT:
+                code = (profile & FBCORE_OUTPUT_VARCHAR) != 0 ? SQL_VARYING : 0;
+                break;
+            default:
+                code = 0;
+                break;
+        }
+        if (code != 0 && fbcore_set_var_type(var, code, var->sqlsubtype) == FBCORE_OK)
+            changed++;
+    }
+    if (changed > 0 && fbcore_relayout_data_buffer(sqlda, vars) != FBCORE_OK)
+        changed = -1;
+    free(vars);
+    return changed;
+}
+
+/*
+ * The fixed part of a row spans from the start of the buffer (the first indicator, or the first fixed width column
+ * without nullable columns) to the end of the last fixed width column, CHAR and VARCHAR columns follow it.
+ */
+static size_t fbcore_fixed_part(const XSQLDA* sqlda, const char** start) {
+    const char* first = NULL;
+    const char* end = NULL;
+    int i;
+    for (i = 0; i < sqlda->sqld; i++) {
+        const XSQLVAR* var = &sqlda->sqlvar[i];
+        const char* data = (const char*)var->sqldata;
+        if (first == NULL || data < first)
+            first = data;
+        if (var->sqlind != NULL) {
+            const char* ind = (const char*)var->sqlind;
+            if (ind < first)
+                first = ind;
+            if (end == NULL || ind + sizeof(ISC_SHORT) > end)
+                end = ind + sizeof(ISC_SHORT);
+        }
+        if (!fbcore_is_varlen(var) && (end == NULL || data + var->sqllen > end))
+            end = data + var->sqllen;
+    }
+    *start = first;
+    return end == NULL ? 0 : (size_t)(end - first);
+}
+
+static int fbcore_is_null(const XSQLVAR* var) {
+    return (var->sqltype & 1) == 1 && *var->sqlind == -1;
+}
+
+size_t fbcore_packed_size(const XSQLDA* sqlda) {
+    const char* start;
+    size_t total = fbcore_fixed_part(sqlda, &start);
+    int i;
+    for (i = 0; i < sqlda->sqld; i++) {
+        const XSQLVAR* var = &sqlda->sqlvar[i];
+        if (!fbcore_is_varlen(var) || fbcore_is_null(var))
+            continue;
+        if ((var->sqltype & ~1) == SQL_TEXT)
+            total += var->sqllen;
+        else
+            total += sizeof(ISC_USHORT) + ((const PARAMVARY*)var->sqldata)->vary_length;
+    }
+    return total;
+}
+
+size_t fbcore_pack_row(const XSQLDA* sqlda, char* out) {
+    const char* start;
+    size_t total = fbcore_fixed_part(sqlda, &start);
+    int i;
+    memcpy(out, start, total);
+    for (i = 0; i < sqlda->sqld; i++) {
+        const XSQLVAR* var = &sqlda->sqlvar[i];
+        size_t length;
+        if (!fbcore_is_varlen(var) || fbcore_is_null(var))
+            continue;
+        if ((var->sqltype & ~1) == SQL_TEXT)
+            length = var->sqllen;
+        else
+            length = sizeof(ISC_USHORT) + ((const PARAMVARY*)var->sqldata)->vary_length;
+        memcpy(out + total, var->sqldata, length);
+        total += length;
+    }
+    return total;
+}
+
+size_t fbcore_unpack_row(XSQLDA* sqlda, const char* in) {
+    const char* start;
+    size_t total = fbcore_fixed_part(sqlda, &start);
+    int i;
+    /* the indicators are restored first, they tell which text columns were packed */
+    memcpy((char*)start, in, total);
+    for (i = 0; i < sqlda->sqld; i++) {
+        XSQLVAR* var = &sqlda->sqlvar[i];
+        size_t length;
+        if (!fbcore_is_varlen(var) || fbcore_is_null(var))
+            continue;
+        if ((var->sqltype & ~1) == SQL_TEXT)
+            length = var->sqllen;
+        else {
+            ISC_USHORT vary;
+            memcpy(&vary, in + total, sizeof(vary));
+            length = sizeof(ISC_USHORT) + vary;
+        }
+        memcpy(var->sqldata, in + total, length);
+        total += length;
+    }
+    return total;
+}
+
+void fbcore_free_sqlda(XSQLDA* sqlda) {
+    if (sqlda != NULL) {
+        fbcore_free_data_buffer(sqlda);
+        free(sqlda);
+    }
+}
+
+size_t fbcore_utf8_size(const char* string, int maxlength, int maxsize) {
+    size_t length = 0;
+    size_t size = 0;
+    while (*string != 0) {
+        if ((*string++ & 0xC0) != 0x80) ++length;
+        if (length > (size_t)maxlength || size++ == (size_t)maxsize)
+            break;
+    }
+    return size;
+}
+
+const char* fbcore_get_text(ISC_SCHAR* data, int code, int len, int bytesPerChar) {
+    switch (code) {
+        case SQL_VARYING: {
+            PARAMVARY* vary = (PARAMVARY*)data;
+            vary->vary_string[vary->vary_length] = 0;
+            return (const char*)vary->vary_string;
+        }
+        case SQL_TEXT: {
+            size_t size = fbcore_utf8_size(data, len / bytesPerChar, len);
+            data[size] = 0;
+            return data;
+        }
+        default:
+            return NULL;
+    }
+}
+
+int fbcore_blob_read(ISC_STATUS* status, isc_blob_handle* blob, char* buffer, int length, fbcore_get_segment_fn get) {
+    int total = 0;
+    unsigned short size = 0;
+    while (length > 0) {
+        unsigned short toRead = (unsigned short)(length < FBCORE_SEGMENT_SIZE ? length : FBCORE_SEGMENT_SIZE);
+        ISC_STATUS ret = get(status, blob, &size, toRead, buffer);
+        int success = ret == 0 || status[1] == FBCORE_ISC_SEGMENT;
+        while (success && size == 0) {
+            ret = get(status, blob, &size, toRead, buffer);
+            success = ret == 0 || status[1] == FBCORE_ISC_SEGMENT;
+        }
+        if (size > 0) {
+            buffer += size;
+            length -= size;
+            total += size;
+            size = 0;
+        } else
+            break;
+    }
+    return total;
+}
+
+int fbcore_blob_write(ISC_STATUS* status, isc_blob_handle* blob, const char* buffer, int length,
+                      fbcore_put_segment_fn put) {
+    int total = 0;
+    while (length > 0) {
+        unsigned short toWrite = (unsigned short)(length < FBCORE_SEGMENT_SIZE ? length : FBCORE_SEGMENT_SIZE);
+        if (put(status, blob, toWrite, buffer) != 0)
+            break;
+        buffer += toWrite;
+        length -= toWrite;
+        total += toWrite;
+    }
+    return total;
+}
+
+ISC_STATUS fbcore_blob_length(ISC_STATUS* status, isc_blob_handle* blob, ISC_LONG* length, fbcore_blob_info_fn info) {
+    char buffer[9];
+    char item = isc_info_blob_total_length;
+    ISC_STATUS ret = info(status, blob, 1, &item, sizeof buffer, buffer);
+    if (ret == 0)
+        memcpy(length, &buffer[3], sizeof(ISC_LONG));
+    return ret;
+}
+
+unsigned int fbcore_interpret(ISC_SCHAR* buffer, unsigned int size, const ISC_STATUS* status,
+                              fbcore_interpret_fn interpret) {
+    const ISC_STATUS* vector = status;
+    unsigned int total;
+    ISC_LONG len;
+    if (size == 0)
+        return 0;
+    memset(buffer, 0, size);
+    len = interpret(buffer, size - 1, &vector);
+    total = len > 0 ? (unsigned int)len : 0;
+    while (len > 0 && total + 1 < size - 1) {
+        buffer[total++] = '\n';
+        len = interpret(buffer + total, size - 1 - total, &vector);
+        if (len > 0)
+            total += (unsigned int)len;
+    }
+    return total;
+}
+
+int fbcore_statement_type(ISC_STATUS* status, isc_stmt_handle* statement, fbcore_sql_info_fn info) {
+    ISC_SCHAR data[9] = {isc_info_sql_stmt_type};
+    info(status, statement, 1, data, 8, &data[1]);
+    return data[4] - 1;
+}
+
+/* EPB_version1 of consts_pub.h */
+#define FBCORE_EPB_VERSION 1
+
+size_t fbcore_event_name(ISC_UCHAR* block, size_t position, const char* name, size_t length) {
+    if (length == 0 || length > 255)
+        return 0;
+    if (position == 0)
+        block[position++] = FBCORE_EPB_VERSION;
+    block[position++] = (ISC_UCHAR)length;
+    memcpy(block + position, name, length);
+    position += length;
+    memset(block + position, 0, 4);
+    return position + 4;
+}
+
+static ISC_ULONG fbcore_event_count(const ISC_UCHAR* p) {
+    return (ISC_ULONG)p[0] | (ISC_ULONG)p[1] << 8 | (ISC_ULONG)p[2] << 16 | (ISC_ULONG)p[3] << 24;
+}
+
+int fbcore_event_counts(ISC_ULONG* counts, int capacity, ISC_UCHAR* block, size_t length, const ISC_UCHAR* updated) {
+    size_t position = 1;
+    int count = 0;
+    while (position < length) {
+        /* the length of the name, the name, then the count */
+        position += 1 + block[position];
+        if (position + 4 > length)
+            break;
+        if (count < capacity) {
+            ISC_ULONG before = fbcore_event_count(block + position);
+            ISC_ULONG after = fbcore_event_count(updated + position);
+            counts[count] = after > before ? after - before : 0;
+        }
+        count++;
+        position += 4;
+    }
+    memcpy(block, updated, length);
+    return count;
+}
+
+static size_t fbcore_digits(char* out, const char* digits, size_t count, int negative, int scale) {
+    /* digits holds count digits, most significant first, of the absolute value */
+    size_t length = 0;
+    size_t fraction = scale < 0 ? (size_t)-scale : 0;
+    size_t i;
+    if (negative)
+        out[length++] = '-';
+    if (count <= fraction) {
+        out[length++] = '0';
+        out[length++] = '.';
+        for (i = count; i < fraction; i++)
+            out[length++] = '0';
+        memcpy(out + length, digits, count);
+        return length + count;
+    }
+    memcpy(out + length, digits, count - fraction);
+    length += count - fraction;
+    if (fraction > 0) {
+        out[length++] = '.';
+        memcpy(out + length, digits + count - fraction, fraction);
+        length += fraction;
+    }
+    return length;
+}
+
+size_t fbcore_format_integer(char* out, ISC_INT64 value, int scale) {
+    char digits[20];
+    size_t count = 0;
+    /* unsigned, INT64_MIN has no positive counterpart */
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[sizeof digits - ++count] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    return fbcore_digits(out, digits + sizeof digits - count, count, value < 0, scale);
+}
+
+size_t fbcore_format_int128(char* out, const ISC_INT64 value[2], int scale) {
+    char digits[40];
+    size_t count = 0;
+    int negative = value[1] < 0;
+    unsigned long long low = (unsigned long long)value[0];
+    unsigned long long high = (unsigned long long)value[1];
+    ISC_ULONG limbs[4];
+    int i;
+    if (negative) {
+        /* two's complement negation over both halves */
+        low = ~low + 1;
+        high = ~high + (low == 0 ? 1 : 0);
+    }
+    limbs[0] = (ISC_ULONG)(high >> 32);
+    limbs[1] = (ISC_ULONG)high;
+    limbs[2] = (ISC_ULONG)(low >> 32);
+    limbs[3] = (ISC_ULONG)low;
+    do {
+        /* long division by 10, 32 bits at a time */
+        unsigned long long remainder = 0;
+        int zero = 1;
+        for (i = 0; i < 4; i++) {
+            unsigned long long current = (remainder << 32) | limbs[i];
+            limbs[i] = (ISC_ULONG)(current / 10);
+            remainder = current % 10;
+            zero &= limbs[i] == 0;
+        }
+        digits[sizeof digits - ++count] = (char)('0' + remainder);
+        if (zero)
+            break;
+    } while (1);
+    return fbcore_digits(out, digits + sizeof digits - count, count, negative, scale);
+}
+
+size_t fbcore_format_double(char* out, double value, int precision) {
+    /* the shortest of the decimal representations that round trips */
+    int digits = precision > 9 ? 15 : 6;
+    int length = 0;
+    for (; digits <= precision; digits++) {
+        length = snprintf(out, FBCORE_FORMAT_SIZE, "%.*g", digits, value);
+        if ((precision > 9 ? strtod(out, NULL) : (double)strtof(out, NULL)) == value)
+            break;
+    }
+    return (size_t)length;
+}
+
+static void fbcore_two_digits(char* out, unsigned int value) {
+    out[0] = (char)('0' + value / 10);
+    out[1] = (char)('0' + value % 10);
+}
+
+size_t fbcore_format_date(char* out, ISC_DATE date) {
+    /* civil date from days since 1970-01-01, proleptic Gregorian calendar */
+    long days = (long)date - FBCORE_EPOCH_DAYS + 719468;
+    long era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned long dayOfEra = (unsigned long)(days - era * 146097);
+    unsigned long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned long mp = (5 * dayOfYear + 2) / 153;
+    unsigned int day = (unsigned int)(dayOfYear - (153 * mp + 2) / 5 + 1);
+    unsigned int month = (unsigned int)(mp < 10 ? mp + 3 : mp - 9);
+    long year = (long)yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    fbcore_two_digits(out, (unsigned int)(year / 100 % 100));
+    fbcore_two_digits(out + 2, (unsigned int)(year % 100));
+    out[4] = '-';
+    fbcore_two_digits(out + 5, month);
+    out[7] = '-';
+    fbcore_two_digits(out + 8, day);
+    return 10;
+}
+
+size_t fbcore_format_time(char* out, ISC_TIME time) {
+    unsigned int seconds = time / ISC_TIME_SECONDS_PRECISION;
+    unsigned int fraction = time % ISC_TIME_SECONDS_PRECISION;
+    fbcore_two_digits(out, seconds / 3600);
+    out[2] = ':';
+    fbcore_two_digits(out + 3, seconds / 60 % 60);
+    out[5] = ':';
+    fbcore_two_digits(out + 6, seconds % 60);
+    out[8] = '.';
+    fbcore_two_digits(out + 9, fraction / 100);
+    fbcore_two_digits(out + 11, fraction % 100);
+    return 13;
+}
+
+/* the offset suffix of a time zone value, Z for UTC */
+static size_t fbcore_format_offset(char* out, int minutes) {
+    unsigned int magnitude = (unsigned int)(minutes < 0 ? -minutes : minutes);
+    if (minutes == 0) {
+        out[0] = 'Z';
+        return 1;
+    }
+    out[0] = minutes < 0 ? '-' : '+';
+    fbcore_two_digits(out + 1, magnitude / 60);
+    out[3] = ':';
+    fbcore_two_digits(out + 4, magnitude % 60);
+    return 6;
+}
+
+static size_t fbcore_format_timestamp(char* out, ISC_DATE date, ISC_TIME time, int offset) {
+    /* a UTC timestamp shifted by offset minutes */
+    const long day = 86400L * ISC_TIME_SECONDS_PRECISION;
+    long local = (long)time + (long)offset * 60 * ISC_TIME_SECONDS_PRECISION;
+    size_t length;
+    if (local < 0) {
+        local += day;
+        date--;
+    } else if (local >= day) {
+        local -= day;
+        date++;
+    }
+    length = fbcore_format_date(out, date);
+    out[length++] = 'T';
+    return length + fbcore_format_time(out + length, (ISC_TIME)local);
+}
+
+int fbcore_format_scalar(char* out, const ISC_SCHAR* data, int code, int scale) {
+    switch (code) {
+        case SQL_BOOLEAN:
+            if (*(const ISC_UCHAR*)data != 0) {
+                memcpy(out, "true", 4);
+                return 4;
+            }
+            memcpy(out, "false", 5);
+            return 5;
+        case SQL_SHORT:
+            return (int)fbcore_format_integer(out, *(const ISC_SHORT*)data, scale);
+        case SQL_LONG:
+            return (int)fbcore_format_integer(out, *(const ISC_LONG*)data, scale);
+        case SQL_INT64:
+            return (int)fbcore_format_integer(out, *(const ISC_INT64*)data, scale);
+        case SQL_INT128: {
+            ISC_INT64 value[2];
+            fbcore_get_int128(data, code, value);
+            return (int)fbcore_format_int128(out, value, scale);
+        }
+        case SQL_FLOAT:
+            if (!isfinite(*(const float*)data))
+                return -1;
+            return (int)fbcore_format_double(out, *(const float*)data, 9);
+        case SQL_DOUBLE:
+        case SQL_D_FLOAT:
+            if (!isfinite(*(const double*)data))
+                return -1;
+            return (int)fbcore_format_double(out, *(const double*)data, 17);
+        case SQL_TYPE_DATE:
+            return (int)fbcore_format_date(out, *(const ISC_DATE*)data);
+        case SQL_TYPE_TIME:
+            return (int)fbcore_format_time(out, *(const ISC_TIME*)data);
+        case SQL_TIMESTAMP: {
+            const ISC_TIMESTAMP* value = (const ISC_TIMESTAMP*)data;
+            return (int)fbcore_format_timestamp(out, value->timestamp_date, value->timestamp_time, 0);
+        }
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX: {
+            const ISC_TIME_TZ_EX* value = (const ISC_TIME_TZ_EX*)data;
+            const long long day = 86400LL * ISC_TIME_SECONDS_PRECISION;
+            int offset = code == SQL_TIME_TZ_EX ? value->ext_offset : 0;
+            long long local = ((long long)value->utc_time + (long long)offset * 60 * ISC_TIME_SECONDS_PRECISION + day) % day;
+            size_t length = fbcore_format_time(out, (ISC_TIME)local);
+            return (int)(length + fbcore_format_offset(out + length, offset));
+        }
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX: {
+            const ISC_TIMESTAMP_TZ_EX* value = (const ISC_TIMESTAMP_TZ_EX*)data;
+            int offset = code == SQL_TIMESTAMP_TZ_EX ? value->ext_offset : 0;
+            size_t length = fbcore_format_timestamp(out, value->utc_timestamp.timestamp_date,
+                                                    value->utc_timestamp.timestamp_time, offset);
+            return (int)(length + fbcore_format_offset(out + length, offset));
+        }
+        default:
+            return -1;
+    }
+}
+
+/* SWAR tests over the 8 bytes of a word */
+#define FBCORE_ONES 0x0101010101010101ULL
+#define FBCORE_HIGHS 0x8080808080808080ULL
+#define FBCORE_HAS_ZERO(v) (((v) - FBCORE_ONES) & ~(v) & FBCORE_HIGHS)
+#define FBCORE_HAS_LESS(v, n) (((v) - FBCORE_ONES * (n)) & ~(v) & FBCORE_HIGHS)
+#define FBCORE_HAS_BYTE(v, c) FBCORE_HAS_ZERO((v) ^ (FBCORE_ONES * (c)))
+
+size_t fbcore_json_string(char* out, const char* text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    size_t position = 0;
+    size_t i = 0;
+    out[position++] = '"';
+    while (i < length) {
+        /* copy runs of 8 bytes needing no escape at once */
+        while (i + 8 <= length) {
+            unsigned long long word;
+            memcpy(&word, text + i, 8);
+            if (FBCORE_HAS_LESS(word, 0x20) | FBCORE_HAS_BYTE(word, '"') | FBCORE_HAS_BYTE(word, '\\'))
+                break;
+            memcpy(out + position, text + i, 8);
+            position += 8;
+            i += 8;
+        }
+        if (i >= length)
+            break;
+        {
+            unsigned char c = (unsigned char)text[i++];
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                out[position++] = (char)c;
+                continue;
+            }
+            out[position++] = '\\';
+            switch (c) {
+                case '"': out[position++] = '"'; break;
+                case '\\': out[position++] = '\\'; break;
+                case '\n': out[position++] = 'n'; break;
+                case '\r': out[position++] = 'r'; break;
+                case '\t': out[position++] = 't'; break;
+                case '\b': out[position++] = 'b'; break;
+                case '\f': out[position++] = 'f'; break;
+                default:
+                    memcpy(out + position, "u00", 3);
+                    out[position + 3] = hex[c >> 4];
+                    out[position + 4] = hex[c & 15];
+                    position += 5;
+            }
+        }
+    }
+    out[position++] = '"';
+    return position;
+}
+
+size_t fbcore_base64(char* out, const unsigned char* data, size_t length) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t position = 0;
+    size_t i;
+    for (i = 0; i + 3 <= length; i += 3) {
+        unsigned long triple = ((unsigned long)data[i] << 16) | ((unsigned long)data[i + 1] << 8) | data[i + 2];
+        out[position++] = alphabet[(triple >> 18) & 63];
+        out[position++] = alphabet[(triple >> 12) & 63];
+        out[position++] = alphabet[(triple >> 6) & 63];
+        out[position++] = alphabet[triple & 63];
+    }
+    if (i < length) {
+        unsigned long triple = (unsigned long)data[i] << 16;
+        if (i + 1 < length)
+            triple |= (unsigned long)data[i + 1] << 8;
+        out[position++] = alphabet[(triple >> 18) & 63];
+        out[position++] = alphabet[(triple >> 12) & 63];
+        out[position++] = i + 1 < length ? alphabet[(triple >> 6) & 63] : '=';
+        out[position++] = '=';
+    }
+    return position;
+}
+
+size_t fbcore_json_base64(char* out, const unsigned char* data, size_t length) {
+    size_t position = fbcore_base64(out + 1, data, length) + 1;
+    out[0] = '"';
+    out[position++] = '"';
+    return position;
+}
+
+/* magnitude * 10 + digit over 128 bits, 0 on overflow */
+static int fbcore_push_digit(unsigned long long* high, unsigned long long* low, unsigned int digit) {
+    unsigned long long bottom = (*low & 0xFFFFFFFFULL) * 10 + digit;
+    unsigned long long top = (*low >> 32) * 10 + (bottom >> 32);
+    if (*high > (~0ULL - (top >> 32)) / 10)
+        return 0;
+    *high = *high * 10 + (top >> 32);
+    *low = (top << 32) | (bottom & 0xFFFFFFFFULL);
+    return 1;
+}
+
+/* the magnitude of a plain decimal number scaled by 10^-scale, rounded half away from zero */
+static int fbcore_parse_decimal(const char* text, size_t length, int scale, int* negative, unsigned long long* high,
+                                unsigned long long* low) {
+    size_t i = 0;
+    int digits = 0;
+    int fraction = -1; /* digits after the point, -1 before it */
+    int wanted = -scale;
+    int round = 0;
+    *negative = 0;
+    *high = 0;
+    *low = 0;
+    if (scale > 0)
+        return FBCORE_CONVERSION;
+    if (i < length && (text[i] == '-' || text[i] == '+'))
+        *negative = text[i++] == '-';
+    for (; i < length; i++) {
+        char c = text[i];
+        if (c == '.' && fraction < 0) {
+            fraction = 0;
+            continue;
+        }
+        if (c < '0' || c > '9')
+            return FBCORE_CONVERSION;
+        digits++;
+        if (fraction >= 0) {
+            if (fraction == wanted) {
+                /* only the first digit beyond the scale decides */
+                round = c >= '5';
+                fraction++;
+                continue;
+            }
+            if (fraction > wanted)
+                continue;
+            fraction++;
+        }
+        if (!fbcore_push_digit(high, low, (unsigned int)(c - '0')))
+            return FBCORE_TRUNCATION;
+    }
+    if (digits == 0)
+        return FBCORE_CONVERSION;
+    for (fraction = fraction < 0 ? 0 : fraction; fraction < wanted; fraction++)
+        if (!fbcore_push_digit(high, low, 0))
+            return FBCORE_TRUNCATION;
+    if (round && ++*low == 0 && ++*high == 0)
+        return FBCORE_TRUNCATION;
+    return FBCORE_OK;
+}
+
+/* a fixed number of digits */
+static int fbcore_parse_digits(const char* text, size_t length, size_t* position, int count, int* value) {
+    int i;
+    *value = 0;
+    if (*position + (size_t)count > length)
+        return 0;
+    for (i = 0; i < count; i++) {
+        char c = text[*position + i];
+        if (c < '0' || c > '9')
+            return 0;
+        *value = *value * 10 + (c - '0');
+    }
+    *position += (size_t)count;
+    return 1;
+}
+
+static int fbcore_parse_date(const char* text, size_t length, size_t* position, ISC_DATE* date) {
+    static const int monthDays[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int year, month, day;
+    long y, era, yearOfEra, dayOfYear;
+    if (!fbcore_parse_digits(text, length, position, 4, &year) || *position >= length || text[(*position)++] != '-' ||
+        !fbcore_parse_digits(text, length, position, 2, &month) || *position >= length ||
+        text[(*position)++] != '-' || !fbcore_parse_digits(text, length, position, 2, &day))
+        return 0;
+    if (year < 1 || month < 1 || month > 12 || day < 1 || day > monthDays[month - 1] ||
+        (month == 2 && day == 29 && (year % 4 != 0 || (year % 100 == 0 && year % 400 != 0))))
+        return 0;
+    /* days since 1970-01-01 from the civil date, proleptic Gregorian calendar */
+    y = year - (month <= 2 ? 1 : 0);
+    era = y / 400;
+    yearOfEra = y - era * 400;
+    dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    *date = (ISC_DATE)(era * 146097 + yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear - 719468 +
+                       FBCORE_EPOCH_DAYS);
+    return 1;
+}
+
+/* HH:MM[:SS[.fraction]], digits beyond the precision of ISC_TIME are dropped */
+static int fbcore_parse_time(const char* text, size_t length, size_t* position, ISC_TIME* time) {
+    int hours, minutes, seconds = 0;
+    ISC_TIME fraction = 0;
+    ISC_TIME unit = ISC_TIME_SECONDS_PRECISION;
+    if (!fbcore_parse_digits(text, length, position, 2, &hours) || *position >= length || text[(*position)++] != ':' ||
+        !fbcore_parse_digits(text, length, position, 2, &minutes))
+        return 0;
+    if (*position < length && text[*position] == ':') {
+        (*position)++;
+        if (!fbcore_parse_digits(text, length, position, 2, &seconds))
+            return 0;
+        if (*position < length && text[*position] == '.') {
+            (*position)++;
+            if (*position >= length || text[*position] < '0' || text[*position] > '9')
+                return 0;
+            for (; *position < length && text[*position] >= '0' && text[*position] <= '9'; (*position)++) {
+                unit /= 10;
+                fraction += (ISC_TIME)(text[*position] - '0') * unit;
+            }
+        }
+    }
+    if (hours > 23 || minutes > 59 || seconds > 59)
+        return 0;
+    *time = ((ISC_TIME)hours * 3600 + (ISC_TIME)minutes * 60 + (ISC_TIME)seconds) * ISC_TIME_SECONDS_PRECISION + fraction;
+    return 1;
+}
+
+/* Z or an offset, the rest of the text; nothing is UTC */
+static int fbcore_parse_offset(const char* text, size_t length, size_t* position, int* minutes) {
+    int sign, hours, rest;
+    *minutes = 0;
+    if (*position == length)
+        return 1;
+    if (text[*position] == 'Z')
+        return ++*position == length;
+    if (text[*position] != '+' && text[*position] != '-')
+        return 0;
+    sign = text[(*position)++] == '-' ? -1 : 1;
+    if (!fbcore_parse_digits(text, length, position, 2, &hours) || *position >= length || text[(*position)++] != ':' ||
+        !fbcore_parse_digits(text, length, position, 2, &rest) || *position != length || hours > 23 || rest > 59)
+        return 0;
+    *minutes = sign * (hours * 60 + rest);
+    return 1;
+}
+
+/* the time zone id of an offset, offsets are encoded around 23:59, GMT has its own id */
+static ISC_USHORT fbcore_offset_zone(int minutes) {
+    return (ISC_USHORT)(minutes == 0 ? 65535 : minutes + 1439);
+}
+
+int fbcore_parse_scalar(ISC_SCHAR* data, int code, int scale, const char* text, size_t length) {
+    size_t position = 0;
+    switch (code) {
+        case SQL_BOOLEAN:
+            if ((length == 4 && strncmp(text, "true", 4) == 0) || (length == 1 && text[0] == '1'))
+                *(ISC_UCHAR*)data = FB_TRUE;
+            else if ((length == 5 && strncmp(text, "false", 5) == 0) || (length == 1 && text[0] == '0'))
+                *(ISC_UCHAR*)data = FB_FALSE;
+            else
+                return FBCORE_CONVERSION;
+            return FBCORE_OK;
+        case SQL_SHORT:
+        case SQL_LONG:
+        case SQL_INT64: {
+            int negative;
+            unsigned long long high, low;
+            unsigned long long limit = code == SQL_SHORT ? 0x7FFFULL : code == SQL_LONG ? 0x7FFFFFFFULL
+                                                                                        : 0x7FFFFFFFFFFFFFFFULL;
+            int ret = fbcore_parse_decimal(text, length, scale, &negative, &high, &low);
+            if (ret != FBCORE_OK)
+                return ret;
+            if (high != 0 || low > limit + (negative ? 1 : 0))
+                return FBCORE_TRUNCATION;
+            if (negative)
+                low = 0ULL - low;
+            if (code == SQL_SHORT)
+                *(ISC_SHORT*)data = (ISC_SHORT)low;
+            else if (code == SQL_LONG)
+                *(ISC_LONG*)data = (ISC_LONG)low;
+            else
+                *(ISC_INT64*)data = (ISC_INT64)low;
+            return FBCORE_OK;
+        }
+        case SQL_INT128: {
+            int negative;
+            unsigned long long high, low;
+            int ret = fbcore_parse_decimal(text, length, scale, &negative, &high, &low);
+            if (ret != FBCORE_OK)
+                return ret;
+            if (high > 0x7FFFFFFFFFFFFFFFULL && !(negative && high == 0x8000000000000000ULL && low == 0))
+                return FBCORE_TRUNCATION;
+            if (negative) {
+                low = ~low + 1;
+                high = ~high + (low == 0 ? 1 : 0);
+            }
+            return fbcore_set_int128(data, code, (ISC_INT64)low, (ISC_INT64)high);
+        }
+        case SQL_FLOAT:
+        case SQL_DOUBLE:
+        case SQL_D_FLOAT: {
+            /* strtod needs a terminated copy */
+            char copy[FBCORE_FORMAT_SIZE + 16];
+            char* end;
+            if (length == 0 || length >= sizeof copy)
+                return FBCORE_CONVERSION;
+            memcpy(copy, text, length);
+            copy[length] = 0;
+            if (code == SQL_FLOAT)
+                *(float*)data = strtof(copy, &end);
+            else
+                *(double*)data = strtod(copy, &end);
+            return end == copy + length ? FBCORE_OK : FBCORE_CONVERSION;
+        }
+        case SQL_TYPE_DATE:
+            if (!fbcore_parse_date(text, length, &position, (ISC_DATE*)data) || position != length)
+                return FBCORE_CONVERSION;
+            return FBCORE_OK;
+        case SQL_TYPE_TIME:
+            if (!fbcore_parse_time(text, length, &position, (ISC_TIME*)data) || position != length)
+                return FBCORE_CONVERSION;
+            return FBCORE_OK;
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX: {
+            const long long day = 86400LL * ISC_TIME_SECONDS_PRECISION;
+            ISC_TIME_TZ_EX* value = (ISC_TIME_TZ_EX*)data;
+            ISC_TIME local;
+            int offset;
+            if (!fbcore_parse_time(text, length, &position, &local) || !fbcore_parse_offset(text, length, &position, &offset))
+                return FBCORE_CONVERSION;
+            value->utc_time = (ISC_TIME)(((long long)local - (long long)offset * 60 * ISC_TIME_SECONDS_PRECISION + day) % day);
+            value->time_zone = fbcore_offset_zone(offset);
+            if (code == SQL_TIME_TZ_EX)
+                value->ext_offset = (ISC_SHORT)offset;
+            return FBCORE_OK;
+        }
+        case SQL_TIMESTAMP:
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX: {
+            const long long day = 86400LL * ISC_TIME_SECONDS_PRECISION;
+            ISC_DATE date;
+            ISC_TIME time = 0;
+            int offset = 0;
+            long long utc;
+            if (!fbcore_parse_date(text, length, &position, &date))
+                return FBCORE_CONVERSION;
+            /* a date alone is midnight */
+            if (position < length) {
+                if (text[position] != 'T' && text[position] != ' ')
+                    return FBCORE_CONVERSION;
+                position++;
+                if (!fbcore_parse_time(text, length, &position, &time))
+                    return FBCORE_CONVERSION;
+            }
+            if (code == SQL_TIMESTAMP) {
+                if (position != length)
+                    return FBCORE_CONVERSION;
+                ((ISC_TIMESTAMP*)data)->timestamp_date = date;
+                ((ISC_TIMESTAMP*)data)->timestamp_time = time;
+                return FBCORE_OK;
+            }
+            if (!fbcore_parse_offset(text, length, &position, &offset))
+                return FBCORE_CONVERSION;
+            utc = (long long)time - (long long)offset * 60 * ISC_TIME_SECONDS_PRECISION;
+            if (utc < 0) {
+                utc += day;
+                date--;
+            } else if (utc >= day) {
+                utc -= day;
+                date++;
+            }
+            ((ISC_TIMESTAMP_TZ_EX*)data)->utc_timestamp.timestamp_date = date;
+            ((ISC_TIMESTAMP_TZ_EX*)data)->utc_timestamp.timestamp_time = (ISC_TIME)utc;
+            ((ISC_TIMESTAMP_TZ_EX*)data)->time_zone = fbcore_offset_zone(offset);
+            if (code == SQL_TIMESTAMP_TZ_EX)
+                ((ISC_TIMESTAMP_TZ_EX*)data)->ext_offset = (ISC_SHORT)offset;
+            return FBCORE_OK;
+        }
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+long fbcore_parse_base64(unsigned char* out, const char* text, size_t length) {
+    long position = 0;
+    size_t i;
+    if (length % 4 != 0)
+        return -1;
+    for (i = 0; i < length; i += 4) {
+        unsigned long quad = 0;
+        int padding = 0;
+        int j;
+        for (j = 0; j < 4; j++) {
+            char c = text[i + j];
+            unsigned long value;
+            if (c >= 'A' && c <= 'Z')
+                value = (unsigned long)(c - 'A');
+            else if (c >= 'a' && c <= 'z')
+                value = (unsigned long)(c - 'a' + 26);
+            else if (c >= '0' && c <= '9')
+                value = (unsigned long)(c - '0' + 52);
+            else if (c == '+')
+                value = 62;
+            else if (c == '/')
+                value = 63;
+            else if (c == '=' && i + 4 == length && j >= 2) {
+                padding++;
+                value = 0;
+            } else
+                return -1;
+            /* padding only at the end of the last group */
+            if (padding > 0 && c != '=')
+                return -1;
+            quad = (quad << 6) | value;
+        }
+        out[position++] = (unsigned char)(quad >> 16);
+        if (padding < 2)
+            out[position++] = (unsigned char)(quad >> 8);
+        if (padding < 1)
+            out[position++] = (unsigned char)quad;
+    }
+    return position;
+}
@@ -0,0 +1,646 @@
+#ifndef FBCORE_H
+#define FBCORE_H
+
+/*
+ * Conversion core shared by the JNI shim and the Kotlin/Native cinterop.
+ *
+ * Plain C ABI so that the same code runs behind both backends: the type kernels are static inline functions, which
+ * the JNI shim inlines in its entry points and cinterop exposes through generated stubs, while the buffer, blob and
+ * info routines live in fbcore.c (libfbcore).
+ *
+ * The core never throws nor allocates on the caller's behalf except for XSQLDA buffers: kernels return one of the
+ * FBCORE_ codes below and each backend maps it to its own exception. Client entry points are passed in as function
+ * pointers, the JNI shim resolves them at runtime while Kotlin/Native links them.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <ibase.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FBCORE_OK          0
+#define FBCORE_CONVERSION  1 /* the column type does not accept the value */
+#define FBCORE_TRUNCATION  2 /* the value does not fit in the column */
+
+/* days between 1858-11-17, the day 0 of ISC_DATE, and 1970-01-01 */
+#define FBCORE_EPOCH_DAYS  40587
+
+typedef ISC_LONG (ISC_EXPORT *fbcore_interpret_fn)(ISC_SCHAR*, unsigned int, const ISC_STATUS**);
+typedef ISC_STATUS (ISC_EXPORT *fbcore_get_segment_fn)(ISC_STATUS*, isc_blob_handle*, unsigned short*, unsigned short,
+        void*);
+typedef ISC_STATUS (ISC_EXPORT *fbcore_put_segment_fn)(ISC_STATUS*, isc_blob_handle*, unsigned short, const void*);
+typedef ISC_STATUS (ISC_EXPORT *fbcore_blob_info_fn)(ISC_STATUS*, isc_blob_handle*, short, const void*, short, void*);
+typedef ISC_STATUS (ISC_EXPORT *fbcore_sql_info_fn)(ISC_STATUS*, isc_stmt_handle*, short, const ISC_SCHAR*, short,
+        ISC_SCHAR*);
+
+/*
+ * XSQLDA layout
+ */
+
+/**
+ * Allocates a zeroed version 1 XSQLDA able to describe count columns, sqln is set.
+ */
+XSQLDA* fbcore_alloc_sqlda(short count);
+
+/**
+ * Allocates one buffer holding the data and null indicators of every described column and points sqldata and sqlind
+ * into it. Text columns get room for a zero terminal, nullable columns start null.
+ *
+ * The null indicators come first as one contiguous block, then the fixed width columns aligned on their natural
+ * alignment, then the CHAR and VARCHAR columns; the columns of a row are not laid out in column order.
+ *
+ * @return FBCORE_OK, or -1 when the buffer cannot be allocated; sqldata and sqlind are cleared then.
+ */
+int fbcore_allocate_data_buffer(XSQLDA* sqlda);
+
+/**
+ * Frees the buffer of fbcore_allocate_data_buffer and clears sqldata and sqlind.
+ */
+void fbcore_free_data_buffer(XSQLDA* sqlda);
+
+/**
+ * Replaces the columns of an XSQLDA laid out by fbcore_allocate_data_buffer with copies whose types changed, in a new
+ * data buffer; the values set are lost. The XSQLDA is left as it was when the buffer cannot be allocated.
+ *
+ * @param vars The sqld columns of the XSQLDA, changed by fbcore_set_var_type.
+ * @return FBCORE_OK, or -1 when the buffer cannot be allocated.
+ */
+int fbcore_relayout_data_buffer(XSQLDA* sqlda, const XSQLVAR* vars);
+
+/**
+ * Changes the type of a described column to the one the client reads or writes, the server converting the values
+ * from or to the described type when the statement is executed or fetched.
+ *
+ * The length follows the type: the size of a fixed width type; for text, the described length converted to the new
+ * character set, or 64 characters when the column was not text. Exact numerics keep their scale when they stay exact
+ * numerics, other types take a scale of 0. The data buffer must be laid out again afterwards, by
+ * fbcore_relayout_data_buffer.
+ *
+ * @param code The new SQL type, without the null flag which is kept.
+ * @param subtype For SQL_TEXT and SQL_VARYING, the character set, 4 for UTF8; the others are taken as one byte per
+ * character.
+ * @return FBCORE_OK, or FBCORE_CONVERSION when the type is not supported or the column is a blob or an array.
+ */
+int fbcore_set_var_type(XSQLVAR* var, int code, int subtype);
+
+#define FBCORE_OUTPUT_TIMESTAMP 1 /* times and timestamps with a time zone read without it, in the session time zone */
+#define FBCORE_OUTPUT_BIGINT    2 /* INT128 read as BIGINT with the same scale */
+#define FBCORE_OUTPUT_VARCHAR   4 /* CHAR read as VARCHAR, with the length of the value */
+
+/**
+ * Changes the types of the described output columns of a statement to the ones the getters read without decoding,
+ * as fbcore_set_var_type does, following a combination of the FBCORE_OUTPUT_ flags, and lays out the data buffer
+ * again when columns are changed. The XSQLDA is left as it was when the buffer cannot be allocated.
+ *
+ * The server converts the values on fetch and fails it when a value does not fit, an INT128 beyond the BIGINT range.
+ *
+ * @return The number of columns changed, or -1 when the buffer cannot be allocated.
+ */
+int fbcore_set_output_profile(XSQLDA* sqlda, int profile);
+
+/**
+ * Frees an XSQLDA from fbcore_alloc_sqlda and its data buffer, if any.
+ */
+void fbcore_free_sqlda(XSQLDA* sqlda);
+
+/**
+ * Returns the size of the current row of an XSQLDA packed by fbcore_pack_row.
+ */
+size_t fbcore_packed_size(const XSQLDA* sqlda);
+
+/**
+ * Packs the current row of an XSQLDA laid out by fbcore_allocate_data_buffer: the null indicators and fixed width
+ * columns are copied as they are, then the CHAR columns and the VARCHAR columns with their actual length, skipping
+ * the null ones.
+ *
+ * @return The number of bytes written, as fbcore_packed_size.
+ */
+size_t fbcore_pack_row(const XSQLDA* sqlda, char* out);
+
+/**
+ * Restores a row packed by fbcore_pack_row into the buffer of the same XSQLDA. The data of null text columns is left
+ * as it was.
+ *
+ * @return The number of bytes read.
+ */
+size_t fbcore_unpack_row(XSQLDA* sqlda, const char* in);
+
+/*
+ * Text
+ */
+
+/**
+ * Returns the number of bytes of the first maxlength UTF-8 characters of a zero terminated string, at most maxsize.
+ */
+size_t fbcore_utf8_size(const char* string, int maxlength, int maxsize);
+
+/**
+ * Terminates a CHAR or VARCHAR value in place and returns it as a C string, CHAR padding beyond the column's
+ * character length is dropped. bytesPerChar is the maximum size of a character in the column's character set.
+ *
+ * @return the string, or NULL when the column is not a text column.
+ */
+const char* fbcore_get_text(ISC_SCHAR* data, int code, int len, int bytesPerChar);
+
+/*
+ * Blobs
+ */
+
+/**
+ * Reads up to length bytes of an open blob, across segments. Empty segments are skipped.
+ *
+ * @return the number of bytes read, reading stops early at the end of the blob or on error (see status).
+ */
+int fbcore_blob_read(ISC_STATUS* status, isc_blob_handle* blob, char* buffer, int length, fbcore_get_segment_fn get);
+
+/**
+ * Writes length bytes to an open blob, in segments of at most 32767 bytes.
+ *
+ * @return the number of bytes written, writing stops early on error (see status).
+ */
+int fbcore_blob_write(ISC_STATUS* status, isc_blob_handle* blob, const char* buffer, int length,
+                      fbcore_put_segment_fn put);
+
+/**
+ * Queries the total length of an open blob.
+ */
+ISC_STATUS fbcore_blob_length(ISC_STATUS* status, isc_blob_handle* blob, ISC_LONG* length, fbcore_blob_info_fn info);
+
+/*
+ * Info and status
+ */
+
+/**
+ * Formats every message of a status vector, one per line, into buffer.
+ *
+ * @return the length of the text, which is always zero terminated.
+ */
+unsigned int fbcore_interpret(ISC_SCHAR* buffer, unsigned int size, const ISC_STATUS* status,
+                              fbcore_interpret_fn interpret);
+
+/**
+ * Returns the isc_info_sql_stmt_type of a prepared statement, minus one as the API.getStatementType contract.
+ */
+int fbcore_statement_type(ISC_STATUS* status, isc_stmt_handle* statement, fbcore_sql_info_fn info);
+
+/*
+ * Events
+ *
+ * An event parameter block is a version byte followed, for each event, by the length of its name, the name and the
+ * last count received, as a little endian 32-bit integer.
+ */
+
+/**
+ * Appends an event with a zero count to an event parameter block, position 0 starts the block with its version byte.
+ * A name takes at most 5 bytes more than its length, the version byte one.
+ *
+ * @return The position after the event, or 0 when the name is empty or longer than 255 bytes.
+ */
+size_t fbcore_event_name(ISC_UCHAR* block, size_t position, const char* name, size_t length);
+
+/**
+ * Compares the counts of an event parameter block with the updated block given to an event callback, then copies
+ * the updated block over it, as isc_event_counts does.
+ *
+ * @param counts Receives, for each event, the number of times it was posted since the block was queued.
+ * @param capacity The length of counts.
+ * @return The number of events of the block.
+ */
+int fbcore_event_counts(ISC_ULONG* counts, int capacity, ISC_UCHAR* block, size_t length, const ISC_UCHAR* updated);
+
+/*
+ * Text formatting
+ *
+ * Formatters write the text of a value into out and return its length, the text is not zero terminated. Scalar
+ * formatters need FBCORE_FORMAT_SIZE bytes; string formatters need the worst case size given for each.
+ */
+
+#define FBCORE_FORMAT_SIZE 48
+
+/**
+ * Formats an integer with its scale, -3 puts three digits after the decimal point.
+ */
+size_t fbcore_format_integer(char* out, ISC_INT64 value, int scale);
+
+/**
+ * Formats a 128-bit integer, value[0] holding the low 64 bits, with its scale.
+ */
+size_t fbcore_format_int128(char* out, const ISC_INT64 value[2], int scale);
+
+/**
+ * Formats a finite floating point value with the fewest digits that read back to it, precision 9 for a float.
+ */
+size_t fbcore_format_double(char* out, double value, int precision);
+
+/**
+ * Formats a date as YYYY-MM-DD.
+ */
+size_t fbcore_format_date(char* out, ISC_DATE date);
+
+/**
+ * Formats a time of day as HH:MM:SS.FFFF.
+ */
+size_t fbcore_format_time(char* out, ISC_TIME time);
+
+/**
+ * Formats a column that is neither text nor blob: numbers with their scale, booleans, and ISO 8601 dates, times and
+ * timestamps. Values with a time zone are given in UTC with a Z suffix, or with their offset for the _EX types.
+ *
+ * @return the length, or -1 for text, blob, array and decimal float columns and for non-finite floating points.
+ */
+int fbcore_format_scalar(char* out, const ISC_SCHAR* data, int code, int scale);
+
+/**
+ * Writes text as a quoted JSON string, escaping quotes, backslashes and control characters; UTF-8 is copied as is.
+ * out needs 6 * length + 2 bytes.
+ */
+size_t fbcore_json_string(char* out, const char* text, size_t length);
+
+/**
+ * Writes bytes in base64, with padding. out needs 4 * ((length + 2) / 3) bytes.
+ */
+size_t fbcore_base64(char* out, const unsigned char* data, size_t length);
+
+/**
+ * Writes bytes as a quoted base64 JSON string. out needs 4 * ((length + 2) / 3) + 2 bytes.
+ */
+size_t fbcore_json_base64(char* out, const unsigned char* data, size_t length);
+
+/*
+ * Text parsing
+ *
+ * The inverse of the formatting above, for loading text files: plain decimal numbers, ISO 8601 dates and times and
+ * time zones as Z or an offset.
+ */
+
+/**
+ * Parses the text of a value into the sqldata of a column of type code, for the types fbcore_format_scalar formats.
+ * Decimals beyond the scale are rounded half away from zero; a time zone value without Z nor offset is UTC.
+ *
+ * @return FBCORE_OK, FBCORE_CONVERSION when the text is not a value of the type, or FBCORE_TRUNCATION when the value
+ * is out of the range of the type.
+ */
+int fbcore_parse_scalar(ISC_SCHAR* data, int code, int scale, const char* text, size_t length);
+
+/**
+ * Decodes padded base64 text. out needs 3 * (length / 4) bytes.
+ *
+ * @return the number of bytes decoded, or -1 when the text is not base64.
+ */
+long fbcore_parse_base64(unsigned char* out, const char* text, size_t length);
+
+/*
+ * Type kernels
+ *
+ * data points to the sqldata of a column and code is its sqltype without the null flag. Getters store the value and
+ * setters write it when the column type accepts it, otherwise they leave everything untouched.
+ */
+
+static inline int fbcore_get_boolean(const ISC_SCHAR* data, int code, int* value) {
+    switch (code) {
+        case SQL_BOOLEAN:
+            *value = *(const ISC_UCHAR*)data != FB_FALSE;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_get_short(const ISC_SCHAR* data, int code, ISC_SHORT* value) {
+    switch (code) {
+        case SQL_SHORT:
+            *value = *(const ISC_SHORT*)data;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_get_int(const ISC_SCHAR* data, int code, ISC_LONG* value) {
+    switch (code) {
+        case SQL_LONG:
+            *value = *(const ISC_LONG*)data;
+            return FBCORE_OK;
+        case SQL_SHORT:
+            *value = *(const ISC_SHORT*)data;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_get_long(const ISC_SCHAR* data, int code, ISC_INT64* value) {
+    switch (code) {
+        case SQL_INT64:
+        case SQL_QUAD:
+            *value = *(const ISC_INT64*)data;
+            return FBCORE_OK;
+        case SQL_LONG:
+            *value = *(const ISC_LONG*)data;
+            return FBCORE_OK;
+        case SQL_SHORT:
+            *value = *(const ISC_SHORT*)data;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+/* value[0] holds the low 64 bits, value[1] the high ones */
+static inline int fbcore_get_int128(const ISC_SCHAR* data, int code, ISC_INT64 value[2]) {
+    switch (code) {
+        case SQL_INT128:
+            value[0] = (ISC_INT64)((const FB_I128*)data)->fb_data[0];
+            value[1] = (ISC_INT64)((const FB_I128*)data)->fb_data[1];
+            return FBCORE_OK;
+        default:
+            if (fbcore_get_long(data, code, &value[0]) != FBCORE_OK)
+                return FBCORE_CONVERSION;
+            value[1] = value[0] >= 0 ? 0 : -1;
+            return FBCORE_OK;
+    }
+}
+
+static inline int fbcore_get_float(const ISC_SCHAR* data, int code, float* value) {
+    switch (code) {
+        case SQL_FLOAT:
+            *value = *(const float*)data;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_get_double(const ISC_SCHAR* data, int code, double* value) {
+    switch (code) {
+        case SQL_FLOAT:
+            *value = *(const float*)data;
+            return FBCORE_OK;
+        case SQL_DOUBLE:
+        case SQL_D_FLOAT:
+            *value = *(const double*)data;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+/* days since 1970-01-01 */
+static inline int fbcore_get_date(const ISC_SCHAR* data, int code, int* value) {
+    switch (code) {
+        case SQL_TYPE_DATE:
+        case SQL_TIMESTAMP:
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX:
+            *value = *(const ISC_DATE*)data - FBCORE_EPOCH_DAYS;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+/* milliseconds of the day */
+static inline int fbcore_get_time(const ISC_SCHAR* data, int code, int* value) {
+    switch (code) {
+        case SQL_TYPE_TIME:
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX:
+            *value = (int)(*(const ISC_TIME*)data / 10);
+            return FBCORE_OK;
+        case SQL_TIMESTAMP:
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX:
+            *value = (int)(((const ISC_TIMESTAMP*)data)->timestamp_time / 10);
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_get_time_zone(const ISC_SCHAR* data, int code, int* value) {
+    switch (code) {
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX:
+            *value = ((const ISC_TIME_TZ*)data)->time_zone;
+            return FBCORE_OK;
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX:
+            *value = ((const ISC_TIMESTAMP_TZ*)data)->time_zone;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_get_blob_id(const ISC_SCHAR* data, int code, ISC_INT64* value) {
+    switch (code) {
+        case SQL_BLOB:
+            *value = *(const ISC_INT64*)data;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_boolean(ISC_SCHAR* data, int code, int value) {
+    switch (code) {
+        case SQL_BOOLEAN:
+            *(ISC_UCHAR*)data = value ? FB_TRUE : FB_FALSE;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline void fbcore_store_int128(ISC_SCHAR* data, ISC_INT64 value) {
+    ((FB_I128*)data)->fb_data[0] = (ISC_UINT64)value;
+    ((FB_I128*)data)->fb_data[1] = value < 0 ? (ISC_UINT64)-1 : 0;
+}
+
+static inline int fbcore_set_short(ISC_SCHAR* data, int code, ISC_SHORT value) {
+    switch (code) {
+        case SQL_SHORT:
+            *(ISC_SHORT*)data = value;
+            return FBCORE_OK;
+        case SQL_LONG:
+            *(ISC_LONG*)data = value;
+            return FBCORE_OK;
+        case SQL_INT64:
+        case SQL_QUAD:
+            *(ISC_INT64*)data = value;
+            return FBCORE_OK;
+        case SQL_FLOAT:
+            *(float*)data = value;
+            return FBCORE_OK;
+        case SQL_D_FLOAT:
+        case SQL_DOUBLE:
+            *(double*)data = value;
+            return FBCORE_OK;
+        case SQL_INT128:
+            fbcore_store_int128(data, value);
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_int(ISC_SCHAR* data, int code, ISC_LONG value) {
+    switch (code) {
+        case SQL_LONG:
+            *(ISC_LONG*)data = value;
+            return FBCORE_OK;
+        case SQL_INT64:
+        case SQL_QUAD:
+            *(ISC_INT64*)data = value;
+            return FBCORE_OK;
+        case SQL_D_FLOAT:
+        case SQL_DOUBLE:
+            *(double*)data = value;
+            return FBCORE_OK;
+        case SQL_INT128:
+            fbcore_store_int128(data, value);
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_long(ISC_SCHAR* data, int code, ISC_INT64 value) {
+    switch (code) {
+        case SQL_INT64:
+        case SQL_QUAD:
+            *(ISC_INT64*)data = value;
+            return FBCORE_OK;
+        case SQL_INT128:
+            fbcore_store_int128(data, value);
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_int128(ISC_SCHAR* data, int code, ISC_INT64 low, ISC_INT64 high) {
+    switch (code) {
+        case SQL_INT128:
+            ((FB_I128*)data)->fb_data[0] = (ISC_UINT64)low;
+            ((FB_I128*)data)->fb_data[1] = (ISC_UINT64)high;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_float(ISC_SCHAR* data, int code, float value) {
+    switch (code) {
+        case SQL_FLOAT:
+            *(float*)data = value;
+            return FBCORE_OK;
+        case SQL_D_FLOAT:
+        case SQL_DOUBLE:
+            *(double*)data = value;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_double(ISC_SCHAR* data, int code, double value) {
+    switch (code) {
+        case SQL_D_FLOAT:
+        case SQL_DOUBLE:
+            *(double*)data = value;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_date(ISC_SCHAR* data, int code, int value) {
+    switch (code) {
+        case SQL_TYPE_DATE:
+        case SQL_TIMESTAMP:
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX:
+            *(ISC_DATE*)data = value + FBCORE_EPOCH_DAYS;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_time(ISC_SCHAR* data, int code, int value) {
+    switch (code) {
+        case SQL_TYPE_TIME:
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX:
+            *(ISC_TIME*)data = (ISC_TIME)value * 10;
+            return FBCORE_OK;
+        case SQL_TIMESTAMP:
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX:
+            ((ISC_TIMESTAMP*)data)->timestamp_time = (ISC_TIME)value * 10;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_time_zone(ISC_SCHAR* data, int code, int value) {
+    if (value < 0 || value > 65535)
+        return FBCORE_CONVERSION;
+    switch (code) {
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX:
+            ((ISC_TIME_TZ*)data)->time_zone = (ISC_USHORT)value;
+            return FBCORE_OK;
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX:
+            ((ISC_TIMESTAMP_TZ*)data)->time_zone = (ISC_USHORT)value;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+static inline int fbcore_set_blob_id(ISC_SCHAR* data, int code, ISC_INT64 value) {
+    switch (code) {
+        case SQL_BLOB:
+            *(ISC_INT64*)data = value;
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+/**
+ * Copies raw bytes into a CHAR or VARCHAR column, CHAR values are padded with pad up to the column length.
+ */
+static inline int fbcore_set_bytes(ISC_SCHAR* data, int code, int len, const void* value, int size, char pad) {
+    switch (code) {
+        case SQL_VARYING:
+            if (size > len)
+                return FBCORE_TRUNCATION;
+            if (size > 0)
+                memcpy(((PARAMVARY*)data)->vary_string, value, (size_t)size);
+            ((PARAMVARY*)data)->vary_length = (ISC_USHORT)size;
+            return FBCORE_OK;
+        case SQL_TEXT:
+            if (size > len)
+                return FBCORE_TRUNCATION;
+            memset(data, pad, (size_t)len);
+            if (size > 0)
+                memcpy(data, value, (size_t)size);
+            return FBCORE_OK;
+        default:
+            return FBCORE_CONVERSION;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FBCORE_H */
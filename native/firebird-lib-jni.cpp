@@ -1,1667 +1,6093 @@
 #include <jni.h>
 #include <ibase.h>
+#include <firebird/Interface.h>
 #include <cstring>
+#include <cstdarg>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <algorithm>
+#include <cerrno>
+#include <condition_variable>
 #include <limits>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
 
 #ifdef _WIN32
     #include <windows.h>
+    #include <io.h>
 #else
     #include <dlfcn.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
 #endif
 
-static ISC_LONG ISC_EXPORT (*interpret)(ISC_SCHAR*, unsigned int, const ISC_STATUS**);
+#include "histogram.h"
+#include "recorder.h"
+#include "fbcore.h"
 
-static ISC_STATUS ISC_EXPORT (*attach_database)(ISC_STATUS *, short, const void *, isc_db_handle *, short, const void *);
+/**
+ * An entry point of the client library, called like the function pointer it holds.
+ *
+ * The entry points are swapped while other threads call through them, when the interposition layer is toggled or a
+ * library loaded: the pointer is atomic, its relaxed loads cost no more than those of a plain pointer.
+ */
+template<typename F>
+class ClientEntry {
+public:
+    using Function = F;
 
-static ISC_STATUS ISC_EXPORT (*create_database)(ISC_STATUS*, unsigned short, const void*, isc_db_handle*, unsigned short, const void*, unsigned short);
+    operator F*() const {
+        return entry.load(std::memory_order_relaxed);
+    }
 
-static ISC_STATUS ISC_EXPORT (*detach_database)(ISC_STATUS *, isc_db_handle *);
+    ClientEntry& operator=(F* function) {
+        entry.store(function, std::memory_order_relaxed);
+        return *this;
+    }
 
-static ISC_STATUS ISC_EXPORT (*dsql_execute_immediate)(ISC_STATUS*, isc_db_handle*, isc_tr_handle*, unsigned short, const void*, unsigned short, const XSQLDA*);
+    ClientEntry& operator=(const ClientEntry& other) {
+        return *this = static_cast<F*>(other);
+    }
 
-static ISC_STATUS ISC_EXPORT_VARARG (*start_transaction)(ISC_STATUS*, isc_tr_handle*, short, ...);
+private:
+    std::atomic<F*> entry{nullptr};
+};
 
-static ISC_STATUS ISC_EXPORT (*commit_retaining)(ISC_STATUS *, isc_tr_handle *);
+static ClientEntry<ISC_LONG ISC_EXPORT (ISC_SCHAR*, unsigned int, const ISC_STATUS**)> interpret;
 
-static ISC_STATUS ISC_EXPORT (*commit_transaction)(ISC_STATUS *, isc_tr_handle *);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, short, const void *, isc_db_handle *, short, const void *)> attach_database;
 
-static ISC_STATUS ISC_EXPORT (*rollback_retaining)(ISC_STATUS*, isc_tr_handle*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, unsigned short, const void*, isc_db_handle*, unsigned short, const void*, unsigned short)> create_database;
 
-static ISC_STATUS ISC_EXPORT (*rollback_transaction)(ISC_STATUS*, isc_tr_handle*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_db_handle *)> detach_database;
 
-static ISC_STATUS ISC_EXPORT (*dsql_allocate_statement)(ISC_STATUS *, isc_db_handle *, isc_stmt_handle *);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, isc_tr_handle*, unsigned short, const void*, unsigned short, const XSQLDA*)> dsql_execute_immediate;
 
-static ISC_STATUS ISC_EXPORT (*dsql_prepare)(ISC_STATUS*, isc_tr_handle*, isc_stmt_handle*, unsigned short, const void*, unsigned short, XSQLDA*);
+static ClientEntry<ISC_STATUS ISC_EXPORT_VARARG (ISC_STATUS*, isc_tr_handle*, short, ...)> start_transaction;
 
-static ISC_STATUS ISC_EXPORT (*dsql_set_cursor_name)(ISC_STATUS*, isc_stmt_handle*, const ISC_SCHAR*, unsigned short);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_tr_handle *)> commit_retaining;
 
-static ISC_STATUS ISC_EXPORT (*dsql_describe)(ISC_STATUS *, isc_stmt_handle *, unsigned short, XSQLDA *);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_tr_handle *)> commit_transaction;
 
-static ISC_STATUS ISC_EXPORT (*dsql_describe_bind)(ISC_STATUS *, isc_stmt_handle *, unsigned short, XSQLDA *);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_tr_handle*)> rollback_retaining;
 
-static ISC_STATUS ISC_EXPORT (*dsql_execute)(ISC_STATUS*, isc_tr_handle*, isc_stmt_handle*, unsigned short, const XSQLDA*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_tr_handle*)> rollback_transaction;
 
-static ISC_STATUS ISC_EXPORT (*dsql_execute2)(ISC_STATUS*, isc_tr_handle*, isc_stmt_handle*, unsigned short, const XSQLDA*, const XSQLDA*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_db_handle *, isc_stmt_handle *)> dsql_allocate_statement;
 
-static ISC_STATUS ISC_EXPORT (*dsql_fetch)(ISC_STATUS *, isc_stmt_handle *, unsigned short, const XSQLDA *);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_tr_handle*, isc_stmt_handle*, unsigned short, const void*, unsigned short, XSQLDA*)> dsql_prepare;
 
-static ISC_STATUS ISC_EXPORT (*dsql_free_statement)(ISC_STATUS *, isc_stmt_handle *, unsigned short);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_stmt_handle*, const ISC_SCHAR*, unsigned short)> dsql_set_cursor_name;
 
-static ISC_STATUS ISC_EXPORT (*open_blob)(ISC_STATUS*, isc_db_handle*, isc_tr_handle*, isc_blob_handle*, ISC_QUAD*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_stmt_handle *, unsigned short, XSQLDA *)> dsql_describe;
 
-static ISC_STATUS ISC_EXPORT (*get_segment)(ISC_STATUS *, isc_blob_handle *, unsigned short *, unsigned short, void *);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_stmt_handle *, unsigned short, XSQLDA *)> dsql_describe_bind;
 
-static ISC_STATUS ISC_EXPORT (*put_segment)(ISC_STATUS*, isc_blob_handle*, unsigned short, const void*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_tr_handle*, isc_stmt_handle*, unsigned short, const XSQLDA*)> dsql_execute;
 
-static ISC_STATUS ISC_EXPORT (*blob_info)(ISC_STATUS*, isc_blob_handle*, short, const void*, short, void*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_tr_handle*, isc_stmt_handle*, unsigned short, const XSQLDA*, const XSQLDA*)> dsql_execute2;
 
-static ISC_STATUS ISC_EXPORT (*close_blob)(ISC_STATUS *, isc_blob_handle *);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_stmt_handle *, unsigned short, const XSQLDA *)> dsql_fetch;
 
-static ISC_STATUS ISC_EXPORT (*create_blob)(ISC_STATUS*, isc_db_handle*, isc_tr_handle*, isc_blob_handle*, ISC_QUAD*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_stmt_handle *, unsigned short)> dsql_free_statement;
 
-static ISC_STATUS ISC_EXPORT (*dsql_sql_info)(ISC_STATUS*, isc_stmt_handle*, short, const ISC_SCHAR*, short, ISC_SCHAR*);
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, isc_tr_handle*, isc_blob_handle*, ISC_QUAD*)> open_blob;
 
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_blob_handle *, unsigned short *, unsigned short, void *)> get_segment;
 
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_blob_handle*, unsigned short, const void*)> put_segment;
 
-void throwDataConversionError(JNIEnv* env, int column) {
-    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_blob_handle*, short, const void*, short, void*)> blob_info;
 
-    if (exceptionClass != nullptr) {
-        std::string str = "Data type conversion error (" + std::to_string(column) + ")";
-        env->ThrowNew(exceptionClass, str.c_str());
-    }
-}
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS *, isc_blob_handle *)> close_blob;
 
-void throwNullError(JNIEnv* env) {
-    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, isc_tr_handle*, isc_blob_handle*, ISC_QUAD*)> create_blob;
 
-    if (exceptionClass != nullptr) {
-        env->ThrowNew(exceptionClass, "Field is null");
-    }
-}
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_stmt_handle*, short, const ISC_SCHAR*, short, ISC_SCHAR*)> dsql_sql_info;
 
-void throwOutOfBoundError(JNIEnv* env, int index) {
-    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, short, const ISC_SCHAR*, short, ISC_SCHAR*)> database_info;
 
-    if (exceptionClass != nullptr) {
-        std::string str = "Index out of bound: " + std::to_string(index);
-        env->ThrowNew(exceptionClass, str.c_str());
-    }
-}
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, isc_tr_handle*, const ISC_SCHAR*, const ISC_SCHAR*, ISC_ARRAY_DESC*)> array_lookup_bounds;
 
-void throwHandleError(JNIEnv* env) {
-    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, isc_tr_handle*, ISC_QUAD*, const ISC_ARRAY_DESC*, void*, ISC_LONG*)> array_get_slice;
 
-    if (exceptionClass != nullptr) {
-        env->ThrowNew(exceptionClass, "Invalid Handle value");
-    }
-}
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, isc_tr_handle*, ISC_QUAD*, const ISC_ARRAY_DESC*, void*, ISC_LONG*)> array_put_slice;
 
-void throwStringTruncation(JNIEnv* env, int index) {
-    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_blob_handle*)> cancel_blob;
 
-    if (exceptionClass != nullptr) {
-        std::string str = "String truncation: " + std::to_string(index);
-        env->ThrowNew(exceptionClass, str.c_str());
-    }
-}
+// entry points of the object API, missing from clients older than Firebird 3; they are neither traced nor replayed
+static ClientEntry<Firebird::IMaster* ISC_EXPORT ()> get_master_interface;
 
-void throwLoadLibraryError(JavaVM* vm) {
-    JNIEnv* env;
-    if (vm->GetEnv((void**)&env, JNI_VERSION_1_6) == JNI_OK) {
-        jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, void*, isc_stmt_handle*)> get_statement_interface;
 
-        if (exceptionClass != nullptr) {
-            env->ThrowNew(exceptionClass, "Error loading Firebird client library");
-        }
-    }
-}
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, void*, isc_tr_handle*)> get_transaction_interface;
 
-extern "C"
-JNIEXPORT jint JNICALL
-JNI_OnLoad(JavaVM* vm, void* reserved) {
+// entry points of the events, whose callbacks come from threads of the client library; they are neither traced nor
+// replayed
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, ISC_LONG*, unsigned short, const ISC_UCHAR*,
+                                          ISC_EVENT_CALLBACK, void*)> que_events;
 
-#ifdef _WIN32
-    HINSTANCE handle = NULL;
-    if (!(handle = LoadLibrary("fbclient.dll"))) {
-        throwLoadLibraryError(vm);
-        return JNI_ERR;
-    }
+static ClientEntry<ISC_STATUS ISC_EXPORT (ISC_STATUS*, isc_db_handle*, ISC_LONG*)> cancel_events;
 
-    *(FARPROC *) (&interpret) = GetProcAddress(handle, "fb_interpret");
-    *(FARPROC *) (&attach_database) = GetProcAddress(handle, "isc_attach_database");
-    *(FARPROC *) (&create_database) = GetProcAddress(handle, "isc_create_database");
-    *(FARPROC *) (&detach_database) = GetProcAddress(handle, "isc_detach_database");
-    *(FARPROC *) (&dsql_execute_immediate) = GetProcAddress(handle, "isc_dsql_execute_immediate");
-    *(FARPROC *) (&start_transaction) = GetProcAddress(handle, "isc_start_transaction");
-    *(FARPROC *) (&commit_retaining) = GetProcAddress(handle, "isc_commit_retaining");
-    *(FARPROC *) (&commit_transaction) = GetProcAddress(handle, "isc_commit_transaction");
-    *(FARPROC *) (&rollback_retaining) = GetProcAddress(handle, "isc_rollback_retaining");
-    *(FARPROC *) (&rollback_transaction) = GetProcAddress(handle, "isc_rollback_transaction");
-    *(FARPROC *) (&dsql_allocate_statement) = GetProcAddress(handle, "isc_dsql_allocate_statement");
-    *(FARPROC *) (&dsql_prepare) = GetProcAddress(handle, "isc_dsql_prepare");
-    *(FARPROC *) (&dsql_set_cursor_name) = GetProcAddress(handle, "isc_dsql_set_cursor_name");
-    *(FARPROC *) (&dsql_describe) = GetProcAddress(handle, "isc_dsql_describe");
-    *(FARPROC *) (&dsql_describe_bind) = GetProcAddress(handle, "isc_dsql_describe_bind");
-    *(FARPROC *) (&dsql_execute) = GetProcAddress(handle, "isc_dsql_execute");
-    *(FARPROC *) (&dsql_execute2) = GetProcAddress(handle, "isc_dsql_execute2");
-    *(FARPROC *) (&dsql_fetch) = GetProcAddress(handle, "isc_dsql_fetch");
-    *(FARPROC *) (&dsql_free_statement) = GetProcAddress(handle, "isc_dsql_free_statement");
-    *(FARPROC *) (&open_blob) = GetProcAddress(handle, "isc_open_blob");
-    *(FARPROC *) (&get_segment) = GetProcAddress(handle, "isc_get_segment");
-    *(FARPROC *) (&put_segment) = GetProcAddress(handle, "isc_put_segment");
-    *(FARPROC *) (&blob_info) = GetProcAddress(handle, "isc_blob_info");
-    *(FARPROC *) (&close_blob) = GetProcAddress(handle, "isc_close_blob");
-    *(FARPROC *) (&create_blob) = GetProcAddress(handle, "isc_create_blob");
-    *(FARPROC *) (&dsql_sql_info) = GetProcAddress(handle, "isc_dsql_sql_info");
+#define CLIENT_FUNCTIONS(X) \
+    X(interpret) X(attach_database) X(create_database) X(detach_database) X(dsql_execute_immediate) \
+    X(start_transaction) X(commit_retaining) X(commit_transaction) X(rollback_retaining) X(rollback_transaction) \
+    X(dsql_allocate_statement) X(dsql_prepare) X(dsql_set_cursor_name) X(dsql_describe) X(dsql_describe_bind) \
+    X(dsql_execute) X(dsql_execute2) X(dsql_fetch) X(dsql_free_statement) X(open_blob) X(get_segment) \
+    X(put_segment) X(blob_info) X(close_blob) X(create_blob) X(dsql_sql_info) X(database_info) \
+    X(array_lookup_bounds) X(array_get_slice) X(array_put_slice) X(cancel_blob)
 
-#else
-    #ifdef __APPLE__
-        #define LIB_FBCLIENT "libfbclient.dylib"
-        #define LIB_FBCLIENT2 "/Library/Frameworks/Firebird.framework/Resources/lib/libfbclient.dylib"
-    #else
-        #define LIB_FBCLIENT "libfbclient.so"
-        #define LIB_FBCLIENT2 "/opt/firebird/lib/libfbclient.so"
-    #endif
+#define JNI_ENTRIES(X) \
+    X(allocStatusArray) X(allocHandle) X(freeHandle) X(freeStatusArray) X(attachDatabase) X(createDatabase) \
+    X(detachDatabase) X(databaseInfo) X(executeImmediate) X(interpret) X(startTransaction) X(commitTransaction) \
+    X(rollbackTransaction) X(prepareStatement) X(getStatementType) X(freeSQLDA) X(freeStatement) X(prepareParams) \
+    X(setIsNull) X(getScale) X(getType) X(getName) X(getRelation) X(getOwner) X(getAlias) X(getCount) \
+    X(setValueBoolean) X(setValueShort) X(setValueInt) X(setValueLong) X(setValueString) X(setValueByteArray) \
+    X(setValueFloat) X(setValueDouble) X(setValueInt128) X(setValueDate) X(setValueTime) X(setValueTimeZone) \
+    X(execute) X(execute2) X(fetch) X(getIsNull) X(getValueBoolean) X(getValueShort) X(getValueInt) \
+    X(getValueLong) X(getValueString) X(getValueByteArray) X(getValueFloat) X(getValueDouble) X(getValueInt128) \
+    X(getValueDate) X(getValueTime) X(getValueTimeZone) X(blobOpen) X(blobClose) X(setValueBlobId) \
+    X(getValueBlobId) X(blobRead) X(blobLength) X(blobCreate) X(blobWrite) X(mapRow) X(mapRows) X(writeJson) \
+    X(writeJsonRows) X(exportRows) X(importRows) X(spoolRows) X(spoolSeek) \
+    X(queEvents) X(cancelEvents) X(cacheLookup) X(cacheRows) X(cacheSeek) X(getArrayBounds) X(getArrayInt) \
+    X(getArrayDouble) X(getArrayBuffer) X(setArrayColumn) X(setArrayInt) X(setArrayDouble) X(setArrayBuffer) \
+    X(bindPacked) X(executeMany) X(setTypes) X(setOutputProfile) \
+    X(setValueBlobFile) X(setValueBlobStream)
 
-    void* handle = nullptr;
-    if (!(handle = dlopen(LIB_FBCLIENT, RTLD_NOW))) {
-        if (!(handle = dlopen(LIB_FBCLIENT2, RTLD_NOW))) {
-            throwLoadLibraryError(vm);
-            return JNI_ERR;
-        }
-    }
-
-    *(void **) (&interpret) = dlsym(handle, "fb_interpret");
-    *(void **) (&attach_database) = dlsym(handle, "isc_attach_database");
-    *(void **) (&create_database) = dlsym(handle, "isc_create_database");
-    *(void **) (&detach_database) = dlsym(handle, "isc_detach_database");
-    *(void **) (&dsql_execute_immediate) = dlsym(handle, "isc_dsql_execute_immediate");
-    *(void **) (&start_transaction) = dlsym(handle, "isc_start_transaction");
-    *(void **) (&commit_retaining) = dlsym(handle, "isc_commit_retaining");
-    *(void **) (&commit_transaction) = dlsym(handle, "isc_commit_transaction");
-    *(void **) (&rollback_retaining) = dlsym(handle, "isc_rollback_retaining");
-    *(void **) (&rollback_transaction) = dlsym(handle, "isc_rollback_transaction");
-    *(void **) (&dsql_allocate_statement) = dlsym(handle, "isc_dsql_allocate_statement");
-    *(void **) (&dsql_prepare) = dlsym(handle, "isc_dsql_prepare");
-    *(void **) (&dsql_set_cursor_name) = dlsym(handle, "isc_dsql_set_cursor_name");
-    *(void **) (&dsql_describe) = dlsym(handle, "isc_dsql_describe");
-    *(void **) (&dsql_describe_bind) = dlsym(handle, "isc_dsql_describe_bind");
-    *(void **) (&dsql_execute) = dlsym(handle, "isc_dsql_execute");
-    *(void **) (&dsql_execute2) = dlsym(handle, "isc_dsql_execute2");
-    *(void **) (&dsql_fetch) = dlsym(handle, "isc_dsql_fetch");
-    *(void **) (&dsql_free_statement) = dlsym(handle, "isc_dsql_free_statement");
-    *(void **) (&open_blob) = dlsym(handle, "isc_open_blob");
-    *(void **) (&get_segment) = dlsym(handle, "isc_get_segment");
-    *(void **) (&put_segment) = dlsym(handle, "isc_put_segment");
-    *(void **) (&blob_info) = dlsym(handle, "isc_blob_info");
-    *(void **) (&close_blob) = dlsym(handle, "isc_close_blob");
-    *(void **) (&create_blob) = dlsym(handle, "isc_create_blob");
-    *(void **) (&dsql_sql_info) = dlsym(handle, "isc_dsql_sql_info");
-#endif
+#define ENUM_ENTRY(name) name,
+#define COUNT_ENTRY(name) + 1
+#define NAME_ENTRY(name) #name,
 
-    return JNI_VERSION_1_6;
-}
+enum class ClientCall { CLIENT_FUNCTIONS(ENUM_ENTRY) };
+enum class JniCall { JNI_ENTRIES(ENUM_ENTRY) };
 
-extern "C"
-JNIEXPORT void JNICALL
-JNI_OnUnload(JavaVM* vm, void* reserved) {
-    // Libération des ressources ici
-}
+constexpr int CLIENT_CALL_COUNT = 0 CLIENT_FUNCTIONS(COUNT_ENTRY);
+constexpr int JNI_CALL_COUNT = 0 JNI_ENTRIES(COUNT_ENTRY);
 
-constexpr ISC_STATUS ISC_MASK	= FB_IMPL_MSG_MASK;	// Defines the code as a valid ISC code
-constexpr ISC_STATUS FAC_MASK	= 0x00FF0000;	// Specifies the facility where the code is located
-constexpr ISC_STATUS CODE_MASK	= 0x0000FFFF;	// Specifies the code in the message file
-constexpr ISC_STATUS CLASS_MASK	= 0xF0000000;	// Defines the code as warning, error, info, or other
+static const char* clientCallNames[] = { CLIENT_FUNCTIONS(NAME_ENTRY) };
+static const char* jniCallNames[] = { JNI_ENTRIES(NAME_ENTRY) };
 
-#define CLASS_ERROR		0L		// Code represents an error
-#define CLASS_WARNING		1L		// Code represents a warning
-#define CLASS_INFO		2L		// Code represents an information msg
+#define CLIENT_ENTRY(name) decltype(::name) name;
 
-jlong checkStatus(JNIEnv* env, const ISC_STATUS* statusArray, jlong code) {
-    if (code != 0) {
-        if (((code & CLASS_MASK) >> 30) == CLASS_ERROR) {
-            jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
-            if (exceptionClass != nullptr) {
-                ISC_SCHAR buffer[1024] = {0};
-                auto len = interpret(buffer, sizeof(buffer), &statusArray);
-                auto total = len;
-                while (len > 0 && total < sizeof buffer) {
-                    buffer[total++] = '\n';
-                    len = interpret(buffer + total, sizeof(buffer) - total, &statusArray);
-                    total += len;
-                }
-                env->ThrowNew(exceptionClass, buffer);
-            }
-        }
-    }
-    return code;
-}
+/**
+ * A table of the functions of the client library.
+ */
+struct ClientTable {
+    CLIENT_FUNCTIONS(CLIENT_ENTRY)
+};
 
-jlong checkStatus(JNIEnv* env, jlong status, jlong code) {
-    const ISC_STATUS* statusArray = (ISC_STATUS*)(status);
-    return checkStatus(env, statusArray, code);
-}
+/**
+ * Entry points resolved from the client library.
+ */
+static ClientTable library;
 
-template<typename T, T (*block)(JNIEnv*, ISC_STATUS*, FB_API_HANDLE*, FB_API_HANDLE*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT)>
-inline T getFieldValue(JNIEnv *env, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, int index) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    auto p = (handle != nullptr)?*handle: nullptr;
-    if (p != nullptr) {
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            if (v->sqlind == nullptr || *v->sqlind == 0) {
-                return block(env, statusArray, dbHandle, trHandle, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype);
-            } else
-                throwNullError(env);
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
-    return 0;
-}
+/**
+ * Entry points serving the calls: those of the client library, or the replayed functions while a log is replayed.
+ * The function pointers above point either to them or, while the interposition layer is enabled, to the traced
+ * wrappers below.
+ */
+static ClientTable client;
 
-template<typename T, T (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT)>
-inline T getFieldValue(JNIEnv *env, jlong sqlda, int index) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    auto p = (handle != nullptr)?*handle: nullptr;
-    if (p != nullptr) {
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            if (v->sqlind == nullptr || *v->sqlind == 0) {
-                return block(env, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype);
-            } else
-                throwNullError(env);
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
-    return 0;
-}
+#undef CLIENT_ENTRY
 
-template<typename T, T (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT)>
-inline T getFieldValue(JNIEnv *env, jlong sqlda, int index) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    auto p = (handle != nullptr)?*handle: nullptr;
-    if (p != nullptr) {
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            if (v->sqlind == nullptr || *v->sqlind == 0) {
-                return block(env, index, v->sqldata, v->sqltype & ~1);
-            } else
-                throwNullError(env);
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
-    return 0;
-}
+// interposition features, the traced wrappers are installed while any of them is enabled
+constexpr int TRACE_LATENCY = 1;
+constexpr int TRACE_COUNTS = 2;
+constexpr int TRACE_RECORD = 4;
 
+static std::atomic<int> interposition(0);
 
-template<typename T, void (*block)(JNIEnv*, ISC_STATUS*, FB_API_HANDLE*, FB_API_HANDLE*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT, T)>
-inline void setFieldValue(JNIEnv *env, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, int index, T value) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    auto p = (handle != nullptr)?*handle: nullptr;
-    if (p != nullptr) {
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            block(env, statusArray, dbHandle, trHandle, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype, value);
-            if (v->sqlind != nullptr)
-                *v->sqlind = 0;
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
-}
+// serializes the updates of the interposition features and of the entry points
+static std::mutex interpositionMutex;
 
-template<typename T, void (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT, T)>
-inline void setFieldValue(JNIEnv *env, jlong sqlda, int index, T value) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    auto p = (handle != nullptr)?*handle: nullptr;
-    if (p != nullptr) {
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            block(env, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype, value);
-            if (v->sqlind != nullptr)
-                *v->sqlind = 0;
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
-}
+/**
+ * Totals of the calls made to a function of the client library.
+ */
+struct alignas(64) CallCounters {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> errors;
+};
 
-template<typename T, void (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT, T)>
-inline void setFieldValue(JNIEnv *env, jlong sqlda, int index, T value) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    auto p = (handle != nullptr)?*handle: nullptr;
-    if (p != nullptr) {
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            block(env, index, v->sqldata, v->sqltype & ~1, value);
-            if (v->sqlind != nullptr)
-                *v->sqlind = 0;
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
-}
+static CallCounters clientCounters[CLIENT_CALL_COUNT];
+static ClientLog clientLog;
+static ClientReplay clientReplay;
+static LatencyHistogram clientLatency[CLIENT_CALL_COUNT];
+static LatencyHistogram jniLatency[JNI_CALL_COUNT];
 
+// time spent by the current thread in the client library, used to isolate the JNI conversion time
+static thread_local uint64_t clientNanos = 0;
 
 /**
- * @brief Allocates memory for the data buffer of an XSQLDA structure.
- *
- * This function allocates memory for a data buffer based on the information provided in the specified XSQLDA structure.
- * The data buffer is used to store the actual data values for each field in the XSQLDA structure.
- *
- * @param sqlda The XSQLDA structure containing the field definitions.
+ * @brief Returns the size of the message described by an XSQLDA, as sent to or received from the server.
+ */
+static size_t messageSize(const XSQLDA* sqlda) {
+    size_t size = 0;
+    if (sqlda != nullptr) {
+        for (int i = 0; i < sqlda->sqld; i++) {
+            auto var = &sqlda->sqlvar[i];
+            size += var->sqllen;
+            if ((var->sqltype & ~1) == SQL_VARYING)
+                size += sizeof(ISC_USHORT);
+            if ((var->sqltype & 1) == 1)
+                size += sizeof(ISC_SHORT);
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Accounts a call into the client library, made through a traced wrapper.
  *
- * @note The XSQLDA structure should be pre-initialized with the correct values for version, sqldaid, sqldabc, sqln, and sqld.
- *       The sqlvar array should contain the field definitions.
+ * The enabled features are read once, with a single relaxed atomic load, when the call starts.
  */
-void allocateDataBuffer(XSQLDA *sqlda) {
-    size_t total = 0;
-    for (int i = 0; i < sqlda->sqld; i ++) {
-        auto var = &sqlda->sqlvar[i];
-        var->sqldata = (ISC_SCHAR*)total;
-        switch (var->sqltype & ~1) {
-            case SQL_TEXT:
-                // + zero terminal
-                total += var->sqllen + 1;
-                break;
-            case SQL_VARYING:
-                // size of PARAMVARY + zero terminal
-                total += sizeof (ISC_USHORT) + var->sqllen + 1;
-                break;
-            case SQL_FLOAT:
-            case SQL_D_FLOAT:
-            case SQL_DOUBLE:
-                // scale is irrelevant and lead to duplicate code
-                var->sqlscale = 0;
-                total += var->sqllen;
-                break;
-            default:
-                total += var->sqllen;
+class ClientScope {
+public:
+    explicit ClientScope(ClientCall call) : call(call), features(interposition.load(std::memory_order_relaxed)),
+        start((features & TRACE_LATENCY) != 0 ? nanoTime() : 0) {}
+
+    /**
+     * @brief Completes the call, an error is any status other than end of stream or partial segment.
+     *
+     * @param ret The status returned by the client library.
+     * @return The status, unchanged.
+     */
+    ISC_STATUS done(ISC_STATUS ret) {
+        if ((features & TRACE_LATENCY) != 0) {
+            auto elapsed = nanoTime() - start;
+            clientLatency[(int)call].record(elapsed);
+            clientNanos += elapsed;
+        }
+        if ((features & TRACE_COUNTS) != 0) {
+            auto& counters = clientCounters[(int)call];
+            counters.calls.fetch_add(1, std::memory_order_relaxed);
+            if (ret != 0 && ret != 100 && ret != isc_segment && ret != isc_segstr_eof)
+                counters.errors.fetch_add(1, std::memory_order_relaxed);
         }
+        return ret;
+    }
 
-        if ((var->sqltype & 1) == 1) {
-            var->sqlind = (ISC_SHORT *)total;
-            total += sizeof (short);
-        } else
-            var->sqlind = nullptr;
+    bool counting() const {
+        return (features & TRACE_COUNTS) != 0;
     }
-    auto buffer = (ISC_SCHAR *)malloc(total);
-    memset(buffer, 0, total);
-    for (int i = 0; i < sqlda->sqld; i ++) {
-        auto var = &sqlda->sqlvar[i];
-        var->sqldata = buffer + (size_t)var->sqldata;
-        if (var->sqlind != nullptr) {
-            var->sqlind = (ISC_SHORT *)(buffer + (size_t)var->sqlind);
-            *var->sqlind = -1; // nullables are null
-        }
 
+    bool recording() const {
+        return (features & TRACE_RECORD) != 0;
+    }
+
+    /**
+     * @brief Accounts the bytes moved by the call, when counting is enabled.
+     */
+    void bytes(size_t count) {
+        if ((features & TRACE_COUNTS) != 0)
+            clientCounters[(int)call].bytes.fetch_add(count, std::memory_order_relaxed);
     }
-}
+
+private:
+    ClientCall call;
+    int features;
+    uint64_t start;
+};
 
 /**
- * @brief Calculates the size of a UTF-8 string.
- *
- * This function calculates the size of a UTF-8 string by iterating
- * through each character in the string and counting the number of
- * valid UTF-8 characters. The maximum length of the string and the
- * maximum number of UTF-8 characters to count can be specified.
+ * @brief Measures the time spent in a JNI entry point, minus the time spent in the client library.
  *
- * @param string The UTF-8 string.
- * @param maxlength The maximum length of the string to process.
- * @param maxsize The maximum number of UTF-8 characters to count.
- *
- * @return The size of the UTF-8 string in number of UTF-8 characters.
+ * When latency tracking is disabled, this costs a single relaxed atomic load.
  */
-static size_t utf8_size(char* string, int maxlength, short maxsize) {
-    size_t length = 0;
-    size_t size = 0;
-    while (*string != 0) {
-        if ((*string++ & 0xC0) != 0x80) ++length;
-        if (length > maxlength || size++ == maxsize)
-            break;
+class JniScope {
+public:
+    explicit JniScope(JniCall call) : call(call), start(0), client(0) {
+        if ((interposition.load(std::memory_order_relaxed) & TRACE_LATENCY) != 0) {
+            client = clientNanos;
+            start = nanoTime();
+        }
     }
-    return size;
+
+    ~JniScope() {
+        if (start != 0) {
+            auto elapsed = nanoTime() - start;
+            auto inClient = clientNanos - client;
+            jniLatency[(int)call].record(elapsed > inClient ? elapsed - inClient : 0);
+        }
+    }
+
+private:
+    JniCall call;
+    uint64_t start;
+    uint64_t client;
+};
+
+static ISC_LONG ISC_EXPORT traced_interpret(ISC_SCHAR* buffer, unsigned int length, const ISC_STATUS** status) {
+    ClientScope scope(ClientCall::interpret);
+    auto ret = client.interpret(buffer, length, status);
+    scope.done(0);
+    scope.bytes(ret > 0 ? ret : 0);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::interpret, ret, nullptr);
+        record.bytes(buffer, ret > 0 ? ret : 0);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_allocStatusArray(JNIEnv *env, jclass clazz) {
-    auto status = new ISC_STATUS_ARRAY;
-    for(int i = 0; i < ISC_STATUS_LENGTH; i++) {
-        status[i] = 0;
+static ISC_STATUS ISC_EXPORT traced_attach_database(ISC_STATUS* status, short length, const void* path,
+                                                    isc_db_handle* db, short dpbLength, const void* dpb) {
+    ClientScope scope(ClientCall::attach_database);
+    auto ret = scope.done(client.attach_database(status, length, path, db, dpbLength, dpb));
+    scope.bytes(length + dpbLength);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::attach_database, ret, status);
+        record.string(path, length);
+        record.bytes(dpb, dpbLength);
+        record.handle(db);
     }
-    return reinterpret_cast<jlong>(status);
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_allocHandle(JNIEnv *env, jclass clazz) {
-    auto handle = (void**)malloc(sizeof (void*));
-    *handle = nullptr;
-    return reinterpret_cast<jlong>(handle);
+static ISC_STATUS ISC_EXPORT traced_create_database(ISC_STATUS* status, unsigned short length, const void* path,
+                                                    isc_db_handle* db, unsigned short dpbLength, const void* dpb,
+                                                    unsigned short type) {
+    ClientScope scope(ClientCall::create_database);
+    auto ret = scope.done(client.create_database(status, length, path, db, dpbLength, dpb, type));
+    scope.bytes(length + dpbLength);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::create_database, ret, status);
+        record.string(path, length);
+        record.bytes(dpb, dpbLength);
+        record.handle(db);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_freeHandle(JNIEnv *env, jclass clazz, jlong handle) {
-    if (handle != 0)
-        free((void*)(handle));
+static ISC_STATUS ISC_EXPORT traced_detach_database(ISC_STATUS* status, isc_db_handle* db) {
+    ClientScope scope(ClientCall::detach_database);
+    auto ret = scope.done(client.detach_database(status, db));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::detach_database, ret, status);
+        record.handle(db);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_freeStatusArray(JNIEnv *env, jclass clazz, jlong status) {
-    if (status != 0)
-        delete[] reinterpret_cast<ISC_STATUS_ARRAY*>(status);
+static ISC_STATUS ISC_EXPORT traced_dsql_execute_immediate(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                           unsigned short length, const void* sql,
+                                                           unsigned short dialect, const XSQLDA* sqlda) {
+    ClientScope scope(ClientCall::dsql_execute_immediate);
+    auto ret = scope.done(client.dsql_execute_immediate(status, db, tr, length, sql, dialect, sqlda));
+    if (scope.counting())
+        scope.bytes((length != 0 ? length : strlen((const char*)sql)) + messageSize(sqlda));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_execute_immediate, ret, status);
+        record.string(sql, length);
+        record.data(sqlda);
+        record.handle(tr);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_attachDatabase(
-        JNIEnv *env, jclass clazz, jlong status, jstring path,jlong db_handle, jbyteArray options) {
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE *>(db_handle);
-    const char *dbPath = env->GetStringUTFChars(path, nullptr);
-    auto len = (options != nullptr)? env->GetArrayLength(options): 0;
-    auto dpb = (len > 0) ? env->GetByteArrayElements(options, nullptr) : nullptr;
-    auto ret = attach_database(statusArray, (short)std::strlen(dbPath), dbPath, dbHandle, (short)len, (ISC_SCHAR *)dpb);
-    if (dpb != nullptr)
-        env->ReleaseByteArrayElements(options, dpb, 0);
-    env->ReleaseStringUTFChars(path, dbPath);
+// transactions are only started on a single database by this library
+static ISC_STATUS ISC_EXPORT_VARARG traced_start_transaction(ISC_STATUS* status, isc_tr_handle* tr, short count, ...) {
+    va_list args;
+    va_start(args, count);
+    auto db = va_arg(args, isc_db_handle*);
+    auto tpbLength = (short)va_arg(args, int);
+    auto tpb = va_arg(args, ISC_SCHAR*);
+    va_end(args);
+    ClientScope scope(ClientCall::start_transaction);
+    auto ret = scope.done(client.start_transaction(status, tr, count, db, tpbLength, tpb));
+    scope.bytes(tpbLength);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::start_transaction, ret, status);
+        record.bytes(tpb, tpbLength);
+        record.handle(tr);
+    }
     return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_createDatabase(
-        JNIEnv *env, jclass clazz, jlong status, jstring path,jlong db_handle, jbyteArray options) {
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE *>(db_handle);
-    const char *dbPath = env->GetStringUTFChars(path, nullptr);
-    auto len = (options != nullptr)? env->GetArrayLength(options): 0;
-    auto dpb = (len > 0) ? env->GetByteArrayElements(options, nullptr) : nullptr;
-    auto ret = create_database(statusArray, (short)std::strlen(dbPath), dbPath, dbHandle, (short)len, (ISC_SCHAR *)dpb, 0);
-    if (dpb != nullptr)
-        env->ReleaseByteArrayElements(options, dpb, 0);
-    env->ReleaseStringUTFChars(path, dbPath);
+static ISC_STATUS ISC_EXPORT traced_commit_retaining(ISC_STATUS* status, isc_tr_handle* tr) {
+    ClientScope scope(ClientCall::commit_retaining);
+    auto ret = scope.done(client.commit_retaining(status, tr));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::commit_retaining, ret, status);
+        record.handle(tr);
+    }
     return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_detachDatabase(
-        JNIEnv *env, jclass clazz, jlong status, jlong db_handle) {
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
-    return detach_database(statusArray, dbHandle);
+static ISC_STATUS ISC_EXPORT traced_commit_transaction(ISC_STATUS* status, isc_tr_handle* tr) {
+    ClientScope scope(ClientCall::commit_transaction);
+    auto ret = scope.done(client.commit_transaction(status, tr));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::commit_transaction, ret, status);
+        record.handle(tr);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_executeImmediate(JNIEnv *env, jclass clazz, jlong status,
-                                                    jlong db_handle, jlong tr_handle, jstring sql, jshort dialect) {
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    auto string = env->GetStringUTFChars(sql, nullptr);
-    auto ret = dsql_execute_immediate(statusArray, dbHandle, trHandle, strlen(string), string, dialect, nullptr);
-    env->ReleaseStringUTFChars(sql, string);
+static ISC_STATUS ISC_EXPORT traced_rollback_retaining(ISC_STATUS* status, isc_tr_handle* tr) {
+    ClientScope scope(ClientCall::rollback_retaining);
+    auto ret = scope.done(client.rollback_retaining(status, tr));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::rollback_retaining, ret, status);
+        record.handle(tr);
+    }
     return ret;
 }
 
-extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_progdigy_fbclient_API_interpret(JNIEnv *env, jclass clazz, jlong status) {
-    ISC_SCHAR buffer[1024] = {0};
-    const ISC_STATUS* statusArray = (ISC_STATUS*)(status);
-    auto len = interpret(buffer, sizeof(buffer), &statusArray);
-    auto total = len;
-    while (len > 0 && total < sizeof buffer) {
-        buffer[total++] = '\n';
-        len = interpret(buffer + total, sizeof(buffer) - total, &statusArray);
-        total += len;
+static ISC_STATUS ISC_EXPORT traced_rollback_transaction(ISC_STATUS* status, isc_tr_handle* tr) {
+    ClientScope scope(ClientCall::rollback_transaction);
+    auto ret = scope.done(client.rollback_transaction(status, tr));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::rollback_transaction, ret, status);
+        record.handle(tr);
     }
-    return env->NewStringUTF(buffer);
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_startTransaction(JNIEnv *env, jclass clazz, jlong status,
-                                                jlong tr_handle, jlong db_handle, jbyteArray options) {
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    auto len = (options != nullptr)? env->GetArrayLength(options): 0;
-    auto tpb = (len > 0)?env->GetByteArrayElements(options, nullptr): nullptr;
-    auto ret = start_transaction(statusArray, trHandle, 1, dbHandle, (short)len, (ISC_SCHAR *)tpb);
-    if (tpb != nullptr)
-        env->ReleaseByteArrayElements(options, tpb, 0);
+static ISC_STATUS ISC_EXPORT traced_dsql_allocate_statement(ISC_STATUS* status, isc_db_handle* db,
+                                                            isc_stmt_handle* stmt) {
+    ClientScope scope(ClientCall::dsql_allocate_statement);
+    auto ret = scope.done(client.dsql_allocate_statement(status, db, stmt));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_allocate_statement, ret, status);
+        record.handle(stmt);
+    }
     return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_commitTransaction(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jboolean retain) {
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    if (retain)
-        return commit_retaining(statusArray, trHandle);
-    else
-        return commit_transaction(statusArray, trHandle);
+static ISC_STATUS ISC_EXPORT traced_dsql_prepare(ISC_STATUS* status, isc_tr_handle* tr, isc_stmt_handle* stmt,
+                                                 unsigned short length, const void* sql, unsigned short dialect,
+                                                 XSQLDA* sqlda) {
+    ClientScope scope(ClientCall::dsql_prepare);
+    auto ret = scope.done(client.dsql_prepare(status, tr, stmt, length, sql, dialect, sqlda));
+    if (scope.counting())
+        scope.bytes(length != 0 ? length : strlen((const char*)sql));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_prepare, ret, status);
+        record.string(sql, length);
+        record.metadata(sqlda);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_rollbackTransaction(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jboolean retain) {
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    if (retain)
-        return rollback_retaining(statusArray, trHandle);
-    else
-        return rollback_transaction(statusArray, trHandle);
+static ISC_STATUS ISC_EXPORT traced_dsql_set_cursor_name(ISC_STATUS* status, isc_stmt_handle* stmt,
+                                                         const ISC_SCHAR* name, unsigned short type) {
+    ClientScope scope(ClientCall::dsql_set_cursor_name);
+    auto ret = scope.done(client.dsql_set_cursor_name(status, stmt, name, type));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_set_cursor_name, ret, status);
+        record.string(name, 0);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_prepareStatement(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
-    jlong st_handle, jstring sql, jstring cursor, jshort dialect, jlong sqlda) {
+static ISC_STATUS ISC_EXPORT traced_dsql_describe(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short dialect,
+                                                  XSQLDA* sqlda) {
+    ClientScope scope(ClientCall::dsql_describe);
+    auto ret = scope.done(client.dsql_describe(status, stmt, dialect, sqlda));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_describe, ret, status);
+        record.metadata(sqlda);
+    }
+    return ret;
+}
 
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
-    auto xsqlda   = reinterpret_cast<XSQLDA **>(sqlda);
-    const char *statement = env->GetStringUTFChars(sql, nullptr);
-    auto ret = dsql_allocate_statement(statusArray, dbHandle, stHandle);
-    if (ret != 0) return ret;
-    XSQLDA da = {0};
-    da.version = SQLDA_VERSION1;
-    ret = dsql_prepare(statusArray, trHandle, stHandle, strlen(statement), statement, dialect, &da);
-    env->ReleaseStringUTFChars(sql, statement);
-    if (ret == 0) {
-        if (cursor != nullptr) {
-            const char *name = env->GetStringUTFChars(cursor, nullptr);
-            ret = dsql_set_cursor_name(statusArray, stHandle, name, 0);
-            env->ReleaseStringUTFChars(cursor, name);
-        }
-        if (ret == 0 && xsqlda != nullptr && da.sqld > 0) {
-            auto len = XSQLDA_LENGTH(da.sqld);
-            auto pXSQLDA = (XSQLDA*)malloc(len);
-            memset(pXSQLDA, 0, len);
-            pXSQLDA->version = SQLDA_VERSION1;
-            pXSQLDA->sqln = da.sqld;
-            ret = dsql_describe(statusArray, stHandle, dialect, pXSQLDA);
-            if (ret == 0) {
-                *xsqlda = pXSQLDA;
-                allocateDataBuffer(pXSQLDA);
-            } else {
-                free(pXSQLDA);
-                return ret;
-            }
-        }
+static ISC_STATUS ISC_EXPORT traced_dsql_describe_bind(ISC_STATUS* status, isc_stmt_handle* stmt,
+                                                       unsigned short dialect, XSQLDA* sqlda) {
+    ClientScope scope(ClientCall::dsql_describe_bind);
+    auto ret = scope.done(client.dsql_describe_bind(status, stmt, dialect, sqlda));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_describe_bind, ret, status);
+        record.metadata(sqlda);
     }
     return ret;
 }
 
-extern "C"
-JNIEXPORT jint JNICALL
-Java_com_progdigy_fbclient_API_getStatementType(JNIEnv *env, jclass clazz, jlong status, jlong st_handle) {
-    ISC_SCHAR data[9] = {isc_info_sql_stmt_type};
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
-    if (stHandle == nullptr || *stHandle == 0)
-        throwHandleError(env);
-    dsql_sql_info(statusArray, stHandle, 1, (ISC_SCHAR*)&data, 8, (ISC_SCHAR*)&data[1]);
-    return data[4] - 1;
+static ISC_STATUS ISC_EXPORT traced_dsql_execute(ISC_STATUS* status, isc_tr_handle* tr, isc_stmt_handle* stmt,
+                                                 unsigned short dialect, const XSQLDA* sqlda) {
+    ClientScope scope(ClientCall::dsql_execute);
+    auto ret = scope.done(client.dsql_execute(status, tr, stmt, dialect, sqlda));
+    if (scope.counting())
+        scope.bytes(messageSize(sqlda));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_execute, ret, status);
+        record.data(sqlda);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_freeSQLDA(JNIEnv *env, jclass clazz, jlong handle) {
-    auto h = reinterpret_cast<XSQLDA **>(handle);
-    if (h != nullptr) {
-        auto sqlda = *h;
-        if (sqlda != nullptr) {
-            free(sqlda->sqlvar[0].sqldata);
-            free(sqlda);
-            *h = nullptr;
-        }
+static ISC_STATUS ISC_EXPORT traced_dsql_execute2(ISC_STATUS* status, isc_tr_handle* tr, isc_stmt_handle* stmt,
+                                                  unsigned short dialect, const XSQLDA* in, const XSQLDA* out) {
+    ClientScope scope(ClientCall::dsql_execute2);
+    auto ret = scope.done(client.dsql_execute2(status, tr, stmt, dialect, in, out));
+    if (scope.counting())
+        scope.bytes(messageSize(in) + messageSize(out));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_execute2, ret, status);
+        record.data(in);
+        record.data(ret == 0 ? out : nullptr);
     }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_freeStatement(JNIEnv *env, jclass clazz, jlong status, jlong st_handle, jshort action) {
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
-    auto ret = dsql_free_statement(statusArray, stHandle, action);
-    if (action == DSQL_drop)
-        *stHandle = 0;
+static ISC_STATUS ISC_EXPORT traced_dsql_fetch(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short dialect,
+                                               const XSQLDA* sqlda) {
+    ClientScope scope(ClientCall::dsql_fetch);
+    auto ret = scope.done(client.dsql_fetch(status, stmt, dialect, sqlda));
+    if (ret == 0 && scope.counting())
+        scope.bytes(messageSize(sqlda));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_fetch, ret, status);
+        record.data(ret == 0 ? sqlda : nullptr);
+    }
     return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_prepareParams(JNIEnv *env, jclass clazz, jlong status, jlong statement, jshort dialect, jlong sqlda) {
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(statement);
-    auto xsqlda   = reinterpret_cast<XSQLDA **>(sqlda);
+static ISC_STATUS ISC_EXPORT traced_dsql_free_statement(ISC_STATUS* status, isc_stmt_handle* stmt,
+                                                        unsigned short option) {
+    ClientScope scope(ClientCall::dsql_free_statement);
+    auto ret = scope.done(client.dsql_free_statement(status, stmt, option));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_free_statement, ret, status);
+        record.handle(stmt);
+    }
+    return ret;
+}
 
-    XSQLDA da = {0};
-    da.version = SQLDA_VERSION1;
-    da.sqld = 0;
-    da.sqln = 0;
-    auto ret = dsql_describe_bind(statusArray, stHandle, dialect, &da);
-    if (ret == 0 && da.sqld > 0) {
-        auto len = XSQLDA_LENGTH(da.sqld);
-        auto pXSQLDA = (XSQLDA*)malloc(len);
-        memset(pXSQLDA, 0, len);
-        pXSQLDA->version = SQLDA_VERSION1;
-        pXSQLDA->sqln = da.sqld;
-        ret = dsql_describe_bind(statusArray, stHandle, dialect, pXSQLDA);
-        if (ret == 0) {
-            *xsqlda = pXSQLDA;
-            allocateDataBuffer(pXSQLDA);
-        } else {
-            free(pXSQLDA);
-        }
+static ISC_STATUS ISC_EXPORT traced_open_blob(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                              isc_blob_handle* blob, ISC_QUAD* id) {
+    ClientScope scope(ClientCall::open_blob);
+    auto ret = scope.done(client.open_blob(status, db, tr, blob, id));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::open_blob, ret, status);
+        record.handle(blob);
     }
+    return ret;
+}
 
+static ISC_STATUS ISC_EXPORT traced_get_segment(ISC_STATUS* status, isc_blob_handle* blob, unsigned short* actual,
+                                                unsigned short length, void* buffer) {
+    ClientScope scope(ClientCall::get_segment);
+    auto ret = scope.done(client.get_segment(status, blob, actual, length, buffer));
+    scope.bytes(actual != nullptr ? *actual : 0);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::get_segment, ret, status);
+        record.bytes(buffer, actual != nullptr ? *actual : 0);
+    }
     return ret;
 }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setIsNull(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    if (handle != nullptr) {
-        auto p = *handle;
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            if (v->sqlind != nullptr)
-                *v->sqlind = -1;
-            else
-                throwDataConversionError(env, index);
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
+static ISC_STATUS ISC_EXPORT traced_put_segment(ISC_STATUS* status, isc_blob_handle* blob, unsigned short length,
+                                                const void* buffer) {
+    ClientScope scope(ClientCall::put_segment);
+    auto ret = scope.done(client.put_segment(status, blob, length, buffer));
+    scope.bytes(length);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::put_segment, ret, status);
+        record.bytes(buffer, length);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_getScale(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    if (handle != nullptr) {
-        auto p = *handle;
-        if (index >= 0 && index < p->sqld) {
-            return p->sqlvar[index].sqlscale;
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
-    return 0;
+static ISC_STATUS ISC_EXPORT traced_blob_info(ISC_STATUS* status, isc_blob_handle* blob, short itemsLength,
+                                              const void* items, short length, void* buffer) {
+    ClientScope scope(ClientCall::blob_info);
+    auto ret = scope.done(client.blob_info(status, blob, itemsLength, items, length, buffer));
+    scope.bytes(itemsLength + length);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::blob_info, ret, status);
+        record.bytes(items, itemsLength);
+        record.bytes(buffer, length);
+    }
+    return ret;
 }
 
-extern "C"
-JNIEXPORT jint JNICALL
-Java_com_progdigy_fbclient_API_getType(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    if (handle != nullptr) {
-        auto p = *handle;
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            switch (v->sqltype & ~1) {
-                case SQL_SHORT: return 0;
-                case SQL_LONG : return 1;
-                case SQL_QUAD :
-                case SQL_INT64: return 2;
-                case SQL_FLOAT: return 3;
-                case SQL_D_FLOAT:
-                case SQL_DOUBLE: return 4;
-                case SQL_TEXT:
-                case SQL_VARYING:
-                    if (v->sqlsubtype != 0)
-                        return 5;
-                    else
-                        return 6;
-                case SQL_INT128:
-                    return 7;
-                case SQL_BOOLEAN:
-                    return 8;
-                case SQL_TYPE_DATE:
-                    return 9;
-                case SQL_TYPE_TIME:
-                    return 10;
-                case SQL_TIMESTAMP:
-                    return 11;
-                case SQL_TIME_TZ:
-                case SQL_TIME_TZ_EX:
-                    return 12;
-                case SQL_TIMESTAMP_TZ:
-                case SQL_TIMESTAMP_TZ_EX:
-                    return 13;
-                case SQL_BLOB:
-                    return v->sqlsubtype == 1?15:14;
-                default:
-                    return -1;
-            }
-        } else
+static ISC_STATUS ISC_EXPORT traced_close_blob(ISC_STATUS* status, isc_blob_handle* blob) {
+    ClientScope scope(ClientCall::close_blob);
+    auto ret = scope.done(client.close_blob(status, blob));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::close_blob, ret, status);
+        record.handle(blob);
+    }
+    return ret;
+}
+
+static ISC_STATUS ISC_EXPORT traced_create_blob(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                isc_blob_handle* blob, ISC_QUAD* id) {
+    ClientScope scope(ClientCall::create_blob);
+    auto ret = scope.done(client.create_blob(status, db, tr, blob, id));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::create_blob, ret, status);
+        record.handle(blob);
+        record.bytes(id, sizeof(ISC_QUAD));
+    }
+    return ret;
+}
+
+static ISC_STATUS ISC_EXPORT traced_dsql_sql_info(ISC_STATUS* status, isc_stmt_handle* stmt, short itemsLength,
+                                                  const ISC_SCHAR* items, short length, ISC_SCHAR* buffer) {
+    ClientScope scope(ClientCall::dsql_sql_info);
+    auto ret = scope.done(client.dsql_sql_info(status, stmt, itemsLength, items, length, buffer));
+    scope.bytes(itemsLength + length);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::dsql_sql_info, ret, status);
+        record.bytes(items, itemsLength);
+        record.bytes(buffer, length);
+    }
+    return ret;
+}
+
+static ISC_STATUS ISC_EXPORT traced_database_info(ISC_STATUS* status, isc_db_handle* db, short itemsLength,
+                                                  const ISC_SCHAR* items, short length, ISC_SCHAR* buffer) {
+    ClientScope scope(ClientCall::database_info);
+    auto ret = scope.done(client.database_info(status, db, itemsLength, items, length, buffer));
+    scope.bytes(itemsLength + length);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::database_info, ret, status);
+        record.bytes(items, itemsLength);
+        record.bytes(buffer, length);
+    }
+    return ret;
+}
+
+static ISC_STATUS ISC_EXPORT traced_array_lookup_bounds(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                        const ISC_SCHAR* relation, const ISC_SCHAR* field,
+                                                        ISC_ARRAY_DESC* desc) {
+    ClientScope scope(ClientCall::array_lookup_bounds);
+    auto ret = scope.done(client.array_lookup_bounds(status, db, tr, relation, field, desc));
+    scope.bytes(sizeof(ISC_ARRAY_DESC));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::array_lookup_bounds, ret, status);
+        record.string(relation, 0);
+        record.string(field, 0);
+        record.bytes(desc, sizeof(ISC_ARRAY_DESC));
+    }
+    return ret;
+}
+
+static ISC_STATUS ISC_EXPORT traced_array_get_slice(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                    ISC_QUAD* id, const ISC_ARRAY_DESC* desc, void* buffer,
+                                                    ISC_LONG* length) {
+    ClientScope scope(ClientCall::array_get_slice);
+    auto ret = scope.done(client.array_get_slice(status, db, tr, id, desc, buffer, length));
+    scope.bytes(*length);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::array_get_slice, ret, status);
+        record.bytes(buffer, *length);
+    }
+    return ret;
+}
+
+static ISC_STATUS ISC_EXPORT traced_array_put_slice(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                    ISC_QUAD* id, const ISC_ARRAY_DESC* desc, void* buffer,
+                                                    ISC_LONG* length) {
+    ClientScope scope(ClientCall::array_put_slice);
+    auto ret = scope.done(client.array_put_slice(status, db, tr, id, desc, buffer, length));
+    scope.bytes(*length);
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::array_put_slice, ret, status);
+        record.bytes(buffer, *length);
+        record.bytes(id, sizeof(ISC_QUAD));
+    }
+    return ret;
+}
+
+static ISC_STATUS ISC_EXPORT traced_cancel_blob(ISC_STATUS* status, isc_blob_handle* blob) {
+    ClientScope scope(ClientCall::cancel_blob);
+    auto ret = scope.done(client.cancel_blob(status, blob));
+    if (scope.recording()) {
+        LogRecord record(clientLog, (int)ClientCall::cancel_blob, ret, status);
+        record.handle(blob);
+    }
+    return ret;
+}
+
+static ISC_LONG ISC_EXPORT replay_interpret(ISC_SCHAR* buffer, unsigned int length, const ISC_STATUS** status) {
+    LogReader reader(clientReplay, (int)ClientCall::interpret, nullptr);
+    auto copied = reader.bytes(buffer, length > 0 ? length - 1 : 0);
+    if (buffer != nullptr && length > 0)
+        buffer[copied] = 0;
+    return reader.result() > 0 ? (ISC_LONG)copied : 0;
+}
+
+static ISC_STATUS ISC_EXPORT replay_attach_database(ISC_STATUS* status, short length, const void* path,
+                                                    isc_db_handle* db, short dpbLength, const void* dpb) {
+    LogReader reader(clientReplay, (int)ClientCall::attach_database, status);
+    reader.skip();
+    reader.skip();
+    reader.handle(db);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_create_database(ISC_STATUS* status, unsigned short length, const void* path,
+                                                    isc_db_handle* db, unsigned short dpbLength, const void* dpb,
+                                                    unsigned short type) {
+    LogReader reader(clientReplay, (int)ClientCall::create_database, status);
+    reader.skip();
+    reader.skip();
+    reader.handle(db);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_detach_database(ISC_STATUS* status, isc_db_handle* db) {
+    LogReader reader(clientReplay, (int)ClientCall::detach_database, status);
+    reader.handle(db);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_execute_immediate(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                           unsigned short length, const void* sql,
+                                                           unsigned short dialect, const XSQLDA* sqlda) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_execute_immediate, status);
+    reader.skip();
+    reader.skip();
+    reader.handle(tr);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT_VARARG replay_start_transaction(ISC_STATUS* status, isc_tr_handle* tr, short count, ...) {
+    LogReader reader(clientReplay, (int)ClientCall::start_transaction, status);
+    reader.skip();
+    reader.handle(tr);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_commit_retaining(ISC_STATUS* status, isc_tr_handle* tr) {
+    LogReader reader(clientReplay, (int)ClientCall::commit_retaining, status);
+    reader.handle(tr);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_commit_transaction(ISC_STATUS* status, isc_tr_handle* tr) {
+    LogReader reader(clientReplay, (int)ClientCall::commit_transaction, status);
+    reader.handle(tr);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_rollback_retaining(ISC_STATUS* status, isc_tr_handle* tr) {
+    LogReader reader(clientReplay, (int)ClientCall::rollback_retaining, status);
+    reader.handle(tr);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_rollback_transaction(ISC_STATUS* status, isc_tr_handle* tr) {
+    LogReader reader(clientReplay, (int)ClientCall::rollback_transaction, status);
+    reader.handle(tr);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_allocate_statement(ISC_STATUS* status, isc_db_handle* db,
+                                                            isc_stmt_handle* stmt) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_allocate_statement, status);
+    reader.handle(stmt);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_prepare(ISC_STATUS* status, isc_tr_handle* tr, isc_stmt_handle* stmt,
+                                                 unsigned short length, const void* sql, unsigned short dialect,
+                                                 XSQLDA* sqlda) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_prepare, status);
+    reader.skip();
+    reader.metadata(sqlda);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_set_cursor_name(ISC_STATUS* status, isc_stmt_handle* stmt,
+                                                         const ISC_SCHAR* name, unsigned short type) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_set_cursor_name, status);
+    reader.skip();
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_describe(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short dialect,
+                                                  XSQLDA* sqlda) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_describe, status);
+    reader.metadata(sqlda);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_describe_bind(ISC_STATUS* status, isc_stmt_handle* stmt,
+                                                       unsigned short dialect, XSQLDA* sqlda) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_describe_bind, status);
+    reader.metadata(sqlda);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_execute(ISC_STATUS* status, isc_tr_handle* tr, isc_stmt_handle* stmt,
+                                                 unsigned short dialect, const XSQLDA* sqlda) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_execute, status);
+    reader.skip();
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_execute2(ISC_STATUS* status, isc_tr_handle* tr, isc_stmt_handle* stmt,
+                                                  unsigned short dialect, const XSQLDA* in, const XSQLDA* out) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_execute2, status);
+    reader.skip();
+    reader.data(out);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_fetch(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short dialect,
+                                               const XSQLDA* sqlda) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_fetch, status);
+    reader.data(sqlda);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_free_statement(ISC_STATUS* status, isc_stmt_handle* stmt,
+                                                        unsigned short option) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_free_statement, status);
+    reader.handle(stmt);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_open_blob(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                              isc_blob_handle* blob, ISC_QUAD* id) {
+    LogReader reader(clientReplay, (int)ClientCall::open_blob, status);
+    reader.handle(blob);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_get_segment(ISC_STATUS* status, isc_blob_handle* blob, unsigned short* actual,
+                                                unsigned short length, void* buffer) {
+    LogReader reader(clientReplay, (int)ClientCall::get_segment, status);
+    auto copied = reader.bytes(buffer, length);
+    if (actual != nullptr)
+        *actual = (unsigned short)copied;
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_put_segment(ISC_STATUS* status, isc_blob_handle* blob, unsigned short length,
+                                                const void* buffer) {
+    LogReader reader(clientReplay, (int)ClientCall::put_segment, status);
+    reader.skip();
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_blob_info(ISC_STATUS* status, isc_blob_handle* blob, short itemsLength,
+                                              const void* items, short length, void* buffer) {
+    LogReader reader(clientReplay, (int)ClientCall::blob_info, status);
+    reader.skip();
+    reader.bytes(buffer, length);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_close_blob(ISC_STATUS* status, isc_blob_handle* blob) {
+    LogReader reader(clientReplay, (int)ClientCall::close_blob, status);
+    reader.handle(blob);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_create_blob(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                isc_blob_handle* blob, ISC_QUAD* id) {
+    LogReader reader(clientReplay, (int)ClientCall::create_blob, status);
+    reader.handle(blob);
+    reader.bytes(id, sizeof(ISC_QUAD));
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_dsql_sql_info(ISC_STATUS* status, isc_stmt_handle* stmt, short itemsLength,
+                                                  const ISC_SCHAR* items, short length, ISC_SCHAR* buffer) {
+    LogReader reader(clientReplay, (int)ClientCall::dsql_sql_info, status);
+    reader.skip();
+    reader.bytes(buffer, length);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_database_info(ISC_STATUS* status, isc_db_handle* db, short itemsLength,
+                                                  const ISC_SCHAR* items, short length, ISC_SCHAR* buffer) {
+    LogReader reader(clientReplay, (int)ClientCall::database_info, status);
+    reader.skip();
+    reader.bytes(buffer, length);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_array_lookup_bounds(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                        const ISC_SCHAR* relation, const ISC_SCHAR* field,
+                                                        ISC_ARRAY_DESC* desc) {
+    LogReader reader(clientReplay, (int)ClientCall::array_lookup_bounds, status);
+    reader.skip();
+    reader.skip();
+    reader.bytes(desc, sizeof(ISC_ARRAY_DESC));
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_array_get_slice(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                    ISC_QUAD* id, const ISC_ARRAY_DESC* desc, void* buffer,
+                                                    ISC_LONG* length) {
+    LogReader reader(clientReplay, (int)ClientCall::array_get_slice, status);
+    *length = (ISC_LONG)reader.bytes(buffer, (size_t)*length);
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_array_put_slice(ISC_STATUS* status, isc_db_handle* db, isc_tr_handle* tr,
+                                                    ISC_QUAD* id, const ISC_ARRAY_DESC* desc, void* buffer,
+                                                    ISC_LONG* length) {
+    LogReader reader(clientReplay, (int)ClientCall::array_put_slice, status);
+    reader.skip();
+    reader.bytes(id, sizeof(ISC_QUAD));
+    return reader.result();
+}
+
+static ISC_STATUS ISC_EXPORT replay_cancel_blob(ISC_STATUS* status, isc_blob_handle* blob) {
+    LogReader reader(clientReplay, (int)ClientCall::cancel_blob, status);
+    reader.handle(blob);
+    return reader.result();
+}
+
+/**
+ * @brief Installs the traced wrappers while at least one interposition feature is enabled, restores the entry
+ * points of the client library otherwise.
+ *
+ * Calls already in flight complete through the pointer they were made with. The caller holds interpositionMutex.
+ */
+static void updateInterposition() {
+    if (interposition.load(std::memory_order_relaxed) != 0) {
+#define CLIENT_TRACED(name) name = traced_##name;
+        CLIENT_FUNCTIONS(CLIENT_TRACED)
+#undef CLIENT_TRACED
+    } else {
+#define CLIENT_RESTORE(name) name = client.name;
+        CLIENT_FUNCTIONS(CLIENT_RESTORE)
+#undef CLIENT_RESTORE
+    }
+}
+
+/**
+ * @brief Enables or disables an interposition feature, installing or removing the traced wrappers accordingly.
+ *
+ * @param feature The feature, one of TRACE_LATENCY, TRACE_COUNTS or TRACE_RECORD.
+ * @param enabled true to enable the feature.
+ */
+static void setInterposition(int feature, bool enabled) {
+    std::lock_guard<std::mutex> lock(interpositionMutex);
+    if (enabled)
+        interposition.fetch_or(feature, std::memory_order_relaxed);
+    else
+        interposition.fetch_and(~feature, std::memory_order_relaxed);
+    updateInterposition();
+}
+
+
+
+void throwDataConversionError(JNIEnv* env, int column) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        std::string str = "Data type conversion error (" + std::to_string(column) + ")";
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+void throwNullError(JNIEnv* env) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        env->ThrowNew(exceptionClass, "Field is null");
+    }
+}
+
+void throwOutOfBoundError(JNIEnv* env, int index) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        std::string str = "Index out of bound: " + std::to_string(index);
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+void throwHandleError(JNIEnv* env) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        env->ThrowNew(exceptionClass, "Invalid Handle value");
+    }
+}
+
+void throwStringTruncation(JNIEnv* env, int index) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        std::string str = "String truncation: " + std::to_string(index);
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+/**
+ * @brief Throws the exception matching a conversion status of the core, if any.
+ *
+ * @return true when the core reported FBCORE_OK.
+ */
+inline bool checkCore(JNIEnv* env, int index, int code) {
+    switch (code) {
+        case FBCORE_OK:
+            return true;
+        case FBCORE_TRUNCATION:
+            throwStringTruncation(env, index);
+            return false;
+        default:
+            throwDataConversionError(env, index);
+            return false;
+    }
+}
+
+void throwFileError(JNIEnv* env, jstring path) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        auto file = env->GetStringUTFChars(path, nullptr);
+        std::string str = "Cannot open file: " + std::string(file);
+        env->ReleaseStringUTFChars(path, file);
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+void throwWriteError(JNIEnv* env, int error) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        std::string str = "Cannot write file: " + std::string(strerror(error));
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+void throwRecordError(JNIEnv* env, int64_t offset, int column) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        std::string str = column < 0 ? "Malformed record at offset " + std::to_string(offset)
+                                     : "Invalid value for column " + std::to_string(column) + " in the record at offset " +
+                                       std::to_string(offset);
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+void throwReadError(JNIEnv* env, int error) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        std::string str = "Cannot read file: " + std::string(strerror(error));
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+void throwUnsupportedError(JNIEnv* env, const char* feature) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        std::string str = std::string(feature) + " not supported by the client library";
+        env->ThrowNew(exceptionClass, str.c_str());
+    }
+}
+
+void throwMemoryError(JNIEnv* env) {
+    jclass exceptionClass = env->FindClass("java/lang/OutOfMemoryError");
+
+    if (exceptionClass != nullptr) {
+        env->ThrowNew(exceptionClass, "Cannot allocate the XSQLDA buffer");
+    }
+}
+
+void throwLoadLibraryError(JNIEnv* env) {
+    jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+
+    if (exceptionClass != nullptr) {
+        env->ThrowNew(exceptionClass, "Error loading Firebird client library");
+    }
+}
+
+// set once the entry points serve the calls, the acquire load pairs with the release store made after they are set
+static std::atomic<bool> clientLoaded(false);
+
+/**
+ * @brief Resolves an entry point of the client library, nullptr when the library does not export it.
+ *
+ * @param entry The entry point to set.
+ * @param handle The handle of the library.
+ * @param symbol The name of the exported function.
+ */
+template<typename F>
+static void resolveEntry(ClientEntry<F>& entry, void* handle, const char* symbol) {
+    F* function;
+#ifdef _WIN32
+    *(FARPROC *) (&function) = GetProcAddress(static_cast<HINSTANCE>(handle), symbol);
+#else
+    *(void **) (&function) = dlsym(handle, symbol);
+#endif
+    entry = function;
+}
+
+/**
+ * @brief Tells whether a function may be missing from the client library, its callers then fail when it is used.
+ */
+static bool optionalEntry(ClientCall call) {
+    return call == ClientCall::array_lookup_bounds || call == ClientCall::array_get_slice ||
+           call == ClientCall::array_put_slice;
+}
+
+/**
+ * @brief Loads the Firebird client library and resolves its entry points.
+ *
+ * The entry points replace those of a previously loaded library, which stays loaded as calls may still be in flight.
+ * A replayed log is no longer served once a library is loaded. A library missing a required entry point is unloaded
+ * and the current entry points are kept.
+ *
+ * @param path The path of the library, nullptr to search the default locations.
+ * @return true if the library was loaded.
+ */
+static bool loadClientLibrary(const char* path) {
+#ifdef _WIN32
+    HINSTANCE instance = NULL;
+    if (!(instance = LoadLibrary(path != nullptr ? path : "fbclient.dll")))
+        return false;
+    void* handle = instance;
+#else
+    #ifdef __APPLE__
+        #define LIB_FBCLIENT "libfbclient.dylib"
+        #define LIB_FBCLIENT2 "/Library/Frameworks/Firebird.framework/Resources/lib/libfbclient.dylib"
+    #else
+        #define LIB_FBCLIENT "libfbclient.so"
+        #define LIB_FBCLIENT2 "/opt/firebird/lib/libfbclient.so"
+    #endif
+
+    void* handle = nullptr;
+    if (path != nullptr) {
+        if (!(handle = dlopen(path, RTLD_NOW)))
+            return false;
+    } else if (!(handle = dlopen(LIB_FBCLIENT, RTLD_NOW))) {
+        if (!(handle = dlopen(LIB_FBCLIENT2, RTLD_NOW)))
+            return false;
+    }
+#endif
+
+    ClientTable resolved;
+    resolveEntry(resolved.interpret, handle, "fb_interpret");
+    resolveEntry(resolved.attach_database, handle, "isc_attach_database");
+    resolveEntry(resolved.create_database, handle, "isc_create_database");
+    resolveEntry(resolved.detach_database, handle, "isc_detach_database");
+    resolveEntry(resolved.dsql_execute_immediate, handle, "isc_dsql_execute_immediate");
+    resolveEntry(resolved.start_transaction, handle, "isc_start_transaction");
+    resolveEntry(resolved.commit_retaining, handle, "isc_commit_retaining");
+    resolveEntry(resolved.commit_transaction, handle, "isc_commit_transaction");
+    resolveEntry(resolved.rollback_retaining, handle, "isc_rollback_retaining");
+    resolveEntry(resolved.rollback_transaction, handle, "isc_rollback_transaction");
+    resolveEntry(resolved.dsql_allocate_statement, handle, "isc_dsql_allocate_statement");
+    resolveEntry(resolved.dsql_prepare, handle, "isc_dsql_prepare");
+    resolveEntry(resolved.dsql_set_cursor_name, handle, "isc_dsql_set_cursor_name");
+    resolveEntry(resolved.dsql_describe, handle, "isc_dsql_describe");
+    resolveEntry(resolved.dsql_describe_bind, handle, "isc_dsql_describe_bind");
+    resolveEntry(resolved.dsql_execute, handle, "isc_dsql_execute");
+    resolveEntry(resolved.dsql_execute2, handle, "isc_dsql_execute2");
+    resolveEntry(resolved.dsql_fetch, handle, "isc_dsql_fetch");
+    resolveEntry(resolved.dsql_free_statement, handle, "isc_dsql_free_statement");
+    resolveEntry(resolved.open_blob, handle, "isc_open_blob");
+    resolveEntry(resolved.get_segment, handle, "isc_get_segment");
+    resolveEntry(resolved.put_segment, handle, "isc_put_segment");
+    resolveEntry(resolved.blob_info, handle, "isc_blob_info");
+    resolveEntry(resolved.close_blob, handle, "isc_close_blob");
+    resolveEntry(resolved.create_blob, handle, "isc_create_blob");
+    resolveEntry(resolved.dsql_sql_info, handle, "isc_dsql_sql_info");
+    resolveEntry(resolved.database_info, handle, "isc_database_info");
+    resolveEntry(resolved.array_lookup_bounds, handle, "isc_array_lookup_bounds");
+    resolveEntry(resolved.array_get_slice, handle, "isc_array_get_slice");
+    resolveEntry(resolved.array_put_slice, handle, "isc_array_put_slice");
+    resolveEntry(resolved.cancel_blob, handle, "isc_cancel_blob");
+    decltype(get_master_interface) masterInterface;
+    decltype(get_statement_interface) statementInterface;
+    decltype(get_transaction_interface) transactionInterface;
+    decltype(que_events) queEvents;
+    decltype(cancel_events) cancelEvents;
+    resolveEntry(masterInterface, handle, "fb_get_master_interface");
+    resolveEntry(statementInterface, handle, "fb_get_statement_interface");
+    resolveEntry(transactionInterface, handle, "fb_get_transaction_interface");
+    resolveEntry(queEvents, handle, "isc_que_events");
+    resolveEntry(cancelEvents, handle, "isc_cancel_events");
+
+    bool complete = true;
+#define CLIENT_REQUIRED(name) complete = complete && (resolved.name != nullptr || optionalEntry(ClientCall::name));
+    CLIENT_FUNCTIONS(CLIENT_REQUIRED)
+#undef CLIENT_REQUIRED
+    if (!complete) {
+#ifdef _WIN32
+        FreeLibrary(instance);
+#else
+        dlclose(handle);
+#endif
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(interpositionMutex);
+    get_master_interface = masterInterface;
+    get_statement_interface = statementInterface;
+    get_transaction_interface = transactionInterface;
+    que_events = queEvents;
+    cancel_events = cancelEvents;
+#define CLIENT_SAVE(name) client.name = library.name = resolved.name;
+    CLIENT_FUNCTIONS(CLIENT_SAVE)
+#undef CLIENT_SAVE
+    updateInterposition();
+    clientLoaded.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Returns the value of a Java system property, or an empty string when it is not set.
+ */
+static std::string systemProperty(JNIEnv* env, const char* name) {
+    std::string result;
+    auto systemClass = env->FindClass("java/lang/System");
+    if (systemClass == nullptr)
+        return result;
+    auto getProperty = env->GetStaticMethodID(systemClass, "getProperty", "(Ljava/lang/String;)Ljava/lang/String;");
+    auto key = env->NewStringUTF(name);
+    auto value = (jstring)env->CallStaticObjectMethod(systemClass, getProperty, key);
+    if (value != nullptr) {
+        auto chars = env->GetStringUTFChars(value, nullptr);
+        result = chars;
+        env->ReleaseStringUTFChars(value, chars);
+        env->DeleteLocalRef(value);
+    }
+    env->DeleteLocalRef(key);
+    return result;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM* vm, void* reserved) {
+    JNIEnv* env;
+    if (vm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK)
+        return JNI_ERR;
+
+    // the client library is searched in this order: the "fbclient.library" system property, the FBCLIENT_LIBRARY
+    // environment variable and the default locations. When none is found, API.init must be called with its path.
+    auto path = systemProperty(env, "fbclient.library");
+    if (path.empty()) {
+        auto variable = getenv("FBCLIENT_LIBRARY");
+        if (variable != nullptr)
+            path = variable;
+    }
+    loadClientLibrary(path.empty() ? nullptr : path.c_str());
+
+    return JNI_VERSION_1_6;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_init(JNIEnv *env, jclass clazz, jstring path) {
+    auto file = env->GetStringUTFChars(path, nullptr);
+    auto loaded = loadClientLibrary(file);
+    env->ReleaseStringUTFChars(path, file);
+    if (!loaded)
+        throwLoadLibraryError(env);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+JNI_OnUnload(JavaVM* vm, void* reserved) {
+    // Libération des ressources ici
+}
+
+constexpr ISC_STATUS ISC_MASK	= FB_IMPL_MSG_MASK;	// Defines the code as a valid ISC code
+constexpr ISC_STATUS FAC_MASK	= 0x00FF0000;	// Specifies the facility where the code is located
+constexpr ISC_STATUS CODE_MASK	= 0x0000FFFF;	// Specifies the code in the message file
+constexpr ISC_STATUS CLASS_MASK	= 0xF0000000;	// Defines the code as warning, error, info, or other
+
+#define CLASS_ERROR		0L		// Code represents an error
+#define CLASS_WARNING		1L		// Code represents a warning
+#define CLASS_INFO		2L		// Code represents an information msg
+
+jlong checkStatus(JNIEnv* env, const ISC_STATUS* statusArray, jlong code) {
+    if (code != 0) {
+        if (((code & CLASS_MASK) >> 30) == CLASS_ERROR) {
+            jclass exceptionClass = env->FindClass("com/progdigy/fbclient/FirebirdException");
+            if (exceptionClass != nullptr) {
+                ISC_SCHAR buffer[1024];
+                fbcore_interpret(buffer, sizeof buffer, statusArray, interpret);
+                env->ThrowNew(exceptionClass, buffer);
+            }
+        }
+    }
+    return code;
+}
+
+jlong checkStatus(JNIEnv* env, jlong status, jlong code) {
+    const ISC_STATUS* statusArray = (ISC_STATUS*)(status);
+    return checkStatus(env, statusArray, code);
+}
+
+/*
+ * Column accessor plans
+ *
+ * A described XSQLDA is followed, in the same allocation, by one ColumnPlan per allocated sqlvar. The plan caches the
+ * data and indicator pointers of a column and the slot of its type; the scalar getters and setters index a table of
+ * kernels specialized on the type with the slot, so a call is one indirect call without the switch over sqltype.
+ */
+
+#define COLUMN_TYPES(X) \
+    X(SQL_TEXT) X(SQL_VARYING) X(SQL_SHORT) X(SQL_LONG) X(SQL_FLOAT) X(SQL_DOUBLE) X(SQL_D_FLOAT) X(SQL_TIMESTAMP) \
+    X(SQL_BLOB) X(SQL_ARRAY) X(SQL_QUAD) X(SQL_TYPE_TIME) X(SQL_TYPE_DATE) X(SQL_INT64) X(SQL_TIMESTAMP_TZ_EX) \
+    X(SQL_TIME_TZ_EX) X(SQL_INT128) X(SQL_TIMESTAMP_TZ) X(SQL_TIME_TZ) X(SQL_DEC16) X(SQL_DEC34) X(SQL_BOOLEAN) \
+    X(SQL_NULL)
+
+#define SLOT_ENTRY(code) slot_##code,
+#define SLOT_CASE(code) case code: return slot_##code;
+
+// the last slot holds the kernels of the types the client does not know, they all fail the conversion
+enum ColumnSlot : unsigned char { COLUMN_TYPES(SLOT_ENTRY) slot_other };
+
+struct ColumnPlan {
+    ISC_SCHAR* data;
+    ISC_SHORT* ind;
+    ColumnSlot slot;
+};
+
+static ColumnSlot columnSlot(ISC_SHORT code) {
+    switch (code) {
+        COLUMN_TYPES(SLOT_CASE)
+        default: return slot_other;
+    }
+}
+
+static size_t columnPlanOffset(ISC_SHORT count) {
+    auto length = XSQLDA_LENGTH(count > 0 ? count : 1);
+    return (length + alignof(ColumnPlan) - 1) & ~(alignof(ColumnPlan) - 1);
+}
+
+inline ColumnPlan* columnPlans(XSQLDA* sqlda) {
+    return reinterpret_cast<ColumnPlan*>(reinterpret_cast<char*>(sqlda) + columnPlanOffset(sqlda->sqln));
+}
+
+/**
+ * Allocates an XSQLDA for count columns with room for their plans, freed by fbcore_free_sqlda.
+ */
+static XSQLDA* allocSQLDA(ISC_SHORT count) {
+    auto sqlda = (XSQLDA*)calloc(1, columnPlanOffset(count) + sizeof(ColumnPlan) * (count > 0 ? count : 1));
+    if (sqlda != nullptr) {
+        sqlda->version = SQLDA_VERSION1;
+        sqlda->sqln = count;
+    }
+    return sqlda;
+}
+
+/**
+ * Plans the columns of an XSQLDA from allocSQLDA, once its data buffer is laid out.
+ */
+static void planColumns(XSQLDA* sqlda) {
+    auto plans = columnPlans(sqlda);
+    for (int i = 0; i < sqlda->sqld; i++) {
+        auto v = &sqlda->sqlvar[i];
+        plans[i] = ColumnPlan{v->sqldata, v->sqlind, columnSlot(v->sqltype & ~1)};
+    }
+}
+
+/**
+ * Allocates the data buffer of a described XSQLDA from allocSQLDA and plans its columns.
+ */
+static int allocateDataBuffer(XSQLDA* sqlda) {
+    auto ret = fbcore_allocate_data_buffer(sqlda);
+    if (ret == FBCORE_OK)
+        planColumns(sqlda);
+    return ret;
+}
+
+template<typename T, T (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT), ISC_SHORT code>
+T decodeColumn(JNIEnv* env, int index, ISC_SCHAR* data) {
+    return block(env, index, data, code);
+}
+
+template<typename T, void (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT, T), ISC_SHORT code>
+void encodeColumn(JNIEnv* env, int index, ISC_SCHAR* data, T value) {
+    block(env, index, data, code, value);
+}
+
+#define DECODE_ENTRY(code) decodeColumn<T, block, code>,
+#define ENCODE_ENTRY(code) encodeColumn<T, block, code>,
+
+template<typename T, T (*block)(JNIEnv*, ISC_STATUS*, FB_API_HANDLE*, FB_API_HANDLE*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT)>
+inline T getFieldValue(JNIEnv *env, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, int index) {
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto p = (handle != nullptr)?*handle: nullptr;
+    if (p != nullptr) {
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            if (v->sqlind == nullptr || *v->sqlind == 0) {
+                return block(env, statusArray, dbHandle, trHandle, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype);
+            } else
+                throwNullError(env);
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+    return 0;
+}
+
+template<typename T, T (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT)>
+inline T getFieldValue(JNIEnv *env, jlong sqlda, int index) {
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    auto p = (handle != nullptr)?*handle: nullptr;
+    if (p != nullptr) {
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            if (v->sqlind == nullptr || *v->sqlind == 0) {
+                return block(env, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype);
+            } else
+                throwNullError(env);
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+    return 0;
+}
+
+template<typename T, T (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT)>
+inline T getFieldValue(JNIEnv *env, jlong sqlda, int index) {
+    static T (*const kernels[])(JNIEnv*, int, ISC_SCHAR*) = { COLUMN_TYPES(DECODE_ENTRY) decodeColumn<T, block, 0> };
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    auto p = (handle != nullptr)?*handle: nullptr;
+    if (p != nullptr) {
+        if (index >= 0 && index < p->sqld) {
+            auto c = &columnPlans(p)[index];
+            if (c->ind == nullptr || *c->ind == 0) {
+                return kernels[c->slot](env, index, c->data);
+            } else
+                throwNullError(env);
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+    return 0;
+}
+
+
+template<typename T, void (*block)(JNIEnv*, ISC_STATUS*, FB_API_HANDLE*, FB_API_HANDLE*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT, T)>
+inline void setFieldValue(JNIEnv *env, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, int index, T value) {
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto p = (handle != nullptr)?*handle: nullptr;
+    if (p != nullptr) {
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            block(env, statusArray, dbHandle, trHandle, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype, value);
+            if (v->sqlind != nullptr)
+                *v->sqlind = 0;
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+}
+
+template<typename T, void (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT, ISC_SHORT, ISC_SHORT, T)>
+inline void setFieldValue(JNIEnv *env, jlong sqlda, int index, T value) {
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    auto p = (handle != nullptr)?*handle: nullptr;
+    if (p != nullptr) {
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            block(env, index, v->sqldata, v->sqltype & ~1, v->sqllen, v->sqlsubtype, value);
+            if (v->sqlind != nullptr)
+                *v->sqlind = 0;
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+}
+
+template<typename T, void (*block)(JNIEnv*, int, ISC_SCHAR*, ISC_SHORT, T)>
+inline void setFieldValue(JNIEnv *env, jlong sqlda, int index, T value) {
+    static void (*const kernels[])(JNIEnv*, int, ISC_SCHAR*, T) = { COLUMN_TYPES(ENCODE_ENTRY) encodeColumn<T, block, 0> };
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    auto p = (handle != nullptr)?*handle: nullptr;
+    if (p != nullptr) {
+        if (index >= 0 && index < p->sqld) {
+            auto c = &columnPlans(p)[index];
+            kernels[c->slot](env, index, c->data, value);
+            if (c->ind != nullptr)
+                *c->ind = 0;
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+}
+
+
+/**
+ * @brief Reads a little-endian integer of variable length from an info buffer, as isc_vax_integer does.
+ */
+static ISC_INT64 vaxInteger(const ISC_SCHAR* buffer, int length) {
+    ISC_INT64 value = 0;
+    for (int i = 0; i < length && i < 8; i++)
+        value |= (ISC_INT64)(ISC_UCHAR)buffer[i] << (i * 8);
+    return value;
+}
+
+/**
+ * A statement followed by the slow query log, from its preparation to its release.
+ */
+struct TrackedStatement {
+    std::string sql;
+    std::string parameters;
+    uint64_t elapsed = 0;
+    // the statement opens a cursor when executed: a SELECT, with or without FOR UPDATE
+    bool cursor = false;
+    bool open = false;
+};
+
+/**
+ * A statement that exceeded the slow query threshold.
+ */
+struct SlowQuery {
+    std::string sql;
+    std::string parameters;
+    uint64_t elapsed = 0;
+    ISC_INT64 selected = 0;
+    ISC_INT64 inserted = 0;
+    ISC_INT64 updated = 0;
+    ISC_INT64 deleted = 0;
+    std::string plan;
+};
+
+// 0 when the slow query log is disabled
+static std::atomic<uint64_t> slowQueryThreshold(0);
+static std::mutex slowQueryMutex;
+static std::unordered_map<FB_API_HANDLE*, TrackedStatement> trackedStatements;
+static std::deque<SlowQuery> slowQueries;
+static size_t slowQueryCapacity = 0;
+
+/**
+ * @brief Describes the type of an XSQLVAR, for diagnostic purposes.
+ */
+static std::string sqlTypeName(const XSQLVAR* var) {
+    std::string name;
+    switch (var->sqltype & ~1) {
+        case SQL_TEXT: name = "CHAR(" + std::to_string(var->sqllen) + ")"; break;
+        case SQL_VARYING: name = "VARCHAR(" + std::to_string(var->sqllen) + ")"; break;
+        case SQL_SHORT: name = "SMALLINT"; break;
+        case SQL_LONG: name = "INTEGER"; break;
+        case SQL_QUAD:
+        case SQL_INT64: name = "BIGINT"; break;
+        case SQL_INT128: name = "INT128"; break;
+        case SQL_FLOAT: name = "FLOAT"; break;
+        case SQL_D_FLOAT:
+        case SQL_DOUBLE: name = "DOUBLE PRECISION"; break;
+        case SQL_BOOLEAN: name = "BOOLEAN"; break;
+        case SQL_TYPE_DATE: name = "DATE"; break;
+        case SQL_TYPE_TIME: name = "TIME"; break;
+        case SQL_TIMESTAMP: name = "TIMESTAMP"; break;
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX: name = "TIME WITH TIME ZONE"; break;
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX: name = "TIMESTAMP WITH TIME ZONE"; break;
+        case SQL_BLOB: name = "BLOB SUB_TYPE " + std::to_string(var->sqlsubtype); break;
+        case SQL_ARRAY: name = "ARRAY"; break;
+        default: name = "TYPE " + std::to_string(var->sqltype & ~1);
+    }
+    if (var->sqlscale != 0)
+        name += " SCALE " + std::to_string(var->sqlscale);
+    return name;
+}
+
+/**
+ * @brief Reads the plan of a statement, the explained form when the server supports it (Firebird 3 and later).
+ */
+static std::string statementPlan(FB_API_HANDLE* stHandle) {
+    ISC_STATUS_ARRAY status = {0};
+    ISC_SCHAR buffer[16384];
+    const ISC_SCHAR items[] = {isc_info_sql_explain_plan, isc_info_sql_get_plan};
+    for (auto item : items) {
+        if (dsql_sql_info(status, stHandle, 1, &item, sizeof(buffer), buffer) == 0 && buffer[0] == item) {
+            auto length = (int)vaxInteger(&buffer[1], 2);
+            std::string plan(&buffer[3], std::min(length, (int)sizeof(buffer) - 3));
+            plan.erase(0, plan.find_first_not_of('\n'));
+            return plan;
+        }
+    }
+    return std::string();
+}
+
+/**
+ * @brief Reads the number of records selected, inserted, updated and deleted by the last execution of a statement.
+ *
+ * @param counts Receives the four counts, in that order.
+ * @return False when the counts cannot be requested.
+ */
+static bool statementRecords(FB_API_HANDLE* stHandle, ISC_INT64 counts[4]) {
+    ISC_STATUS_ARRAY status = {0};
+    ISC_SCHAR item = isc_info_sql_records;
+    ISC_SCHAR buffer[128];
+    if (dsql_sql_info(status, stHandle, 1, &item, sizeof(buffer), buffer) != 0 || buffer[0] != item)
+        return false;
+    counts[0] = counts[1] = counts[2] = counts[3] = 0;
+    auto p = &buffer[3];
+    while (p < buffer + sizeof(buffer) - 3 && *p != isc_info_end) {
+        auto length = (int)vaxInteger(p + 1, 2);
+        auto value = vaxInteger(p + 3, length);
+        switch (*p) {
+            case isc_info_req_select_count: counts[0] = value; break;
+            case isc_info_req_insert_count: counts[1] = value; break;
+            case isc_info_req_update_count: counts[2] = value; break;
+            case isc_info_req_delete_count: counts[3] = value; break;
+            default: break;
+        }
+        p += 3 + length;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the slow query record of a statement and pushes it into the ring, dropping the oldest record
+ * when the ring is full.
+ *
+ * The record counts and the plan are requested from the statement, which must still be prepared.
+ */
+static void captureSlowQuery(FB_API_HANDLE* stHandle, const TrackedStatement& statement) {
+    SlowQuery query;
+    query.sql = statement.sql;
+    query.parameters = statement.parameters;
+    query.elapsed = statement.elapsed;
+    if (stHandle != nullptr) {
+        ISC_INT64 counts[4];
+        if (statementRecords(stHandle, counts)) {
+            query.selected = counts[0];
+            query.inserted = counts[1];
+            query.updated = counts[2];
+            query.deleted = counts[3];
+        }
+        query.plan = statementPlan(stHandle);
+    }
+    std::lock_guard<std::mutex> lock(slowQueryMutex);
+    if (slowQueryCapacity == 0)
+        return;
+    while (slowQueries.size() >= slowQueryCapacity)
+        slowQueries.pop_front();
+    slowQueries.push_back(std::move(query));
+}
+
+/**
+ * @brief Starts following a statement, when the slow query log is enabled.
+ */
+static void slowQueryPrepared(FB_API_HANDLE* stHandle, const char* sql) {
+    if (slowQueryThreshold.load(std::memory_order_relaxed) == 0)
+        return;
+    ISC_STATUS_ARRAY status = {0};
+    // the statement types are 0 based, as getStatementType reports them
+    auto type = fbcore_statement_type(status, stHandle, dsql_sql_info) + 1;
+    std::lock_guard<std::mutex> lock(slowQueryMutex);
+    auto& statement = trackedStatements[stHandle];
+    statement.sql = sql;
+    statement.parameters.clear();
+    statement.elapsed = 0;
+    statement.cursor = status[1] == 0 &&
+                       (type == isc_info_sql_stmt_select || type == isc_info_sql_stmt_select_for_upd);
+    statement.open = false;
+}
+
+/**
+ * @brief Accounts the execution of a followed statement, completed unless it opened a cursor.
+ *
+ * @param stHandle The statement handle.
+ * @param input The input parameters, may be nullptr.
+ * @param elapsed The duration of the execution in nanoseconds.
+ * @param cursor false when the execution cannot leave a cursor open, as execute2 fetches its singleton row; otherwise
+ * the prepared statement type tells whether it did, the cursor completes when fetched to the end or closed.
+ */
+static void slowQueryExecuted(FB_API_HANDLE* stHandle, const XSQLDA* input, uint64_t elapsed, bool cursor) {
+    TrackedStatement completed;
+    {
+        std::lock_guard<std::mutex> lock(slowQueryMutex);
+        auto it = trackedStatements.find(stHandle);
+        if (it == trackedStatements.end())
+            return;
+        auto& statement = it->second;
+        cursor = cursor && statement.cursor;
+        statement.elapsed = elapsed;
+        statement.open = cursor;
+        bool slow = elapsed >= slowQueryThreshold.load(std::memory_order_relaxed);
+        if (!cursor && !slow)
+            return;
+        // The caller owns the parameters, describe them now: an open cursor may outlive them.
+        statement.parameters.clear();
+        if (input != nullptr) {
+            for (int i = 0; i < input->sqld; i++) {
+                if (i > 0)
+                    statement.parameters += ", ";
+                statement.parameters += sqlTypeName(&input->sqlvar[i]);
+            }
+        }
+        if (cursor)
+            return;
+        completed = statement;
+    }
+    captureSlowQuery(stHandle, completed);
+}
+
+/**
+ * @brief Accounts a fetch on the open cursor of a followed statement.
+ *
+ * @param stHandle The statement handle.
+ * @param elapsed The duration of the fetch in nanoseconds.
+ * @param end true when the cursor reached its end or failed.
+ */
+static void slowQueryFetched(FB_API_HANDLE* stHandle, uint64_t elapsed, bool end) {
+    TrackedStatement completed;
+    {
+        std::lock_guard<std::mutex> lock(slowQueryMutex);
+        auto it = trackedStatements.find(stHandle);
+        if (it == trackedStatements.end() || !it->second.open)
+            return;
+        auto& statement = it->second;
+        statement.elapsed += elapsed;
+        if (!end)
+            return;
+        statement.open = false;
+        if (statement.elapsed < slowQueryThreshold.load(std::memory_order_relaxed))
+            return;
+        completed = statement;
+    }
+    captureSlowQuery(stHandle, completed);
+}
+
+/**
+ * @brief Completes the open cursor of a followed statement before it is closed or executed again, and stops following
+ * it when it is dropped.
+ */
+static void slowQueryReleased(FB_API_HANDLE* stHandle, bool drop) {
+    if (slowQueryThreshold.load(std::memory_order_relaxed) == 0)
+        return;
+    TrackedStatement completed;
+    bool slow = false;
+    {
+        std::lock_guard<std::mutex> lock(slowQueryMutex);
+        auto it = trackedStatements.find(stHandle);
+        if (it == trackedStatements.end())
+            return;
+        auto& statement = it->second;
+        slow = statement.open && statement.elapsed >= slowQueryThreshold.load(std::memory_order_relaxed);
+        if (slow)
+            completed = statement;
+        if (drop)
+            trackedStatements.erase(it);
+        else
+            statement.open = false;
+    }
+    if (slow)
+        captureSlowQuery(stHandle, completed);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_allocStatusArray(JNIEnv *env, jclass clazz) {
+    JniScope scope(JniCall::allocStatusArray);
+    auto status = new ISC_STATUS_ARRAY;
+    for(int i = 0; i < ISC_STATUS_LENGTH; i++) {
+        status[i] = 0;
+    }
+    return reinterpret_cast<jlong>(status);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_allocHandle(JNIEnv *env, jclass clazz) {
+    JniScope scope(JniCall::allocHandle);
+    auto handle = (void**)malloc(sizeof (void*));
+    *handle = nullptr;
+    return reinterpret_cast<jlong>(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_freeHandle(JNIEnv *env, jclass clazz, jlong handle) {
+    JniScope scope(JniCall::freeHandle);
+    if (handle != 0)
+        free((void*)(handle));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_freeStatusArray(JNIEnv *env, jclass clazz, jlong status) {
+    JniScope scope(JniCall::freeStatusArray);
+    if (status != 0)
+        delete[] reinterpret_cast<ISC_STATUS_ARRAY*>(status);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_attachDatabase(
+        JNIEnv *env, jclass clazz, jlong status, jstring path,jlong db_handle, jbyteArray options) {
+    JniScope scope(JniCall::attachDatabase);
+    if (!clientLoaded.load(std::memory_order_acquire)) {
+        throwLoadLibraryError(env);
+        return 0;
+    }
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE *>(db_handle);
+    const char *dbPath = env->GetStringUTFChars(path, nullptr);
+    auto len = (options != nullptr)? env->GetArrayLength(options): 0;
+    auto dpb = (len > 0) ? env->GetByteArrayElements(options, nullptr) : nullptr;
+    auto ret = attach_database(statusArray, (short)std::strlen(dbPath), dbPath, dbHandle, (short)len, (ISC_SCHAR *)dpb);
+    if (dpb != nullptr)
+        env->ReleaseByteArrayElements(options, dpb, 0);
+    env->ReleaseStringUTFChars(path, dbPath);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_createDatabase(
+        JNIEnv *env, jclass clazz, jlong status, jstring path,jlong db_handle, jbyteArray options) {
+    JniScope scope(JniCall::createDatabase);
+    if (!clientLoaded.load(std::memory_order_acquire)) {
+        throwLoadLibraryError(env);
+        return 0;
+    }
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE *>(db_handle);
+    const char *dbPath = env->GetStringUTFChars(path, nullptr);
+    auto len = (options != nullptr)? env->GetArrayLength(options): 0;
+    auto dpb = (len > 0) ? env->GetByteArrayElements(options, nullptr) : nullptr;
+    auto ret = create_database(statusArray, (short)std::strlen(dbPath), dbPath, dbHandle, (short)len, (ISC_SCHAR *)dpb, 0);
+    if (dpb != nullptr)
+        env->ReleaseByteArrayElements(options, dpb, 0);
+    env->ReleaseStringUTFChars(path, dbPath);
+    return ret;
+}
+
+// defined with the array accessors, which cache descriptors per attachment
+static void forgetArrayDescriptors(const FB_API_HANDLE* db);
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_detachDatabase(
+        JNIEnv *env, jclass clazz, jlong status, jlong db_handle) {
+    JniScope scope(JniCall::detachDatabase);
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    forgetArrayDescriptors(dbHandle);
+    return detach_database(statusArray, dbHandle);
+}
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_com_progdigy_fbclient_API_databaseInfo(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                            jbyteArray items, jint length) {
+    JniScope scope(JniCall::databaseInfo);
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto buffer = (ISC_SCHAR *)malloc(length);
+    if (buffer == nullptr) {
+        throwMemoryError(env);
+        return nullptr;
+    }
+    auto itemsLength = env->GetArrayLength(items);
+    auto request = env->GetByteArrayElements(items, nullptr);
+    auto ret = database_info(statusArray, dbHandle, (short)itemsLength, (ISC_SCHAR *)request, (short)length, buffer);
+    env->ReleaseByteArrayElements(items, request, JNI_ABORT);
+    jbyteArray result = nullptr;
+    if (checkStatus(env, statusArray, ret) == 0) {
+        result = env->NewByteArray(length);
+        env->SetByteArrayRegion(result, 0, length, (jbyte *)buffer);
+    }
+    free(buffer);
+    return result;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_executeImmediate(JNIEnv *env, jclass clazz, jlong status,
+                                                    jlong db_handle, jlong tr_handle, jstring sql, jshort dialect) {
+    JniScope scope(JniCall::executeImmediate);
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto string = env->GetStringUTFChars(sql, nullptr);
+    auto threshold = slowQueryThreshold.load(std::memory_order_relaxed);
+    auto start = threshold != 0 ? nanoTime() : 0;
+    auto ret = dsql_execute_immediate(statusArray, dbHandle, trHandle, strlen(string), string, dialect, nullptr);
+    if (start != 0 && ret == 0) {
+        TrackedStatement statement;
+        statement.sql = string;
+        statement.elapsed = nanoTime() - start;
+        if (statement.elapsed >= threshold)
+            captureSlowQuery(nullptr, statement);
+    }
+    env->ReleaseStringUTFChars(sql, string);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_progdigy_fbclient_API_interpret(JNIEnv *env, jclass clazz, jlong status) {
+    JniScope scope(JniCall::interpret);
+    ISC_SCHAR buffer[1024];
+    fbcore_interpret(buffer, sizeof buffer, reinterpret_cast<const ISC_STATUS*>(status), interpret);
+    return env->NewStringUTF(buffer);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_startTransaction(JNIEnv *env, jclass clazz, jlong status,
+                                                jlong tr_handle, jlong db_handle, jbyteArray options) {
+    JniScope scope(JniCall::startTransaction);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto len = (options != nullptr)? env->GetArrayLength(options): 0;
+    auto tpb = (len > 0)?env->GetByteArrayElements(options, nullptr): nullptr;
+    auto ret = start_transaction(statusArray, trHandle, 1, dbHandle, (short)len, (ISC_SCHAR *)tpb);
+    if (tpb != nullptr)
+        env->ReleaseByteArrayElements(options, tpb, 0);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_commitTransaction(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jboolean retain) {
+    JniScope scope(JniCall::commitTransaction);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    if (retain)
+        return commit_retaining(statusArray, trHandle);
+    else
+        return commit_transaction(statusArray, trHandle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_rollbackTransaction(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jboolean retain) {
+    JniScope scope(JniCall::rollbackTransaction);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    if (retain)
+        return rollback_retaining(statusArray, trHandle);
+    else
+        return rollback_transaction(statusArray, trHandle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_prepareStatement(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+    jlong st_handle, jstring sql, jstring cursor, jshort dialect, jlong sqlda) {
+    JniScope scope(JniCall::prepareStatement);
+
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto xsqlda   = reinterpret_cast<XSQLDA **>(sqlda);
+    const char *statement = env->GetStringUTFChars(sql, nullptr);
+    auto ret = dsql_allocate_statement(statusArray, dbHandle, stHandle);
+    if (ret != 0) return ret;
+    XSQLDA da = {0};
+    da.version = SQLDA_VERSION1;
+    ret = dsql_prepare(statusArray, trHandle, stHandle, strlen(statement), statement, dialect, &da);
+    if (ret == 0)
+        slowQueryPrepared(stHandle, statement);
+    env->ReleaseStringUTFChars(sql, statement);
+    if (ret == 0) {
+        if (cursor != nullptr) {
+            const char *name = env->GetStringUTFChars(cursor, nullptr);
+            ret = dsql_set_cursor_name(statusArray, stHandle, name, 0);
+            env->ReleaseStringUTFChars(cursor, name);
+        }
+        if (ret == 0 && xsqlda != nullptr && da.sqld > 0) {
+            auto pXSQLDA = allocSQLDA(da.sqld);
+            ret = dsql_describe(statusArray, stHandle, dialect, pXSQLDA);
+            if (ret == 0 && allocateDataBuffer(pXSQLDA) != FBCORE_OK) {
+                fbcore_free_sqlda(pXSQLDA);
+                throwMemoryError(env);
+                return 0;
+            }
+            if (ret == 0) {
+                *xsqlda = pXSQLDA;
+            } else {
+                fbcore_free_sqlda(pXSQLDA);
+                return ret;
+            }
+        }
+    }
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getStatementType(JNIEnv *env, jclass clazz, jlong status, jlong st_handle) {
+    JniScope scope(JniCall::getStatementType);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    if (stHandle == nullptr || *stHandle == 0) {
+        throwHandleError(env);
+        return 0;
+    }
+    return fbcore_statement_type(statusArray, stHandle, dsql_sql_info);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_freeSQLDA(JNIEnv *env, jclass clazz, jlong handle) {
+    JniScope scope(JniCall::freeSQLDA);
+    auto h = reinterpret_cast<XSQLDA **>(handle);
+    if (h != nullptr) {
+        auto sqlda = *h;
+        if (sqlda != nullptr) {
+            fbcore_free_sqlda(sqlda);
+            *h = nullptr;
+        }
+    }
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_freeStatement(JNIEnv *env, jclass clazz, jlong status, jlong st_handle, jshort action) {
+    JniScope scope(JniCall::freeStatement);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    if (action != DSQL_unprepare)
+        slowQueryReleased(stHandle, action == DSQL_drop);
+    auto ret = dsql_free_statement(statusArray, stHandle, action);
+    if (action == DSQL_drop)
+        *stHandle = 0;
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_prepareParams(JNIEnv *env, jclass clazz, jlong status, jlong statement, jshort dialect, jlong sqlda) {
+    JniScope scope(JniCall::prepareParams);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(statement);
+    auto xsqlda   = reinterpret_cast<XSQLDA **>(sqlda);
+
+    XSQLDA da = {0};
+    da.version = SQLDA_VERSION1;
+    da.sqld = 0;
+    da.sqln = 0;
+    auto ret = dsql_describe_bind(statusArray, stHandle, dialect, &da);
+    if (ret == 0 && da.sqld > 0) {
+        auto pXSQLDA = allocSQLDA(da.sqld);
+        ret = dsql_describe_bind(statusArray, stHandle, dialect, pXSQLDA);
+        if (ret == 0 && allocateDataBuffer(pXSQLDA) != FBCORE_OK) {
+            fbcore_free_sqlda(pXSQLDA);
+            throwMemoryError(env);
+            return 0;
+        }
+        if (ret == 0) {
+            *xsqlda = pXSQLDA;
+        } else {
+            fbcore_free_sqlda(pXSQLDA);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Returns the SQL type and the character set of a DataType ordinal, as getType reports them.
+ *
+ * @return False for the types a column cannot be changed to.
+ */
+static bool dataTypeCode(jint type, int& code, int& subtype) {
+    subtype = 0;
+    switch (type) {
+        case 0: code = SQL_SHORT; return true;
+        case 1: code = SQL_LONG; return true;
+        case 2: code = SQL_INT64; return true;
+        case 3: code = SQL_FLOAT; return true;
+        case 4: code = SQL_DOUBLE; return true;
+        case 5: code = SQL_VARYING; subtype = 4; return true;
+        case 6: code = SQL_VARYING; return true;
+        case 7: code = SQL_INT128; return true;
+        case 8: code = SQL_BOOLEAN; return true;
+        case 9: code = SQL_TYPE_DATE; return true;
+        case 10: code = SQL_TYPE_TIME; return true;
+        case 11: code = SQL_TIMESTAMP; return true;
+        case 12: code = SQL_TIME_TZ; return true;
+        case 13: code = SQL_TIMESTAMP_TZ; return true;
+        default: return false;
+    }
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setTypes(JNIEnv *env, jclass clazz, jlong sqlda, jintArray types) {
+    JniScope scope(JniCall::setTypes);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return;
+    }
+    auto p = *handle;
+    // fewer types than columns keep the described types of the last ones, more are an error
+    auto count = (int)env->GetArrayLength(types);
+    if (count > p->sqld) {
+        throwOutOfBoundError(env, p->sqld);
+        return;
+    }
+    std::vector<jint> values((size_t)count);
+    env->GetIntArrayRegion(types, 0, count, values.data());
+    // the columns are changed on a copy, left as they are when a type is refused or the buffer cannot be allocated
+    std::vector<XSQLVAR> vars(p->sqlvar, p->sqlvar + p->sqld);
+    for (int i = 0; i < count; i++) {
+        int code, subtype;
+        if (values[i] < 0)
+            continue;
+        if (!dataTypeCode(values[i], code, subtype) || fbcore_set_var_type(&vars[i], code, subtype) != FBCORE_OK) {
+            throwDataConversionError(env, i);
+            return;
+        }
+    }
+    if (fbcore_relayout_data_buffer(p, vars.data()) != FBCORE_OK) {
+        throwMemoryError(env);
+        return;
+    }
+    planColumns(p);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setOutputProfile(JNIEnv *env, jclass clazz, jlong sqlda, jint profile) {
+    JniScope scope(JniCall::setOutputProfile);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr) {
+        throwHandleError(env);
+        return;
+    }
+    // a statement without columns has no XSQLDA
+    auto p = *handle;
+    if (p == nullptr)
+        return;
+    auto changed = fbcore_set_output_profile(p, profile);
+    if (changed < 0)
+        throwMemoryError(env);
+    else if (changed > 0)
+        planColumns(p);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setIsNull(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::setIsNull);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle != nullptr) {
+        auto p = *handle;
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            if (v->sqlind != nullptr)
+                *v->sqlind = -1;
+            else
+                throwDataConversionError(env, index);
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_getScale(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getScale);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle != nullptr) {
+        auto p = *handle;
+        if (index >= 0 && index < p->sqld) {
+            return p->sqlvar[index].sqlscale;
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getType(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getType);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle != nullptr) {
+        auto p = *handle;
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            switch (v->sqltype & ~1) {
+                case SQL_SHORT: return 0;
+                case SQL_LONG : return 1;
+                case SQL_QUAD :
+                case SQL_INT64: return 2;
+                case SQL_FLOAT: return 3;
+                case SQL_D_FLOAT:
+                case SQL_DOUBLE: return 4;
+                case SQL_TEXT:
+                case SQL_VARYING:
+                    if (v->sqlsubtype != 0)
+                        return 5;
+                    else
+                        return 6;
+                case SQL_INT128:
+                    return 7;
+                case SQL_BOOLEAN:
+                    return 8;
+                case SQL_TYPE_DATE:
+                    return 9;
+                case SQL_TYPE_TIME:
+                    return 10;
+                case SQL_TIMESTAMP:
+                    return 11;
+                case SQL_TIME_TZ:
+                case SQL_TIME_TZ_EX:
+                    return 12;
+                case SQL_TIMESTAMP_TZ:
+                case SQL_TIMESTAMP_TZ_EX:
+                    return 13;
+                case SQL_BLOB:
+                    return v->sqlsubtype == 1?15:14;
+                case SQL_ARRAY:
+                    return 16;
+                default:
+                    return -1;
+            }
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+    return 0;
+}
+
+jstring getName(JNIEnv *env, jlong sqlda, jint index, int kind) {
+    char data[33] = {0};
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle != nullptr) {
+        auto p = *handle;
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            switch (kind) {
+                case 0:
+                    memcpy(data, v->sqlname, v->sqlname_length);
+                    data[v->sqlname_length] = 0;
+                    break;
+                case 1:
+                    memcpy(data, v->relname, v->relname_length);
+                    data[v->relname_length] = 0;
+                    break;
+                case 2:
+                    memcpy(data, v->ownname, v->ownname_length);
+                    data[v->ownname_length] = 0;
+                    break;
+                case 3:
+                    memcpy(data, v->aliasname, v->aliasname_length);
+                    data[v->aliasname_length] = 0;
+                    break;
+                default:
+                    // nop
+                    break;
+            }
+            return env->NewStringUTF(data);
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+    return nullptr;
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_progdigy_fbclient_API_getName(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getName);
+    return getName(env, sqlda, index, 0);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_progdigy_fbclient_API_getRelation(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getRelation);
+    return getName(env, sqlda, index, 1);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_progdigy_fbclient_API_getOwner(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getOwner);
+    return getName(env, sqlda, index, 2);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_progdigy_fbclient_API_getAlias(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getAlias);
+    return getName(env, sqlda, index, 3);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getCount(JNIEnv *env, jclass clazz, jlong sqlda) {
+    JniScope scope(JniCall::getCount);
+    char data[33] = {0};
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle != nullptr) {
+        auto p = *handle;
+        return p->sqld;
+    } else
+        throwHandleError(env);
+    return 0;
+}
+
+inline void setValueBoolean(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jboolean value) {
+    checkCore(env, index, fbcore_set_boolean(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueBoolean(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jboolean value) {
+    JniScope scope(JniCall::setValueBoolean);
+    setFieldValue<jboolean, setValueBoolean>(env, sqlda, index, value);
+}
+
+inline void setValueShort(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jshort value) {
+    checkCore(env, index, fbcore_set_short(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueShort(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jshort value) {
+    JniScope scope(JniCall::setValueShort);
+    setFieldValue<jshort , setValueShort>(env, sqlda, index, value);
+}
+
+inline void setValueInt(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
+    checkCore(env, index, fbcore_set_int(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueInt(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
+    JniScope scope(JniCall::setValueInt);
+    setFieldValue<jint, setValueInt>(env, sqlda, index, value);
+}
+
+inline void setValueLong(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jlong value) {
+    checkCore(env, index, fbcore_set_long(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueLong(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jlong value) {
+    JniScope scope(JniCall::setValueLong);
+    setFieldValue<jlong, setValueLong>(env, sqlda, index, value);
+}
+
+/**
+ * @brief Sets UTF-8 text into a column: UTF8 CHAR or VARCHAR holding length characters, or a text blob.
+ *
+ * @param length The number of UTF-16 characters of the text, as returned by GetStringLength.
+ * @return False when the value is not set, an exception is pending then.
+ */
+static bool setValueText(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle, int index,
+                         ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype, const char* text, int size,
+                         jsize length) {
+    switch (code) {
+        case SQL_VARYING:
+        case SQL_TEXT:
+            if (subtype != 4)
+                break;
+            if (length > len / 4) {
+                throwStringTruncation(env, index);
+                return false;
+            }
+            fbcore_set_bytes(data, code, len, text, size, ' ');
+            return true;
+        case SQL_BLOB: {
+            if (subtype != 1)
+                break;
+            isc_blob_handle blob = 0;
+            auto ret = create_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
+            if (ret == 0) {
+                fbcore_blob_write(status, &blob, text, size, put_segment);
+                ret = close_blob(status, &blob);
+            }
+            return checkStatus(env, status, ret) == 0;
+        }
+        default:
+            break;
+    }
+    throwDataConversionError(env, index);
+    return false;
+}
+
+inline void setValueString(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                           int index, ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype, jstring value) {
+    auto str = env->GetStringUTFChars(value, nullptr);
+    setValueText(env, status, dbHandle, trHandle, index, data, code, len, subtype, str, (int)strlen(str),
+                 env->GetStringLength(value));
+    env->ReleaseStringUTFChars(value, str);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueString(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                              jlong sqlda, jint index, jstring value) {
+    JniScope scope(JniCall::setValueString);
+    setFieldValue<jstring, setValueString>(env, status, db_handle, tr_handle, sqlda, index, value);
+}
+
+/**
+ * @brief Sets raw bytes into a column: CHAR or VARCHAR, padded with spaces unless binary, or a blob, see setValueText.
+ */
+static bool setValueBytes(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle, int index,
+                          ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype, const char* bytes, int size) {
+    switch (code) {
+        case SQL_VARYING:
+        case SQL_TEXT:
+            if (size > len) {
+                throwStringTruncation(env, index);
+                return false;
+            }
+            fbcore_set_bytes(data, code, len, bytes, size, subtype > 0 ? ' ' : 0);
+            return true;
+        case SQL_BLOB: {
+            isc_blob_handle blob = 0;
+            auto ret = create_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
+            if (ret == 0) {
+                fbcore_blob_write(status, &blob, bytes, size, put_segment);
+                ret = close_blob(status, &blob);
+            }
+            return checkStatus(env, status, ret) == 0;
+        }
+        default:
+            throwDataConversionError(env, index);
+            return false;
+    }
+}
+
+inline void setValueByteArray(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                              int index, ISC_SCHAR* data,  ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype, jbyteArray value) {
+    auto size = env->GetArrayLength(value);
+    auto bytes = env->GetByteArrayElements(value, nullptr);
+    setValueBytes(env, status, dbHandle, trHandle, index, data, code, len, subtype, (const char*)bytes, size);
+    env->ReleaseByteArrayElements(value, bytes, JNI_ABORT);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueByteArray(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                                 jlong sqlda, jint index, jbyteArray value) {
+    JniScope scope(JniCall::setValueByteArray);
+    setFieldValue<jbyteArray, setValueByteArray>(env, status, db_handle, tr_handle, sqlda, index, value);
+}
+
+inline void setValueFloat(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jfloat value) {
+    checkCore(env, index, fbcore_set_float(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueFloat(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jfloat value) {
+    JniScope scope(JniCall::setValueFloat);
+    setFieldValue<jfloat, setValueFloat>(env, sqlda, index, value);
+}
+
+inline void setValueDouble(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jdouble value) {
+    checkCore(env, index, fbcore_set_double(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueDouble(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jdouble value) {
+    JniScope scope(JniCall::setValueDouble);
+    setFieldValue<jdouble, setValueDouble>(env, sqlda, index, value);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueInt128(JNIEnv *env, jclass clazz, jlong sqlda, jint index,
+                                              jlong a, jlong b) {
+    JniScope scope(JniCall::setValueInt128);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle != nullptr) {
+        auto p = *handle;
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            if (v->sqlind != nullptr)
+                *v->sqlind = 0;
+            checkCore(env, index, fbcore_set_int128(v->sqldata, v->sqltype & ~1, a, b));
+        } else
+            throwOutOfBoundError(env, index);
+    } else
+        throwHandleError(env);
+}
+
+inline void setValueDate(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
+    checkCore(env, index, fbcore_set_date(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueDate(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
+    JniScope scope(JniCall::setValueDate);
+    setFieldValue<jint, setValueDate>(env, sqlda, index, value);
+}
+
+inline void setValueTime(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
+    checkCore(env, index, fbcore_set_time(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueTime(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
+    JniScope scope(JniCall::setValueTime);
+    setFieldValue<jint, setValueTime>(env, sqlda, index, value);
+}
+
+inline void setValueTimeZone(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
+    checkCore(env, index, fbcore_set_time_zone(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueTimeZone(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
+    JniScope scope(JniCall::setValueTimeZone);
+    setFieldValue<jint, setValueTimeZone>(env, sqlda, index, value);
+}
+
+static char* directBuffer(JNIEnv* env, jobject buffer, size_t& capacity) {
+    auto address = (char*)env->GetDirectBufferAddress(buffer);
+    auto size = env->GetDirectBufferCapacity(buffer);
+    if (address == nullptr || size < 0) {
+        throwHandleError(env);
+        return nullptr;
+    }
+    capacity = (size_t)size;
+    return address;
+}
+
+/*
+ * Packed parameters
+ *
+ * bindPacked sets the parameters of an input XSQLDA from a buffer written by PackedParams, in one call instead of one
+ * call per parameter. A packed row holds an entry per parameter, from the first one, in the native byte order: a tag
+ * byte followed by the value, a 4 byte length then the bytes for PACKED_STRING (UTF-8) and PACKED_BYTES. Values go
+ * through the conversions of the setValue* functions and fail with the same errors.
+ */
+
+constexpr int PACKED_NULL = 0;
+constexpr int PACKED_BOOLEAN = 1;
+constexpr int PACKED_SHORT = 2;
+constexpr int PACKED_INT = 3;
+constexpr int PACKED_LONG = 4;
+constexpr int PACKED_FLOAT = 5;
+constexpr int PACKED_DOUBLE = 6;
+constexpr int PACKED_STRING = 7;
+constexpr int PACKED_BYTES = 8;
+// low then high 64 bits
+constexpr int PACKED_INT128 = 9;
+// days since 1970-01-01
+constexpr int PACKED_DATE = 10;
+// milliseconds of the day
+constexpr int PACKED_TIME = 11;
+// days then milliseconds
+constexpr int PACKED_TIMESTAMP = 12;
+// days, milliseconds then time zone id
+constexpr int PACKED_TIMESTAMP_TZ = 13;
+constexpr int PACKED_BLOB_ID = 14;
+// leaves the parameter unchanged
+constexpr int PACKED_SKIP = 15;
+
+// the number of UTF-16 characters of UTF-8 text, as GetStringLength counts them
+static jsize utf16Length(const char* text, size_t size) {
+    jsize length = 0;
+    for (size_t i = 0; i < size; i++) {
+        auto c = (unsigned char)text[i];
+        if ((c & 0xC0) != 0x80)
+            length += c >= 0xF0 ? 2 : 1;
+    }
+    return length;
+}
+
+template<typename T>
+inline bool readPacked(const char*& p, const char* end, T& value) {
+    if ((size_t)(end - p) < sizeof(T))
+        return false;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+/**
+ * @brief Binds the entries of a packed row to the parameters of an XSQLDA, until every parameter is bound or the
+ * buffer ends.
+ *
+ * @param p The start of the row, moved after the entries read.
+ * @param base The start of the buffer, for the offsets of the errors.
+ * @param whole True when the row must hold an entry per parameter, a buffer ending before is malformed then.
+ * @return False when an entry is malformed or a value is not set, an exception is pending then.
+ */
+static bool bindPackedRow(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                          XSQLDA* sqlda, const char*& p, const char* end, const char* base, bool whole) {
+    int i = 0;
+    for (; i < sqlda->sqld && p < end; i++) {
+        auto entry = p;
+        auto tag = (unsigned char)*p++;
+        auto v = &sqlda->sqlvar[i];
+        auto data = v->sqldata;
+        auto code = (ISC_SHORT)(v->sqltype & ~1);
+        auto ret = FBCORE_OK;
+        bool read = true;
+        switch (tag) {
+            case PACKED_NULL:
+                if (v->sqlind == nullptr) {
+                    throwDataConversionError(env, i);
+                    return false;
+                }
+                *v->sqlind = -1;
+                continue;
+            case PACKED_SKIP:
+                continue;
+            case PACKED_BOOLEAN: {
+                jboolean value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_boolean(data, code, value);
+                break;
+            }
+            case PACKED_SHORT: {
+                jshort value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_short(data, code, value);
+                break;
+            }
+            case PACKED_INT: {
+                jint value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_int(data, code, value);
+                break;
+            }
+            case PACKED_LONG: {
+                jlong value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_long(data, code, value);
+                break;
+            }
+            case PACKED_FLOAT: {
+                jfloat value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_float(data, code, value);
+                break;
+            }
+            case PACKED_DOUBLE: {
+                jdouble value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_double(data, code, value);
+                break;
+            }
+            case PACKED_STRING:
+            case PACKED_BYTES: {
+                jint size;
+                if (!(read = readPacked(p, end, size) && size >= 0 && size <= end - p))
+                    break;
+                auto value = p;
+                p += size;
+                auto set = tag == PACKED_STRING
+                    ? setValueText(env, status, dbHandle, trHandle, i, data, code, v->sqllen, v->sqlsubtype, value, size,
+                                   utf16Length(value, (size_t)size))
+                    : setValueBytes(env, status, dbHandle, trHandle, i, data, code, v->sqllen, v->sqlsubtype, value,
+                                    size);
+                if (!set)
+                    return false;
+                break;
+            }
+            case PACKED_INT128: {
+                jlong low, high;
+                if ((read = readPacked(p, end, low) && readPacked(p, end, high)))
+                    ret = fbcore_set_int128(data, code, low, high);
+                break;
+            }
+            case PACKED_DATE: {
+                jint value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_date(data, code, value);
+                break;
+            }
+            case PACKED_TIME: {
+                jint value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_time(data, code, value);
+                break;
+            }
+            case PACKED_TIMESTAMP:
+            case PACKED_TIMESTAMP_TZ: {
+                jint days, millis, zone = 0;
+                if ((read = readPacked(p, end, days) && readPacked(p, end, millis) &&
+                            (tag == PACKED_TIMESTAMP || readPacked(p, end, zone)))) {
+                    ret = fbcore_set_date(data, code, days);
+                    if (ret == FBCORE_OK)
+                        ret = fbcore_set_time(data, code, millis);
+                    if (ret == FBCORE_OK && tag == PACKED_TIMESTAMP_TZ)
+                        ret = fbcore_set_time_zone(data, code, zone);
+                }
+                break;
+            }
+            case PACKED_BLOB_ID: {
+                jlong value;
+                if ((read = readPacked(p, end, value)))
+                    ret = fbcore_set_blob_id(data, code, value);
+                break;
+            }
+            default:
+                read = false;
+                break;
+        }
+        if (!read) {
+            throwRecordError(env, entry - base, -1);
+            return false;
+        }
+        if (!checkCore(env, i, ret))
+            return false;
+        if (v->sqlind != nullptr)
+            *v->sqlind = 0;
+    }
+    if (whole && i < sqlda->sqld) {
+        throwRecordError(env, p - base, -1);
+        return false;
+    }
+    return true;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_bindPacked(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                          jlong sqlda, jobject buffer, jint position, jint length) {
+    JniScope scope(JniCall::bindPacked);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return -1;
+    }
+    size_t capacity = 0;
+    auto address = directBuffer(env, buffer, capacity);
+    if (address == nullptr)
+        return -1;
+    if (position < 0 || length < 0 || (size_t)position + (size_t)length > capacity) {
+        throwOutOfBoundError(env, position);
+        return -1;
+    }
+    const char* p = address + position;
+    if (!bindPackedRow(env, reinterpret_cast<ISC_STATUS*>(status), reinterpret_cast<FB_API_HANDLE*>(db_handle),
+                       reinterpret_cast<FB_API_HANDLE*>(tr_handle), *handle, p, p + length, address, false))
+        return -1;
+    return (jint)(p - address);
+}
+
+#define EXECUTE_CONTINUE 1 // rows failing to execute are reported and skipped instead of ending the loop
+
+// executes the statement once per packed row of sqld entries; the status vector keeps the error of the last row that
+// failed, a row that does not bind or ends early ends the loop with an exception pending
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_executeMany(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                           jlong st_handle, jshort dialect, jlong sqlda, jobject buffer, jint position,
+                                           jint length, jint count, jint options, jlongArray codes,
+                                           jlongArray affected) {
+    JniScope scope(JniCall::executeMany);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return -1;
+    }
+    size_t capacity = 0;
+    auto address = directBuffer(env, buffer, capacity);
+    if (address == nullptr)
+        return -1;
+    if (position < 0 || length < 0 || (size_t)position + (size_t)length > capacity) {
+        throwOutOfBoundError(env, position);
+        return -1;
+    }
+    count = std::max(count, 0);
+    if ((codes != nullptr && env->GetArrayLength(codes) < count) ||
+        (affected != nullptr && env->GetArrayLength(affected) < count)) {
+        throwOutOfBoundError(env, count - 1);
+        return -1;
+    }
+    auto keepGoing = (options & EXECUTE_CONTINUE) != 0;
+    auto da = *handle;
+    auto rowCodes = codes != nullptr ? env->GetLongArrayElements(codes, nullptr) : nullptr;
+    auto rowCounts = affected != nullptr ? env->GetLongArrayElements(affected, nullptr) : nullptr;
+    statusArray[0] = isc_arg_gds;
+    statusArray[1] = 0;
+    statusArray[2] = isc_arg_end;
+
+    slowQueryReleased(stHandle, false);
+
+    const char* p = address + position;
+    const char* end = p + length;
+    jint row = 0;
+    while (row < count) {
+        if (!bindPackedRow(env, statusArray, dbHandle, trHandle, da, p, end, address, true)) {
+            row = -1;
+            break;
+        }
+        // a failure is kept in the status vector, the next rows would clear it
+        ISC_STATUS_ARRAY rowStatus;
+        auto start = slowQueryThreshold.load(std::memory_order_relaxed) != 0 ? nanoTime() : 0;
+        auto ret = dsql_execute(rowStatus, trHandle, stHandle, (unsigned short)dialect, da);
+        // each row is a completed execution, captured with its own record counts
+        if (start != 0 && ret == 0)
+            slowQueryExecuted(stHandle, da, nanoTime() - start, false);
+        if (rowCodes != nullptr)
+            rowCodes[row] = ret;
+        if (rowCounts != nullptr) {
+            ISC_INT64 records[4];
+            rowCounts[row] = ret == 0 && statementRecords(stHandle, records) ? records[1] + records[2] + records[3]
+                                                                              : -1;
+        }
+        row++;
+        if (ret != 0) {
+            memcpy(statusArray, rowStatus, sizeof(rowStatus));
+            if (!keepGoing)
+                break;
+        }
+    }
+    if (rowCodes != nullptr)
+        env->ReleaseLongArrayElements(codes, rowCodes, 0);
+    if (rowCounts != nullptr)
+        env->ReleaseLongArrayElements(affected, rowCounts, 0);
+    return row;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_execute(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jlong st_handle, jshort dialect, jlong sqlda) {
+    JniScope scope(JniCall::execute);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto xsqlda   = reinterpret_cast<const XSQLDA **>(sqlda);
+    const auto da = xsqlda != nullptr?*xsqlda: nullptr;
+    auto start = slowQueryThreshold.load(std::memory_order_relaxed) != 0 ? nanoTime() : 0;
+    if (start != 0)
+        slowQueryReleased(stHandle, false);
+    auto ret = dsql_execute(statusArray, trHandle, stHandle, dialect, da);
+    if (start != 0 && ret == 0)
+        slowQueryExecuted(stHandle, da, nanoTime() - start, true);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_execute2(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jlong st_handle, jshort dialect, jlong input, jlong output) {
+    JniScope scope(JniCall::execute2);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto i = reinterpret_cast<const XSQLDA **>(input);
+    auto o = reinterpret_cast<const XSQLDA **>(output);
+    const auto dai = i != nullptr?*i: nullptr;
+    const auto dao = o != nullptr?*o: nullptr;
+    auto start = slowQueryThreshold.load(std::memory_order_relaxed) != 0 ? nanoTime() : 0;
+    if (start != 0)
+        slowQueryReleased(stHandle, false);
+    auto ret = dsql_execute2(statusArray, trHandle, stHandle, dialect, dai, dao);
+    if (start != 0 && ret == 0)
+        slowQueryExecuted(stHandle, dai, nanoTime() - start, false);
+    return ret;
+}
+
+static ISC_STATUS fetchRow(ISC_STATUS* statusArray, FB_API_HANDLE* stHandle, const XSQLDA* da) {
+    auto start = slowQueryThreshold.load(std::memory_order_relaxed) != 0 ? nanoTime() : 0;
+    auto ret = dsql_fetch(statusArray,  stHandle, SQLDA_VERSION1, da);
+    if (start != 0)
+        slowQueryFetched(stHandle, nanoTime() - start, ret != 0);
+    return ret;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_fetch(JNIEnv *env, jclass clazz, jlong status, jlong st_handle, jlong sqlda) {
+    JniScope scope(JniCall::fetch);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto xsqlda   = reinterpret_cast<const XSQLDA **>(sqlda);
+    const auto da = xsqlda != nullptr?*xsqlda: nullptr;
+    return fetchRow(statusArray, stHandle, da);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_progdigy_fbclient_API_getIsNull(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getIsNull);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle != nullptr) {
+        auto p = *handle;
+        if (index >= 0 && index < p->sqld) {
+            auto v = &p->sqlvar[index];
+            if (v->sqlind != nullptr)
+                return *v->sqlind!=0?JNI_TRUE:JNI_FALSE;
+            return JNI_FALSE;
+        } else
             throwOutOfBoundError(env, index);
     } else
         throwHandleError(env);
-    return 0;
+
+    return JNI_FALSE;
+}
+
+inline jboolean getValueBoolean(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    int value = 0;
+    checkCore(env, index, fbcore_get_boolean(data, code, &value));
+    return value ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_progdigy_fbclient_API_getValueBoolean(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueBoolean);
+    return getFieldValue<jboolean, getValueBoolean>(env, sqlda, index);
+}
+
+inline jshort getValueShort(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    ISC_SHORT value = 0;
+    checkCore(env, index, fbcore_get_short(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jshort JNICALL
+Java_com_progdigy_fbclient_API_getValueShort(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueShort);
+    return getFieldValue<jshort, getValueShort>(env, sqlda, index);
+}
+
+inline jint getValueInt(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    ISC_LONG value = 0;
+    checkCore(env, index, fbcore_get_int(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getValueInt(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueInt);
+    return getFieldValue<jint, getValueInt>(env, sqlda, index);
+}
+
+inline jlong getValueLong(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    ISC_INT64 value = 0;
+    checkCore(env, index, fbcore_get_long(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_getValueLong(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueLong);
+    return getFieldValue<jlong, getValueLong>(env, sqlda, index);
+}
+
+inline jstring getValueString(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                              int index, ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype) {
+    switch (code) {
+        case SQL_VARYING:
+        case SQL_TEXT:
+            if (subtype == 4)
+                return env->NewStringUTF(fbcore_get_text(data, code, len, subtype));
+            break;
+        case SQL_BLOB:
+            if (subtype == 1) {
+                isc_blob_handle blob = 0;
+                char* str = nullptr;
+                auto ret = open_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
+                if (ret == 0) {
+                    ISC_LONG length = 0;
+                    ret = fbcore_blob_length(status, &blob, &length, blob_info);
+                    if (ret == 0 && length >= 0) {
+                        str = (char*)malloc(length + 1);
+                        str[fbcore_blob_read(status, &blob, str, length, get_segment)] = 0;
+                    }
+                    ret = close_blob(status, &blob);
+                    if (str != nullptr) {
+                        auto jstr = env->NewStringUTF(str);
+                        free(str);
+                        return jstr;
+                    }
+                }
+                checkStatus(env, status, ret);
+            }
+            break;
+        default:
+            break;
+    }
+
+    throwDataConversionError(env, index);
+    return nullptr;
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_progdigy_fbclient_API_getValueString(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueString);
+    return getFieldValue<jstring, getValueString>(env, status, db_handle, tr_handle, sqlda, index);
+}
+
+inline jbyteArray getValueByteArray(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                                    int index, ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype) {
+    switch (code) {
+        case SQL_VARYING: {
+            auto vary = (PARAMVARY*)data;
+            auto arr = env->NewByteArray(vary->vary_length);
+            auto bytes = env->GetByteArrayElements(arr, nullptr);
+            memcpy(bytes, vary->vary_string, vary->vary_length);
+            env->ReleaseByteArrayElements(arr, bytes, JNI_COMMIT);
+            return arr;
+        }
+        case SQL_TEXT: {
+            auto arr = env->NewByteArray(len);
+            auto bytes = env->GetByteArrayElements(arr, nullptr);
+            memcpy(bytes, data, len);
+            env->ReleaseByteArrayElements(arr, bytes, JNI_COMMIT);
+            return arr;
+        }
+        case SQL_BLOB: {
+            isc_blob_handle blob = 0;
+            jbyteArray arr = nullptr;
+            auto ret = open_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
+            if (ret == 0) {
+                ISC_LONG length = 0;
+                ret = fbcore_blob_length(status, &blob, &length, blob_info);
+                if (ret == 0) {
+                    arr = env->NewByteArray(length);
+                    if (length > 0) {
+                        auto bytes = env->GetByteArrayElements(arr, nullptr);
+                        fbcore_blob_read(status, &blob, (char*)bytes, length, get_segment);
+                        env->ReleaseByteArrayElements(arr, bytes, JNI_COMMIT);
+                    }
+                }
+                ret = close_blob(status, &blob);
+            }
+            checkStatus(env, status, ret);
+            return arr;
+        }
+        default:
+            throwDataConversionError(env, index);
+            return nullptr;
+    }
+}
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_com_progdigy_fbclient_API_getValueByteArray(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueByteArray);
+    return getFieldValue<jbyteArray, getValueByteArray>(env, status, db_handle, tr_handle, sqlda, index);
+}
+
+inline jfloat getValueFloat(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    float value = 0;
+    checkCore(env, index, fbcore_get_float(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_progdigy_fbclient_API_getValueFloat(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueFloat);
+    return getFieldValue<jfloat, getValueFloat>(env, sqlda, index);
+}
+
+inline jdouble getValueDouble(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    double value = 0;
+    checkCore(env, index, fbcore_get_double(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jdouble JNICALL
+Java_com_progdigy_fbclient_API_getValueDouble(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueDouble);
+    return getFieldValue<jdouble, getValueDouble>(env, sqlda, index);
+}
+
+inline jlongArray getValueInt128(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    ISC_INT64 value[2];
+    if (!checkCore(env, index, fbcore_get_int128(data, code, value)))
+        return nullptr;
+    auto arr = env->NewLongArray(2);
+    env->SetLongArrayRegion(arr, 0, 2, (jlong*)value);
+    return arr;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_progdigy_fbclient_API_getValueInt128(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueInt128);
+    return getFieldValue<jlongArray, getValueInt128>(env, sqlda, index);
+}
+
+inline jint getValueDate(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    int value = 0;
+    checkCore(env, index, fbcore_get_date(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getValueDate(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueDate);
+    return getFieldValue<jint, getValueDate>(env, sqlda, index);
+}
+
+inline jint getValueTime(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    int value = 0;
+    checkCore(env, index, fbcore_get_time(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getValueTime(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueTime);
+    return getFieldValue<jint, getValueTime>(env, sqlda, index);
+}
+
+inline jint getValueTimeZone(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    int value = 0;
+    checkCore(env, index, fbcore_get_time_zone(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getValueTimeZone(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueTimeZone);
+    return getFieldValue<jint, getValueTimeZone>(env, sqlda, index);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_blobOpen(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                        jlong blob_handle, jlong blob_id) {
+    JniScope scope(JniCall::blobOpen);
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE *>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE *>(tr_handle);
+    auto blobHandle = reinterpret_cast<FB_API_HANDLE *>(blob_handle);
+    return open_blob(statusArray, dbHandle, trHandle, blobHandle, (GDS_QUAD*)&blob_id);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_blobClose(JNIEnv *env, jclass clazz, jlong status,
+                                         jlong blob_handle) {
+    JniScope scope(JniCall::blobClose);
+    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto blobHandle = reinterpret_cast<FB_API_HANDLE *>(blob_handle);
+    auto ret = close_blob(statusArray, blobHandle);
+    *blobHandle = 0;
+    return ret;
+}
+
+inline void setValueBlobId(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jlong value) {
+    checkCore(env, index, fbcore_set_blob_id(data, code, value));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setValueBlobId(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jlong value) {
+    JniScope scope(JniCall::setValueBlobId);
+    setFieldValue<jlong, setValueBlobId>(env, sqlda, index, value);
+}
+
+inline jlong getValueBlobId(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
+    ISC_INT64 value = 0;
+    checkCore(env, index, fbcore_get_blob_id(data, code, &value));
+    return value;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_getValueBlobId(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getValueBlobId);
+    return getFieldValue<jlong, getValueBlobId>(env, sqlda, index);
+}
+
+/*
+ * Row mappers
+ *
+ * A mapper fills instances of a class from the current row of an XSQLDA, each bound column going to a field through
+ * a cached jfieldID and the getter kernel matching the type of the field. Boxed fields take nulls, primitive fields
+ * throw the null error of the getters.
+ */
+
+enum class FieldKind { Boolean, Short, Int, Long, Float, Double, String, Bytes, Boxed };
+
+struct FieldBinding {
+    int column;
+    jfieldID field;
+    FieldKind kind;
+    // boxed fields: the primitive kind, the box class and its valueOf
+    FieldKind primitive;
+    jclass box;
+    jmethodID valueOf;
+};
+
+struct RowMapper {
+    jclass type;
+    jmethodID constructor;
+    std::vector<FieldBinding> fields;
+};
+
+static bool primitiveKind(char signature, FieldKind& kind) {
+    switch (signature) {
+        case 'Z': kind = FieldKind::Boolean; return true;
+        case 'S': kind = FieldKind::Short; return true;
+        case 'I': kind = FieldKind::Int; return true;
+        case 'J': kind = FieldKind::Long; return true;
+        case 'F': kind = FieldKind::Float; return true;
+        case 'D': kind = FieldKind::Double; return true;
+        default: return false;
+    }
+}
+
+static bool bindField(JNIEnv* env, FieldBinding& binding, const char* signature) {
+    static const struct { const char* box; char primitive; } boxes[] = {
+        {"java/lang/Boolean", 'Z'}, {"java/lang/Short", 'S'}, {"java/lang/Integer", 'I'},
+        {"java/lang/Long", 'J'}, {"java/lang/Float", 'F'}, {"java/lang/Double", 'D'}};
+    if (signature[0] != 0 && signature[1] == 0 && primitiveKind(signature[0], binding.kind))
+        return true;
+    if (strcmp(signature, "Ljava/lang/String;") == 0) {
+        binding.kind = FieldKind::String;
+        return true;
+    }
+    if (strcmp(signature, "[B") == 0) {
+        binding.kind = FieldKind::Bytes;
+        return true;
+    }
+    for (auto& box : boxes) {
+        auto length = strlen(box.box);
+        if (signature[0] == 'L' && strncmp(signature + 1, box.box, length) == 0 && strcmp(signature + 1 + length, ";") == 0) {
+            auto boxClass = env->FindClass(box.box);
+            if (boxClass == nullptr)
+                return false;
+            char valueOf[] = "(X)Ljava/lang/";
+            valueOf[1] = box.primitive;
+            auto method = env->GetStaticMethodID(boxClass, "valueOf", (std::string(valueOf) + (box.box + 10) + ";").c_str());
+            if (method == nullptr)
+                return false;
+            binding.kind = FieldKind::Boxed;
+            primitiveKind(box.primitive, binding.primitive);
+            binding.box = (jclass)env->NewGlobalRef(boxClass);
+            binding.valueOf = method;
+            env->DeleteLocalRef(boxClass);
+            return true;
+        }
+    }
+    throwDataConversionError(env, binding.column);
+    return false;
+}
+
+static void freeRowMapper(JNIEnv* env, RowMapper* mapper) {
+    for (auto& binding : mapper->fields)
+        if (binding.box != nullptr)
+            env->DeleteGlobalRef(binding.box);
+    env->DeleteGlobalRef(mapper->type);
+    delete mapper;
+}
+
+static jobject boxValue(JNIEnv* env, const FieldBinding& binding, jlong sqlda) {
+    jvalue value;
+    switch (binding.primitive) {
+        case FieldKind::Boolean: value.z = getFieldValue<jboolean, getValueBoolean>(env, sqlda, binding.column); break;
+        case FieldKind::Short: value.s = getFieldValue<jshort, getValueShort>(env, sqlda, binding.column); break;
+        case FieldKind::Int: value.i = getFieldValue<jint, getValueInt>(env, sqlda, binding.column); break;
+        case FieldKind::Long: value.j = getFieldValue<jlong, getValueLong>(env, sqlda, binding.column); break;
+        case FieldKind::Float: value.f = getFieldValue<jfloat, getValueFloat>(env, sqlda, binding.column); break;
+        default: value.d = getFieldValue<jdouble, getValueDouble>(env, sqlda, binding.column); break;
+    }
+    if (env->ExceptionCheck())
+        return nullptr;
+    return env->CallStaticObjectMethodA(binding.box, binding.valueOf, &value);
+}
+
+static bool isNullColumn(XSQLDA* sqlda, int index) {
+    if (index < 0 || index >= sqlda->sqld)
+        return false; // the getter reports the index
+    auto ind = columnPlans(sqlda)[index].ind;
+    return ind != nullptr && *ind != 0;
+}
+
+static jobject mapRow(JNIEnv* env, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, const RowMapper* mapper) {
+    auto p = *reinterpret_cast<XSQLDA **>(sqlda);
+    auto object = mapper->constructor != nullptr ? env->NewObject(mapper->type, mapper->constructor)
+                                                 : env->AllocObject(mapper->type);
+    if (object == nullptr)
+        return nullptr;
+    for (auto& binding : mapper->fields) {
+        auto column = binding.column;
+        if (binding.kind >= FieldKind::String && isNullColumn(p, column)) {
+            env->SetObjectField(object, binding.field, nullptr);
+            continue;
+        }
+        switch (binding.kind) {
+            case FieldKind::Boolean:
+                env->SetBooleanField(object, binding.field, getFieldValue<jboolean, getValueBoolean>(env, sqlda, column));
+                break;
+            case FieldKind::Short:
+                env->SetShortField(object, binding.field, getFieldValue<jshort, getValueShort>(env, sqlda, column));
+                break;
+            case FieldKind::Int:
+                env->SetIntField(object, binding.field, getFieldValue<jint, getValueInt>(env, sqlda, column));
+                break;
+            case FieldKind::Long:
+                env->SetLongField(object, binding.field, getFieldValue<jlong, getValueLong>(env, sqlda, column));
+                break;
+            case FieldKind::Float:
+                env->SetFloatField(object, binding.field, getFieldValue<jfloat, getValueFloat>(env, sqlda, column));
+                break;
+            case FieldKind::Double:
+                env->SetDoubleField(object, binding.field, getFieldValue<jdouble, getValueDouble>(env, sqlda, column));
+                break;
+            case FieldKind::String:
+            case FieldKind::Bytes:
+            case FieldKind::Boxed: {
+                jobject value;
+                if (binding.kind == FieldKind::String)
+                    value = getFieldValue<jstring, getValueString>(env, status, db_handle, tr_handle, sqlda, column);
+                else if (binding.kind == FieldKind::Bytes)
+                    value = getFieldValue<jbyteArray, getValueByteArray>(env, status, db_handle, tr_handle, sqlda, column);
+                else
+                    value = boxValue(env, binding, sqlda);
+                if (value != nullptr) {
+                    env->SetObjectField(object, binding.field, value);
+                    env->DeleteLocalRef(value);
+                }
+                break;
+            }
+        }
+        if (env->ExceptionCheck()) {
+            env->DeleteLocalRef(object);
+            return nullptr;
+        }
+    }
+    return object;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_createRowMapper(JNIEnv *env, jclass clazz, jclass type, jintArray columns,
+                                               jobjectArray names, jobjectArray signatures) {
+    auto mapper = new RowMapper{(jclass)env->NewGlobalRef(type), nullptr, {}};
+    mapper->constructor = env->GetMethodID(type, "<init>", "()V");
+    if (mapper->constructor == nullptr)
+        env->ExceptionClear(); // no default constructor, instances are allocated without running one
+    auto count = env->GetArrayLength(columns);
+    auto indexes = env->GetIntArrayElements(columns, nullptr);
+    mapper->fields.reserve(count);
+    for (jsize i = 0; i < count; i++) {
+        auto name = (jstring)env->GetObjectArrayElement(names, i);
+        auto signature = (jstring)env->GetObjectArrayElement(signatures, i);
+        auto nameChars = env->GetStringUTFChars(name, nullptr);
+        auto signatureChars = env->GetStringUTFChars(signature, nullptr);
+        FieldBinding binding = {indexes[i], env->GetFieldID(type, nameChars, signatureChars), FieldKind::Int,
+                                FieldKind::Int, nullptr, nullptr};
+        auto bound = binding.field != nullptr && bindField(env, binding, signatureChars);
+        env->ReleaseStringUTFChars(signature, signatureChars);
+        env->ReleaseStringUTFChars(name, nameChars);
+        env->DeleteLocalRef(signature);
+        env->DeleteLocalRef(name);
+        if (!bound) {
+            env->ReleaseIntArrayElements(columns, indexes, JNI_ABORT);
+            freeRowMapper(env, mapper);
+            return 0;
+        }
+        mapper->fields.push_back(binding);
+    }
+    env->ReleaseIntArrayElements(columns, indexes, JNI_ABORT);
+    return reinterpret_cast<jlong>(mapper);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_freeRowMapper(JNIEnv *env, jclass clazz, jlong mapper) {
+    if (mapper != 0)
+        freeRowMapper(env, reinterpret_cast<RowMapper*>(mapper));
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_progdigy_fbclient_API_mapRow(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                      jlong sqlda, jlong mapper) {
+    JniScope scope(JniCall::mapRow);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr || mapper == 0) {
+        throwHandleError(env);
+        return nullptr;
+    }
+    return mapRow(env, status, db_handle, tr_handle, sqlda, reinterpret_cast<RowMapper*>(mapper));
 }
 
-jstring getName(JNIEnv *env, jlong sqlda, jint index, int kind) {
-    char data[33] = {0};
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_progdigy_fbclient_API_mapRows(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                       jlong st_handle, jlong sqlda, jlong mapper, jint count) {
+    JniScope scope(JniCall::mapRows);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
     auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    if (handle != nullptr) {
-        auto p = *handle;
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            switch (kind) {
-                case 0:
-                    memcpy(data, v->sqlname, v->sqlname_length);
-                    data[v->sqlname_length] = 0;
-                    break;
-                case 1:
-                    memcpy(data, v->relname, v->relname_length);
-                    data[v->relname_length] = 0;
-                    break;
-                case 2:
-                    memcpy(data, v->ownname, v->ownname_length);
-                    data[v->ownname_length] = 0;
-                    break;
-                case 3:
-                    memcpy(data, v->aliasname, v->aliasname_length);
-                    data[v->aliasname_length] = 0;
-                    break;
-                default:
-                    // nop
-                    break;
-            }
-            return env->NewStringUTF(data);
-        } else
-            throwOutOfBoundError(env, index);
-    } else
+    if (handle == nullptr || *handle == nullptr || mapper == 0 || count < 0) {
         throwHandleError(env);
-    return nullptr;
+        return nullptr;
+    }
+    auto rowMapper = reinterpret_cast<RowMapper*>(mapper);
+    auto rows = env->NewObjectArray(count, rowMapper->type, nullptr);
+    if (rows == nullptr)
+        return nullptr;
+    jsize fetched = 0;
+    while (fetched < count) {
+        auto ret = fetchRow(statusArray, stHandle, *handle);
+        if (ret != 0) {
+            checkStatus(env, statusArray, ret == 100 ? 0 : ret);
+            if (env->ExceptionCheck())
+                return nullptr;
+            break;
+        }
+        auto object = mapRow(env, status, db_handle, tr_handle, sqlda, rowMapper);
+        if (object == nullptr)
+            return nullptr;
+        env->SetObjectArrayElement(rows, fetched++, object);
+        env->DeleteLocalRef(object);
+    }
+    if (fetched == count)
+        return rows;
+    // the cursor is exhausted, the last batch is shorter
+    auto last = env->NewObjectArray(fetched, rowMapper->type, nullptr);
+    for (jsize i = 0; last != nullptr && i < fetched; i++) {
+        auto object = env->GetObjectArrayElement(rows, i);
+        env->SetObjectArrayElement(last, i, object);
+        env->DeleteLocalRef(object);
+    }
+    return last;
+}
+
+/*
+ * JSON rows
+ *
+ * Rows are written as JSON objects keyed by column alias straight from the XSQLDA into the memory of a direct
+ * ByteBuffer. A row is written whole or not at all: when it does not fit, the position is left where the row started.
+ */
+
+#define JSON_BLOB_TEXT 1 // text blobs are read and inlined as strings, other blobs are written as their id
+#define JSON_LINES     2 // each row is followed by a new line instead of rows being separated by commas
+#define JSON_CONTINUE  4 // the first row is preceded by a comma, continuing an array written by a previous call
+
+class JsonWriter {
+public:
+    JsonWriter(char* buffer, size_t position, size_t capacity) : buffer(buffer), position(position), capacity(capacity) {}
+
+    // room for size more bytes
+    bool reserve(size_t size) const {
+        return capacity - position >= size;
+    }
+
+    bool put(char c) {
+        if (!reserve(1))
+            return false;
+        buffer[position++] = c;
+        return true;
+    }
+
+    bool put(const char* text, size_t length) {
+        if (!reserve(length))
+            return false;
+        memcpy(buffer + position, text, length);
+        position += length;
+        return true;
+    }
+
+    bool string(const char* text, size_t length) {
+        // the worst case is 6 bytes per byte, measure the escaped text only when that does not fit
+        if (!reserve(6 * length + 2) && !reserve(escapedSize(text, length)))
+            return false;
+        position += fbcore_json_string(buffer + position, text, length);
+        return true;
+    }
+
+    bool base64(const unsigned char* data, size_t length) {
+        if (!reserve(4 * ((length + 2) / 3) + 2))
+            return false;
+        position += fbcore_json_base64(buffer + position, data, length);
+        return true;
+    }
+
+    char* buffer;
+    size_t position;
+    size_t capacity;
+
+private:
+    static size_t escapedSize(const char* text, size_t length) {
+        size_t size = length + 2;
+        for (size_t i = 0; i < length; i++) {
+            auto c = (unsigned char)text[i];
+            if (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t' || c == '\b' || c == '\f')
+                size += 1;
+            else if (c < 0x20)
+                size += 5;
+        }
+        return size;
+    }
+};
+
+enum class JsonResult { Written, Full, Failed };
+
+static JsonResult writeJsonBlobText(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                                    ISC_SCHAR* data, JsonWriter& writer) {
+    isc_blob_handle blob = 0;
+    char* text = nullptr;
+    ISC_LONG length = 0;
+    auto ret = open_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
+    if (ret == 0) {
+        ret = fbcore_blob_length(status, &blob, &length, blob_info);
+        if (ret == 0 && length >= 0) {
+            text = (char*)malloc(length > 0 ? length : 1);
+            length = fbcore_blob_read(status, &blob, text, length, get_segment);
+        }
+        auto closed = close_blob(status, &blob);
+        if (ret == 0)
+            ret = closed;
+    }
+    if (ret != 0) {
+        free(text);
+        checkStatus(env, status, ret);
+        return JsonResult::Failed;
+    }
+    auto written = writer.string(text, (size_t)length);
+    free(text);
+    return written ? JsonResult::Written : JsonResult::Full;
+}
+
+static JsonResult writeJsonColumn(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                                  int index, XSQLVAR* v, JsonWriter& writer, int options) {
+    auto code = v->sqltype & ~1;
+    int scale = v->sqlscale;
+    if (v->sqlind != nullptr && *v->sqlind != 0)
+        return writer.put("null", 4) ? JsonResult::Written : JsonResult::Full;
+    switch (code) {
+        case SQL_VARYING: {
+            auto vary = (PARAMVARY*)v->sqldata;
+            auto written = v->sqlsubtype == 1 ? writer.base64(vary->vary_string, vary->vary_length)
+                                              : writer.string((const char*)vary->vary_string, vary->vary_length);
+            return written ? JsonResult::Written : JsonResult::Full;
+        }
+        case SQL_TEXT: {
+            bool written;
+            if (v->sqlsubtype == 1)
+                written = writer.base64((const unsigned char*)v->sqldata, (size_t)v->sqllen);
+            else {
+                // the column length is in bytes, CHAR padding beyond the character length is dropped
+                auto size = v->sqlsubtype == 4 ? fbcore_utf8_size(v->sqldata, v->sqllen / 4, v->sqllen) : (size_t)v->sqllen;
+                written = writer.string(v->sqldata, size);
+            }
+            return written ? JsonResult::Written : JsonResult::Full;
+        }
+        case SQL_BLOB:
+            if (v->sqlsubtype == 1 && (options & JSON_BLOB_TEXT) != 0)
+                return writeJsonBlobText(env, status, dbHandle, trHandle, v->sqldata, writer);
+            code = SQL_INT64; // the blob id
+            scale = 0;
+            break;
+        case SQL_FLOAT:
+        case SQL_DOUBLE:
+        case SQL_D_FLOAT: {
+            char text[FBCORE_FORMAT_SIZE];
+            auto length = fbcore_format_scalar(text, v->sqldata, code, 0);
+            // JSON has no NaN nor infinity
+            auto written = length < 0 ? writer.put("null", 4) : writer.put(text, (size_t)length);
+            return written ? JsonResult::Written : JsonResult::Full;
+        }
+        default:
+            break;
+    }
+    char text[FBCORE_FORMAT_SIZE];
+    auto length = fbcore_format_scalar(text, v->sqldata, code, scale);
+    if (length < 0) {
+        throwDataConversionError(env, index);
+        return JsonResult::Failed;
+    }
+    auto quoted = code == SQL_TYPE_DATE || code == SQL_TYPE_TIME || code == SQL_TIMESTAMP || code == SQL_TIME_TZ ||
+                  code == SQL_TIME_TZ_EX || code == SQL_TIMESTAMP_TZ || code == SQL_TIMESTAMP_TZ_EX;
+    if (!writer.reserve((size_t)length + 2))
+        return JsonResult::Full;
+    if (quoted)
+        writer.put('"');
+    writer.put(text, (size_t)length);
+    if (quoted)
+        writer.put('"');
+    return JsonResult::Written;
 }
 
-extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_progdigy_fbclient_API_getName(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getName(env, sqlda, index, 0);
+static JsonResult writeJsonRow(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                               XSQLDA* sqlda, JsonWriter& writer, int options, bool separate) {
+    auto start = writer.position;
+    auto result = JsonResult::Full;
+    if ((!separate || writer.put(',')) && writer.put('{')) {
+        result = JsonResult::Written;
+        for (int i = 0; i < sqlda->sqld && result == JsonResult::Written; i++) {
+            auto v = &sqlda->sqlvar[i];
+            if ((i > 0 && !writer.put(',')) || !writer.string(v->aliasname, (size_t)v->aliasname_length) || !writer.put(':'))
+                result = JsonResult::Full;
+            else
+                result = writeJsonColumn(env, status, dbHandle, trHandle, i, v, writer, options);
+        }
+        if (result == JsonResult::Written && (!writer.put('}') || ((options & JSON_LINES) != 0 && !writer.put('\n'))))
+            result = JsonResult::Full;
+    }
+    if (result != JsonResult::Written)
+        writer.position = start;
+    return result;
 }
 
 extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_progdigy_fbclient_API_getRelation(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getName(env, sqlda, index, 1);
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_writeJson(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                         jlong sqlda, jobject buffer, jint position, jint options) {
+    JniScope scope(JniCall::writeJson);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    size_t capacity = 0;
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return -1;
+    }
+    auto address = directBuffer(env, buffer, capacity);
+    if (address == nullptr)
+        return -1;
+    if (position < 0 || (size_t)position > capacity) {
+        throwOutOfBoundError(env, position);
+        return -1;
+    }
+    JsonWriter writer(address, (size_t)position, capacity);
+    auto result = writeJsonRow(env, reinterpret_cast<ISC_STATUS*>(status), reinterpret_cast<FB_API_HANDLE*>(db_handle),
+                               reinterpret_cast<FB_API_HANDLE*>(tr_handle), *handle, writer, options,
+                               (options & (JSON_CONTINUE | JSON_LINES)) == JSON_CONTINUE);
+    return result == JsonResult::Written ? (jint)writer.position : -1;
 }
 
 extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_progdigy_fbclient_API_getOwner(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getName(env, sqlda, index, 2);
+JNIEXPORT jboolean JNICALL
+Java_com_progdigy_fbclient_API_writeJsonRows(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                             jlong st_handle, jlong sqlda, jobject buffer, jintArray state, jint count,
+                                             jint options) {
+    JniScope scope(JniCall::writeJsonRows);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    size_t capacity = 0;
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return JNI_FALSE;
+    }
+    auto address = directBuffer(env, buffer, capacity);
+    if (address == nullptr)
+        return JNI_FALSE;
+    if (env->GetArrayLength(state) < 2) {
+        throwOutOfBoundError(env, 1);
+        return JNI_FALSE;
+    }
+    // released after the rows are written, which may end with an exception pending
+    auto progress = env->GetIntArrayElements(state, nullptr);
+    if (progress == nullptr)
+        return JNI_FALSE;
+    if (progress[0] < 0 || (size_t)progress[0] > capacity) {
+        auto position = progress[0];
+        env->ReleaseIntArrayElements(state, progress, JNI_ABORT);
+        throwOutOfBoundError(env, position);
+        return JNI_FALSE;
+    }
+    JsonWriter writer(address, (size_t)progress[0], capacity);
+    auto more = JNI_TRUE;
+    jint rows = 0;
+    while (rows < count) {
+        auto separate = (options & JSON_LINES) == 0 && (rows > 0 || (options & JSON_CONTINUE) != 0);
+        auto result = writeJsonRow(env, statusArray, dbHandle, trHandle, *handle, writer, options, separate);
+        if (result == JsonResult::Failed) {
+            // the rows written before the failing one are kept
+            more = JNI_FALSE;
+            break;
+        }
+        if (result == JsonResult::Full)
+            break; // the row stays current for the next call
+        rows++;
+        auto ret = fetchRow(statusArray, stHandle, *handle);
+        if (ret != 0) {
+            checkStatus(env, statusArray, ret == 100 ? 0 : ret);
+            more = JNI_FALSE;
+            break;
+        }
+    }
+    progress[0] = (jint)writer.position;
+    progress[1] = rows;
+    env->ReleaseIntArrayElements(state, progress, 0);
+    return more;
 }
 
-extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_progdigy_fbclient_API_getAlias(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getName(env, sqlda, index, 3);
+/*
+ * Delimited export
+ *
+ * Rows are formatted as CSV (RFC 4180) or TSV straight from the XSQLDA into large buffers written to a file
+ * descriptor, the JVM only gets progress counters back. With CSV_WRITER_THREAD a thread writes each full buffer while
+ * the next one is filled, so formatting overlaps the disk or pipe.
+ */
+
+#define CSV_TAB           1  // tab separated, special characters escaped with a backslash and nulls written as \N
+#define CSV_HEADER        2  // the column aliases are written first
+#define CSV_BLOB_TEXT     4  // text blobs are read and written as text, other blobs are written as their id
+#define CSV_WRITER_THREAD 8  // full buffers are written by a separate thread
+#define CSV_APPEND        16 // a file opened by path is appended to instead of truncated
+
+#ifdef _WIN32
+#define EXPORT_FLAGS (_O_WRONLY | _O_CREAT | _O_BINARY)
+#define EXPORT_OPEN(path, flags) _open(path, flags, _S_IREAD | _S_IWRITE)
+#define EXPORT_WRITE(fd, data, size) _write(fd, data, (unsigned int)(size))
+#define EXPORT_CLOSE _close
+#define EXPORT_APPEND _O_APPEND
+#define EXPORT_TRUNCATE _O_TRUNC
+#else
+#define EXPORT_FLAGS (O_WRONLY | O_CREAT)
+#define EXPORT_OPEN(path, flags) open(path, flags, 0666)
+#define EXPORT_WRITE write
+#define EXPORT_CLOSE close
+#define EXPORT_APPEND O_APPEND
+#define EXPORT_TRUNCATE O_TRUNC
+#endif
+
+// a buffer is handed to the file when it is full, values larger than a quarter of it are written in pieces
+constexpr size_t EXPORT_BUFFER_SIZE = 1 << 20;
+constexpr size_t EXPORT_CHUNK_SIZE = EXPORT_BUFFER_SIZE / 4;
+
+// only whole rows are handed to the file: the row being formatted is carried over to the next buffer, which grows
+// when a single row does not fit in it
+class ExportWriter {
+public:
+    ExportWriter(int fd, bool threaded) : fd(fd), buffers{std::vector<char>(EXPORT_BUFFER_SIZE),
+                                                          std::vector<char>(threaded ? EXPORT_BUFFER_SIZE : 0)} {
+        if (threaded)
+            writer = std::thread(&ExportWriter::run, this);
+    }
+
+    ~ExportWriter() {
+        if (writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+            writer.join();
+        }
+    }
+
+    // room for size more bytes, size is at most EXPORT_CHUNK_SIZE * 2 + 2
+    bool reserve(size_t size) {
+        if (buffers[current].size() - position >= size)
+            return true;
+        // a row starting the buffer leaves nothing to flush
+        if (row != 0 && !flush())
+            return false;
+        if (buffers[current].size() - position < size)
+            buffers[current].resize(std::max(buffers[current].size() * 2, position + size));
+        return true;
+    }
+
+    // the following bytes are a row, kept out of the file until endRow
+    void beginRow() {
+        row = position;
+    }
+
+    void endRow() {
+        row = NO_ROW;
+    }
+
+    // drops the bytes of the row being formatted
+    void rollback() {
+        if (row != NO_ROW)
+            position = row;
+        row = NO_ROW;
+    }
+
+    void put(char c) {
+        buffers[current][position++] = c;
+    }
+
+    void put(const char* text, size_t length) {
+        memcpy(buffers[current].data() + position, text, length);
+        position += length;
+    }
+
+    // the free space of the current buffer, for formatting in place
+    char* tail() {
+        return buffers[current].data() + position;
+    }
+
+    void advance(size_t length) {
+        position += length;
+    }
+
+    // an EXPORT_CHUNK_SIZE buffer for reading blobs
+    char* scratch() {
+        if (chunk.empty())
+            chunk.resize(EXPORT_CHUNK_SIZE);
+        return chunk.data();
+    }
+
+    // hands the whole rows of the current buffer to the file, false on a write error (see error)
+    bool flush() {
+        auto size = row != NO_ROW ? row : position;
+        if (size == 0)
+            return true;
+        auto carried = position - size;
+        if (!writer.joinable()) {
+            error = writeAll(buffers[0].data(), size);
+            if (error == 0)
+                bytes += size;
+            memmove(buffers[0].data(), buffers[0].data() + size, carried);
+            position = carried;
+            if (row != NO_ROW)
+                row = 0;
+            return error == 0;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return pending == 0; });
+        if (error != 0)
+            return false;
+        auto& next = buffers[current ^ 1];
+        if (next.size() < buffers[current].size())
+            next.resize(buffers[current].size());
+        memcpy(next.data(), buffers[current].data() + size, carried);
+        bytes += size;
+        pending = size;
+        pendingIndex = current;
+        lock.unlock();
+        changed.notify_all();
+        current ^= 1;
+        position = carried;
+        if (row != NO_ROW)
+            row = 0;
+        return true;
+    }
+
+    // flushes and waits for the writer thread to be done with the last buffer
+    bool finish() {
+        auto flushed = flush();
+        if (writer.joinable()) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return pending == 0; });
+        }
+        return flushed && error == 0;
+    }
+
+    int error = 0;
+    uint64_t bytes = 0;
+
+private:
+    int writeAll(const char* data, size_t size) const {
+        while (size > 0) {
+            auto written = EXPORT_WRITE(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                return errno;
+            }
+            data += written;
+            size -= (size_t)written;
+        }
+        return 0;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            changed.wait(lock, [this] { return pending != 0 || stopping; });
+            if (pending == 0)
+                return;
+            auto data = buffers[pendingIndex].data();
+            auto size = pending;
+            lock.unlock();
+            auto failed = writeAll(data, size);
+            lock.lock();
+            if (failed != 0)
+                error = failed;
+            pending = 0;
+            changed.notify_all();
+        }
+    }
+
+    static constexpr size_t NO_ROW = SIZE_MAX;
+
+    int fd;
+    std::vector<char> buffers[2];
+    int current = 0;
+    size_t position = 0;
+    size_t row = NO_ROW; // where the row being formatted starts in the current buffer
+    std::vector<char> chunk;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t pending = 0; // bytes of buffers[pendingIndex] the writer thread has to write
+    int pendingIndex = 0;
+    bool stopping = false;
+};
+
+// text as a quoted CSV field, quotes are doubled
+static bool exportCsvText(ExportWriter& writer, const char* text, size_t length, bool open, bool close) {
+    if (open) {
+        if (!writer.reserve(1))
+            return false;
+        writer.put('"');
+    }
+    while (length > 0) {
+        auto chunk = std::min(length, EXPORT_CHUNK_SIZE);
+        if (!writer.reserve(2 * chunk + 1))
+            return false;
+        auto end = text + chunk;
+        while (text < end) {
+            auto quote = (const char*)memchr(text, '"', (size_t)(end - text));
+            auto run = quote == nullptr ? end : quote + 1;
+            writer.put(text, (size_t)(run - text));
+            if (quote != nullptr)
+                writer.put('"');
+            text = run;
+        }
+        length -= chunk;
+    }
+    if (close) {
+        if (!writer.reserve(1))
+            return false;
+        writer.put('"');
+    }
+    return true;
 }
 
-extern "C"
-JNIEXPORT jint JNICALL
-Java_com_progdigy_fbclient_API_getCount(JNIEnv *env, jclass clazz, jlong sqlda) {
-    char data[33] = {0};
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    if (handle != nullptr) {
-        auto p = *handle;
-        return p->sqld;
-    } else
-        throwHandleError(env);
-    return 0;
+// text as a TSV field, tabs, new lines and backslashes are escaped
+static bool exportTsvText(ExportWriter& writer, const char* text, size_t length) {
+    while (length > 0) {
+        auto chunk = std::min(length, EXPORT_CHUNK_SIZE);
+        if (!writer.reserve(2 * chunk))
+            return false;
+        auto out = writer.tail();
+        size_t size = 0;
+        for (size_t i = 0; i < chunk; i++) {
+            auto c = text[i];
+            switch (c) {
+                case '\t': out[size++] = '\\'; out[size++] = 't'; break;
+                case '\n': out[size++] = '\\'; out[size++] = 'n'; break;
+                case '\r': out[size++] = '\\'; out[size++] = 'r'; break;
+                case '\\': out[size++] = '\\'; out[size++] = '\\'; break;
+                default: out[size++] = c;
+            }
+        }
+        writer.advance(size);
+        text += chunk;
+        length -= chunk;
+    }
+    return true;
 }
 
-inline void setValueBoolean(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jboolean value) {
-    switch (code) {
-        case SQL_BOOLEAN:
-            *(ISC_UCHAR *)data = value?FB_TRUE:FB_FALSE;
-            break;
-        default:
-            throwDataConversionError(env, index);
+static bool exportText(ExportWriter& writer, const char* text, size_t length, int options) {
+    if ((options & CSV_TAB) != 0)
+        return exportTsvText(writer, text, length);
+    return exportCsvText(writer, text, length, true, true);
+}
+
+// bytes in base64, which has nothing to quote nor escape
+static bool exportBytes(ExportWriter& writer, const unsigned char* data, size_t length) {
+    while (length > 0) {
+        // whole groups of 3 bytes, so that the pieces concatenate
+        auto chunk = std::min(length, EXPORT_CHUNK_SIZE / 3 * 3);
+        if (!writer.reserve(4 * ((chunk + 2) / 3)))
+            return false;
+        writer.advance(fbcore_base64(writer.tail(), data, chunk));
+        data += chunk;
+        length -= chunk;
     }
+    return true;
 }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueBoolean(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jboolean value) {
-    setFieldValue<jboolean, setValueBoolean>(env, sqlda, index, value);
+static bool exportBlobText(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                           ISC_SCHAR* data, ExportWriter& writer, int options) {
+    isc_blob_handle blob = 0;
+    auto ret = open_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
+    if (ret != 0) {
+        checkStatus(env, status, ret);
+        return false;
+    }
+    auto csv = (options & CSV_TAB) == 0;
+    auto chunk = writer.scratch();
+    auto written = !csv || exportCsvText(writer, nullptr, 0, true, false);
+    ISC_STATUS failed = 0;
+    while (written) {
+        auto length = fbcore_blob_read(status, &blob, chunk, (int)EXPORT_CHUNK_SIZE, get_segment);
+        if (length > 0)
+            written = csv ? exportCsvText(writer, chunk, (size_t)length, false, false)
+                          : exportTsvText(writer, chunk, (size_t)length);
+        if (length < (int)EXPORT_CHUNK_SIZE) {
+            if (status[1] != 0 && status[1] != isc_segstr_eof && status[1] != isc_segment)
+                failed = status[1];
+            break;
+        }
+    }
+    if (failed != 0) {
+        checkStatus(env, status, failed);
+        ISC_STATUS_ARRAY closing;
+        close_blob(closing, &blob);
+        return false;
+    }
+    ret = close_blob(status, &blob);
+    if (ret != 0) {
+        checkStatus(env, status, ret);
+        return false;
+    }
+    return written && (!csv || exportCsvText(writer, nullptr, 0, false, true));
 }
 
-inline void setValueShort(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jshort value) {
+static bool exportColumn(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                         int index, XSQLVAR* v, ExportWriter& writer, int options) {
+    auto code = v->sqltype & ~1;
+    int scale = v->sqlscale;
+    if (v->sqlind != nullptr && *v->sqlind != 0) {
+        // an empty CSV field, an empty string being quoted
+        if ((options & CSV_TAB) == 0)
+            return true;
+        if (!writer.reserve(2))
+            return false;
+        writer.put("\\N", 2);
+        return true;
+    }
     switch (code) {
-        case SQL_SHORT:
-            *(ISC_SHORT*)data = value;
-            break;
-        case SQL_LONG :
-            *(ISC_LONG*)data  = value;
-            break;
-        case SQL_INT64:
-        case SQL_QUAD:
-            *(ISC_INT64*)data = value;
-            break;
-        case SQL_FLOAT:
-            *(float *)data = value;
-            break;
-        case SQL_D_FLOAT:
-        case SQL_DOUBLE:
-            *(double *)data = value;
+        case SQL_VARYING: {
+            auto vary = (PARAMVARY*)v->sqldata;
+            if (v->sqlsubtype == 1)
+                return exportBytes(writer, vary->vary_string, vary->vary_length);
+            return exportText(writer, (const char*)vary->vary_string, vary->vary_length, options);
+        }
+        case SQL_TEXT: {
+            if (v->sqlsubtype == 1)
+                return exportBytes(writer, (const unsigned char*)v->sqldata, (size_t)v->sqllen);
+            // the column length is in bytes, CHAR padding beyond the character length is dropped
+            auto size = v->sqlsubtype == 4 ? fbcore_utf8_size(v->sqldata, v->sqllen / 4, v->sqllen) : (size_t)v->sqllen;
+            return exportText(writer, v->sqldata, size, options);
+        }
+        case SQL_BLOB:
+            if (v->sqlsubtype == 1 && (options & CSV_BLOB_TEXT) != 0)
+                return exportBlobText(env, status, dbHandle, trHandle, v->sqldata, writer, options);
+            code = SQL_INT64; // the blob id
+            scale = 0;
             break;
-        case SQL_INT128: {
-            auto v = (FB_I128 *)data;
-            v->fb_data[0] = value;
-            v->fb_data[1] = value < 0 ? -1 : 0;
+        default:
             break;
+    }
+    if (!writer.reserve(FBCORE_FORMAT_SIZE))
+        return false;
+    auto length = fbcore_format_scalar(writer.tail(), v->sqldata, code, scale);
+    if (length >= 0) {
+        writer.advance((size_t)length);
+        return true;
+    }
+    double value;
+    if ((code == SQL_FLOAT || code == SQL_DOUBLE || code == SQL_D_FLOAT) && fbcore_get_double(v->sqldata, code, &value) == FBCORE_OK) {
+        auto text = value != value ? "NaN" : value > 0 ? "Infinity" : "-Infinity";
+        writer.put(text, strlen(text));
+        return true;
+    }
+    throwDataConversionError(env, index);
+    return false;
+}
+
+static bool exportRow(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                      XSQLDA* sqlda, ExportWriter& writer, int options) {
+    auto delimiter = (options & CSV_TAB) != 0 ? '\t' : ',';
+    for (int i = 0; i < sqlda->sqld; i++) {
+        if (i > 0) {
+            if (!writer.reserve(1))
+                return false;
+            writer.put(delimiter);
         }
-        default:
-            throwDataConversionError(env, index);
+        if (!exportColumn(env, status, dbHandle, trHandle, i, &sqlda->sqlvar[i], writer, options))
+            return false;
     }
+    if (!writer.reserve(1))
+        return false;
+    writer.put('\n');
+    return true;
+}
+
+static bool exportHeader(XSQLDA* sqlda, ExportWriter& writer, int options) {
+    auto delimiter = (options & CSV_TAB) != 0 ? '\t' : ',';
+    for (int i = 0; i < sqlda->sqld; i++) {
+        if (i > 0) {
+            if (!writer.reserve(1))
+                return false;
+            writer.put(delimiter);
+        }
+        auto v = &sqlda->sqlvar[i];
+        if (!exportText(writer, v->aliasname, (size_t)v->aliasname_length, options))
+            return false;
+    }
+    if (!writer.reserve(1))
+        return false;
+    writer.put('\n');
+    return true;
 }
 
 extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueShort(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jshort value) {
-    setFieldValue<jshort , setValueShort>(env, sqlda, index, value);
+JNIEXPORT jboolean JNICALL
+Java_com_progdigy_fbclient_API_exportRows(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                          jlong st_handle, jlong sqlda, jstring path, jint fd, jint count, jint options,
+                                          jlongArray progress) {
+    JniScope scope(JniCall::exportRows);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return JNI_FALSE;
+    }
+    if (env->GetArrayLength(progress) < 2) {
+        throwOutOfBoundError(env, 1);
+        return JNI_FALSE;
+    }
+    auto file = (int)fd;
+    if (path != nullptr) {
+        auto name = env->GetStringUTFChars(path, nullptr);
+        file = EXPORT_OPEN(name, EXPORT_FLAGS | ((options & CSV_APPEND) != 0 ? EXPORT_APPEND : EXPORT_TRUNCATE));
+        env->ReleaseStringUTFChars(path, name);
+        if (file < 0) {
+            throwFileError(env, path);
+            return JNI_FALSE;
+        }
+    }
+    // released after the export, which may end with an exception pending
+    auto counters = env->GetLongArrayElements(progress, nullptr);
+    auto more = JNI_TRUE;
+    jlong rows = 0;
+    int error = 0;
+    {
+        ExportWriter writer(file, (options & CSV_WRITER_THREAD) != 0);
+        auto written = (options & CSV_HEADER) == 0 || exportHeader(*handle, writer, options);
+        while (written && (count <= 0 || rows < count)) {
+            writer.beginRow();
+            written = exportRow(env, statusArray, dbHandle, trHandle, *handle, writer, options);
+            if (!written) {
+                writer.rollback();
+                break;
+            }
+            writer.endRow();
+            rows++;
+            auto ret = fetchRow(statusArray, stHandle, *handle);
+            if (ret != 0) {
+                more = JNI_FALSE;
+                if (ret != 100) {
+                    checkStatus(env, statusArray, ret);
+                    written = false;
+                }
+                break;
+            }
+        }
+        // the rows formatted before an error are still written, not the one that failed
+        if (!writer.finish() || !written) {
+            more = JNI_FALSE;
+            error = writer.error;
+        }
+        counters[1] += (jlong)writer.bytes;
+    }
+    if (path != nullptr)
+        EXPORT_CLOSE(file);
+    counters[0] += rows;
+    env->ReleaseLongArrayElements(progress, counters, 0);
+    if (error != 0 && !env->ExceptionCheck())
+        throwWriteError(env, error);
+    return more;
 }
 
-inline void setValueInt(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
-    switch (code) {
-        case SQL_LONG :
-            *(ISC_LONG*)data  = value;
-            break;
-        case SQL_INT64:
-        case SQL_QUAD:
-            *(ISC_INT64*)data = value;
-            break;
-        case SQL_D_FLOAT:
-        case SQL_DOUBLE:
-            *(double *)data = value;
-            break;
-        case SQL_INT128: {
-            auto v = (FB_I128 *)data;
-            v->fb_data[0] = value;
-            v->fb_data[1] = value < 0 ? -1 : 0;
-            break;
+/*
+ * CSV import
+ *
+ * A CSV or TSV file is mapped in memory and cut on record boundaries into chunks parsed by a pool of threads, each
+ * record straight into a message laid out like the input of the prepared statement. The calling thread sends the
+ * messages as they come: in IBatch batches when the client library and the server support them (Firebird 4) and the
+ * statement has no blob parameter, otherwise by executing the statement once per record.
+ */
+
+#define IMPORT_TAB      1 // tab separated, with the escapes and the \N nulls written by exportRows
+#define IMPORT_HEADER   2 // the first record holds the column names and is skipped
+#define IMPORT_CONTINUE 4 // records failing to parse or to insert are reported and skipped instead of ending the import
+
+// the largest IBatch buffer accepted by the server
+constexpr size_t IMPORT_BATCH_BYTES = 256 << 20;
+
+// a read-only view of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const char* path) {
+#ifdef _WIN32
+        auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                                nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER length;
+        if (GetFileSizeEx(file, &length)) {
+            size = (size_t)length.QuadPart;
+            if (size == 0)
+                data = "";
+            else if ((mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) != nullptr)
+                data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+        CloseHandle(file);
+#else
+        auto file = open(path, O_RDONLY);
+        if (file < 0)
+            return;
+        struct stat info;
+        if (fstat(file, &info) == 0) {
+            size = (size_t)info.st_size;
+            if (size == 0)
+                data = "";
+            else {
+                auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+                if (address != MAP_FAILED) {
+                    madvise(address, size, MADV_SEQUENTIAL);
+                    data = (const char*)address;
+                }
+            }
+        }
+        close(file);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data != nullptr && size > 0)
+            UnmapViewOfFile(data);
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+#else
+        if (data != nullptr && size > 0)
+            munmap((void*)data, size);
+#endif
+    }
+
+    const char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+private:
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// a parameter of the statement, in a message
+struct ImportColumn {
+    int code;
+    int scale;
+    int length;
+    int charset;
+    size_t offset;
+    size_t nullOffset;
+    bool nullable;
+};
+
+struct ImportLayout {
+    std::vector<ImportColumn> columns;
+    size_t length = 0; // the bytes of a message
+    size_t stride = 0; // the bytes between two messages
+    bool blobs = false;
+};
+
+// the layout of the data buffer of a described XSQLDA, which starts at the lowest sqldata or sqlind pointer
+static char* sqldaLayout(XSQLDA* sqlda, ImportLayout& layout) {
+    char* base = nullptr;
+    char* end = nullptr;
+    for (int i = 0; i < sqlda->sqld; i++) {
+        auto v = &sqlda->sqlvar[i];
+        auto size = (size_t)v->sqllen + ((v->sqltype & ~1) == SQL_VARYING ? 2 : 0);
+        if (base == nullptr || v->sqldata < base)
+            base = v->sqldata;
+        end = std::max(end, v->sqldata + size);
+        if ((v->sqltype & 1) != 0) {
+            base = std::min(base, (char*)v->sqlind);
+            end = std::max(end, (char*)(v->sqlind + 1));
+        }
+    }
+    for (int i = 0; i < sqlda->sqld; i++) {
+        auto v = &sqlda->sqlvar[i];
+        auto nullable = (v->sqltype & 1) != 0;
+        layout.columns.push_back({v->sqltype & ~1, v->sqlscale, v->sqllen, v->sqlsubtype, (size_t)(v->sqldata - base),
+                                  nullable ? (size_t)((char*)v->sqlind - base) : 0, nullable});
+        layout.blobs |= (v->sqltype & ~1) == SQL_BLOB;
+    }
+    layout.length = (size_t)(end - base);
+    layout.stride = (layout.length + 7) & ~(size_t)7;
+    return base;
+}
+
+static bool metadataLayout(Firebird::IMessageMetadata* metadata, Firebird::CheckStatusWrapper* status,
+                           ImportLayout& layout) {
+    auto count = metadata->getCount(status);
+    for (unsigned i = 0; i < count; i++) {
+        auto code = (int)metadata->getType(status, i) & ~1;
+        layout.columns.push_back({code, metadata->getScale(status, i), (int)metadata->getLength(status, i),
+                                  (int)metadata->getCharSet(status, i), metadata->getOffset(status, i),
+                                  metadata->getNullOffset(status, i), metadata->isNullable(status, i) != FB_FALSE});
+        layout.blobs |= code == SQL_BLOB;
+    }
+    layout.length = metadata->getMessageLength(status);
+    layout.stride = metadata->getAlignedLength(status);
+    return (status->getState() & Firebird::IStatus::STATE_ERRORS) == 0;
+}
+
+struct ImportRejection {
+    int64_t offset; // of the record in the file
+    int column;     // the first field that could not be stored, -1 when the record has the wrong number of fields
+};
+
+// consecutive records of a chunk
+struct ImportBlock {
+    std::vector<char> messages;
+    std::vector<int64_t> offsets; // of the record of each message
+    std::vector<ImportRejection> rejected;
+    std::string blobs; // the text of blob fields, a message holds its position and length until the blob is created
+    size_t rows = 0;
+};
+
+// the blocks parsed and not sent yet, bounded to keep the parsers close to the sender
+class ImportQueue {
+public:
+    explicit ImportQueue(size_t capacity) : capacity(capacity) {}
+
+    // false once the import is stopped
+    bool push(std::unique_ptr<ImportBlock> block) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return blocks.size() < capacity || stopped; });
+        if (stopped)
+            return false;
+        blocks.push_back(std::move(block));
+        changed.notify_all();
+        return true;
+    }
+
+    // false once every parser is done and every block taken
+    bool pop(std::unique_ptr<ImportBlock>& block) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !blocks.empty() || producers == 0; });
+        if (blocks.empty())
+            return false;
+        block = std::move(blocks.front());
+        blocks.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    void start(int count) {
+        producers = count;
+    }
+
+    void done() {
+        std::lock_guard<std::mutex> lock(mutex);
+        producers--;
+        changed.notify_all();
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+        changed.notify_all();
+    }
+
+    bool stopping() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stopped;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::unique_ptr<ImportBlock>> blocks;
+    size_t capacity;
+    int producers = 0;
+    bool stopped = false;
+};
+
+// parses records into messages, one per thread
+class ImportParser {
+public:
+    ImportParser(const ImportLayout& layout, int options) : layout(layout), tab((options & IMPORT_TAB) != 0) {}
+
+    // the records of [begin, end), in blocks of rows messages
+    void parse(const char* base, const char* begin, const char* end, bool header, size_t rows, ImportQueue& queue) {
+        auto p = begin;
+        if (header)
+            skipRecord(p, end);
+        std::unique_ptr<ImportBlock> block(new ImportBlock());
+        block->messages.reserve(rows * layout.stride);
+        while (p < end) {
+            // blank lines are skipped
+            if (*p == '\n' || (*p == '\r' && p + 1 < end && p[1] == '\n')) {
+                p += *p == '\r' ? 2 : 1;
+                continue;
+            }
+            auto record = p;
+            block->messages.resize((block->rows + 1) * layout.stride);
+            auto message = &block->messages[block->rows * layout.stride];
+            memset(message, 0, layout.stride);
+            auto column = parseRecord(p, end, message, *block);
+            if (column == (int)layout.columns.size()) {
+                block->offsets.push_back(record - base);
+                block->rows++;
+            } else {
+                block->messages.resize(block->rows * layout.stride);
+                block->rejected.push_back({record - base, column});
+            }
+            if (block->rows == rows) {
+                if (!queue.push(std::move(block)))
+                    return;
+                block.reset(new ImportBlock());
+                block->messages.reserve(rows * layout.stride);
+            }
+        }
+        if (block->rows > 0 || !block->rejected.empty())
+            queue.push(std::move(block));
+    }
+
+    // the rest of a record, in CSV a newline within quotes does not end it
+    void skipRecord(const char*& p, const char* end) const {
+        auto quoted = false;
+        for (; p < end; p++) {
+            if (*p == '"' && !tab)
+                quoted = !quoted;
+            else if (*p == '\n' && !quoted) {
+                p++;
+                return;
+            }
+        }
+    }
+
+private:
+    /**
+     * Reads a field, leaving p on the delimiter or the end of the record.
+     *
+     * @return false when a quoted field is not closed.
+     */
+    bool readField(const char*& p, const char* end, const char*& text, size_t& length, bool& null) {
+        null = false;
+        if (tab) {
+            auto start = p;
+            while (p < end && *p != '\t' && *p != '\n')
+                p++;
+            length = (size_t)(p - start);
+            if (p < end && *p == '\n' && length > 0 && p[-1] == '\r')
+                length--;
+            text = start;
+            if (length == 2 && start[0] == '\\' && start[1] == 'N') {
+                null = true;
+                return true;
+            }
+            if (memchr(start, '\\', length) == nullptr)
+                return true;
+            scratch.clear();
+            for (size_t i = 0; i < length; i++) {
+                auto c = start[i];
+                if (c == '\\' && i + 1 < length) {
+                    c = start[++i];
+                    c = c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+                }
+                scratch.push_back(c);
+            }
+            text = scratch.data();
+            length = scratch.size();
+            return true;
+        }
+        if (p < end && *p == '"') {
+            auto start = ++p;
+            auto copied = false;
+            for (;;) {
+                auto quote = (const char*)memchr(p, '"', (size_t)(end - p));
+                if (quote == nullptr) {
+                    p = end;
+                    return false;
+                }
+                if (quote + 1 < end && quote[1] == '"') {
+                    // a doubled quote, the field is unescaped into scratch
+                    if (!copied)
+                        scratch.clear();
+                    scratch.append(start, quote + 1);
+                    copied = true;
+                    p = start = quote + 2;
+                    continue;
+                }
+                if (copied) {
+                    scratch.append(start, quote);
+                    text = scratch.data();
+                    length = scratch.size();
+                } else {
+                    text = start;
+                    length = (size_t)(quote - start);
+                }
+                p = quote + 1;
+                return true;
+            }
+        }
+        auto start = p;
+        while (p < end && *p != ',' && *p != '\n')
+            p++;
+        text = start;
+        length = (size_t)(p - start);
+        if (p < end && *p == '\n' && length > 0 && p[-1] == '\r')
+            length--;
+        null = length == 0;
+        return true;
+    }
+
+    bool store(const ImportColumn& column, char* message, const char* text, size_t length, bool null,
+               ImportBlock& block) {
+        auto data = message + column.offset;
+        auto textual = column.code == SQL_TEXT || column.code == SQL_VARYING || column.code == SQL_BLOB;
+        if (null || (length == 0 && !textual)) {
+            if (!column.nullable)
+                return false;
+            *(ISC_SHORT*)(message + column.nullOffset) = -1;
+            return true;
+        }
+        switch (column.code) {
+            case SQL_TEXT:
+            case SQL_VARYING:
+                if (column.charset == 1) {
+                    // binary text is base64, as exported
+                    bytes.resize(3 * (length / 4) + 1);
+                    auto size = fbcore_parse_base64(bytes.data(), text, length);
+                    if (size < 0 || size > column.length)
+                        return false;
+                    return fbcore_set_bytes(data, column.code, column.length, bytes.data(), (int)size, 0) == FBCORE_OK;
+                }
+                if (length > (size_t)column.length)
+                    return false;
+                return fbcore_set_bytes(data, column.code, column.length, text, (int)length, ' ') == FBCORE_OK;
+            case SQL_BLOB: {
+                ISC_ULONG reference[2] = {(ISC_ULONG)block.blobs.size(), (ISC_ULONG)length};
+                memcpy(data, reference, sizeof reference);
+                block.blobs.append(text, length);
+                return true;
+            }
+            default:
+                return fbcore_parse_scalar(data, column.code, column.scale, text, length) == FBCORE_OK;
+        }
+    }
+
+    /**
+     * Parses a record into a message, leaving p at the start of the next record.
+     *
+     * @return the number of columns when every field was stored, the first field that was not otherwise, -1 for a
+     * wrong number of fields.
+     */
+    int parseRecord(const char*& p, const char* end, char* message, ImportBlock& block) {
+        auto delimiter = tab ? '\t' : ',';
+        auto count = (int)layout.columns.size();
+        auto failed = count;
+        for (int i = 0;; i++) {
+            const char* text;
+            size_t length;
+            bool null;
+            if (!readField(p, end, text, length, null))
+                return -1;
+            if (i < count && failed == count && !store(layout.columns[i], message, text, length, null, block))
+                failed = i;
+            if (p < end && *p == delimiter) {
+                p++;
+                continue;
+            }
+            // the end of the record
+            if (p < end && *p == '\r' && p + 1 < end && p[1] == '\n')
+                p++;
+            if (p < end && *p != '\n') {
+                // text after a closing quote
+                skipRecord(p, end);
+                return -1;
+            }
+            if (p < end)
+                p++;
+            return i + 1 == count ? failed : -1;
         }
-        default:
-            throwDataConversionError(env, index);
     }
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueInt(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
-    setFieldValue<jint, setValueInt>(env, sqlda, index, value);
+    const ImportLayout& layout;
+    bool tab;
+    std::string scratch;
+    std::vector<unsigned char> bytes;
+};
+
+// cuts the file into about parts chunks starting at the start of a record
+static std::vector<std::pair<size_t, size_t>> importChunks(const char* data, size_t size, size_t parts, bool quoted,
+                                                           int threads) {
+    std::vector<size_t> starts(parts);
+    std::vector<size_t> quotes(parts, 0);
+    for (size_t i = 0; i < parts; i++)
+        starts[i] = size / parts * i;
+    // outside quotes, a CSV newline ends a record; the parity of the quotes before each part is counted in parallel
+    if (quoted && parts > 1) {
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> counters;
+        for (int t = 0; t < threads; t++)
+            counters.emplace_back([&] {
+                for (size_t i; (i = next++) < parts;) {
+                    auto end = i + 1 < parts ? starts[i + 1] : size;
+                    size_t count = 0;
+                    for (auto c = data + starts[i]; c < data + end; c++)
+                        count += *c == '"';
+                    quotes[i] = count;
+                }
+            });
+        for (auto& counter : counters)
+            counter.join();
+    }
+    std::vector<std::pair<size_t, size_t>> chunks;
+    size_t begin = 0;
+    size_t before = 0; // the quotes before starts[i]
+    for (size_t i = 1; i < parts; i++) {
+        before += quotes[i - 1];
+        if (starts[i] < begin)
+            continue; // within the previous chunk
+        auto inside = (before & 1) != 0;
+        auto boundary = starts[i];
+        for (; boundary < size; boundary++) {
+            auto c = data[boundary];
+            if (c == '"' && quoted)
+                inside = !inside;
+            else if (c == '\n' && !inside) {
+                boundary++;
+                break;
+            }
+        }
+        if (boundary > begin)
+            chunks.emplace_back(begin, boundary);
+        begin = boundary;
+    }
+    if (size > begin)
+        chunks.emplace_back(begin, size);
+    return chunks;
 }
 
-inline void setValueLong(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jlong value) {
-    switch (code) {
-        case SQL_INT64:
-        case SQL_QUAD:
-            *(ISC_INT64*)data = value;
+// copies the errors of a status of the object API into a status array, for checkStatus to throw them
+static void throwStatusErrors(JNIEnv* env, ISC_STATUS* statusArray, const Firebird::IStatus* status) {
+    auto errors = status->getErrors();
+    size_t i = 0;
+    while (errors[i] != isc_arg_end) {
+        size_t size = errors[i] == isc_arg_cstring ? 3 : 2;
+        if (i + size >= ISC_STATUS_LENGTH)
             break;
-        case SQL_INT128: {
-            auto v = (FB_I128 *)data;
-            v->fb_data[0] = value;
-            v->fb_data[1] = value < 0 ? -1 : 0;
-            break;
-        }
-        default:
-            throwDataConversionError(env, index);
+        for (size_t k = 0; k < size; k++)
+            statusArray[i + k] = errors[i + k];
+        i += size;
     }
+    statusArray[i] = isc_arg_end;
+    checkStatus(env, statusArray, i > 1 ? statusArray[1] : 0);
 }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueLong(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jlong value) {
-    setFieldValue<jlong, setValueLong>(env, sqlda, index, value);
-}
+// the counters of an import and the offsets of its rejected records, in arrays of the caller
+struct ImportProgress {
+    jlong inserted = 0;
+    jlong rejected = 0;
+    jlong* offsets = nullptr;
+    jsize capacity = 0;
+
+    void reject(int64_t offset) {
+        if (rejected < capacity)
+            offsets[rejected] = offset;
+        rejected++;
+    }
+};
+
+// an IBatch of the prepared statement, when the client library and the server provide one
+class ImportBatch {
+public:
+    /**
+     * Creates the batch and the layout of its messages. rows is lowered to what fits in the batch buffer.
+     */
+    ImportBatch(ISC_STATUS* statusArray, FB_API_HANDLE* trHandle, FB_API_HANDLE* stHandle, ImportLayout& layout,
+                size_t& rows, bool keepGoing)
+        : master(get_master_interface != nullptr ? get_master_interface() : nullptr),
+          status(master != nullptr ? master->getStatus() : nullptr) {
+        // a replayed statement has no interface
+        if (master == nullptr || get_statement_interface == nullptr || get_transaction_interface == nullptr ||
+            client.dsql_execute != library.dsql_execute)
+            return;
+        if (get_statement_interface(statusArray, &statement, stHandle) != 0 ||
+            get_transaction_interface(statusArray, &transaction, trHandle) != 0)
+            return;
+        metadata = statement->getInputMetadata(&status);
+        // blobs would have to be registered with the batch
+        if (failed() || !metadataLayout(metadata, &status, layout) || layout.blobs || layout.stride == 0) {
+            layout = ImportLayout();
+            return;
+        }
+        rows = std::max<size_t>(1, std::min(rows, IMPORT_BATCH_BYTES / layout.stride));
+        auto builder = master->getUtilInterface()->getXpbBuilder(&status, Firebird::IXpbBuilder::BATCH, nullptr, 0);
+        if (failed()) {
+            layout = ImportLayout();
+            return;
+        }
+        builder->insertInt(&status, Firebird::IBatch::TAG_MULTIERROR, keepGoing ? 1 : 0);
+        builder->insertInt(&status, Firebird::IBatch::TAG_BUFFER_BYTES_SIZE,
+                           (int)std::min(IMPORT_BATCH_BYTES, rows * layout.stride + (1 << 20)));
+        batch = statement->createBatch(&status, metadata, builder->getBufferLength(&status), builder->getBuffer(&status));
+        builder->dispose();
+        if (failed()) {
+            // a server older than Firebird 4
+            batch = nullptr;
+            layout = ImportLayout();
+        }
+    }
 
-inline void setValueString(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
-                           int index, ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype, jstring value) {
-    switch (code) {
-        case SQL_VARYING:
-            if (subtype == 4) {
-                auto strLen = env->GetStringLength(value);
-                if (strLen <= len / 4) {
-                    auto str = env->GetStringUTFChars(value, nullptr);
-                    auto size = strlen(str);
-                    auto vary = (PARAMVARY *)data;
-                    memcpy(vary->vary_string, str, size);
-                    vary->vary_length = size;
-                    env->ReleaseStringUTFChars(value, str);
-                } else
-                    throwStringTruncation(env, index);
-            } else
-                throwDataConversionError(env, index);
-            break;
-        case SQL_TEXT:
-            if (subtype == 4) {
-                auto strLen = env->GetStringLength(value);
-                if (strLen <= len / 4) {
-                    auto str = env->GetStringUTFChars(value, nullptr);
-                    auto size = strlen(str);
-                    memset(data, ' ',len);
-                    memcpy(data, str, size);
-                    env->ReleaseStringUTFChars(value, str);
-                } else
-                    throwStringTruncation(env, index);
-            } else
-                throwDataConversionError(env, index);
-            break;
-        case SQL_BLOB:
-            if (subtype == 1) {
-                isc_blob_handle blob = 0;
-                auto ret = create_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
-                if (ret == 0) {
-                    auto bytes = env->GetStringUTFChars(value, nullptr);
-                    auto length = strlen(bytes);
-                    auto toWrite = std::min(length, (size_t)std::numeric_limits<ISC_SHORT>::max());
-                    auto p = bytes;
-                    while (put_segment(status, &blob, toWrite, p) == 0) {
-                        length -= toWrite;
-                        if (length <= 0)
-                            break;
-                        toWrite = std::min(length, (size_t)std::numeric_limits<ISC_SHORT>::max());
-                        p += toWrite;
-                    }
-                    env->ReleaseStringUTFChars(value, bytes);
-                    ret = close_blob(status, &blob);
-                }
-                checkStatus(env, status, ret);
-            } else
-                throwDataConversionError(env, index);
-            break;
-        default:
-            throwDataConversionError(env, index);
+    ~ImportBatch() {
+        if (batch != nullptr)
+            batch->release();
+        if (metadata != nullptr)
+            metadata->release();
+        if (statement != nullptr)
+            statement->release();
+        if (transaction != nullptr)
+            transaction->release();
+        if (master != nullptr)
+            status.dispose();
     }
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueString(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
-                                              jlong sqlda, jint index, jstring value) {
-    setFieldValue<jstring, setValueString>(env, status, db_handle, tr_handle, sqlda, index, value);
-}
+    bool ready() const {
+        return batch != nullptr;
+    }
 
-inline void setValueByteArray(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
-                              int index, ISC_SCHAR* data,  ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype, jbyteArray value) {
-    switch (code) {
-        case SQL_VARYING: {
-            auto size = env->GetArrayLength(value);
-            if (size <= len) {
-                auto array = env->GetByteArrayElements(value, nullptr);
-                auto vary = (PARAMVARY *)data;
-                memcpy(vary->vary_string, array, size);
-                vary->vary_length = size;
-                env->ReleaseByteArrayElements(value, array, JNI_COMMIT);
-            } else
-                throwStringTruncation(env, index);
-            break;
+    // adds and executes the messages of a block, false when the import stops on an error, which is thrown
+    bool send(JNIEnv* env, ISC_STATUS* statusArray, const ImportBlock& block, bool keepGoing, ImportProgress& progress) {
+        batch->add(&status, (unsigned)block.rows, block.messages.data());
+        if (failed()) {
+            throwStatusErrors(env, statusArray, &status);
+            return false;
         }
-        case SQL_TEXT: {
-            auto size = env->GetArrayLength(value);
-            if (size <= len) {
-                auto array = env->GetByteArrayElements(value, nullptr);
-                memset(data, subtype > 0?' ':0,len);
-                memcpy(data, array, size);
-                env->ReleaseByteArrayElements(value, array, JNI_COMMIT);
-            } else
-                throwStringTruncation(env, index);
-            break;
+        auto state = batch->execute(&status, transaction);
+        if (failed()) {
+            throwStatusErrors(env, statusArray, &status);
+            return false;
         }
-        case SQL_BLOB: {
+        // without TAG_MULTIERROR the execution ends at the first failed message
+        auto size = state->getSize(&status);
+        auto running = true;
+        for (unsigned i = 0; i < size && running; i++) {
+            if (state->getState(&status, i) != Firebird::IBatchCompletionState::EXECUTE_FAILED) {
+                progress.inserted++;
+                continue;
+            }
+            progress.reject(block.offsets[i]);
+            if (!keepGoing) {
+                auto error = master->getStatus();
+                state->getStatus(&status, error, i);
+                throwStatusErrors(env, statusArray, error);
+                error->dispose();
+                running = false;
+            }
+        }
+        state->dispose();
+        return running;
+    }
+
+private:
+    bool failed() const {
+        return (status.getState() & Firebird::IStatus::STATE_ERRORS) != 0;
+    }
+
+    Firebird::IMaster* master;
+    Firebird::CheckStatusWrapper status;
+    Firebird::IStatement* statement = nullptr;
+    Firebird::ITransaction* transaction = nullptr;
+    Firebird::IMessageMetadata* metadata = nullptr;
+    Firebird::IBatch* batch = nullptr;
+};
+
+// executes the statement once per message, creating the blobs of the record first
+static bool executeRecords(JNIEnv* env, ISC_STATUS* statusArray, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                           FB_API_HANDLE* stHandle, XSQLDA* sqlda, char* base, const ImportLayout& layout,
+                           const ImportBlock& block, int dialect, bool keepGoing, ImportProgress& progress) {
+    for (size_t row = 0; row < block.rows; row++) {
+        memcpy(base, &block.messages[row * layout.stride], layout.length);
+        ISC_STATUS ret = 0;
+        for (auto& column : layout.columns) {
+            if (column.code != SQL_BLOB || (column.nullable && *(ISC_SHORT*)(base + column.nullOffset) != 0))
+                continue;
+            ISC_ULONG reference[2];
+            memcpy(reference, base + column.offset, sizeof reference);
             isc_blob_handle blob = 0;
-            auto ret = create_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
-            if (ret == 0) {
-                auto length = env->GetArrayLength(value);
-                auto bytes = env->GetByteArrayElements(value, nullptr);
-                auto toWrite = std::min(length, (jsize)std::numeric_limits<ISC_SHORT>::max());
-                auto p = bytes;
-                while (put_segment(status, &blob, toWrite, p) == 0) {
-                    length -= toWrite;
-                    if (length <= 0)
-                        break;
-                    toWrite = std::min(length, (jsize)std::numeric_limits<ISC_SHORT>::max());
-                    p += toWrite;
-                }
-                env->ReleaseByteArrayElements(value, bytes, JNI_COMMIT);
-                ret = close_blob(status, &blob);
+            ret = create_blob(statusArray, dbHandle, trHandle, &blob, (ISC_QUAD*)(base + column.offset));
+            if (ret != 0)
+                break;
+            auto length = (int)reference[1];
+            if (fbcore_blob_write(statusArray, &blob, block.blobs.data() + reference[0], length, put_segment) < length) {
+                ret = statusArray[1];
+                ISC_STATUS_ARRAY closing;
+                close_blob(closing, &blob);
+                break;
             }
-            checkStatus(env, status, ret);
-            break;
+            ret = close_blob(statusArray, &blob);
+            if (ret != 0)
+                break;
+        }
+        if (ret == 0)
+            ret = dsql_execute(statusArray, trHandle, stHandle, (unsigned short)dialect, sqlda);
+        if (ret == 0) {
+            progress.inserted++;
+            continue;
+        }
+        progress.reject(block.offsets[row]);
+        if (!keepGoing) {
+            checkStatus(env, statusArray, ret);
+            return false;
         }
-        default:
-            throwDataConversionError(env, index);
     }
+    return true;
 }
 
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueByteArray(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
-                                                 jlong sqlda, jint index, jbyteArray value) {
-    setFieldValue<jbyteArray, setValueByteArray>(env, status, db_handle, tr_handle, sqlda, index, value);
+Java_com_progdigy_fbclient_API_importRows(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                          jlong st_handle, jlong sqlda, jstring path, jint dialect, jint batch_size,
+                                          jint threads, jint options, jlongArray progress, jlongArray rejected) {
+    JniScope scope(JniCall::importRows);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return;
+    }
+    if (env->GetArrayLength(progress) < 2) {
+        throwOutOfBoundError(env, 1);
+        return;
+    }
+    auto name = env->GetStringUTFChars(path, nullptr);
+    MappedFile file(name);
+    env->ReleaseStringUTFChars(path, name);
+    if (file.data == nullptr) {
+        throwFileError(env, path);
+        return;
+    }
+    auto keepGoing = (options & IMPORT_CONTINUE) != 0;
+    auto workers = threads > 0 ? (int)threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    auto rows = (size_t)std::max(batch_size, 1);
+    ImportLayout layout;
+    ImportBatch batch(statusArray, trHandle, stHandle, layout, rows, keepGoing);
+    auto base = batch.ready() ? nullptr : sqldaLayout(*handle, layout);
+
+    // a part per megabyte, up to four per thread
+    auto parts = std::max<size_t>(1, std::min<size_t>(file.size >> 20, (size_t)workers * 4));
+    auto chunks = importChunks(file.data, file.size, parts, (options & IMPORT_TAB) == 0, workers);
+    ImportQueue queue((size_t)workers * 2);
+    queue.start(workers);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> parsers;
+    for (int t = 0; t < workers; t++)
+        parsers.emplace_back([&] {
+            ImportParser parser(layout, options);
+            for (size_t i; (i = next++) < chunks.size() && !queue.stopping();)
+                parser.parse(file.data, file.data + chunks[i].first, file.data + chunks[i].second,
+                             i == 0 && (options & IMPORT_HEADER) != 0, rows, queue);
+            queue.done();
+        });
+
+    // released after the import, which may end with an exception pending
+    auto counters = env->GetLongArrayElements(progress, nullptr);
+    ImportProgress result;
+    if (rejected != nullptr) {
+        result.capacity = env->GetArrayLength(rejected);
+        result.offsets = env->GetLongArrayElements(rejected, nullptr);
+    }
+    // blocks are sent in the order they are parsed, each message keeps the offset of its record
+    std::unique_ptr<ImportBlock> block;
+    auto running = true;
+    while (running && queue.pop(block)) {
+        for (auto& rejection : block->rejected) {
+            result.reject(rejection.offset);
+            if (!keepGoing) {
+                throwRecordError(env, rejection.offset, rejection.column);
+                running = false;
+                break;
+            }
+        }
+        if (running && block->rows > 0)
+            running = batch.ready() ? batch.send(env, statusArray, *block, keepGoing, result)
+                                    : executeRecords(env, statusArray, dbHandle, trHandle, stHandle, *handle, base,
+                                                     layout, *block, dialect, keepGoing, result);
+    }
+    queue.stop();
+    for (auto& parser : parsers)
+        parser.join();
+    counters[0] = result.inserted;
+    counters[1] = result.rejected;
+    env->ReleaseLongArrayElements(progress, counters, 0);
+    if (result.offsets != nullptr)
+        env->ReleaseLongArrayElements(rejected, result.offsets, 0);
 }
 
-inline void setValueFloat(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jfloat value) {
-    switch (code) {
-        case SQL_FLOAT:
-            *(float *)data = value;
-            break;
-        case SQL_D_FLOAT:
-        case SQL_DOUBLE:
-            *(double *)data = value;
-            break;
-        default:
-            throwDataConversionError(env, index);
+/*
+ * Result spool
+ *
+ * Rows are packed by fbcore_pack_row into a memory mapped temporary file, deleted as soon as it is created (or on
+ * close on Windows), and their offsets into a second one; a row is restored into the XSQLDA it was fetched into by
+ * its number, so that a result set can be read again in any order without holding its rows on the heap or running the
+ * query again. Pages of the files are written back by the system under memory pressure.
+ */
+
+// a temporary file mapped read-write, grown by doubling
+class SpoolFile {
+public:
+    SpoolFile(const char* directory, size_t capacity) : capacity(capacity) {
+#ifdef _WIN32
+        char folder[MAX_PATH + 1];
+        char name[MAX_PATH + 1];
+        if (directory == nullptr) {
+            if (GetTempPathA(sizeof(folder), folder) == 0)
+                return;
+            directory = folder;
+        }
+        if (GetTempFileNameA(directory, "fbs", 0, name) == 0)
+            return;
+        file = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            file = nullptr;
+            return;
+        }
+#else
+        if (directory == nullptr)
+            directory = getenv("TMPDIR");
+        auto name = std::string(directory != nullptr && *directory != 0 ? directory : "/tmp") + "/fbspoolXXXXXX";
+        file = mkstemp(&name[0]);
+        if (file < 0)
+            return;
+        unlink(name.c_str());
+#endif
+        map();
+    }
+
+    ~SpoolFile() {
+        unmap();
+#ifdef _WIN32
+        if (file != nullptr)
+            CloseHandle(file);
+#else
+        if (file >= 0)
+            close(file);
+#endif
+    }
+
+    // the address where length bytes can be written at the end of the file, null when it cannot grow
+    char* reserve(size_t length) {
+        if (data == nullptr)
+            return nullptr;
+        if (size + length > capacity) {
+            unmap();
+            while (size + length > capacity)
+                capacity *= 2;
+            if (!map())
+                return nullptr;
+        }
+        return data + size;
+    }
+
+    char* data = nullptr;
+    size_t size = 0;
+
+private:
+    bool map() {
+#ifdef _WIN32
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)capacity >> 32),
+                                     (DWORD)capacity, nullptr);
+        if (mapping != nullptr)
+            data = (char*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, capacity);
+#else
+        if (ftruncate(file, (off_t)capacity) == 0) {
+            auto address = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+            if (address != MAP_FAILED)
+                data = (char*)address;
+        }
+#endif
+        return data != nullptr;
+    }
+
+    void unmap() {
+#ifdef _WIN32
+        if (data != nullptr)
+            UnmapViewOfFile(data);
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        if (data != nullptr)
+            munmap(data, capacity);
+#endif
+        data = nullptr;
+    }
+
+    size_t capacity;
+#ifdef _WIN32
+    HANDLE file = nullptr;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+};
+
+struct Spool {
+    Spool(const char* directory) : rows(directory, 16 << 20), offsets(directory, 1 << 20) {}
+
+    // appends the current row of the XSQLDA, false when a file cannot grow (see error)
+    bool append(const XSQLDA* sqlda) {
+        auto length = fbcore_packed_size(sqlda);
+        auto row = rows.reserve(length);
+        auto offset = offsets.reserve(sizeof(uint64_t));
+        if (row == nullptr || offset == nullptr) {
+            if (error == 0)
+                error = errno != 0 ? errno : ENOSPC;
+            return false;
+        }
+        fbcore_pack_row(sqlda, row);
+        auto start = (uint64_t)rows.size;
+        memcpy(offset, &start, sizeof(start));
+        rows.size += length;
+        offsets.size += sizeof(uint64_t);
+        return true;
+    }
+
+    // a file that failed to grow is no longer mapped, its rows cannot be read back
+    bool failed() const {
+        return rows.data == nullptr || offsets.data == nullptr;
+    }
+
+    jlong count() const {
+        return failed() ? 0 : (jlong)(offsets.size / sizeof(uint64_t));
+    }
+
+    SpoolFile rows;
+    SpoolFile offsets;
+    int error = 0;
+};
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_createSpool(JNIEnv *env, jclass clazz, jstring directory) {
+    auto name = directory != nullptr ? env->GetStringUTFChars(directory, nullptr) : nullptr;
+    auto spool = new Spool(name);
+    if (name != nullptr)
+        env->ReleaseStringUTFChars(directory, name);
+    if (spool->rows.data == nullptr || spool->offsets.data == nullptr) {
+        delete spool;
+        throwWriteError(env, errno != 0 ? errno : ENOSPC);
+        return 0;
     }
+    return reinterpret_cast<jlong>(spool);
 }
 
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueFloat(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jfloat value) {
-    setFieldValue<jfloat, setValueFloat>(env, sqlda, index, value);
+Java_com_progdigy_fbclient_API_freeSpool(JNIEnv *env, jclass clazz, jlong spool) {
+    delete reinterpret_cast<Spool*>(spool);
 }
 
-inline void setValueDouble(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jdouble value) {
-    switch (code) {
-        case SQL_D_FLOAT:
-        case SQL_DOUBLE:
-            *(double *)data = value;
-            break;
-        default:
-            throwDataConversionError(env, index);
-    }
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_getSpoolCount(JNIEnv *env, jclass clazz, jlong spool) {
+    return spool != 0 ? reinterpret_cast<Spool*>(spool)->count() : 0;
 }
 
 extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueDouble(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jdouble value) {
-    setFieldValue<jdouble, setValueDouble>(env, sqlda, index, value);
+JNIEXPORT jboolean JNICALL
+Java_com_progdigy_fbclient_API_spoolRows(JNIEnv *env, jclass clazz, jlong status, jlong st_handle, jlong sqlda,
+                                         jlong spool, jint count) {
+    JniScope scope(JniCall::spoolRows);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr || spool == 0) {
+        throwHandleError(env);
+        return JNI_FALSE;
+    }
+    auto target = reinterpret_cast<Spool*>(spool);
+    for (jint rows = 0; count <= 0 || rows < count; rows++) {
+        if (!target->append(*handle)) {
+            throwWriteError(env, target->error);
+            return JNI_FALSE;
+        }
+        auto ret = fetchRow(statusArray, stHandle, *handle);
+        if (ret != 0) {
+            if (ret != 100)
+                checkStatus(env, statusArray, ret);
+            return JNI_FALSE;
+        }
+    }
+    return JNI_TRUE;
 }
 
 extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueInt128(JNIEnv *env, jclass clazz, jlong sqlda, jint index,
-                                              jlong a, jlong b) {
+JNIEXPORT jboolean JNICALL
+Java_com_progdigy_fbclient_API_spoolSeek(JNIEnv *env, jclass clazz, jlong sqlda, jlong spool, jlong row) {
+    JniScope scope(JniCall::spoolSeek);
     auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    if (handle != nullptr) {
-        auto p = *handle;
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            if (v->sqlind != nullptr)
-                *v->sqlind = 0;
-            switch (v->sqltype & ~1) {
-                case SQL_INT128: {
-                    auto data = (FB_I128 *)v->sqldata;
-                    data->fb_data[0] = a;
-                    data->fb_data[1] = b;
-                    break;
-                }
-                default:
-                    throwDataConversionError(env, index);
-            }
-        } else
-            throwOutOfBoundError(env, index);
-    } else
+    if (handle == nullptr || *handle == nullptr || spool == 0) {
         throwHandleError(env);
+        return JNI_FALSE;
+    }
+    auto source = reinterpret_cast<Spool*>(spool);
+    if (source->failed()) {
+        throwWriteError(env, source->error != 0 ? source->error : ENOSPC);
+        return JNI_FALSE;
+    }
+    if (row < 0 || row >= source->count())
+        return JNI_FALSE;
+    uint64_t offset;
+    memcpy(&offset, source->offsets.data + row * sizeof(uint64_t), sizeof(offset));
+    fbcore_unpack_row(*handle, source->rows.data + offset);
+    return JNI_TRUE;
 }
 
-inline void setValueDate(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
-    switch (code) {
-        case SQL_TYPE_DATE:
-        case SQL_TIMESTAMP:
-        case SQL_TIMESTAMP_TZ:
-        case SQL_TIMESTAMP_TZ_EX:
-            *(ISC_DATE *)data = value + 40587;
-            break;
-        default:
-            throwDataConversionError(env, index);
+/*
+ * Events
+ *
+ * A dispatcher queues its events with isc_que_events. The callback, run by a thread of the client library, only
+ * copies the updated block and wakes the dispatch thread, attached to the JVM, which queues the events again then
+ * reports each event posted. Events posted before the block is queued again are counted by the server and reported
+ * together by the next callback.
+ */
+
+class EventDispatcher {
+public:
+    // called on the dispatch thread for each event posted, with its index in the block
+    using Posted = std::function<void(JNIEnv*, size_t, ISC_ULONG)>;
+    // called once the dispatcher is stopped, to release what onPosted holds
+    using Stopped = std::function<void(JNIEnv*)>;
+
+    EventDispatcher(JNIEnv* env, FB_API_HANDLE db) : db(db) {
+        env->GetJavaVM(&vm);
     }
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueDate(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
-    setFieldValue<jint, setValueDate>(env, sqlda, index, value);
-}
+    // appends an event to the block, false when the name is empty or longer than 255 bytes
+    bool add(const char* name, size_t length) {
+        auto position = block.size();
+        block.resize(position + length + 6);
+        position = fbcore_event_name(block.data(), position, name, length);
+        block.resize(position);
+        if (position == 0)
+            return false;
+        events++;
+        return true;
+    }
 
-inline void setValueTime(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
-    switch (code) {
-        case SQL_TYPE_TIME:
-        case SQL_TIME_TZ:
-        case SQL_TIME_TZ_EX:
-            *(ISC_TIME*) data = value * 10;
-            break;
-        case SQL_TIMESTAMP:
-        case SQL_TIMESTAMP_TZ:
-        case SQL_TIMESTAMP_TZ_EX:
-            (*(ISC_TIMESTAMP *)data).timestamp_time = value * 10;
-            break;
-        default:
-            throwDataConversionError(env, index);
+    // queues the events and starts the dispatch thread, the dispatcher is released by cancel from then on
+    ISC_STATUS start(ISC_STATUS* statusArray) {
+        auto ret = queue(statusArray);
+        if (ret == 0)
+            thread = std::thread(&EventDispatcher::run, this);
+        return ret;
     }
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueTime(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
-    setFieldValue<jint, setValueTime>(env, sqlda, index, value);
-}
+    // stops the dispatch thread and releases the dispatcher, from any thread
+    ISC_STATUS cancel(ISC_STATUS* statusArray) {
+        ISC_STATUS ret;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            cancelled = true;
+            ret = cancel_events(statusArray, &db, &id);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            signal.notify_one();
+        }
+        // cancelled by its own handler: the dispatch thread releases the dispatcher when the handler returns
+        if (thread.get_id() == std::this_thread::get_id()) {
+            detached = true;
+            thread.detach();
+        } else {
+            thread.join();
+            delete this;
+        }
+        return ret;
+    }
 
-inline void setValueTimeZone(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jint value) {
-    if (value >= 0 && value <= 65535) {
-        auto tz = (ISC_USHORT)value;
-        switch (code) {
-            case SQL_TIME_TZ:
-            case SQL_TIME_TZ_EX:
-                ((ISC_TIME_TZ *) data)->time_zone = tz;
-                break;
-            case SQL_TIMESTAMP_TZ:
-            case SQL_TIMESTAMP_TZ_EX:
-                ((ISC_TIMESTAMP_TZ *) data)->time_zone = tz;
+    Posted onPosted;
+    Stopped onStopped;
+
+private:
+    ISC_STATUS queue(ISC_STATUS* statusArray) {
+        return que_events(statusArray, &db, &id, (unsigned short)block.size(), block.data(), callback, this);
+    }
+
+    static void callback(void* argument, ISC_USHORT length, const ISC_UCHAR* updated) {
+        auto dispatcher = static_cast<EventDispatcher*>(argument);
+        std::lock_guard<std::mutex> lock(dispatcher->mutex);
+        // a zero length for cancelled events or a lost attachment
+        if (length == 0 || updated == nullptr)
+            return;
+        dispatcher->updated.assign(updated, updated + std::min((size_t)length, dispatcher->block.size()));
+        dispatcher->posted = true;
+        dispatcher->signal.notify_one();
+    }
+
+    void run() {
+        JNIEnv* env = nullptr;
+        JavaVMAttachArgs args = {JNI_VERSION_1_6, (char*)"Firebird events", nullptr};
+#ifdef __ANDROID__
+        auto attached = vm->AttachCurrentThreadAsDaemon(&env, &args) == JNI_OK;
+#else
+        auto attached = vm->AttachCurrentThreadAsDaemon((void**)&env, &args) == JNI_OK;
+#endif
+        ISC_STATUS statusArray[ISC_STATUS_LENGTH];
+        std::vector<ISC_ULONG> counts(events);
+        std::vector<ISC_UCHAR> current;
+        auto first = true;
+        while (attached && !cancelled) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                signal.wait(lock, [this] { return posted || cancelled; });
+                posted = false;
+                current.swap(updated);
+            }
+            if (cancelled || current.size() != block.size())
                 break;
-            default:
-                throwDataConversionError(env, index);
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (cancelled)
+                    break;
+                fbcore_event_counts(counts.data(), (int)counts.size(), block.data(), block.size(), current.data());
+                // stops when the attachment is lost
+                if (queue(statusArray) != 0)
+                    break;
+            }
+            // the first callback only brings the counts of the events when they were queued
+            if (first) {
+                first = false;
+                continue;
+            }
+            for (size_t i = 0; i < counts.size() && !cancelled; i++) {
+                if (counts[i] != 0)
+                    onPosted(env, i, counts[i]);
+            }
         }
-    } else
-        throwDataConversionError(env, index);
-}
+        if (attached) {
+            if (onStopped)
+                onStopped(env);
+            vm->DetachCurrentThread();
+        }
+        if (detached)
+            delete this;
+    }
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueTimeZone(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jint value) {
-    setFieldValue<jint, setValueTimeZone>(env, sqlda, index, value);
-}
+    JavaVM* vm = nullptr;
+    FB_API_HANDLE db;
+    ISC_LONG id = 0;
+    std::vector<ISC_UCHAR> block;
+    size_t events = 0;
+    std::thread thread;
+    std::vector<ISC_UCHAR> updated;
+    // guards updated and posted, taken by the callback
+    std::mutex mutex;
+    std::condition_variable signal;
+    // guards the queued events, never taken by the callback
+    std::mutex queueMutex;
+    std::atomic<bool> cancelled{false};
+    bool posted = false;
+    bool detached = false;
+};
 
 extern "C"
 JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_execute(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jlong st_handle, jshort dialect, jlong sqlda) {
+Java_com_progdigy_fbclient_API_queEvents(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jobjectArray names,
+                                         jobject listener) {
+    JniScope scope(JniCall::queEvents);
     const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
-    auto xsqlda   = reinterpret_cast<const XSQLDA **>(sqlda);
-    const auto da = xsqlda != nullptr?*xsqlda: nullptr;
-    return dsql_execute(statusArray, trHandle, stHandle, dialect, da);
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    if (que_events == nullptr || cancel_events == nullptr) {
+        throwUnsupportedError(env, "Events are");
+        return 0;
+    }
+    auto onEvent = env->GetMethodID(env->GetObjectClass(listener), "onEvent", "(Ljava/lang/String;I)V");
+    if (onEvent == nullptr)
+        return 0;
+    auto count = env->GetArrayLength(names);
+    if (count == 0) {
+        throwOutOfBoundError(env, 0);
+        return 0;
+    }
+    auto dispatcher = std::unique_ptr<EventDispatcher>(new EventDispatcher(env, *dbHandle));
+    auto target = env->NewGlobalRef(listener);
+    auto events = std::make_shared<std::vector<jobject>>();
+    dispatcher->onPosted = [target, onEvent, events](JNIEnv* env, size_t event, ISC_ULONG count) {
+        env->CallVoidMethod(target, onEvent, (*events)[event], (jint)count);
+        if (env->ExceptionCheck())
+            env->ExceptionDescribe(); // describes and clears, the listener keeps listening
+    };
+    dispatcher->onStopped = [target, events](JNIEnv* env) {
+        for (auto name : *events)
+            env->DeleteGlobalRef(name);
+        env->DeleteGlobalRef(target);
+    };
+    for (jsize i = 0; i < count; i++) {
+        auto name = (jstring)env->GetObjectArrayElement(names, i);
+        auto chars = env->GetStringUTFChars(name, nullptr);
+        auto added = dispatcher->add(chars, strlen(chars));
+        env->ReleaseStringUTFChars(name, chars);
+        events->push_back(env->NewGlobalRef(name));
+        env->DeleteLocalRef(name);
+        if (!added) {
+            dispatcher->onStopped(env);
+            throwOutOfBoundError(env, i);
+            return 0;
+        }
+    }
+    auto ret = dispatcher->start(statusArray);
+    if (ret != 0) {
+        dispatcher->onStopped(env);
+        checkStatus(env, statusArray, ret);
+        return 0;
+    }
+    return reinterpret_cast<jlong>(dispatcher.release());
 }
 
 extern "C"
 JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_execute2(JNIEnv *env, jclass clazz, jlong status, jlong tr_handle, jlong st_handle, jshort dialect, jlong input, jlong output) {
+Java_com_progdigy_fbclient_API_cancelEvents(JNIEnv *env, jclass clazz, jlong status, jlong events) {
+    JniScope scope(JniCall::cancelEvents);
     const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE*>(tr_handle);
-    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
-    auto i = reinterpret_cast<const XSQLDA **>(input);
-    auto o = reinterpret_cast<const XSQLDA **>(output);
-    const auto dai = i != nullptr?*i: nullptr;
-    const auto dao = o != nullptr?*o: nullptr;
-    return dsql_execute2(statusArray, trHandle, stHandle, dialect, dai, dao);
+    if (events == 0) {
+        throwHandleError(env);
+        return 0;
+    }
+    return reinterpret_cast<EventDispatcher*>(events)->cancel(statusArray);
 }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_fetch(JNIEnv *env, jclass clazz, jlong status, jlong st_handle, jlong sqlda) {
-    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
-    auto xsqlda   = reinterpret_cast<const XSQLDA **>(sqlda);
-    const auto da = xsqlda != nullptr?*xsqlda: nullptr;
-    return dsql_fetch(statusArray,  stHandle, SQLDA_VERSION1, da);
-}
+/*
+ * Result cache
+ *
+ * Result sets are kept in memory as rows packed by fbcore_pack_row, keyed by their SQL text and the packed row of
+ * their input XSQLDA. An entry is tagged with event names: the event dispatcher of the cache listens to every tag
+ * seen so far and drops the entries tagged with an event as soon as it is posted. The least recently used entries are
+ * evicted to keep the cache under its memory limit.
+ */
 
-extern "C"
-JNIEXPORT jboolean JNICALL
-Java_com_progdigy_fbclient_API_getIsNull(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
-    if (handle != nullptr) {
-        auto p = *handle;
-        if (index >= 0 && index < p->sqld) {
-            auto v = &p->sqlvar[index];
-            if (v->sqlind != nullptr)
-                return *v->sqlind!=0?JNI_TRUE:JNI_FALSE;
-            return JNI_FALSE;
-        } else
-            throwOutOfBoundError(env, index);
-    } else
-        throwHandleError(env);
+struct CachedRows {
+    std::string key;
+    std::vector<std::string> tags;
+    std::vector<char> rows;
+    std::vector<size_t> offsets;
 
-    return JNI_FALSE;
-}
+    size_t bytes() const {
+        return sizeof(CachedRows) + key.size() + rows.size() + offsets.size() * sizeof(size_t);
+    }
+};
 
-inline jboolean getValueBoolean(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_BOOLEAN:
-            return *(char *) data != FB_FALSE;
-        default:
-            throwDataConversionError(env, index);
-            return JNI_FALSE;
+// a reader handle pins its entry, which outlives an eviction until the reader is released
+typedef std::shared_ptr<const CachedRows> CachedRowsRef;
+
+class ResultCache {
+public:
+    ResultCache(FB_API_HANDLE db, size_t limit) : db(db), limit(limit) {}
+
+    ~ResultCache() {
+        if (dispatcher != nullptr) {
+            ISC_STATUS statusArray[ISC_STATUS_LENGTH];
+            dispatcher->cancel(statusArray);
+        }
     }
-}
 
-extern "C"
-JNIEXPORT jboolean JNICALL
-Java_com_progdigy_fbclient_API_getValueBoolean(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jboolean, getValueBoolean>(env, sqlda, index);
-}
+    CachedRowsRef lookup(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found == index.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        entries.splice(entries.begin(), entries, found->second);
+        return *found->second;
+    }
 
-inline jshort getValueShort(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_SHORT:
-            return *(ISC_SHORT *) data;
-        default:
-            throwDataConversionError(env, index);
-            return 0;
+    // stores an entry unless an event was posted since generation, when its rows were read
+    void store(const CachedRowsRef& rows, uint64_t since) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto size = rows->bytes();
+        if (since != generation || size > limit)
+            return;
+        auto found = index.find(rows->key);
+        if (found != index.end())
+            remove(found->second);
+        while (!entries.empty() && bytes + size > limit) {
+            remove(std::prev(entries.end()));
+            evictions++;
+        }
+        entries.push_front(rows);
+        index[rows->key] = entries.begin();
+        bytes += size;
     }
-}
 
-extern "C"
-JNIEXPORT jshort JNICALL
-Java_com_progdigy_fbclient_API_getValueShort(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jshort, getValueShort>(env, sqlda, index);
-}
+    // drops the entries tagged with an event, every entry when tag is null
+    void invalidate(const char* tag) {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        for (auto entry = entries.begin(); entry != entries.end();) {
+            auto& tags = (*entry)->tags;
+            auto next = std::next(entry);
+            if (tag == nullptr || std::find(tags.begin(), tags.end(), tag) != tags.end()) {
+                remove(entry);
+                invalidations++;
+            }
+            entry = next;
+        }
+    }
 
-inline jint getValueInt(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_LONG:
-            return *(ISC_LONG *) data;
-        case SQL_SHORT:
-            return *(ISC_SHORT *) data;
-        default:
-            throwDataConversionError(env, index);
+    /*
+     * Listens to the tags not listened to yet, with a new dispatcher queued before the previous one is cancelled so
+     * that no event is missed in between.
+     */
+    ISC_STATUS listen(JNIEnv* env, ISC_STATUS* statusArray, const std::vector<std::string>& tags) {
+        std::lock_guard<std::mutex> listening(listenMutex);
+        auto names = std::make_shared<std::vector<std::string>>(listened);
+        for (auto& tag : tags)
+            if (std::find(names->begin(), names->end(), tag) == names->end())
+                names->push_back(tag);
+        if (names->size() == listened.size())
             return 0;
+        auto next = std::unique_ptr<EventDispatcher>(new EventDispatcher(env, db));
+        for (auto& name : *names)
+            next->add(name.data(), name.size());
+        next->onPosted = [this, names](JNIEnv*, size_t event, ISC_ULONG) {
+            invalidate((*names)[event].c_str());
+        };
+        auto ret = next->start(statusArray);
+        if (ret != 0)
+            return ret;
+        auto previous = dispatcher;
+        dispatcher = next.release();
+        listened = *names;
+        // without the lock of the entries, the previous dispatcher may be invalidating
+        if (previous != nullptr) {
+            ISC_STATUS ignored[ISC_STATUS_LENGTH];
+            previous->cancel(ignored);
+        }
+        return 0;
     }
+
+    uint64_t since() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return generation;
+    }
+
+    void stats(jlong* values) {
+        std::lock_guard<std::mutex> lock(mutex);
+        values[0] = (jlong)hits;
+        values[1] = (jlong)misses;
+        values[2] = (jlong)entries.size();
+        values[3] = (jlong)bytes;
+        values[4] = (jlong)evictions;
+        values[5] = (jlong)invalidations;
+    }
+
+private:
+    void remove(std::list<CachedRowsRef>::iterator entry) {
+        bytes -= (*entry)->bytes();
+        index.erase((*entry)->key);
+        entries.erase(entry);
+    }
+
+    FB_API_HANDLE db;
+    size_t limit;
+    // guards the entries and the counters, taken by the dispatcher
+    std::mutex mutex;
+    std::list<CachedRowsRef> entries; // most recently used first
+    std::unordered_map<std::string, std::list<CachedRowsRef>::iterator> index;
+    size_t bytes = 0;
+    uint64_t generation = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+    // guards the dispatcher and the names it listens to
+    std::mutex listenMutex;
+    EventDispatcher* dispatcher = nullptr;
+    std::vector<std::string> listened;
+};
+
+// the SQL text, then the packed row of the input XSQLDA, if any
+static std::string cacheKey(JNIEnv* env, jstring sql, jlong input) {
+    auto chars = env->GetStringUTFChars(sql, nullptr);
+    std::string key(chars);
+    env->ReleaseStringUTFChars(sql, chars);
+    auto handle = reinterpret_cast<XSQLDA**>(input);
+    if (handle != nullptr && *handle != nullptr && (*handle)->sqld > 0) {
+        auto length = key.size() + 1;
+        key.resize(length + fbcore_packed_size(*handle));
+        fbcore_pack_row(*handle, &key[length]);
+    }
+    return key;
 }
 
 extern "C"
-JNIEXPORT jint JNICALL
-Java_com_progdigy_fbclient_API_getValueInt(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jint, getValueInt>(env, sqlda, index);
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_createResultCache(JNIEnv *env, jclass clazz, jlong db_handle, jlong max_bytes) {
+    auto dbHandle = reinterpret_cast<FB_API_HANDLE*>(db_handle);
+    if (dbHandle == nullptr) {
+        throwHandleError(env);
+        return 0;
+    }
+    return reinterpret_cast<jlong>(new ResultCache(*dbHandle, (size_t)std::max<jlong>(max_bytes, 0)));
 }
 
-inline jlong getValueLong(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_INT64:
-        case SQL_QUAD:
-            return *(ISC_INT64 *) data;
-        case SQL_LONG:
-            return *(ISC_LONG *) data;
-        case SQL_SHORT:
-            return *(ISC_SHORT *) data;
-        default:
-            throwDataConversionError(env, index);
-            return 0;
-    }
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_freeResultCache(JNIEnv *env, jclass clazz, jlong cache) {
+    delete reinterpret_cast<ResultCache*>(cache);
 }
 
 extern "C"
 JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_getValueLong(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jlong, getValueLong>(env, sqlda, index);
+Java_com_progdigy_fbclient_API_cacheLookup(JNIEnv *env, jclass clazz, jlong cache, jstring sql, jlong input) {
+    JniScope scope(JniCall::cacheLookup);
+    if (cache == 0) {
+        throwHandleError(env);
+        return 0;
+    }
+    auto rows = reinterpret_cast<ResultCache*>(cache)->lookup(cacheKey(env, sql, input));
+    return rows != nullptr ? reinterpret_cast<jlong>(new CachedRowsRef(rows)) : 0;
 }
 
-inline jstring getValueString(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
-                              int index, ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype) {
-    switch (code) {
-        case SQL_VARYING: {
-            if (subtype == 4) {
-                auto vary = (PARAMVARY*)data;
-                vary->vary_string[vary->vary_length] = 0;
-                return env->NewStringUTF((char*)&vary->vary_string);
-            }
-            break;
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_cacheRows(JNIEnv *env, jclass clazz, jlong status, jlong st_handle, jlong sqlda,
+                                         jlong cache, jstring sql, jlong input, jobjectArray tags) {
+    JniScope scope(JniCall::cacheRows);
+    const auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
+    auto stHandle = reinterpret_cast<FB_API_HANDLE*>(st_handle);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr || cache == 0) {
+        throwHandleError(env);
+        return 0;
+    }
+    auto target = reinterpret_cast<ResultCache*>(cache);
+    auto rows = std::make_shared<CachedRows>();
+    rows->key = cacheKey(env, sql, input);
+    auto count = tags != nullptr ? env->GetArrayLength(tags) : 0;
+    for (jsize i = 0; i < count; i++) {
+        auto tag = (jstring)env->GetObjectArrayElement(tags, i);
+        auto chars = env->GetStringUTFChars(tag, nullptr);
+        rows->tags.emplace_back(chars);
+        env->ReleaseStringUTFChars(tag, chars);
+        env->DeleteLocalRef(tag);
+        // the length of an event name is a byte of the event block
+        if (rows->tags.back().empty() || rows->tags.back().size() > 255) {
+            throwOutOfBoundError(env, i);
+            return 0;
         }
-        case SQL_TEXT: {
-            if (subtype == 4) {
-                auto size = utf8_size(data, len / subtype, len);
-                data[size] = 0;
-                return env->NewStringUTF(data);
-            }
-            break;
+    }
+    if (count > 0) {
+        if (que_events == nullptr || cancel_events == nullptr) {
+            throwUnsupportedError(env, "Events are");
+            return 0;
+        }
+        auto ret = target->listen(env, statusArray, rows->tags);
+        if (ret != 0) {
+            checkStatus(env, statusArray, ret);
+            return 0;
         }
-        case SQL_BLOB:
-            if (subtype == 1) {
-                isc_blob_handle blob = 0;
-                char* str = nullptr;
-                auto ret = open_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
-                if (ret == 0) {
-                    char buffer[9];
-                    char info = isc_info_blob_total_length;
-                    ret = blob_info(status, &blob, 1, &info, sizeof buffer, &buffer);
-                    if (ret == 0) {
-                        auto length = (int)*(ISC_ULONG*)&buffer[3];
-                        if (length >= 0) {
-                            str = (char*)malloc(length + 1);
-                            str[length] = 0;
-                            if (length > 0) {
-                                auto toRead = std::min(length, (int)std::numeric_limits<ISC_SHORT>::max());
-                                ISC_USHORT size = 0;
-                                auto p = str;
-                                ret = get_segment(status, &blob, &size, toRead, p);
-                                while (ret == 0 || status[1] == isc_segment) {
-                                    length -= size;
-                                    if (length <= 0)
-                                        break;
-                                    toRead = std::min(length, (int)std::numeric_limits<ISC_SHORT>::max());
-                                    p += size;
-                                    ret = get_segment(status, &blob, &size, toRead, p);
-                                }
-                            }
-                        }
-                    }
-                    ret = close_blob(status, &blob);
-                    if (str != nullptr) {
-                        auto jstr = env->NewStringUTF(str);
-                        free(str);
-                        return jstr;
-                    }
-                }
-                checkStatus(env, status, ret);
-            }
-            break;
-        default:
-            break;
     }
-
-    throwDataConversionError(env, index);
-    return nullptr;
+    // the events are listened to before the rows are read, an event posted while reading them discards the entry
+    auto since = target->since();
+    ISC_STATUS ret;
+    while ((ret = fetchRow(statusArray, stHandle, *handle)) == 0) {
+        auto offset = rows->rows.size();
+        rows->rows.resize(offset + fbcore_packed_size(*handle));
+        fbcore_pack_row(*handle, &rows->rows[offset]);
+        rows->offsets.push_back(offset);
+    }
+    if (ret != 100) {
+        checkStatus(env, statusArray, ret);
+        return 0;
+    }
+    rows->rows.shrink_to_fit();
+    rows->offsets.shrink_to_fit();
+    target->store(rows, since);
+    return reinterpret_cast<jlong>(new CachedRowsRef(rows));
 }
 
 extern "C"
-JNIEXPORT jstring JNICALL
-Java_com_progdigy_fbclient_API_getValueString(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, jint index) {
-    return getFieldValue<jstring, getValueString>(env, status, db_handle, tr_handle, sqlda, index);
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_getCachedCount(JNIEnv *env, jclass clazz, jlong rows) {
+    return rows != 0 ? (jlong)(*reinterpret_cast<CachedRowsRef*>(rows))->offsets.size() : 0;
 }
 
-inline jbyteArray getValueByteArray(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
-                                    int index, ISC_SCHAR* data, ISC_SHORT code, ISC_SHORT len, ISC_SHORT subtype) {
-    switch (code) {
-        case SQL_VARYING: {
-            auto vary = (PARAMVARY*)data;
-            auto arr = env->NewByteArray(vary->vary_length);
-            auto bytes = env->GetByteArrayElements(arr, nullptr);
-            memcpy(bytes, vary->vary_string, vary->vary_length);
-            env->ReleaseByteArrayElements(arr, bytes, JNI_COMMIT);
-            return arr;
-        }
-        case SQL_TEXT: {
-            auto arr = env->NewByteArray(len);
-            auto bytes = env->GetByteArrayElements(arr, nullptr);
-            memcpy(bytes, data, len);
-            env->ReleaseByteArrayElements(arr, bytes, JNI_COMMIT);
-            return arr;
-        }
-        case SQL_BLOB: {
-            isc_blob_handle blob = 0;
-            jbyteArray arr = nullptr;
-            auto ret = open_blob(status, dbHandle, trHandle, &blob, (GDS_QUAD*)data);
-            if (ret == 0) {
-                char buffer[9];
-                char info = isc_info_blob_total_length;
-                ret = blob_info(status, &blob, 1, &info, sizeof buffer, &buffer);
-                if (ret == 0) {
-                    auto length = (int)*(ISC_ULONG*)&buffer[3];
-                    arr = env->NewByteArray(length);
-                    if (length > 0) {
-                        auto bytes = env->GetByteArrayElements(arr, nullptr);
-                        auto toRead = std::min(length, (int)std::numeric_limits<ISC_SHORT>::max());
-                        ISC_USHORT size = 0;
-                        auto p = bytes;
-                        ret = get_segment(status, &blob, &size, toRead, p);
-                        while (ret == 0 || status[1] == isc_segment) {
-                            length -= size;
-                            if (length <= 0)
-                                break;
-                            toRead = std::min(length, (int)std::numeric_limits<ISC_SHORT>::max());
-                            p += size;
-                            ret = get_segment(status, &blob, &size, toRead, p);
-                        }
-                        env->ReleaseByteArrayElements(arr, bytes, JNI_COMMIT);
-                    }
-                }
-                ret = close_blob(status, &blob);
-            }
-            checkStatus(env, status, ret);
-            return arr;
-        }
-        default:
-            throwDataConversionError(env, index);
-            return nullptr;
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_progdigy_fbclient_API_cacheSeek(JNIEnv *env, jclass clazz, jlong sqlda, jlong rows, jlong row) {
+    JniScope scope(JniCall::cacheSeek);
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr || rows == 0) {
+        throwHandleError(env);
+        return JNI_FALSE;
     }
+    auto& source = *reinterpret_cast<CachedRowsRef*>(rows);
+    if (row < 0 || row >= (jlong)source->offsets.size())
+        return JNI_FALSE;
+    fbcore_unpack_row(*handle, source->rows.data() + source->offsets[row]);
+    return JNI_TRUE;
 }
 
 extern "C"
-JNIEXPORT jbyteArray JNICALL
-Java_com_progdigy_fbclient_API_getValueByteArray(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle, jlong sqlda, jint index) {
-    return getFieldValue<jbyteArray, getValueByteArray>(env, status, db_handle, tr_handle, sqlda, index);
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_releaseCachedRows(JNIEnv *env, jclass clazz, jlong rows) {
+    delete reinterpret_cast<CachedRowsRef*>(rows);
 }
 
-inline jfloat getValueFloat(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    if (code == SQL_FLOAT)
-        return *(float *) data;
-    else {
-        throwDataConversionError(env, index);
-        return 0;
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_cacheInvalidate(JNIEnv *env, jclass clazz, jlong cache, jstring tag) {
+    if (cache == 0) {
+        throwHandleError(env);
+        return;
     }
+    auto chars = tag != nullptr ? env->GetStringUTFChars(tag, nullptr) : nullptr;
+    reinterpret_cast<ResultCache*>(cache)->invalidate(chars);
+    if (chars != nullptr)
+        env->ReleaseStringUTFChars(tag, chars);
 }
 
+// hits, misses, entries, bytes, evictions, invalidations
 extern "C"
-JNIEXPORT jfloat JNICALL
-Java_com_progdigy_fbclient_API_getValueFloat(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jfloat, getValueFloat>(env, sqlda, index);
+JNIEXPORT jlongArray JNICALL
+Java_com_progdigy_fbclient_API_getCacheStats(JNIEnv *env, jclass clazz, jlong cache) {
+    jlong values[6] = {};
+    if (cache != 0)
+        reinterpret_cast<ResultCache*>(cache)->stats(values);
+    auto result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, values);
+    return result;
+}
+
+/*
+ * Arrays
+ *
+ * An array column holds the id of its array, whose elements are read and written by slices: isc_array_get_slice and
+ * isc_array_put_slice build the slice description from the descriptor of the column, restricted to the requested
+ * bounds, and move the slice in one round trip. Descriptors come from isc_array_lookup_bounds, which reads the
+ * system tables; they are cached per attachment, relation and field until the attachment is detached.
+ */
+
+static std::mutex arrayMutex;
+static std::unordered_map<const FB_API_HANDLE*, std::unordered_map<std::string, ISC_ARRAY_DESC>> arrayDescriptors;
+
+static void forgetArrayDescriptors(const FB_API_HANDLE* db) {
+    std::lock_guard<std::mutex> lock(arrayMutex);
+    arrayDescriptors.erase(db);
 }
 
-inline jdouble getValueDouble(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_FLOAT:
-            return *(float *) data;
-        case SQL_DOUBLE:
-        case SQL_D_FLOAT:
-            return *(double *) data;
-        default:
-            throwDataConversionError(env, index);
-            return 0;
+// the column type of the elements, the one the scalar kernels take, or 0 for the types they do not convert
+static int arrayElementType(const ISC_ARRAY_DESC& desc) {
+    switch (desc.array_desc_dtype) {
+        case blr_short: return SQL_SHORT;
+        case blr_long: return SQL_LONG;
+        case blr_int64: return SQL_INT64;
+        case blr_float: return SQL_FLOAT;
+        case blr_double: return SQL_DOUBLE;
+        case blr_d_float: return SQL_D_FLOAT;
+        default: return 0;
     }
 }
 
-extern "C"
-JNIEXPORT jdouble JNICALL
-Java_com_progdigy_fbclient_API_getValueDouble(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jdouble, getValueDouble>(env, sqlda, index);
+static size_t arrayElementSize(const ISC_ARRAY_DESC& desc) {
+    return desc.array_desc_length + (desc.array_desc_dtype == blr_varying ? sizeof(ISC_USHORT) : 0);
 }
 
-inline jlongArray getValueInt128(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_SHORT: {
-            auto arr = env->NewLongArray(2);
-            auto i = env->GetLongArrayElements(arr, nullptr);
-            auto int16 =  *(ISC_SHORT *)data;
-            i[0] = int16;
-            i[1] =  (int16>=0)?0:-1;
-            env->ReleaseLongArrayElements(arr, i, JNI_COMMIT);
-            return arr;
-        }
-        case SQL_LONG: {
-            auto arr = env->NewLongArray(2);
-            auto i = env->GetLongArrayElements(arr, nullptr);
-            auto int32 =  *(ISC_LONG *)data;
-            i[0] = int32;
-            i[1] =  (int32>=0)?0:-1;
-            env->ReleaseLongArrayElements(arr, i, JNI_COMMIT);
-            return arr;
+/**
+ * @brief A slice of the array column of a JNI call.
+ *
+ * open resolves the column and its descriptor, narrowed to the requested bounds; get and put move the elements
+ * between the slice buffer and the database. Every failure throws and returns false.
+ */
+struct ArraySlice {
+    ISC_STATUS* status;
+    FB_API_HANDLE* db;
+    FB_API_HANDLE* tr;
+    XSQLVAR* var;
+    ISC_ARRAY_DESC desc;
+    size_t count;
+    size_t size;
+
+    ArraySlice(jlong status, jlong db_handle, jlong tr_handle) : status(reinterpret_cast<ISC_STATUS*>(status)),
+        db(reinterpret_cast<FB_API_HANDLE*>(db_handle)), tr(reinterpret_cast<FB_API_HANDLE*>(tr_handle)),
+        var(nullptr), desc(), count(0), size(0) {}
+
+    /**
+     * @param bounds The lower and upper bound of each dimension, or null for the whole array.
+     * @param read True when the elements are read, the column must not be null then.
+     */
+    bool open(JNIEnv* env, jlong sqlda, jint index, jintArray bounds, bool read) {
+        if (client.array_lookup_bounds == nullptr || client.array_get_slice == nullptr ||
+            client.array_put_slice == nullptr) {
+            throwUnsupportedError(env, "Arrays are");
+            return false;
         }
-        case SQL_QUAD:
-        case SQL_INT64: {
-            auto arr = env->NewLongArray(2);
-            auto i = env->GetLongArrayElements(arr, nullptr);
-            auto int64 =  *(ISC_INT64*)data;
-            i[0] = int64;
-            i[1] =  (int64>=0)?0:-1;
-            env->ReleaseLongArrayElements(arr, i, JNI_COMMIT);
-            return arr;
+        auto handle = reinterpret_cast<XSQLDA**>(sqlda);
+        if (handle == nullptr || *handle == nullptr) {
+            throwHandleError(env);
+            return false;
         }
-        case SQL_INT128: {
-            auto arr = env->NewLongArray(2);
-            auto i = env->GetLongArrayElements(arr, nullptr);
-            memcpy(i, data, sizeof (FB_I128));
-            env->ReleaseLongArrayElements(arr, i, JNI_COMMIT);
-            return arr;
+        auto p = *handle;
+        if (index < 0 || index >= p->sqld) {
+            throwOutOfBoundError(env, index);
+            return false;
         }
-        default:
+        var = &p->sqlvar[index];
+        if ((var->sqltype & ~1) != SQL_ARRAY) {
             throwDataConversionError(env, index);
-            return nullptr;
+            return false;
+        }
+        if (read && var->sqlind != nullptr && *var->sqlind != 0) {
+            throwNullError(env);
+            return false;
+        }
+        if (!lookup(env))
+            return false;
+        if (bounds != nullptr) {
+            auto length = env->GetArrayLength(bounds);
+            if (length != desc.array_desc_dimensions * 2) {
+                throwOutOfBoundError(env, length);
+                return false;
+            }
+            jint values[32];
+            env->GetIntArrayRegion(bounds, 0, length, values);
+            for (int i = 0; i < desc.array_desc_dimensions; i++) {
+                auto& bound = desc.array_desc_bounds[i];
+                if (values[i * 2] < bound.array_bound_lower || values[i * 2 + 1] > bound.array_bound_upper ||
+                    values[i * 2] > values[i * 2 + 1]) {
+                    throwOutOfBoundError(env, i);
+                    return false;
+                }
+                bound.array_bound_lower = (short)values[i * 2];
+                bound.array_bound_upper = (short)values[i * 2 + 1];
+            }
+        }
+        size = arrayElementSize(desc);
+        count = 1;
+        for (int i = 0; i < desc.array_desc_dimensions; i++)
+            count *= (size_t)(desc.array_desc_bounds[i].array_bound_upper - desc.array_desc_bounds[i].array_bound_lower + 1);
+        if (count * size > (size_t)std::numeric_limits<ISC_LONG>::max()) {
+            throwOutOfBoundError(env, index);
+            return false;
+        }
+        return true;
     }
-}
 
-extern "C"
-JNIEXPORT jlongArray JNICALL
-Java_com_progdigy_fbclient_API_getValueInt128(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jlongArray, getValueInt128>(env, sqlda, index);
-}
+    /**
+     * @brief Reads the slice into buffer, of count * size bytes; count is updated to the elements returned.
+     */
+    bool get(JNIEnv* env, void* buffer) {
+        auto length = (ISC_LONG)(count * size);
+        auto ret = array_get_slice(status, db, tr, (ISC_QUAD*)var->sqldata, &desc, buffer, &length);
+        if (ret != 0) {
+            checkStatus(env, status, ret);
+            return false;
+        }
+        count = (size_t)length / size;
+        return true;
+    }
 
-inline jint getValueDate(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_TYPE_DATE:
-        case SQL_TIMESTAMP:
-        case SQL_TIMESTAMP_TZ:
-        case SQL_TIMESTAMP_TZ_EX:
-            //LocalDate(1858, 11, 17).toEpochDays() = -40587
-            return *(ISC_DATE *)data - 40587;
-        default:
-            throwDataConversionError(env, index);
-            return 0;
+    /**
+     * @brief Writes the slice from buffer, of count * size bytes, into a new array whose id is set into the column.
+     *
+     * Elements outside the slice keep the values of the array the column held, when it was not null.
+     */
+    bool put(JNIEnv* env, void* buffer) {
+        ISC_QUAD id = {0, 0};
+        if (var->sqlind == nullptr || *var->sqlind == 0)
+            id = *(ISC_QUAD*)var->sqldata;
+        auto length = (ISC_LONG)(count * size);
+        auto ret = array_put_slice(status, db, tr, &id, &desc, buffer, &length);
+        if (ret != 0) {
+            checkStatus(env, status, ret);
+            return false;
+        }
+        *(ISC_QUAD*)var->sqldata = id;
+        if (var->sqlind != nullptr)
+            *var->sqlind = 0;
+        return true;
     }
-}
 
-extern "C"
-JNIEXPORT jint JNICALL
-Java_com_progdigy_fbclient_API_getValueDate(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jint, getValueDate>(env, sqlda, index);
+private:
+    bool lookup(JNIEnv* env) {
+        std::string relation(var->relname, std::min<size_t>((size_t)var->relname_length, sizeof(var->relname)));
+        std::string field(var->sqlname, std::min<size_t>((size_t)var->sqlname_length, sizeof(var->sqlname)));
+        auto key = relation + '.' + field;
+        {
+            std::lock_guard<std::mutex> lock(arrayMutex);
+            auto found = arrayDescriptors.find(db);
+            if (found != arrayDescriptors.end()) {
+                auto entry = found->second.find(key);
+                if (entry != found->second.end()) {
+                    desc = entry->second;
+                    return true;
+                }
+            }
+        }
+        auto ret = array_lookup_bounds(status, db, tr, relation.c_str(), field.c_str(), &desc);
+        if (ret != 0) {
+            checkStatus(env, status, ret);
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(arrayMutex);
+        arrayDescriptors[db][key] = desc;
+        return true;
+    }
+};
+
+// converts the elements of a slice with the kernel of the scalar getter, false when the type does not convert
+template<typename T, typename V, int (*kernel)(const ISC_SCHAR*, int, V*)>
+static bool decodeSlice(const ArraySlice& slice, const char* data, T* values) {
+    auto code = arrayElementType(slice.desc);
+    for (size_t i = 0; i < slice.count; i++) {
+        V value;
+        if (kernel(data + i * slice.size, code, &value) != FBCORE_OK)
+            return false;
+        values[i] = (T)value;
+    }
+    return true;
 }
 
-inline jint getValueTime(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_TYPE_TIME:
-        case SQL_TIME_TZ:
-        case SQL_TIME_TZ_EX:
-            return (jint)(*(ISC_TIME *)data / 10);
-        case SQL_TIMESTAMP:
-        case SQL_TIMESTAMP_TZ:
-        case SQL_TIMESTAMP_TZ_EX:
-            return (jint)(((ISC_TIMESTAMP *)data)->timestamp_time / 10);
-        default:
-            throwDataConversionError(env, index);
-            return 0;
+template<typename T, typename V, int (*kernel)(ISC_SCHAR*, int, V)>
+static bool encodeSlice(const ArraySlice& slice, char* data, const T* values) {
+    auto code = arrayElementType(slice.desc);
+    for (size_t i = 0; i < slice.count; i++) {
+        if (kernel(data + i * slice.size, code, (V)values[i]) != FBCORE_OK)
+            return false;
     }
+    return true;
 }
 
+// lower and upper bound of each dimension
 extern "C"
-JNIEXPORT jint JNICALL
-Java_com_progdigy_fbclient_API_getValueTime(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jint, getValueTime>(env, sqlda, index);
+JNIEXPORT jintArray JNICALL
+Java_com_progdigy_fbclient_API_getArrayBounds(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                              jlong tr_handle, jlong sqlda, jint index) {
+    JniScope scope(JniCall::getArrayBounds);
+    ArraySlice slice(status, db_handle, tr_handle);
+    if (!slice.open(env, sqlda, index, nullptr, false))
+        return nullptr;
+    jint values[32];
+    auto dimensions = slice.desc.array_desc_dimensions;
+    for (int i = 0; i < dimensions; i++) {
+        values[i * 2] = slice.desc.array_desc_bounds[i].array_bound_lower;
+        values[i * 2 + 1] = slice.desc.array_desc_bounds[i].array_bound_upper;
+    }
+    auto result = env->NewIntArray(dimensions * 2);
+    if (result != nullptr)
+        env->SetIntArrayRegion(result, 0, dimensions * 2, values);
+    return result;
 }
 
-inline jint getValueTimeZone(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_TIME_TZ:
-        case SQL_TIME_TZ_EX:
-            return ((ISC_TIME_TZ *)data)->time_zone;
-        case SQL_TIMESTAMP_TZ:
-        case SQL_TIMESTAMP_TZ_EX:
-            return ((ISC_TIMESTAMP_TZ *)data)->time_zone;
-        default:
-            throwDataConversionError(env, index);
-            return 0;
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_progdigy_fbclient_API_getArrayInt(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                           jlong sqlda, jint index, jintArray bounds) {
+    JniScope scope(JniCall::getArrayInt);
+    ArraySlice slice(status, db_handle, tr_handle);
+    if (!slice.open(env, sqlda, index, bounds, true))
+        return nullptr;
+    std::vector<char> data(slice.count * slice.size);
+    if (!slice.get(env, data.data()))
+        return nullptr;
+    auto result = env->NewIntArray((jsize)slice.count);
+    if (result == nullptr)
+        return nullptr;
+    if (arrayElementType(slice.desc) == SQL_LONG) {
+        env->SetIntArrayRegion(result, 0, (jsize)slice.count, (const jint*)data.data());
+        return result;
+    }
+    std::vector<jint> values(slice.count);
+    if (!decodeSlice<jint, ISC_LONG, fbcore_get_int>(slice, data.data(), values.data())) {
+        throwDataConversionError(env, index);
+        return nullptr;
     }
+    env->SetIntArrayRegion(result, 0, (jsize)slice.count, values.data());
+    return result;
 }
 
 extern "C"
-JNIEXPORT jint JNICALL
-Java_com_progdigy_fbclient_API_getValueTimeZone(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jint, getValueTimeZone>(env, sqlda, index);
+JNIEXPORT jdoubleArray JNICALL
+Java_com_progdigy_fbclient_API_getArrayDouble(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                              jlong tr_handle, jlong sqlda, jint index, jintArray bounds) {
+    JniScope scope(JniCall::getArrayDouble);
+    ArraySlice slice(status, db_handle, tr_handle);
+    if (!slice.open(env, sqlda, index, bounds, true))
+        return nullptr;
+    std::vector<char> data(slice.count * slice.size);
+    if (!slice.get(env, data.data()))
+        return nullptr;
+    auto result = env->NewDoubleArray((jsize)slice.count);
+    if (result == nullptr)
+        return nullptr;
+    auto code = arrayElementType(slice.desc);
+    if (code == SQL_DOUBLE || code == SQL_D_FLOAT) {
+        env->SetDoubleArrayRegion(result, 0, (jsize)slice.count, (const jdouble*)data.data());
+        return result;
+    }
+    std::vector<jdouble> values(slice.count);
+    if (!decodeSlice<jdouble, double, fbcore_get_double>(slice, data.data(), values.data())) {
+        throwDataConversionError(env, index);
+        return nullptr;
+    }
+    env->SetDoubleArrayRegion(result, 0, (jsize)slice.count, values.data());
+    return result;
 }
 
+// the slice is read straight into the buffer, elements in the layout of the client
 extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_blobOpen(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
-                                        jlong blob_handle, jlong blob_id) {
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto dbHandle = reinterpret_cast<FB_API_HANDLE *>(db_handle);
-    auto trHandle = reinterpret_cast<FB_API_HANDLE *>(tr_handle);
-    auto blobHandle = reinterpret_cast<FB_API_HANDLE *>(blob_handle);
-    return open_blob(statusArray, dbHandle, trHandle, blobHandle, (GDS_QUAD*)&blob_id);
+JNIEXPORT jint JNICALL
+Java_com_progdigy_fbclient_API_getArrayBuffer(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                              jlong tr_handle, jlong sqlda, jint index, jintArray bounds,
+                                              jobject buffer, jint position) {
+    JniScope scope(JniCall::getArrayBuffer);
+    ArraySlice slice(status, db_handle, tr_handle);
+    if (!slice.open(env, sqlda, index, bounds, true))
+        return -1;
+    size_t capacity = 0;
+    auto address = directBuffer(env, buffer, capacity);
+    if (address == nullptr)
+        return -1;
+    if (position < 0 || (size_t)position > capacity) {
+        throwOutOfBoundError(env, position);
+        return -1;
+    }
+    if (capacity - (size_t)position < slice.count * slice.size)
+        return -1;
+    if (!slice.get(env, address + position))
+        return -1;
+    return position + (jint)(slice.count * slice.size);
 }
 
 extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_blobClose(JNIEnv *env, jclass clazz, jlong status,
-                                         jlong blob_handle) {
-    auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
-    auto blobHandle = reinterpret_cast<FB_API_HANDLE *>(blob_handle);
-    auto ret = close_blob(statusArray, blobHandle);
-    *blobHandle = 0;
-    return ret;
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setArrayColumn(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jstring relation,
+                                              jstring field) {
+    JniScope scope(JniCall::setArrayColumn);
+    auto handle = reinterpret_cast<XSQLDA**>(sqlda);
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return;
+    }
+    auto p = *handle;
+    if (index < 0 || index >= p->sqld) {
+        throwOutOfBoundError(env, index);
+        return;
+    }
+    auto v = &p->sqlvar[index];
+    auto chars = env->GetStringUTFChars(relation, nullptr);
+    v->relname_length = (ISC_SHORT)std::min(strlen(chars), sizeof(v->relname));
+    memcpy(v->relname, chars, (size_t)v->relname_length);
+    env->ReleaseStringUTFChars(relation, chars);
+    chars = env->GetStringUTFChars(field, nullptr);
+    v->sqlname_length = (ISC_SHORT)std::min(strlen(chars), sizeof(v->sqlname));
+    memcpy(v->sqlname, chars, (size_t)v->sqlname_length);
+    env->ReleaseStringUTFChars(field, chars);
 }
 
-inline void setValueBlobId(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code, jlong value) {
-    switch (code) {
-        case SQL_BLOB:
-            *(jlong *)data = value;
-            break;
-        default:
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setArrayInt(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
+                                           jlong sqlda, jint index, jintArray bounds, jintArray values) {
+    JniScope scope(JniCall::setArrayInt);
+    ArraySlice slice(status, db_handle, tr_handle);
+    if (!slice.open(env, sqlda, index, bounds, false))
+        return;
+    if ((size_t)env->GetArrayLength(values) != slice.count) {
+        throwOutOfBoundError(env, env->GetArrayLength(values));
+        return;
+    }
+    std::vector<char> data(slice.count * slice.size);
+    if (arrayElementType(slice.desc) == SQL_LONG)
+        env->GetIntArrayRegion(values, 0, (jsize)slice.count, (jint*)data.data());
+    else {
+        std::vector<jint> source(slice.count);
+        env->GetIntArrayRegion(values, 0, (jsize)slice.count, source.data());
+        if (!encodeSlice<jint, ISC_LONG, fbcore_set_int>(slice, data.data(), source.data())) {
             throwDataConversionError(env, index);
+            return;
+        }
     }
+    slice.put(env, data.data());
 }
 
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_progdigy_fbclient_API_setValueBlobId(JNIEnv *env, jclass clazz, jlong sqlda, jint index, jlong value) {
-    setFieldValue<jlong, setValueBlobId>(env, sqlda, index, value);
-}
-
-inline jlong getValueBlobId(JNIEnv* env, int index, ISC_SCHAR* data, ISC_SHORT code) {
-    switch (code) {
-        case SQL_BLOB:
-            return *((jlong *)data);
-        default:
+Java_com_progdigy_fbclient_API_setArrayDouble(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                              jlong tr_handle, jlong sqlda, jint index, jintArray bounds,
+                                              jdoubleArray values) {
+    JniScope scope(JniCall::setArrayDouble);
+    ArraySlice slice(status, db_handle, tr_handle);
+    if (!slice.open(env, sqlda, index, bounds, false))
+        return;
+    if ((size_t)env->GetArrayLength(values) != slice.count) {
+        throwOutOfBoundError(env, env->GetArrayLength(values));
+        return;
+    }
+    std::vector<char> data(slice.count * slice.size);
+    auto code = arrayElementType(slice.desc);
+    if (code == SQL_DOUBLE || code == SQL_D_FLOAT)
+        env->GetDoubleArrayRegion(values, 0, (jsize)slice.count, (jdouble*)data.data());
+    else {
+        std::vector<jdouble> source(slice.count);
+        env->GetDoubleArrayRegion(values, 0, (jsize)slice.count, source.data());
+        if (!encodeSlice<jdouble, double, fbcore_set_double>(slice, data.data(), source.data())) {
             throwDataConversionError(env, index);
-            return 0;
+            return;
+        }
     }
+    slice.put(env, data.data());
 }
 
+// the slice is written straight from the buffer, its length must be the one of the slice
 extern "C"
-JNIEXPORT jlong JNICALL
-Java_com_progdigy_fbclient_API_getValueBlobId(JNIEnv *env, jclass clazz, jlong sqlda, jint index) {
-    return getFieldValue<jlong, getValueBlobId>(env, sqlda, index);
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setArrayBuffer(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                              jlong tr_handle, jlong sqlda, jint index, jintArray bounds,
+                                              jobject buffer, jint position, jint length) {
+    JniScope scope(JniCall::setArrayBuffer);
+    ArraySlice slice(status, db_handle, tr_handle);
+    if (!slice.open(env, sqlda, index, bounds, false))
+        return;
+    size_t capacity = 0;
+    auto address = directBuffer(env, buffer, capacity);
+    if (address == nullptr)
+        return;
+    if (position < 0 || length < 0 || (size_t)position + (size_t)length > capacity ||
+        (size_t)length != slice.count * slice.size) {
+        throwOutOfBoundError(env, length);
+        return;
+    }
+    slice.put(env, address + position);
 }
 
 extern "C"
 JNIEXPORT jint JNICALL
 Java_com_progdigy_fbclient_API_blobRead(JNIEnv *env, jclass clazz, jlong status, jlong blob_handle, jbyteArray buffer, jint offset, jint length) {
+    JniScope scope(JniCall::blobRead);
     auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
     auto blobHandle = reinterpret_cast<FB_API_HANDLE *>(blob_handle);
     auto arrayLength = env->GetArrayLength(buffer);
@@ -1669,26 +6095,7 @@ Java_com_progdigy_fbclient_API_blobRead(JNIEnv *env, jclass clazz, jlong status,
     if (arrayLength > 0 && offset >= 0 && length > 0) {
         arrayLength = std::min(arrayLength - offset, length);
         auto arr = env->GetByteArrayElements(buffer, nullptr);
-
-        auto p = &arr[offset];
-        ISC_USHORT size = 0;
-
-        while (arrayLength > 0) {
-            auto toRead = std::min(arrayLength, (jsize)std::numeric_limits<ISC_SHORT>::max());
-            auto ret = get_segment(statusArray, blobHandle, &size, toRead, p);
-            auto success = ret == 0 || statusArray[1] == isc_segment;
-            while (success && size == 0) {
-                ret = get_segment(statusArray, blobHandle, &size, toRead, p);
-                success = ret == 0 || statusArray[1] == isc_segment;
-            }
-            if (size > 0) {
-                p += size;
-                arrayLength -= size;
-                total += size;
-                size = 0;
-            } else
-                break;
-        }
+        total = fbcore_blob_read(statusArray, blobHandle, (char*)&arr[offset], arrayLength, get_segment);
         env->ReleaseByteArrayElements(buffer, arr, JNI_COMMIT);
     }
     return total;
@@ -1697,13 +6104,12 @@ Java_com_progdigy_fbclient_API_blobRead(JNIEnv *env, jclass clazz, jlong status,
 extern "C"
 JNIEXPORT jlong JNICALL
 Java_com_progdigy_fbclient_API_blobLength(JNIEnv *env, jclass clazz, jlong status, jlong blob_handle) {
+    JniScope scope(JniCall::blobLength);
     auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
     auto blobHandle = reinterpret_cast<FB_API_HANDLE*>(blob_handle);
-    char buffer[9];
-    char info = isc_info_blob_total_length;
-    auto ret = blob_info(statusArray, blobHandle, 1, &info, sizeof buffer, &buffer);
-    if (ret == 0)
-        return *(ISC_ULONG*)&buffer[3];
+    ISC_LONG length = 0;
+    if (fbcore_blob_length(statusArray, blobHandle, &length, blob_info) == 0)
+        return (ISC_ULONG)length;
     else
         return 0;
 }
@@ -1712,6 +6118,7 @@ extern "C"
 JNIEXPORT jlong JNICALL
 Java_com_progdigy_fbclient_API_blobCreate(JNIEnv *env, jclass clazz, jlong status, jlong db_handle, jlong tr_handle,
                                         jlong blob_handle) {
+    JniScope scope(JniCall::blobCreate);
     auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
     auto dbHandle = reinterpret_cast<FB_API_HANDLE *>(db_handle);
     auto trHandle = reinterpret_cast<FB_API_HANDLE *>(tr_handle);
@@ -1724,6 +6131,7 @@ Java_com_progdigy_fbclient_API_blobCreate(JNIEnv *env, jclass clazz, jlong statu
 extern "C"
 JNIEXPORT jint JNICALL
 Java_com_progdigy_fbclient_API_blobWrite(JNIEnv *env, jclass clazz, jlong status, jlong blob_handle, jbyteArray buffer, jint offset, jint length) {
+    JniScope scope(JniCall::blobWrite);
     auto statusArray = reinterpret_cast<ISC_STATUS*>(status);
     auto blobHandle = reinterpret_cast<FB_API_HANDLE *>(blob_handle);
     auto arrayLength = env->GetArrayLength(buffer);
@@ -1731,18 +6139,349 @@ Java_com_progdigy_fbclient_API_blobWrite(JNIEnv *env, jclass clazz, jlong status
     if (arrayLength > 0 && offset >= 0 && length > 0) {
         arrayLength = std::min(arrayLength - offset, length);
         auto arr = env->GetByteArrayElements(buffer, nullptr);
-        auto p = &arr[offset];
-        while (arrayLength > 0) {
-            auto toWrite = std::min(arrayLength, (jsize)std::numeric_limits<ISC_SHORT>::max());
-            if (toWrite > 0 && put_segment(statusArray, blobHandle, toWrite, p) == 0) {
-                p += toWrite;
-                arrayLength -= toWrite;
-                total += toWrite;
-            } else
-                break;
+        total = fbcore_blob_write(statusArray, blobHandle, (const char*)&arr[offset], arrayLength, put_segment);
+        env->ReleaseByteArrayElements(buffer, arr, JNI_ABORT);
+    }
+    return total;
+}
+
+/*
+ * Blob streams
+ *
+ * A blob parameter is written from a file, a descriptor or an InputStream in chunks of 64 KB, each chunk sent in
+ * segments as it is read, then its id is set into the column; the content is never held whole in memory.
+ */
+
+#ifdef _WIN32
+#define STREAM_OPEN(path) _open(path, _O_RDONLY | _O_BINARY)
+#define STREAM_READ(fd, data, size) _read(fd, data, (unsigned int)(size))
+#define STREAM_CLOSE _close
+#else
+#define STREAM_OPEN(path) open(path, O_RDONLY)
+#define STREAM_READ read
+#define STREAM_CLOSE close
+#endif
+
+constexpr int BLOB_STREAM_CHUNK = 64 << 10;
+
+/**
+ * @brief Creates a blob, writes the chunks of a source into it and sets its id into a BLOB column.
+ *
+ * @param read Reads at most size bytes into a buffer, returns the number of bytes read, 0 at the end of the source
+ * or -1 when it fails with an exception pending.
+ * @return The number of bytes written, -1 when the column is not set, an exception is pending then.
+ */
+template<typename Read>
+static jlong writeBlobColumn(JNIEnv* env, ISC_STATUS* status, FB_API_HANDLE* dbHandle, FB_API_HANDLE* trHandle,
+                             jlong sqlda, jint index, Read read) {
+    auto handle = reinterpret_cast<XSQLDA **>(sqlda);
+    if (handle == nullptr || *handle == nullptr) {
+        throwHandleError(env);
+        return -1;
+    }
+    auto p = *handle;
+    if (index < 0 || index >= p->sqld) {
+        throwOutOfBoundError(env, index);
+        return -1;
+    }
+    auto v = &p->sqlvar[index];
+    if ((v->sqltype & ~1) != SQL_BLOB) {
+        throwDataConversionError(env, index);
+        return -1;
+    }
+    ISC_QUAD id;
+    isc_blob_handle blob = 0;
+    if (checkStatus(env, status, create_blob(status, dbHandle, trHandle, &blob, &id)) != 0)
+        return -1;
+    std::unique_ptr<char[]> buffer(new char[BLOB_STREAM_CHUNK]);
+    jlong total = 0;
+    int size;
+    while ((size = read(buffer.get(), BLOB_STREAM_CHUNK)) > 0) {
+        if (fbcore_blob_write(status, &blob, buffer.get(), size, put_segment) < size) {
+            size = -1;
+            checkStatus(env, status, status[1]);
+            break;
         }
-        env->ReleaseByteArrayElements(buffer, arr, JNI_COMMIT);
+        total += size;
+    }
+    if (size < 0) {
+        // the partial content is discarded, its id is not set
+        ISC_STATUS_ARRAY cancelling;
+        cancel_blob(cancelling, &blob);
+        return -1;
+    }
+    if (checkStatus(env, status, close_blob(status, &blob)) != 0)
+        return -1;
+    memcpy(v->sqldata, &id, sizeof(id));
+    if (v->sqlind != nullptr)
+        *v->sqlind = 0;
+    return total;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_setValueBlobFile(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                                jlong tr_handle, jlong sqlda, jint index, jstring path, jint fd) {
+    JniScope scope(JniCall::setValueBlobFile);
+    auto file = (int)fd;
+    if (path != nullptr) {
+        auto name = env->GetStringUTFChars(path, nullptr);
+        file = STREAM_OPEN(name);
+        env->ReleaseStringUTFChars(path, name);
+        if (file < 0) {
+            throwFileError(env, path);
+            return -1;
+        }
+    }
+    auto total = writeBlobColumn(env, reinterpret_cast<ISC_STATUS*>(status),
+                                 reinterpret_cast<FB_API_HANDLE*>(db_handle),
+                                 reinterpret_cast<FB_API_HANDLE*>(tr_handle), sqlda, index,
+                                 [env, file](char* data, int size) {
+        for (;;) {
+            auto count = (int)STREAM_READ(file, data, size);
+            if (count >= 0)
+                return count;
+            if (errno != EINTR) {
+                throwReadError(env, errno);
+                return -1;
+            }
+        }
+    });
+    if (path != nullptr)
+        STREAM_CLOSE(file);
+    return total;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_progdigy_fbclient_API_setValueBlobStream(JNIEnv *env, jclass clazz, jlong status, jlong db_handle,
+                                                  jlong tr_handle, jlong sqlda, jint index, jobject stream) {
+    JniScope scope(JniCall::setValueBlobStream);
+    if (stream == nullptr) {
+        throwHandleError(env);
+        return -1;
     }
+    auto read = env->GetMethodID(env->GetObjectClass(stream), "read", "([BII)I");
+    if (read == nullptr)
+        return -1;
+    auto chunk = env->NewByteArray(BLOB_STREAM_CHUNK);
+    if (chunk == nullptr)
+        return -1;
+    auto total = writeBlobColumn(env, reinterpret_cast<ISC_STATUS*>(status),
+                                 reinterpret_cast<FB_API_HANDLE*>(db_handle),
+                                 reinterpret_cast<FB_API_HANDLE*>(tr_handle), sqlda, index,
+                                 [env, stream, read, chunk](char* data, int size) {
+        // the stream blocks until a byte is read and may return less than asked
+        auto count = (int)env->CallIntMethod(stream, read, chunk, 0, size);
+        if (env->ExceptionCheck())
+            return -1;
+        if (count < 0)
+            return 0;
+        env->GetByteArrayRegion(chunk, 0, count, reinterpret_cast<jbyte*>(data));
+        return count;
+    });
+    env->DeleteLocalRef(chunk);
     return total;
 }
 
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setLatencyTracking(JNIEnv *env, jclass clazz, jboolean enabled) {
+    setInterposition(TRACE_LATENCY, enabled);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_resetLatency(JNIEnv *env, jclass clazz) {
+    for (auto& histogram : clientLatency)
+        histogram.reset();
+    for (auto& histogram : jniLatency)
+        histogram.reset();
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_progdigy_fbclient_API_latencyNames(JNIEnv *env, jclass clazz) {
+    auto result = env->NewObjectArray(CLIENT_CALL_COUNT + JNI_CALL_COUNT, env->FindClass("java/lang/String"), nullptr);
+    for (int i = 0; i < CLIENT_CALL_COUNT; i++) {
+        auto name = env->NewStringUTF((std::string("client.") + clientCallNames[i]).c_str());
+        env->SetObjectArrayElement(result, i, name);
+        env->DeleteLocalRef(name);
+    }
+    for (int i = 0; i < JNI_CALL_COUNT; i++) {
+        auto name = env->NewStringUTF((std::string("jni.") + jniCallNames[i]).c_str());
+        env->SetObjectArrayElement(result, CLIENT_CALL_COUNT + i, name);
+        env->DeleteLocalRef(name);
+    }
+    return result;
+}
+
+// count, total, max, p50, p90, p99, p999 for each histogram, in the order of latencyNames
+constexpr int LATENCY_FIELDS = 7;
+
+static void latencyValues(const LatencyHistogram& histogram, LatencyHistogram::Snapshot& snapshot, jlong* values) {
+    histogram.snapshot(snapshot);
+    values[0] = (jlong)snapshot.count;
+    values[1] = (jlong)snapshot.total;
+    values[2] = (jlong)snapshot.max;
+    values[3] = (jlong)snapshot.percentile(0.5);
+    values[4] = (jlong)snapshot.percentile(0.9);
+    values[5] = (jlong)snapshot.percentile(0.99);
+    values[6] = (jlong)snapshot.percentile(0.999);
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_progdigy_fbclient_API_latencyValues(JNIEnv *env, jclass clazz) {
+    constexpr int length = (CLIENT_CALL_COUNT + JNI_CALL_COUNT) * LATENCY_FIELDS;
+    jlong values[length];
+    auto snapshot = new LatencyHistogram::Snapshot();
+    for (int i = 0; i < CLIENT_CALL_COUNT; i++)
+        latencyValues(clientLatency[i], *snapshot, &values[i * LATENCY_FIELDS]);
+    for (int i = 0; i < JNI_CALL_COUNT; i++)
+        latencyValues(jniLatency[i], *snapshot, &values[(CLIENT_CALL_COUNT + i) * LATENCY_FIELDS]);
+    delete snapshot;
+    auto result = env->NewLongArray(length);
+    env->SetLongArrayRegion(result, 0, length, values);
+    return result;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setSlowQueryLog(JNIEnv *env, jclass clazz, jlong threshold, jint capacity) {
+    std::lock_guard<std::mutex> lock(slowQueryMutex);
+    slowQueryCapacity = capacity > 0 ? capacity : 0;
+    while (slowQueries.size() > slowQueryCapacity)
+        slowQueries.pop_front();
+    if (threshold <= 0 || capacity <= 0) {
+        slowQueryThreshold.store(0, std::memory_order_relaxed);
+        trackedStatements.clear();
+    } else
+        slowQueryThreshold.store(threshold, std::memory_order_relaxed);
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_progdigy_fbclient_API_drainSlowQueries(JNIEnv *env, jclass clazz) {
+    std::deque<SlowQuery> queries;
+    {
+        std::lock_guard<std::mutex> lock(slowQueryMutex);
+        queries.swap(slowQueries);
+    }
+    auto queryClass = env->FindClass("com/progdigy/fbclient/SlowQuery");
+    if (queryClass == nullptr)
+        return nullptr;
+    auto constructor = env->GetMethodID(queryClass, "<init>",
+                                        "(Ljava/lang/String;Ljava/lang/String;JJJJJLjava/lang/String;)V");
+    if (constructor == nullptr)
+        return nullptr;
+    auto result = env->NewObjectArray((jsize)queries.size(), queryClass, nullptr);
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto& query = queries[i];
+        auto sql = env->NewStringUTF(query.sql.c_str());
+        auto parameters = env->NewStringUTF(query.parameters.c_str());
+        auto plan = query.plan.empty() ? nullptr : env->NewStringUTF(query.plan.c_str());
+        auto object = env->NewObject(queryClass, constructor, sql, parameters, (jlong)query.elapsed,
+                                     (jlong)query.selected, (jlong)query.inserted, (jlong)query.updated,
+                                     (jlong)query.deleted, plan);
+        env->SetObjectArrayElement(result, (jsize)i, object);
+        env->DeleteLocalRef(object);
+        env->DeleteLocalRef(sql);
+        env->DeleteLocalRef(parameters);
+        if (plan != nullptr)
+            env->DeleteLocalRef(plan);
+    }
+    return result;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_setCallCounting(JNIEnv *env, jclass clazz, jboolean enabled) {
+    setInterposition(TRACE_COUNTS, enabled);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_resetCallCounts(JNIEnv *env, jclass clazz) {
+    for (auto& counters : clientCounters) {
+        counters.calls.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.errors.store(0, std::memory_order_relaxed);
+    }
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_progdigy_fbclient_API_callCountNames(JNIEnv *env, jclass clazz) {
+    auto result = env->NewObjectArray(CLIENT_CALL_COUNT, env->FindClass("java/lang/String"), nullptr);
+    for (int i = 0; i < CLIENT_CALL_COUNT; i++) {
+        auto name = env->NewStringUTF(clientCallNames[i]);
+        env->SetObjectArrayElement(result, i, name);
+        env->DeleteLocalRef(name);
+    }
+    return result;
+}
+
+// calls, bytes, errors for each function of the client library, in the order of callCountNames
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_progdigy_fbclient_API_callCountValues(JNIEnv *env, jclass clazz) {
+    constexpr int length = CLIENT_CALL_COUNT * 3;
+    jlong values[length];
+    for (int i = 0; i < CLIENT_CALL_COUNT; i++) {
+        values[i * 3] = (jlong)clientCounters[i].calls.load(std::memory_order_relaxed);
+        values[i * 3 + 1] = (jlong)clientCounters[i].bytes.load(std::memory_order_relaxed);
+        values[i * 3 + 2] = (jlong)clientCounters[i].errors.load(std::memory_order_relaxed);
+    }
+    auto result = env->NewLongArray(length);
+    env->SetLongArrayRegion(result, 0, length, values);
+    return result;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_startRecording(JNIEnv *env, jclass clazz, jstring path) {
+    auto file = env->GetStringUTFChars(path, nullptr);
+    auto opened = clientLog.open(file);
+    env->ReleaseStringUTFChars(path, file);
+    if (opened)
+        setInterposition(TRACE_RECORD, true);
+    else
+        throwFileError(env, path);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_stopRecording(JNIEnv *env, jclass clazz) {
+    setInterposition(TRACE_RECORD, false);
+    clientLog.close();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_startReplay(JNIEnv *env, jclass clazz, jstring path) {
+    auto file = env->GetStringUTFChars(path, nullptr);
+    auto loaded = clientReplay.load(file);
+    env->ReleaseStringUTFChars(path, file);
+    if (loaded) {
+        std::lock_guard<std::mutex> lock(interpositionMutex);
+#define CLIENT_REPLAY(name) client.name = replay_##name;
+        CLIENT_FUNCTIONS(CLIENT_REPLAY)
+#undef CLIENT_REPLAY
+        updateInterposition();
+        clientLoaded.store(true, std::memory_order_release);
+    } else
+        throwFileError(env, path);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_progdigy_fbclient_API_stopReplay(JNIEnv *env, jclass clazz) {
+    std::lock_guard<std::mutex> lock(interpositionMutex);
+#define CLIENT_LIBRARY(name) client.name = library.name;
+    CLIENT_FUNCTIONS(CLIENT_LIBRARY)
+#undef CLIENT_LIBRARY
+    updateInterposition();
+    clientLoaded.store(library.attach_database != nullptr, std::memory_order_release);
+}
@@ -0,0 +1,165 @@
+#ifndef JNIFBCLIENT_HISTOGRAM_H
+#define JNIFBCLIENT_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds.
+ */
+inline uint64_t nanoTime() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Lock-free latency histogram with HDR-style log-linear buckets.
+ *
+ * Values are nanoseconds. Each power of two is split into 32 sub-buckets, which bounds the relative error of a
+ * recorded value to about 3%, up to 2^40 ns (about 18 minutes), larger values are clamped.
+ *
+ * Recording is wait-free: every thread is assigned one of the shards and only performs relaxed atomic increments
+ * on it, so concurrent threads rarely touch the same cache lines. Shards are merged when a snapshot is taken.
+ *
+ * Instances are meant to have static storage duration, all counters are then zero-initialized and untouched
+ * pages cost no memory.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+    static constexpr int MAX_BITS = 40;
+    static constexpr uint64_t MAX_VALUE = (1ULL << MAX_BITS) - 1;
+    static constexpr int COUNTS_LENGTH = (MAX_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKET_HALF;
+    static constexpr int SHARDS = 8;
+
+    /**
+     * @brief Merged content of all the shards of a histogram.
+     */
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t total = 0;
+        uint64_t max = 0;
+        uint64_t counts[COUNTS_LENGTH] = {0};
+
+        /**
+         * @brief Returns the value below which the given fraction of the recorded values fall.
+         *
+         * @param fraction The fraction, between 0 and 1 (0.99 for the 99th percentile).
+         * @return The highest value equivalent to the percentile bucket, never more than the recorded maximum.
+         */
+        uint64_t percentile(double fraction) const {
+            if (count == 0)
+                return 0;
+            auto target = (uint64_t)(fraction * (double)count);
+            if (target < 1)
+                target = 1;
+            uint64_t cumulated = 0;
+            for (int i = 0; i < COUNTS_LENGTH; i++) {
+                cumulated += counts[i];
+                if (cumulated >= target) {
+                    auto value = highestEquivalentValue(i);
+                    return value < max ? value : max;
+                }
+            }
+            return max;
+        }
+    };
+
+    /**
+     * @brief Records a value in the shard of the calling thread.
+     *
+     * @param value The value in nanoseconds.
+     */
+    void record(uint64_t value) {
+        auto& shard = shards[shardIndex()];
+        shard.counts[indexOf(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.total.fetch_add(value, std::memory_order_relaxed);
+        auto max = shard.max.load(std::memory_order_relaxed);
+        while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+            // max is reloaded by compare_exchange_weak
+        }
+    }
+
+    /**
+     * @brief Merges the shards into a snapshot.
+     *
+     * Values recorded while the snapshot is taken may or may not be part of it.
+     *
+     * @param snapshot The snapshot to fill.
+     */
+    void snapshot(Snapshot& snapshot) const {
+        snapshot = Snapshot();
+        for (auto& shard : shards) {
+            snapshot.count += shard.count.load(std::memory_order_relaxed);
+            if (shard.count.load(std::memory_order_relaxed) == 0)
+                continue;
+            snapshot.total += shard.total.load(std::memory_order_relaxed);
+            auto max = shard.max.load(std::memory_order_relaxed);
+            if (max > snapshot.max)
+                snapshot.max = max;
+            for (int i = 0; i < COUNTS_LENGTH; i++)
+                snapshot.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Clears all the shards.
+     *
+     * Values recorded concurrently with a reset may be partially lost.
+     */
+    void reset() {
+        for (auto& shard : shards) {
+            if (shard.count.exchange(0, std::memory_order_relaxed) == 0)
+                continue;
+            shard.total.store(0, std::memory_order_relaxed);
+            shard.max.store(0, std::memory_order_relaxed);
+            for (auto& c : shard.counts)
+                c.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Returns the index of the bucket holding a value.
+     */
+    static int indexOf(uint64_t value) {
+        if (value > MAX_VALUE)
+            value = MAX_VALUE;
+        if (value < SUB_BUCKET_COUNT)
+            return (int)value;
+        int bucket = (63 - __builtin_clzll(value)) - (SUB_BUCKET_BITS - 1);
+        return ((bucket + 1) << (SUB_BUCKET_BITS - 1)) + (int)(value >> bucket) - SUB_BUCKET_HALF;
+    }
+
+    /**
+     * @brief Returns the highest value that falls in the bucket of the given index.
+     */
+    static uint64_t highestEquivalentValue(int index) {
+        if (index < SUB_BUCKET_COUNT)
+            return (uint64_t)index;
+        int bucket = (index >> (SUB_BUCKET_BITS - 1)) - 1;
+        uint64_t sub = (uint64_t)(index & (SUB_BUCKET_HALF - 1)) + SUB_BUCKET_HALF;
+        return ((sub + 1) << bucket) - 1;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> max;
+        std::atomic<uint64_t> counts[COUNTS_LENGTH];
+    };
+
+    static unsigned shardIndex() {
+        static std::atomic<unsigned> next(0);
+        static thread_local unsigned shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return shard;
+    }
+
+    Shard shards[SHARDS];
+};
+
+#endif // JNIFBCLIENT_HISTOGRAM_H
@@ -0,0 +1,443 @@
+#ifndef JNIFBCLIENT_RECORDER_H
+#define JNIFBCLIENT_RECORDER_H
+
+#include <ibase.h>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Binary log of the calls made to the client library.
+ *
+ * The log starts with the "FBCL" magic and a version byte, followed by one record per call:
+ *
+ *   call id (byte), return value (zigzag varint), status vector chunk (only for a non zero status), fields...
+ *
+ * Every field is either a handle value (varint) or a chunk (varint length followed by the bytes), so a reader can
+ * skip the input fields it does not need. XSQLDA metadata and message data are encoded inside chunks:
+ *
+ *   metadata: sqld, then for each described variable sqltype, sqlscale, sqlsubtype, sqllen and the four names
+ *   data:     sqld, then for each variable 0 when null, or 1 followed by the length and the bytes of the value
+ */
+
+constexpr char CLIENT_LOG_MAGIC[4] = {'F', 'B', 'C', 'L'};
+constexpr unsigned char CLIENT_LOG_VERSION = 1;
+
+/**
+ * @brief Output file of the recorder, records are appended atomically.
+ */
+class ClientLog {
+public:
+    bool open(const char* path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file != nullptr)
+            fclose(file);
+        file = fopen(path, "wb");
+        if (file == nullptr)
+            return false;
+        fwrite(CLIENT_LOG_MAGIC, 1, sizeof(CLIENT_LOG_MAGIC), file);
+        fputc(CLIENT_LOG_VERSION, file);
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file != nullptr) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    void append(const std::string& record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file != nullptr)
+            fwrite(record.data(), 1, record.size(), file);
+    }
+
+private:
+    std::mutex mutex;
+    FILE* file = nullptr;
+};
+
+/**
+ * @brief Serializes one call into a record, appended to the log when the object is destroyed.
+ */
+class LogRecord {
+public:
+    /**
+     * @param log The log receiving the record.
+     * @param call The id of the called function.
+     * @param ret The value returned by the function.
+     * @param status The status vector, nullptr for functions that do not return a status.
+     */
+    LogRecord(ClientLog& log, int call, ISC_STATUS ret, const ISC_STATUS* status) : log(log) {
+        buffer.push_back((char)call);
+        signedVarint(ret);
+        if (status != nullptr && ret != 0) {
+            std::string chunk;
+            std::swap(buffer, chunk);
+            for (int i = 0; i < ISC_STATUS_LENGTH; ) {
+                auto arg = status[i++];
+                signedVarint(arg);
+                if (arg == isc_arg_end || i >= ISC_STATUS_LENGTH)
+                    break;
+                if (arg == isc_arg_cstring) {
+                    if (i + 1 >= ISC_STATUS_LENGTH)
+                        break;
+                    auto length = (size_t)status[i++];
+                    bytes((const char*)status[i++], length);
+                } else if (arg == isc_arg_string || arg == isc_arg_interpreted || arg == isc_arg_sql_state) {
+                    auto string = (const char*)status[i++];
+                    bytes(string, string != nullptr ? strlen(string) : 0);
+                } else
+                    signedVarint(status[i++]);
+            }
+            std::swap(buffer, chunk);
+            bytes(chunk.data(), chunk.size());
+        }
+    }
+
+    ~LogRecord() {
+        log.append(buffer);
+    }
+
+    void handle(const FB_API_HANDLE* value) {
+        varint(value != nullptr ? (uint64_t)*value : 0);
+    }
+
+    void bytes(const void* data, size_t length) {
+        varint(data != nullptr ? length : 0);
+        if (data != nullptr)
+            buffer.append((const char*)data, length);
+    }
+
+    void string(const void* data, size_t length) {
+        bytes(data, (length == 0 && data != nullptr) ? strlen((const char*)data) : length);
+    }
+
+    void metadata(const XSQLDA* sqlda) {
+        std::string chunk;
+        std::swap(buffer, chunk);
+        auto count = sqlda != nullptr ? sqlda->sqld : 0;
+        varint(count);
+        for (int i = 0; sqlda != nullptr && i < count && i < sqlda->sqln; i++) {
+            auto var = &sqlda->sqlvar[i];
+            varint((uint16_t)var->sqltype);
+            signedVarint(var->sqlscale);
+            signedVarint(var->sqlsubtype);
+            varint((uint16_t)var->sqllen);
+            bytes(var->sqlname, (size_t)var->sqlname_length);
+            bytes(var->relname, (size_t)var->relname_length);
+            bytes(var->ownname, (size_t)var->ownname_length);
+            bytes(var->aliasname, (size_t)var->aliasname_length);
+        }
+        std::swap(buffer, chunk);
+        bytes(chunk.data(), chunk.size());
+    }
+
+    void data(const XSQLDA* sqlda) {
+        std::string chunk;
+        std::swap(buffer, chunk);
+        auto count = sqlda != nullptr ? sqlda->sqld : 0;
+        varint(count);
+        for (int i = 0; i < count; i++) {
+            auto var = &sqlda->sqlvar[i];
+            if (var->sqlind != nullptr && *var->sqlind != 0) {
+                varint(0);
+                continue;
+            }
+            varint(1);
+            if ((var->sqltype & ~1) == SQL_VARYING)
+                bytes(var->sqldata, sizeof(ISC_USHORT) + *(ISC_USHORT*)var->sqldata);
+            else
+                bytes(var->sqldata, (size_t)var->sqllen);
+        }
+        std::swap(buffer, chunk);
+        bytes(chunk.data(), chunk.size());
+    }
+
+private:
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back((char)(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((char)value);
+    }
+
+    void signedVarint(int64_t value) {
+        varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    ClientLog& log;
+    std::string buffer;
+};
+
+/**
+ * @brief Recorded log loaded in memory, consumed sequentially by the replayed functions.
+ */
+class ClientReplay {
+public:
+    bool load(const char* path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        log.clear();
+        strings.clear();
+        position = 0;
+        auto file = fopen(path, "rb");
+        if (file == nullptr)
+            return false;
+        char buffer[65536];
+        size_t length;
+        while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            log.insert(log.end(), buffer, buffer + length);
+        fclose(file);
+        if (log.size() < sizeof(CLIENT_LOG_MAGIC) + 1 ||
+            memcmp(log.data(), CLIENT_LOG_MAGIC, sizeof(CLIENT_LOG_MAGIC)) != 0 ||
+            (unsigned char)log[sizeof(CLIENT_LOG_MAGIC)] != CLIENT_LOG_VERSION) {
+            log.clear();
+            return false;
+        }
+        position = sizeof(CLIENT_LOG_MAGIC) + 1;
+        return true;
+    }
+
+private:
+    friend class LogReader;
+
+    std::mutex mutex;
+    std::vector<char> log;
+    size_t position = 0;
+    // strings referenced by the replayed status vectors
+    std::deque<std::string> strings;
+};
+
+/**
+ * @brief Reads the next record of a replayed log, for the lifetime of the object.
+ *
+ * When the record is not a call to the expected function, when the log is exhausted or when the record is truncated,
+ * the call fails with isc_random, the record is left in the log and every accessor leaves its output untouched.
+ */
+class LogReader {
+public:
+    LogReader(ClientReplay& replay, int call, ISC_STATUS* status) : replay(replay), lock(replay.mutex),
+        status(status), start(replay.position) {
+        if (replay.position < replay.log.size() && (unsigned char)replay.log[replay.position] == call) {
+            replay.position++;
+            ret = (ISC_STATUS)signedVarint();
+            if (status != nullptr) {
+                status[0] = isc_arg_gds;
+                status[1] = 0;
+                status[2] = isc_arg_end;
+                if (ret != 0)
+                    statusVector(status);
+            }
+        }
+        if (!failed && replay.position == start)
+            fail(start < replay.log.size() ? "Replayed call out of sequence" : "End of the replayed log");
+    }
+
+    ISC_STATUS result() const {
+        return failed ? isc_random : ret;
+    }
+
+    void handle(FB_API_HANDLE* value) {
+        auto recorded = varint();
+        if (!failed && value != nullptr)
+            *value = (FB_API_HANDLE)recorded;
+    }
+
+    /**
+     * @brief Copies a recorded chunk into a buffer, truncated to its capacity.
+     *
+     * @return The number of bytes copied.
+     */
+    size_t bytes(void* data, size_t capacity) {
+        const char* chunk;
+        auto length = this->chunk(chunk);
+        if (failed || data == nullptr)
+            return 0;
+        if (length > capacity)
+            length = capacity;
+        memcpy(data, chunk, length);
+        return length;
+    }
+
+    void skip() {
+        const char* chunk;
+        this->chunk(chunk);
+    }
+
+    void metadata(XSQLDA* sqlda) {
+        const char* chunk;
+        auto length = this->chunk(chunk);
+        if (failed || sqlda == nullptr)
+            return;
+        Nested nested(*this, chunk, length);
+        sqlda->sqld = (ISC_SHORT)varint();
+        for (int i = 0; i < sqlda->sqld && i < sqlda->sqln && !failed; i++) {
+            auto var = &sqlda->sqlvar[i];
+            var->sqltype = (ISC_SHORT)varint();
+            var->sqlscale = (ISC_SHORT)signedVarint();
+            var->sqlsubtype = (ISC_SHORT)signedVarint();
+            var->sqllen = (ISC_SHORT)varint();
+            var->sqlname_length = (ISC_SHORT)bytes(var->sqlname, sizeof(var->sqlname));
+            var->relname_length = (ISC_SHORT)bytes(var->relname, sizeof(var->relname));
+            var->ownname_length = (ISC_SHORT)bytes(var->ownname, sizeof(var->ownname));
+            var->aliasname_length = (ISC_SHORT)bytes(var->aliasname, sizeof(var->aliasname));
+        }
+    }
+
+    void data(const XSQLDA* sqlda) {
+        const char* chunk;
+        auto length = this->chunk(chunk);
+        if (failed || sqlda == nullptr)
+            return;
+        Nested nested(*this, chunk, length);
+        auto count = (int)varint();
+        for (int i = 0; i < count && i < sqlda->sqld && !failed; i++) {
+            auto var = &sqlda->sqlvar[i];
+            auto present = varint() != 0;
+            if (var->sqlind != nullptr)
+                *var->sqlind = present ? 0 : -1;
+            if (present) {
+                auto capacity = (size_t)var->sqllen;
+                if ((var->sqltype & ~1) == SQL_VARYING)
+                    capacity += sizeof(ISC_USHORT);
+                bytes(var->sqldata, capacity);
+            }
+        }
+    }
+
+private:
+    // redirects the reads of the reader to the content of a chunk
+    struct Nested {
+        Nested(LogReader& reader, const char* chunk, size_t length) : reader(reader),
+            cursor(reader.cursor), limit(reader.limit) {
+            reader.cursor = chunk;
+            reader.limit = chunk + length;
+        }
+
+        ~Nested() {
+            reader.cursor = cursor;
+            reader.limit = limit;
+        }
+
+        LogReader& reader;
+        const char* cursor;
+        const char* limit;
+    };
+
+    bool next(unsigned char& byte) {
+        if (cursor != nullptr) {
+            if (cursor >= limit)
+                return false;
+            byte = (unsigned char)*cursor++;
+            return true;
+        }
+        if (replay.position >= replay.log.size())
+            return false;
+        byte = (unsigned char)replay.log[replay.position++];
+        return true;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        unsigned char byte;
+        for (int shift = 0; !failed; shift += 7) {
+            if (shift > 63 || !next(byte)) {
+                fail("Truncated replayed record");
+                break;
+            }
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                break;
+        }
+        return failed ? 0 : value;
+    }
+
+    int64_t signedVarint() {
+        auto value = varint();
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    size_t chunk(const char*& chunk) {
+        auto length = (size_t)varint();
+        chunk = nullptr;
+        if (failed)
+            return 0;
+        if (cursor != nullptr) {
+            if ((size_t)(limit - cursor) < length) {
+                fail("Truncated replayed record");
+                return 0;
+            }
+            chunk = cursor;
+            cursor += length;
+        } else {
+            if (replay.log.size() - replay.position < length) {
+                fail("Truncated replayed record");
+                return 0;
+            }
+            chunk = replay.log.data() + replay.position;
+            replay.position += length;
+        }
+        return length;
+    }
+
+    void statusVector(ISC_STATUS* status) {
+        const char* chunk;
+        auto length = this->chunk(chunk);
+        if (failed)
+            return;
+        Nested nested(*this, chunk, length);
+        for (int i = 0; i < ISC_STATUS_LENGTH && !failed; ) {
+            auto arg = (ISC_STATUS)signedVarint();
+            status[i++] = arg;
+            if (arg == isc_arg_end || i >= ISC_STATUS_LENGTH)
+                break;
+            if (arg == isc_arg_cstring || arg == isc_arg_string || arg == isc_arg_interpreted ||
+                arg == isc_arg_sql_state) {
+                const char* string;
+                auto size = this->chunk(string);
+                replay.strings.emplace_back(string != nullptr ? string : "", size);
+                if (arg == isc_arg_cstring) {
+                    // the length and the pointer do not fit, pass the string as a plain one
+                    status[i - 1] = isc_arg_string;
+                }
+                status[i++] = (ISC_STATUS)replay.strings.back().c_str();
+            } else
+                status[i++] = (ISC_STATUS)signedVarint();
+        }
+        status[ISC_STATUS_LENGTH - 1] = isc_arg_end;
+    }
+
+    // fails the call, from the constructor or from an accessor reading past the end of the record
+    void fail(const char* message) {
+        failed = true;
+        replay.position = start;
+        ret = isc_random;
+        if (status != nullptr) {
+            status[0] = isc_arg_gds;
+            status[1] = isc_random;
+            status[2] = isc_arg_string;
+            status[3] = (ISC_STATUS)message;
+            status[4] = isc_arg_end;
+        }
+    }
+
+    ClientReplay& replay;
+    std::lock_guard<std::mutex> lock;
+    // the status vector of the call, nullptr for functions that do not return one
+    ISC_STATUS* status;
+    // position of the record in the log
+    size_t start;
+    // position inside a chunk, nullptr when reading the log itself
+    const char* cursor = nullptr;
+    const char* limit = nullptr;
+    ISC_STATUS ret = 0;
+    bool failed = false;
+};
+
+#endif // JNIFBCLIENT_RECORDER_H
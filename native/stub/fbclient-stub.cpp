@@ -0,0 +1,657 @@
+/*
+ * Synthetic Firebird client library.
+ *
+ * Implements the entry points used by the JNI layer and answers them from memory, without network nor server, so
+ * the throughput of the JNI layer can be measured deterministically. Load it with the "fbclient.library" system
+ * property, the FBCLIENT_LIBRARY environment variable or API.init(path).
+ *
+ * Every SELECT returns the same generated rows, other statements succeed without effect. The rows are configured
+ * with environment variables, read when the library is loaded:
+ *
+ *   FBCLIENT_STUB_ROWS       number of rows of each cursor (1000)
+ *   FBCLIENT_STUB_COLUMNS    comma separated column types (integer,varchar(32),bigint,numeric(18,2),double,
+ *                            timestamp,boolean,varchar(100)?)
+ *   FBCLIENT_STUB_PARAMS     comma separated types of the ? parameters, the last one is repeated (varchar(64)?)
+ *   FBCLIENT_STUB_BLOB_SIZE  length of the blobs in bytes (1024)
+ *   FBCLIENT_STUB_ARRAY_SIZE elements of the arrays, every array field is double precision [1:n] (1000)
+ *
+ * Types are smallint, integer, bigint, int128, numeric(p,s), float, double, boolean, date, time, timestamp,
+ * char(n), varchar(n), blob, text (blob sub_type text) and array. A trailing ? makes a column nullable, its value is
+ * then null every fifth row. Strings use the UTF8 character set.
+ */
+
+#pragma GCC visibility push(default)
+#include <ibase.h>
+#pragma GCC visibility pop
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Column {
+    ISC_SHORT type;
+    ISC_SHORT length;
+    ISC_SHORT scale;
+    ISC_SHORT subtype;
+    bool nullable;
+};
+
+std::vector<Column> parseColumns(const char* spec) {
+    std::vector<Column> columns;
+    std::string text(spec);
+    size_t start = 0;
+    while (start <= text.size()) {
+        // commas inside parentheses belong to the type
+        size_t end = start;
+        int depth = 0;
+        while (end < text.size() && (text[end] != ',' || depth > 0)) {
+            if (text[end] == '(') depth++;
+            if (text[end] == ')') depth--;
+            end++;
+        }
+        std::string token;
+        for (size_t i = start; i < end; i++)
+            if (!isspace((unsigned char)text[i]))
+                token += (char)tolower((unsigned char)text[i]);
+        start = end + 1;
+        if (token.empty())
+            continue;
+
+        Column column = {0, 0, 0, 0, false};
+        if (token.back() == '?') {
+            column.nullable = true;
+            token.pop_back();
+        }
+        int a = 0, b = 0;
+        auto open = token.find('(');
+        auto name = token.substr(0, open);
+        if (open != std::string::npos)
+            sscanf(token.c_str() + open, "(%d,%d)", &a, &b);
+
+        if (name == "smallint") { column.type = SQL_SHORT; column.length = sizeof(ISC_SHORT); }
+        else if (name == "integer" || name == "int") { column.type = SQL_LONG; column.length = sizeof(ISC_LONG); }
+        else if (name == "bigint") { column.type = SQL_INT64; column.length = sizeof(ISC_INT64); }
+        else if (name == "int128") { column.type = SQL_INT128; column.length = sizeof(FB_I128); }
+        else if (name == "numeric" || name == "decimal") {
+            column.type = SQL_INT64; column.length = sizeof(ISC_INT64); column.scale = (ISC_SHORT)-b;
+        }
+        else if (name == "float") { column.type = SQL_FLOAT; column.length = sizeof(float); }
+        else if (name == "double") { column.type = SQL_DOUBLE; column.length = sizeof(double); }
+        else if (name == "boolean") { column.type = SQL_BOOLEAN; column.length = sizeof(FB_BOOLEAN); }
+        else if (name == "date") { column.type = SQL_TYPE_DATE; column.length = sizeof(ISC_DATE); }
+        else if (name == "time") { column.type = SQL_TYPE_TIME; column.length = sizeof(ISC_TIME); }
+        else if (name == "timestamp") { column.type = SQL_TIMESTAMP; column.length = sizeof(ISC_TIMESTAMP); }
+        else if (name == "char") { column.type = SQL_TEXT; column.length = (ISC_SHORT)((a > 0 ? a : 1) * 4); column.subtype = 4; }
+        else if (name == "varchar") { column.type = SQL_VARYING; column.length = (ISC_SHORT)((a > 0 ? a : 1) * 4); column.subtype = 4; }
+        else if (name == "blob") { column.type = SQL_BLOB; column.length = sizeof(ISC_QUAD); }
+        else if (name == "text") { column.type = SQL_BLOB; column.length = sizeof(ISC_QUAD); column.subtype = 1; }
+        else if (name == "array") { column.type = SQL_ARRAY; column.length = sizeof(ISC_QUAD); }
+        else
+            continue;
+        columns.push_back(column);
+    }
+    return columns;
+}
+
+struct Config {
+    uint64_t rows;
+    uint32_t blobSize;
+    short arraySize;
+    std::vector<Column> columns;
+    std::vector<Column> params;
+
+    Config() {
+        auto value = getenv("FBCLIENT_STUB_ROWS");
+        rows = value != nullptr ? strtoull(value, nullptr, 10) : 1000;
+        value = getenv("FBCLIENT_STUB_BLOB_SIZE");
+        blobSize = value != nullptr ? (uint32_t)strtoul(value, nullptr, 10) : 1024;
+        value = getenv("FBCLIENT_STUB_ARRAY_SIZE");
+        arraySize = (short)std::min(std::max(value != nullptr ? atoi(value) : 1000, 1), 32767);
+        value = getenv("FBCLIENT_STUB_COLUMNS");
+        columns = parseColumns(value != nullptr ? value
+            : "integer,varchar(32),bigint,numeric(18,2),double,timestamp,boolean,varchar(100)?");
+        value = getenv("FBCLIENT_STUB_PARAMS");
+        params = parseColumns(value != nullptr ? value : "varchar(64)?");
+        if (params.empty())
+            params = parseColumns("varchar(64)?");
+    }
+};
+
+const Config& config() {
+    static Config config;
+    return config;
+}
+
+constexpr int MAX_HANDLES = 4096;
+
+struct Statement {
+    std::atomic<bool> used;
+    int type;
+    int params;
+    bool open;
+    uint64_t row;
+    uint64_t selected;
+};
+
+struct Blob {
+    std::atomic<bool> used;
+    uint32_t remaining;
+};
+
+Statement statements[MAX_HANDLES];
+Blob blobs[MAX_HANDLES];
+std::atomic<FB_API_HANDLE> nextHandle(1);
+std::atomic<uint32_t> nextBlobId(1);
+
+// handles are indexes in the slot arrays, plus one
+template<typename T>
+FB_API_HANDLE allocate(T (&slots)[MAX_HANDLES]) {
+    for (int i = 0; i < MAX_HANDLES; i++) {
+        bool expected = false;
+        if (slots[i].used.compare_exchange_strong(expected, true))
+            return (FB_API_HANDLE)(i + 1);
+    }
+    return 0;
+}
+
+template<typename T>
+T* find(T (&slots)[MAX_HANDLES], const FB_API_HANDLE* handle) {
+    if (handle == nullptr || *handle == 0 || (size_t)*handle > MAX_HANDLES)
+        return nullptr;
+    auto slot = &slots[(size_t)*handle - 1];
+    return slot->used.load(std::memory_order_relaxed) ? slot : nullptr;
+}
+
+ISC_STATUS success(ISC_STATUS* status) {
+    status[0] = isc_arg_gds;
+    status[1] = 0;
+    status[2] = isc_arg_end;
+    return 0;
+}
+
+ISC_STATUS failure(ISC_STATUS* status, ISC_STATUS code) {
+    status[0] = isc_arg_gds;
+    status[1] = code;
+    status[2] = isc_arg_end;
+    return code;
+}
+
+// statement type from the first keyword, as returned by isc_info_sql_stmt_type
+int statementType(const char* sql, unsigned short length) {
+    std::string keyword;
+    size_t end = length != 0 ? length : strlen(sql);
+    size_t i = 0;
+    while (i < end && (isspace((unsigned char)sql[i]) || sql[i] == '('))
+        i++;
+    while (i < end && isalpha((unsigned char)sql[i]))
+        keyword += (char)tolower((unsigned char)sql[i++]);
+    if (keyword == "select" || keyword == "with")
+        return isc_info_sql_stmt_select;
+    if (keyword == "insert")
+        return isc_info_sql_stmt_insert;
+    if (keyword == "update" || keyword == "merge")
+        return isc_info_sql_stmt_update;
+    if (keyword == "delete")
+        return isc_info_sql_stmt_delete;
+    if (keyword == "create" || keyword == "alter" || keyword == "drop" || keyword == "recreate")
+        return isc_info_sql_stmt_ddl;
+    return isc_info_sql_stmt_exec_procedure;
+}
+
+int parameterCount(const char* sql, unsigned short length) {
+    size_t end = length != 0 ? length : strlen(sql);
+    int count = 0;
+    char quote = 0;
+    for (size_t i = 0; i < end; i++) {
+        if (quote != 0) {
+            if (sql[i] == quote)
+                quote = 0;
+        } else if (sql[i] == '\'' || sql[i] == '"')
+            quote = sql[i];
+        else if (sql[i] == '?')
+            count++;
+    }
+    return count;
+}
+
+void describe(XSQLDA* sqlda, int count, const std::vector<Column>& columns, bool repeatLast) {
+    sqlda->sqld = (ISC_SHORT)count;
+    for (int i = 0; i < count && i < sqlda->sqln; i++) {
+        auto& column = repeatLast && (size_t)i >= columns.size() ? columns.back() : columns[i];
+        auto var = &sqlda->sqlvar[i];
+        var->sqltype = (ISC_SHORT)(column.type | (column.nullable ? 1 : 0));
+        var->sqllen = column.length;
+        var->sqlscale = column.scale;
+        var->sqlsubtype = column.subtype;
+        var->sqlname_length = (ISC_SHORT)snprintf(var->sqlname, sizeof(var->sqlname), "F%d", i + 1);
+        var->relname_length = (ISC_SHORT)snprintf(var->relname, sizeof(var->relname), "STUB");
+        var->ownname_length = (ISC_SHORT)snprintf(var->ownname, sizeof(var->ownname), "SYSDBA");
+        var->aliasname_length = (ISC_SHORT)snprintf(var->aliasname, sizeof(var->aliasname), "F%d", i + 1);
+    }
+}
+
+void generateRow(const XSQLDA* sqlda, uint64_t row) {
+    for (int i = 0; i < sqlda->sqld; i++) {
+        auto var = &sqlda->sqlvar[i];
+        if ((var->sqltype & 1) != 0 && var->sqlind != nullptr) {
+            *var->sqlind = (row % 5 == 4) ? -1 : 0;
+            if (*var->sqlind != 0)
+                continue;
+        }
+        auto data = var->sqldata;
+        switch (var->sqltype & ~1) {
+            case SQL_SHORT: *(ISC_SHORT*)data = (ISC_SHORT)row; break;
+            case SQL_LONG: *(ISC_LONG*)data = (ISC_LONG)row; break;
+            case SQL_INT64: *(ISC_INT64*)data = (ISC_INT64)row * 1000 + 7; break;
+            case SQL_INT128: {
+                auto value = (FB_I128*)data;
+                value->fb_data[0] = row;
+                value->fb_data[1] = 0;
+                break;
+            }
+            case SQL_FLOAT: *(float*)data = (float)row * 0.5f; break;
+            case SQL_DOUBLE: *(double*)data = (double)row * 0.25; break;
+            case SQL_BOOLEAN: *(FB_BOOLEAN*)data = (FB_BOOLEAN)(row & 1); break;
+            // 58849 is 2020-01-01
+            case SQL_TYPE_DATE: *(ISC_DATE*)data = (ISC_DATE)(58849 + row % 3650); break;
+            case SQL_TYPE_TIME: *(ISC_TIME*)data = (ISC_TIME)((row % 86400) * ISC_TIME_SECONDS_PRECISION); break;
+            case SQL_TIMESTAMP: {
+                auto value = (ISC_TIMESTAMP*)data;
+                value->timestamp_date = (ISC_DATE)(58849 + row % 3650);
+                value->timestamp_time = (ISC_TIME)((row % 86400) * ISC_TIME_SECONDS_PRECISION);
+                break;
+            }
+            case SQL_TEXT: {
+                char buffer[32];
+                auto length = snprintf(buffer, sizeof(buffer), "row %llu", (unsigned long long)row);
+                memset(data, ' ', var->sqllen);
+                memcpy(data, buffer, std::min((int)var->sqllen / 4, length));
+                break;
+            }
+            case SQL_VARYING: {
+                auto vary = (PARAMVARY*)data;
+                auto length = snprintf((char*)vary->vary_string, var->sqllen / 4 + 1, "value %llu",
+                                       (unsigned long long)row);
+                vary->vary_length = (ISC_USHORT)std::min(length, var->sqllen / 4);
+                break;
+            }
+            case SQL_BLOB:
+            case SQL_ARRAY: {
+                auto id = (ISC_QUAD*)data;
+                id->gds_quad_high = 0;
+                id->gds_quad_low = (ISC_ULONG)(row + 1);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void putInteger(ISC_SCHAR*& p, ISC_SCHAR* end, ISC_SCHAR item, uint32_t value) {
+    if (end - p < 7)
+        return;
+    *p++ = item;
+    *p++ = 4;
+    *p++ = 0;
+    for (int i = 0; i < 4; i++)
+        *p++ = (ISC_SCHAR)(value >> (i * 8));
+}
+
+void putString(ISC_SCHAR*& p, ISC_SCHAR* end, ISC_SCHAR item, const char* value) {
+    auto length = (int)strlen(value);
+    if (end - p < length + 4)
+        return;
+    *p++ = item;
+    *p++ = (ISC_SCHAR)length;
+    *p++ = (ISC_SCHAR)(length >> 8);
+    memcpy(p, value, length);
+    p += length;
+}
+
+void putEnd(ISC_SCHAR*& p, ISC_SCHAR* end) {
+    if (p < end)
+        *p++ = isc_info_end;
+}
+
+} // namespace
+
+ISC_LONG ISC_EXPORT fb_interpret(ISC_SCHAR* buffer, unsigned int length, const ISC_STATUS** vector) {
+    auto status = *vector;
+    if (status[0] != isc_arg_gds || status[1] == 0 || length == 0)
+        return 0;
+    auto size = snprintf(buffer, length, "Firebird stub error %ld", (long)status[1]);
+    // points to the end of the vector, the next call returns nothing
+    *vector = &status[2];
+    return size < (int)length ? size : (ISC_LONG)length - 1;
+}
+
+ISC_STATUS ISC_EXPORT isc_attach_database(ISC_STATUS* status, short, const ISC_SCHAR*, isc_db_handle* db, short,
+                                          const ISC_SCHAR*) {
+    *db = nextHandle++;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_create_database(ISC_STATUS* status, unsigned short, const ISC_SCHAR*, isc_db_handle* db,
+                                          unsigned short, const ISC_SCHAR*, unsigned short) {
+    *db = nextHandle++;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_detach_database(ISC_STATUS* status, isc_db_handle* db) {
+    *db = 0;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_execute_immediate(ISC_STATUS* status, isc_db_handle*, isc_tr_handle*, unsigned short,
+                                                 const ISC_SCHAR*, unsigned short, const XSQLDA*) {
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT_VARARG isc_start_transaction(ISC_STATUS* status, isc_tr_handle* tr, short, ...) {
+    *tr = nextHandle++;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_commit_retaining(ISC_STATUS* status, isc_tr_handle*) {
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_commit_transaction(ISC_STATUS* status, isc_tr_handle* tr) {
+    *tr = 0;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_rollback_retaining(ISC_STATUS* status, isc_tr_handle*) {
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_rollback_transaction(ISC_STATUS* status, isc_tr_handle* tr) {
+    *tr = 0;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_allocate_statement(ISC_STATUS* status, isc_db_handle*, isc_stmt_handle* stmt) {
+    *stmt = allocate(statements);
+    if (*stmt == 0)
+        return failure(status, isc_virmemexh);
+    auto statement = find(statements, stmt);
+    statement->type = 0;
+    statement->params = 0;
+    statement->open = false;
+    statement->selected = 0;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_prepare(ISC_STATUS* status, isc_tr_handle*, isc_stmt_handle* stmt,
+                                       unsigned short length, const ISC_SCHAR* sql, unsigned short,
+                                       XSQLDA* sqlda) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    statement->type = statementType(sql, length);
+    statement->params = parameterCount(sql, length);
+    statement->open = false;
+    if (sqlda != nullptr) {
+        auto count = statement->type == isc_info_sql_stmt_select ? (int)config().columns.size() : 0;
+        describe(sqlda, count, config().columns, false);
+    }
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_set_cursor_name(ISC_STATUS* status, isc_stmt_handle*, const ISC_SCHAR*,
+                                               unsigned short) {
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_describe(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short, XSQLDA* sqlda) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    auto count = statement->type == isc_info_sql_stmt_select ? (int)config().columns.size() : 0;
+    describe(sqlda, count, config().columns, false);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_describe_bind(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short,
+                                             XSQLDA* sqlda) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    describe(sqlda, statement->params, config().params, true);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_execute(ISC_STATUS* status, isc_tr_handle*, isc_stmt_handle* stmt, unsigned short,
+                                       const XSQLDA*) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    if (statement->type == isc_info_sql_stmt_select) {
+        statement->open = true;
+        statement->row = 0;
+        statement->selected = 0;
+    }
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_execute2(ISC_STATUS* status, isc_tr_handle*, isc_stmt_handle* stmt, unsigned short,
+                                        const XSQLDA*, const XSQLDA* out) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    if (out != nullptr && out->sqld > 0) {
+        generateRow(out, 0);
+        statement->selected = 1;
+    }
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_fetch(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short,
+                                     const XSQLDA* sqlda) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    if (!statement->open)
+        return failure(status, isc_dsql_cursor_err);
+    if (statement->row >= config().rows)
+        return 100;
+    if (sqlda != nullptr)
+        generateRow(sqlda, statement->row);
+    statement->row++;
+    statement->selected++;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_free_statement(ISC_STATUS* status, isc_stmt_handle* stmt, unsigned short option) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    statement->open = false;
+    if (option == DSQL_drop) {
+        statement->used.store(false);
+        *stmt = 0;
+    }
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_open_blob(ISC_STATUS* status, isc_db_handle*, isc_tr_handle*, isc_blob_handle* handle,
+                                    ISC_QUAD*) {
+    *handle = allocate(blobs);
+    if (*handle == 0)
+        return failure(status, isc_virmemexh);
+    find(blobs, handle)->remaining = config().blobSize;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_create_blob(ISC_STATUS* status, isc_db_handle*, isc_tr_handle*, isc_blob_handle* handle,
+                                      ISC_QUAD* id) {
+    *handle = allocate(blobs);
+    if (*handle == 0)
+        return failure(status, isc_virmemexh);
+    find(blobs, handle)->remaining = 0;
+    id->gds_quad_high = 1;
+    id->gds_quad_low = nextBlobId++;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_get_segment(ISC_STATUS* status, isc_blob_handle* handle, unsigned short* actual,
+                                      unsigned short length, ISC_SCHAR* buffer) {
+    auto blob = find(blobs, handle);
+    *actual = 0;
+    if (blob == nullptr)
+        return failure(status, isc_bad_segstr_handle);
+    if (blob->remaining == 0)
+        return failure(status, isc_segstr_eof);
+    auto size = length < blob->remaining ? length : (unsigned short)blob->remaining;
+    memset(buffer, 'x', size);
+    blob->remaining -= size;
+    *actual = size;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_put_segment(ISC_STATUS* status, isc_blob_handle* handle, unsigned short,
+                                      const ISC_SCHAR*) {
+    if (find(blobs, handle) == nullptr)
+        return failure(status, isc_bad_segstr_handle);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_close_blob(ISC_STATUS* status, isc_blob_handle* handle) {
+    auto blob = find(blobs, handle);
+    if (blob == nullptr)
+        return failure(status, isc_bad_segstr_handle);
+    blob->used.store(false);
+    *handle = 0;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_cancel_blob(ISC_STATUS* status, isc_blob_handle* handle) {
+    auto blob = find(blobs, handle);
+    if (blob == nullptr)
+        return failure(status, isc_bad_segstr_handle);
+    blob->used.store(false);
+    *handle = 0;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_blob_info(ISC_STATUS* status, isc_blob_handle* handle, short itemsLength,
+                                    const ISC_SCHAR* items, short length, ISC_SCHAR* buffer) {
+    if (find(blobs, handle) == nullptr)
+        return failure(status, isc_bad_segstr_handle);
+    auto p = buffer;
+    auto end = buffer + length;
+    for (int i = 0; i < itemsLength; i++) {
+        switch (items[i]) {
+            case isc_info_blob_total_length: putInteger(p, end, items[i], config().blobSize); break;
+            case isc_info_blob_max_segment: putInteger(p, end, items[i], 32767); break;
+            case isc_info_blob_num_segments: putInteger(p, end, items[i], 1); break;
+            case isc_info_blob_type: putInteger(p, end, items[i], 0); break;
+            default: break;
+        }
+    }
+    putEnd(p, end);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_sql_info(ISC_STATUS* status, isc_stmt_handle* stmt, short itemsLength,
+                                        const ISC_SCHAR* items, short length, ISC_SCHAR* buffer) {
+    auto statement = find(statements, stmt);
+    if (statement == nullptr)
+        return failure(status, isc_bad_stmt_handle);
+    auto p = buffer;
+    auto end = buffer + length;
+    for (int i = 0; i < itemsLength; i++) {
+        switch (items[i]) {
+            case isc_info_sql_stmt_type:
+                putInteger(p, end, items[i], (uint32_t)statement->type);
+                break;
+            case isc_info_sql_get_plan:
+            case isc_info_sql_explain_plan:
+                putString(p, end, items[i], statement->type == isc_info_sql_stmt_select ? "\nPLAN (STUB NATURAL)" : "");
+                break;
+            case isc_info_sql_records:
+                if (end - p >= 3 + 4 * 7 + 1) {
+                    *p++ = items[i];
+                    *p++ = 4 * 7 + 1;
+                    *p++ = 0;
+                    putInteger(p, end, isc_info_req_select_count, (uint32_t)statement->selected);
+                    putInteger(p, end, isc_info_req_insert_count, statement->type == isc_info_sql_stmt_insert ? 1 : 0);
+                    putInteger(p, end, isc_info_req_update_count, statement->type == isc_info_sql_stmt_update ? 1 : 0);
+                    putInteger(p, end, isc_info_req_delete_count, statement->type == isc_info_sql_stmt_delete ? 1 : 0);
+                    putEnd(p, end);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    putEnd(p, end);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_database_info(ISC_STATUS* status, isc_db_handle*, short itemsLength,
+                                        const ISC_SCHAR* items, short length, ISC_SCHAR* buffer) {
+    auto p = buffer;
+    auto end = buffer + length;
+    for (int i = 0; i < itemsLength; i++) {
+        switch (items[i]) {
+            case isc_info_reads:
+            case isc_info_writes:
+            case isc_info_fetches:
+            case isc_info_marks:
+            case isc_info_current_memory:
+            case isc_info_max_memory:
+                putInteger(p, end, items[i], 0);
+                break;
+            default:
+                break;
+        }
+    }
+    putEnd(p, end);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_array_lookup_bounds(ISC_STATUS* status, isc_db_handle*, isc_tr_handle*,
+                                              const ISC_SCHAR* relation, const ISC_SCHAR* field, ISC_ARRAY_DESC* desc) {
+    memset(desc, 0, sizeof(ISC_ARRAY_DESC));
+    desc->array_desc_dtype = blr_double;
+    desc->array_desc_length = sizeof(double);
+    snprintf(desc->array_desc_field_name, sizeof(desc->array_desc_field_name), "%s", field);
+    snprintf(desc->array_desc_relation_name, sizeof(desc->array_desc_relation_name), "%s", relation);
+    desc->array_desc_dimensions = 1;
+    desc->array_desc_bounds[0].array_bound_lower = 1;
+    desc->array_desc_bounds[0].array_bound_upper = config().arraySize;
+    return success(status);
+}
+
+// the element of subscript k of array id is id + k / 4
+ISC_STATUS ISC_EXPORT isc_array_get_slice(ISC_STATUS* status, isc_db_handle*, isc_tr_handle*, ISC_QUAD* id,
+                                          const ISC_ARRAY_DESC* desc, void* buffer, ISC_LONG* length) {
+    if (desc->array_desc_dtype != blr_double || desc->array_desc_dimensions != 1)
+        return failure(status, isc_invalid_dimension);
+    auto& bound = desc->array_desc_bounds[0];
+    auto count = std::min((ISC_LONG)(bound.array_bound_upper - bound.array_bound_lower + 1),
+                          *length / (ISC_LONG)sizeof(double));
+    auto values = (double*)buffer;
+    for (ISC_LONG i = 0; i < count; i++)
+        values[i] = (double)id->gds_quad_low + (bound.array_bound_lower + i) * 0.25;
+    *length = count * (ISC_LONG)sizeof(double);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_array_put_slice(ISC_STATUS* status, isc_db_handle*, isc_tr_handle*, ISC_QUAD* id,
+                                          const ISC_ARRAY_DESC* desc, void*, ISC_LONG*) {
+    if (desc->array_desc_dtype != blr_double || desc->array_desc_dimensions != 1)
+        return failure(status, isc_invalid_dimension);
+    id->gds_quad_high = 1;
+    id->gds_quad_low = nextBlobId++;
+    return success(status);
+}
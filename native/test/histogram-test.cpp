@@ -0,0 +1,73 @@
+/*
+ * Checks of the bucket math of LatencyHistogram, run by ctest.
+ *
+ * usage: histogram_test
+ */
+
+#include "../histogram.h"
+
+#include <cstdio>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what, uint64_t value) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s (%llu)\n", what, (unsigned long long)value);
+        failures++;
+    }
+}
+
+// every bucket ends right before the next one starts, and is at most 1/16 of its lowest value wide
+void buckets() {
+    using H = LatencyHistogram;
+    check(H::indexOf(0) == 0, "indexOf(0)", 0);
+    for (int i = 0; i < H::COUNTS_LENGTH; i++) {
+        auto highest = H::highestEquivalentValue(i);
+        check(H::indexOf(highest) == i, "indexOf(highestEquivalentValue(i)) == i", (uint64_t)i);
+        auto lowest = i == 0 ? 0 : H::highestEquivalentValue(i - 1) + 1;
+        check(H::indexOf(lowest) == i, "indexOf(lowest value of i) == i", (uint64_t)i);
+        if (i >= H::SUB_BUCKET_COUNT)
+            check((highest - lowest + 1) * 16 <= lowest, "bucket width", (uint64_t)i);
+    }
+    check(H::highestEquivalentValue(H::COUNTS_LENGTH - 1) == H::MAX_VALUE, "last bucket", H::MAX_VALUE);
+    // larger values are clamped
+    check(H::indexOf(H::MAX_VALUE + 1) == H::COUNTS_LENGTH - 1, "indexOf(MAX_VALUE + 1)", H::MAX_VALUE + 1);
+    check(H::indexOf(UINT64_MAX) == H::COUNTS_LENGTH - 1, "indexOf(UINT64_MAX)", UINT64_MAX);
+}
+
+LatencyHistogram histogram;
+LatencyHistogram::Snapshot snapshot;
+
+// the percentiles of 1..100000 ns are within the width of their bucket
+void percentiles() {
+    for (uint64_t value = 1; value <= 100000; value++)
+        histogram.record(value);
+    histogram.snapshot(snapshot);
+    check(snapshot.count == 100000, "count", snapshot.count);
+    check(snapshot.total == 100000ULL * 100001 / 2, "total", snapshot.total);
+    check(snapshot.max == 100000, "max", snapshot.max);
+    const double fractions[] = {0.5, 0.9, 0.99, 0.999};
+    for (auto fraction : fractions) {
+        auto expected = (uint64_t)(fraction * 100000);
+        auto value = snapshot.percentile(fraction);
+        check(value >= expected && value - expected <= expected / 16, "percentile", value);
+    }
+    check(snapshot.percentile(1.0) == 100000, "percentile(1.0) is the maximum", snapshot.percentile(1.0));
+
+    histogram.reset();
+    histogram.snapshot(snapshot);
+    check(snapshot.count == 0 && snapshot.max == 0, "reset", snapshot.count);
+    check(snapshot.percentile(0.5) == 0, "percentile of an empty histogram", snapshot.percentile(0.5));
+}
+
+} // namespace
+
+int main() {
+    buckets();
+    percentiles();
+    if (failures == 0)
+        printf("histogram: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -19,6 +19,7 @@ rootProject.name = "Firebird-Client-KMP"
 include(":native")
 include(":FirebirdClient")
 include(":FirebirdClient-ext")
+include(":benchmark")
 
 project(":FirebirdClient").projectDir = file("library")
 project(":FirebirdClient-ext").projectDir = file("library-ext")